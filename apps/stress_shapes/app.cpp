@@ -0,0 +1,310 @@
+#include "app.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+#include "core/BlotEngine.h"
+#include "core/canvas/Canvas.h"
+#include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CShape.h"
+#include "ecs/components/CTransform.h"
+#include "ecs/systems/ShapeCulling.h"
+#include "rendering/BlendMode.h"
+#include "rendering/Graphics.h"
+#include "rendering/RendererRegistry.h"
+#include "rendering/U_gladGlfw.h"
+
+using namespace blot;
+
+namespace {
+
+// Frames right after a switch pay for renderer setup and cold caches
+constexpr float kWarmupSeconds = 0.5f;
+constexpr int kPartialSlices = 8;
+
+std::string getRendererName(RendererType type) {
+	switch (type) {
+	case RendererType::OpenGL:
+		return "OpenGL";
+	case RendererType::Blend2D:
+		return "Blend2D";
+	case RendererType::Software:
+		return "Software";
+	}
+	return "Unknown";
+}
+
+} // namespace
+
+void StressShapesApp::setup() {
+	getEngine()->init("Stress Shapes", 0.1f);
+	// Measure the engine, not the display
+	getEngine()->setVerticalSync(false);
+	getEngine()->setTargetFrameRate(0);
+
+	CanvasSettings canvasSettings;
+	canvasSettings.width = window().width;
+	canvasSettings.height = window().height;
+	m_canvas = getCanvasManager()->createCanvas(canvasSettings, "Stress");
+	m_canvas->setECSManager(getECSManager());
+	// Order-independent modes let the GL instancer batch by shape type
+	m_canvas->getGraphics()->setBlendMode(
+		getBlendModeFromString(m_options.blend));
+
+	spawnShapes();
+
+	for (RendererType type :
+		 RendererRegistry::instance().getRegisteredTypes()) {
+		if (!m_options.renderer.empty() &&
+			getRendererTypeFromString(m_options.renderer) != type) {
+			continue;
+		}
+		for (Motion motion : {Motion::Redraw, Motion::Partial, Motion::All}) {
+			m_modes.push_back({type, motion});
+		}
+	}
+	if (m_modes.empty()) {
+		spdlog::error("[StressShapes] Renderer '{}' is not registered",
+					  m_options.renderer);
+		glfwSetWindowShouldClose(getEngine()->getWindow(), 1);
+		return;
+	}
+
+	std::printf("%d shapes, %.1f s per mode, %s blending\n", m_options.count,
+				m_options.secondsPerMode, m_options.blend.c_str());
+	std::printf("%-10s %-8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "renderer",
+				"motion", "fps", "avg ms", "p50 ms", "p99 ms", "max ms",
+				"frames", "ecs ms", "draws");
+	startMode(0);
+}
+
+void StressShapesApp::spawnShapes() {
+	MEcs *ecs = getECSManager();
+	// Fixed seed so every run, version and backend draws the same scene
+	std::mt19937 rng(20240601);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	auto width = static_cast<float>(window().width);
+	auto height = static_cast<float>(window().height);
+	// Keep total coverage roughly constant: a few hundred pixels per shape
+	// at 1k, collapsing to the point LOD at 1M
+	float size = std::clamp(
+		2.0f * std::sqrt(width * height / m_options.count), 2.0f, 48.0f);
+
+	m_movers.clear();
+	m_movers.reserve(m_options.count);
+	for (int i = 0; i < m_options.count; ++i) {
+		entt::entity entity = ecs->createEntity();
+
+		glm::vec2 base(unit(rng) * width, unit(rng) * height);
+		ecs::CTransform transform;
+		transform.position = glm::vec3(base, 0.0f);
+
+		ecs::CShape shape;
+		shape.type = static_cast<ecs::CShape::Type>(i % 5);
+		float w = size * (0.5f + unit(rng));
+		float h = size * (0.5f + unit(rng));
+		shape.x1 = -w * 0.5f;
+		shape.y1 = -h * 0.5f;
+		shape.x2 = w * 0.5f;
+		shape.y2 = h * 0.5f;
+		shape.sides = 3 + i % 6;
+		shape.innerRadius = 0.4f + 0.2f * unit(rng);
+
+		ecs::CDrawStyle style;
+		style.setFillColor(unit(rng), unit(rng), unit(rng));
+		style.setStrokeColor(unit(rng) * 0.5f, unit(rng) * 0.5f,
+							 unit(rng) * 0.5f);
+		style.strokeWidth = 1.0f + static_cast<float>(i % 4);
+		// Fill only, stroke only, both, translucent fill
+		switch ((i / 5) % 4) {
+		case 0:
+			style.hasStroke = false;
+			break;
+		case 1:
+			style.hasFill = false;
+			break;
+		case 2:
+			break;
+		case 3:
+			style.fillA = 0.35f;
+			style.hasStroke = false;
+			break;
+		}
+		if (shape.type == ecs::CShape::Type::Line) {
+			style.hasStroke = true;
+		}
+
+		ecs->addComponent(entity, transform);
+		ecs->addComponent(entity, shape);
+		ecs->addComponent(entity, style);
+
+		m_movers.push_back({entity, base, size * (0.5f + 2.0f * unit(rng)),
+							0.5f + 1.5f * unit(rng),
+							unit(rng) * 6.2831853f});
+	}
+	spdlog::info("[StressShapes] Spawned {} shapes, {:.1f} px", m_options.count,
+				 size);
+}
+
+void StressShapesApp::animate(Motion motion) {
+	if (motion == Motion::Redraw) {
+		m_canvas->markDirty();
+		return;
+	}
+	MEcs *ecs = getECSManager();
+	size_t first = 0;
+	size_t step = 1;
+	if (motion == Motion::Partial) {
+		first = m_frame % kPartialSlices;
+		step = kPartialSlices;
+	}
+	for (size_t i = first; i < m_movers.size(); i += step) {
+		const Mover &mover = m_movers[i];
+		float angle = m_time * mover.speed + mover.phase;
+		glm::vec2 position =
+			mover.base +
+			mover.radius * glm::vec2(std::cos(angle), std::sin(angle));
+		ecs->patchComponent<ecs::CTransform>(
+			mover.entity, [&](ecs::CTransform &transform) {
+				transform.position.x = position.x;
+				transform.position.y = position.y;
+			});
+	}
+	ecs->updateRenderProxies();
+}
+
+void StressShapesApp::update(float deltaTime) {
+	if (m_finished || m_modes.empty()) {
+		return;
+	}
+	m_time += deltaTime;
+	m_modeTime += deltaTime;
+	++m_frame;
+
+	// ECS time this frame: the engine's updateSystems() call, which ran
+	// just before this, plus moving shapes and rebuilding their proxies
+	auto start = std::chrono::steady_clock::now();
+	animate(m_modes[m_modeIndex].motion);
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	double ecsMs = getECSManager()->getUpdateMs() + elapsed.count();
+
+	if (!m_measuring && m_modeTime >= kWarmupSeconds) {
+		getEngine()->getFramePacer().resetStats();
+		m_measuring = true;
+		m_ecsMs = 0.0;
+		m_draws = 0.0;
+		m_updateFrames = 0;
+		return;
+	}
+	if (m_measuring) {
+		m_ecsMs += ecsMs;
+		// Of the last render, which may trail this update by a frame
+		ecs::ShapeRenderStats shapes = m_canvas->getShapeRenderStats();
+		m_draws += static_cast<double>(shapes.batches + shapes.submitted -
+									   shapes.instanced);
+		++m_updateFrames;
+	}
+	if (m_modeTime >= kWarmupSeconds + m_options.secondsPerMode) {
+		finishMode();
+	}
+}
+
+void StressShapesApp::draw() {
+	// The canvas is drawn by the engine; a UI addon shows it on screen
+}
+
+void StressShapesApp::startMode(size_t index) {
+	// Skip backends that fail to initialize here, e.g. no GL context
+	while (index < m_modes.size()) {
+		RendererType type = m_modes[index].renderer;
+		m_canvas->switchRenderer(type);
+		IRenderer *renderer = m_canvas->getRenderer();
+		if (renderer && renderer->getType() == type) {
+			break;
+		}
+		spdlog::warn("[StressShapes] Skipping {}, it did not initialize",
+					 getRendererName(type));
+		while (index < m_modes.size() && m_modes[index].renderer == type) {
+			++index;
+		}
+	}
+	if (index == m_modes.size()) {
+		printSummary();
+		m_finished = true;
+		glfwSetWindowShouldClose(getEngine()->getWindow(), 1);
+		return;
+	}
+	m_modeIndex = index;
+	m_modeTime = 0.0f;
+	m_measuring = false;
+	m_canvas->markDirty();
+}
+
+void StressShapesApp::finishMode() {
+	const Mode &mode = m_modes[m_modeIndex];
+	Result result;
+	result.renderer = getRendererName(mode.renderer);
+	result.motion = mode.motion;
+	result.stats = getEngine()->getFrameStats();
+	result.ecsMs = m_updateFrames ? static_cast<float>(m_ecsMs / m_updateFrames)
+								  : 0.0f;
+	result.draws = m_updateFrames
+					   ? static_cast<float>(m_draws / m_updateFrames)
+					   : 0.0f;
+	printResult(result);
+	m_results.push_back(result);
+
+	size_t next = m_modeIndex + 1;
+	if (next == m_modes.size() && m_options.loop) {
+		printSummary();
+		m_results.clear();
+		next = 0;
+	}
+	startMode(next);
+}
+
+void StressShapesApp::printResult(const Result &result) const {
+	const FramePacer::Stats &stats = result.stats;
+	std::printf(
+		"%-10s %-8s %8.1f %8.2f %8.2f %8.2f %8.2f %8llu %8.2f %8.0f\n",
+		result.renderer.c_str(), getMotionName(result.motion), stats.fps,
+		stats.averageMs, stats.p50Ms, stats.p99Ms, stats.maxMs,
+		static_cast<unsigned long long>(stats.frames), result.ecsMs,
+		result.draws);
+	std::fflush(stdout);
+}
+
+void StressShapesApp::printSummary() const {
+	if (m_results.empty()) {
+		return;
+	}
+	// The slowest mode is the number to compare across versions
+	auto worst = std::max_element(
+		m_results.begin(), m_results.end(),
+		[](const Result &a, const Result &b) {
+			return a.stats.p99Ms < b.stats.p99Ms;
+		});
+	std::printf("worst p99: %.2f ms (%s, %s) over %zu modes\n",
+				worst->stats.p99Ms, worst->renderer.c_str(),
+				getMotionName(worst->motion), m_results.size());
+	std::fflush(stdout);
+}
+
+const char *StressShapesApp::getMotionName(Motion motion) {
+	switch (motion) {
+	case Motion::Redraw:
+		return "redraw";
+	case Motion::Partial:
+		return "partial";
+	case Motion::All:
+		return "all";
+	}
+	return "";
+}
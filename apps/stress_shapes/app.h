@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/U_core.h"
+#include "core/util/FramePacer.h"
+
+// Command line options, see main.cpp
+struct StressOptions {
+	int count = 10000;			 // Shapes, 1k to 1M
+	float secondsPerMode = 5.0f; // Measured, after a short warm-up
+	std::string renderer;		 // Only this backend, "" = every registered
+	std::string blend = "Normal"; // Canvas blend mode, by name
+	bool loop = false;			 // Cycle until the window is closed
+};
+
+// Canonical workload for comparing engine versions and backends: spawns
+// N shapes with mixed types and styles through MEcs, then times every
+// registered renderer in three motion modes and prints frame-time
+// statistics. Only the Software renderer registers itself in this tree,
+// so it is the only one cycled unless an addon registers another. The
+// canvas is rendered every frame, but without a UI addon nothing shows
+// it: the window stays empty and the numbers cover canvas rendering, not
+// presenting it. "ecs ms" is MEcs::updateSystems() plus moving shapes and
+// rebuilding their render proxies.
+class StressShapesApp : public blot::IApp {
+  public:
+	explicit StressShapesApp(const StressOptions &options)
+		: m_options(options) {
+		window().width = 1280;
+		window().height = 720;
+		window().title = "Stress Shapes";
+	}
+
+	void setup() override;
+	void update(float deltaTime) override;
+	void draw() override;
+
+  private:
+	enum class Motion {
+		Redraw,	 // Nothing moves, the canvas is redrawn every frame
+		Partial, // A rotating eighth of the shapes moves each frame
+		All		 // Every shape moves every frame
+	};
+
+	struct Mode {
+		RendererType renderer;
+		Motion motion;
+	};
+
+	struct Mover {
+		entt::entity entity;
+		glm::vec2 base;
+		float radius;
+		float speed;
+		float phase;
+	};
+
+	struct Result {
+		std::string renderer;
+		Motion motion;
+		blot::FramePacer::Stats stats;
+		float ecsMs;
+		float draws; // Per frame: instanced calls plus single shapes
+	};
+
+	void spawnShapes();
+	void animate(Motion motion);
+	void startMode(size_t index);
+	void finishMode();
+	void printResult(const Result &result) const;
+	void printSummary() const;
+	static const char *getMotionName(Motion motion);
+
+	StressOptions m_options;
+	std::shared_ptr<blot::Canvas> m_canvas;
+	std::vector<Mover> m_movers;
+	std::vector<Mode> m_modes;
+	std::vector<Result> m_results;
+	size_t m_modeIndex = 0;
+	float m_modeTime = 0.0f;
+	bool m_measuring = false;
+	bool m_finished = false;
+	float m_time = 0.0f;
+	uint64_t m_frame = 0;
+	double m_ecsMs = 0.0;
+	double m_draws = 0.0;
+	uint64_t m_updateFrames = 0;
+};
@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "app.h"
+#include "core/BlotEngine.h"
+
+namespace {
+
+void printUsage(const char *program) {
+	std::printf("Usage: %s [--count N] [--seconds S] [--renderer NAME] "
+				"[--blend MODE] [--loop]\n"
+				"  --count N        shapes to spawn, 1000 to 1000000 "
+				"(default 10000)\n"
+				"  --seconds S      seconds per mode (default 5)\n"
+				"  --renderer NAME  only this backend (default: every "
+				"registered one)\n"
+				"  --blend MODE     canvas blend mode, e.g. Add (default "
+				"Normal)\n"
+				"  --loop           cycle the modes until the window is "
+				"closed\n",
+				program);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	StressOptions options;
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--count") == 0 && value) {
+			options.count = std::atoi(value);
+			++i;
+		} else if (std::strcmp(arg, "--seconds") == 0 && value) {
+			options.secondsPerMode = static_cast<float>(std::atof(value));
+			++i;
+		} else if (std::strcmp(arg, "--renderer") == 0 && value) {
+			options.renderer = value;
+			++i;
+		} else if (std::strcmp(arg, "--blend") == 0 && value) {
+			options.blend = value;
+			++i;
+		} else if (std::strcmp(arg, "--loop") == 0) {
+			options.loop = true;
+		} else {
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+	if (options.count < 1000 || options.count > 1000000 ||
+		options.secondsPerMode <= 0.0f) {
+		spdlog::error("[StressShapes] --count must be 1000 to 1000000 and "
+					  "--seconds positive");
+		return 2;
+	}
+
+	auto appInstance = std::make_unique<StressShapesApp>(options);
+	blot::BlotEngine engine(std::move(appInstance));
+	engine.run();
+	return 0;
+}
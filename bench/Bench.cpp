@@ -0,0 +1,300 @@
+// blot_bench runner: calibrates, times and reports every registered case.
+//
+// Usage: blot_bench [--filter text] [--min-time seconds] [--repetitions n]
+//                   [--out file.json] [--list]
+//
+// A table goes to stderr and the JSON report to stdout (or --out), so runs
+// from different releases can be diffed or fed to a tracking script.
+
+#include "Bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+#include <spdlog/spdlog.h>
+
+#include "core/json.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_bytes{0};
+
+void *countedAlloc(std::size_t size) {
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	g_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return countedAlloc(size); }
+void *operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace blot {
+namespace bench {
+
+uint64_t allocationCount() {
+	return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t allocatedBytes() { return g_bytes.load(std::memory_order_relaxed); }
+
+std::vector<Case> &registry() {
+	static std::vector<Case> cases;
+	return cases;
+}
+
+bool registerCase(const std::string &name, Function function) {
+	registry().push_back({name, std::move(function)});
+	return true;
+}
+
+bool State::next() {
+	if (m_done == 0 && !m_running) {
+		start();
+	}
+	if (m_done < m_iterations && m_skipReason.empty()) {
+		++m_done;
+		return true;
+	}
+	if (m_running) {
+		stop();
+	}
+	return false;
+}
+
+void State::pause() {
+	if (m_running) {
+		stop();
+	}
+}
+
+void State::resume() {
+	if (!m_running) {
+		start();
+	}
+}
+
+void State::start() {
+	m_running = true;
+	m_allocStart = allocationCount();
+	m_bytesStart = allocatedBytes();
+	m_start = Clock::now();
+}
+
+void State::stop() {
+	m_elapsed += Clock::now() - m_start;
+	m_allocations += allocationCount() - m_allocStart;
+	m_bytes += allocatedBytes() - m_bytesStart;
+	m_running = false;
+}
+
+double State::getSeconds() const {
+	return std::chrono::duration<double>(m_elapsed).count();
+}
+
+} // namespace bench
+} // namespace blot
+
+namespace {
+
+using blot::json;
+using blot::bench::Case;
+using blot::bench::State;
+
+struct Options {
+	std::string filter;
+	double minTime = 0.25;
+	int repetitions = 3;
+	std::string out;
+	bool list = false;
+};
+
+struct Result {
+	std::string name;
+	size_t iterations = 0;
+	size_t items = 1;
+	double nsPerOp = 0.0;
+	double nsPerOpMin = 0.0;
+	double allocsPerOp = 0.0;
+	double bytesPerOp = 0.0;
+	std::string skipped;
+};
+
+bool parseOptions(int argc, char **argv, Options &options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--filter" && hasValue) {
+			options.filter = argv[++i];
+		} else if (arg == "--min-time" && hasValue) {
+			options.minTime = std::atof(argv[++i]);
+		} else if (arg == "--repetitions" && hasValue) {
+			options.repetitions = std::max(std::atoi(argv[++i]), 1);
+		} else if (arg == "--out" && hasValue) {
+			options.out = argv[++i];
+		} else if (arg == "--list") {
+			options.list = true;
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+State runOnce(const Case &benchCase, size_t iterations) {
+	State state(iterations);
+	benchCase.function(state);
+	return state;
+}
+
+Result runCase(const Case &benchCase, const Options &options) {
+	Result result;
+	result.name = benchCase.name;
+
+	// Grow the iteration count until one run takes at least minTime
+	size_t iterations = 1;
+	for (;;) {
+		State probe = runOnce(benchCase, iterations);
+		if (!probe.getSkipReason().empty()) {
+			result.skipped = probe.getSkipReason();
+			return result;
+		}
+		double seconds = probe.getSeconds();
+		if (seconds >= options.minTime || iterations >= 1000000000) {
+			break;
+		}
+		double scale = seconds > 0.0 ? options.minTime * 1.2 / seconds : 100.0;
+		scale = std::min(std::max(scale, 2.0), 100.0);
+		iterations = static_cast<size_t>(std::ceil(iterations * scale));
+	}
+
+	std::vector<double> samples;
+	for (int r = 0; r < options.repetitions; ++r) {
+		State state = runOnce(benchCase, iterations);
+		double ops = static_cast<double>(state.getIterations()) *
+					 static_cast<double>(state.getItemsPerIteration());
+		samples.push_back(state.getSeconds() * 1e9 / ops);
+		// Allocation counts are deterministic enough to take from one run
+		result.allocsPerOp = state.getAllocations() / ops;
+		result.bytesPerOp = state.getAllocatedBytes() / ops;
+		result.items = state.getItemsPerIteration();
+	}
+	std::sort(samples.begin(), samples.end());
+	result.iterations = iterations;
+	result.nsPerOp = samples[samples.size() / 2];
+	result.nsPerOpMin = samples.front();
+	return result;
+}
+
+json toJson(const std::vector<Result> &results, const Options &options) {
+	json report;
+	report["format"] = 1;
+	report["timestamp"] = static_cast<int64_t>(std::time(nullptr));
+#ifdef __VERSION__
+	report["compiler"] = __VERSION__;
+#endif
+#ifdef NDEBUG
+	report["build"] = "release";
+#else
+	report["build"] = "debug";
+#endif
+	report["minTime"] = options.minTime;
+	report["repetitions"] = options.repetitions;
+	json cases = json::array();
+	for (const Result &result : results) {
+		json entry;
+		entry["name"] = result.name;
+		if (!result.skipped.empty()) {
+			entry["skipped"] = result.skipped;
+		} else {
+			entry["iterations"] = result.iterations;
+			entry["itemsPerIteration"] = result.items;
+			entry["nsPerOp"] = result.nsPerOp;
+			entry["nsPerOpMin"] = result.nsPerOpMin;
+			entry["allocsPerOp"] = result.allocsPerOp;
+			entry["bytesPerOp"] = result.bytesPerOp;
+		}
+		cases.push_back(std::move(entry));
+	}
+	report["cases"] = std::move(cases);
+	return report;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		std::fprintf(stderr,
+					 "usage: %s [--filter text] [--min-time seconds] "
+					 "[--repetitions n] [--out file.json] [--list]\n",
+					 argv[0]);
+		return 1;
+	}
+	// Engine code logs freely; keep the report readable
+	spdlog::set_level(spdlog::level::warn);
+
+	std::vector<Case> cases = blot::bench::registry();
+	std::sort(cases.begin(), cases.end(), [](const Case &a, const Case &b) {
+		return a.name < b.name;
+	});
+	if (options.list) {
+		for (const Case &benchCase : cases) {
+			std::printf("%s\n", benchCase.name.c_str());
+		}
+		return 0;
+	}
+#ifndef NDEBUG
+	std::fprintf(stderr, "warning: debug build, timings are not meaningful\n");
+#endif
+
+	std::vector<Result> results;
+	std::fprintf(stderr, "%-36s %14s %12s %12s\n", "case", "ns/op",
+				 "allocs/op", "bytes/op");
+	for (const Case &benchCase : cases) {
+		if (!options.filter.empty() &&
+			benchCase.name.find(options.filter) == std::string::npos) {
+			continue;
+		}
+		Result result = runCase(benchCase, options);
+		if (!result.skipped.empty()) {
+			std::fprintf(stderr, "%-36s skipped: %s\n", result.name.c_str(),
+						 result.skipped.c_str());
+		} else {
+			std::fprintf(stderr, "%-36s %14.1f %12.2f %12.1f\n",
+						 result.name.c_str(), result.nsPerOp,
+						 result.allocsPerOp, result.bytesPerOp);
+		}
+		results.push_back(std::move(result));
+	}
+
+	std::string report = toJson(results, options).dump(2);
+	if (options.out.empty()) {
+		std::cout << report << std::endl;
+	} else {
+		std::ofstream file(options.out, std::ios::trunc);
+		file << report << std::endl;
+		if (!file) {
+			std::fprintf(stderr, "could not write %s\n", options.out.c_str());
+			return 1;
+		}
+	}
+	return 0;
+}
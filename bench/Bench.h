@@ -0,0 +1,98 @@
+#pragma once
+
+// Minimal benchmark harness for blot_bench. A case is a function that
+// loops while state.next() is true; the runner picks the iteration count
+// from a short calibration run. Allocations are counted through global
+// operator new, so allocs/op covers every thread.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace blot {
+namespace bench {
+
+class State {
+  public:
+	explicit State(size_t iterations) : m_iterations(iterations) {}
+
+	// True while the case should run another iteration. Starts the clock
+	// on the first call and stops it after the last.
+	bool next();
+
+	// Exclude setup inside the loop from the timing and allocation counts
+	void pause();
+	void resume();
+
+	// Work items per iteration (e.g. entities); per-op figures divide by
+	// iterations * items
+	void setItemsPerIteration(size_t items) { m_items = items; }
+	// Mark the case as not runnable here; the runner records the reason
+	void skip(const std::string &reason) { m_skipReason = reason; }
+
+	size_t getIterations() const { return m_iterations; }
+	size_t getItemsPerIteration() const { return m_items; }
+	const std::string &getSkipReason() const { return m_skipReason; }
+	double getSeconds() const;
+	uint64_t getAllocations() const { return m_allocations; }
+	uint64_t getAllocatedBytes() const { return m_bytes; }
+
+  private:
+	using Clock = std::chrono::steady_clock;
+
+	void start();
+	void stop();
+
+	size_t m_iterations;
+	size_t m_done = 0;
+	size_t m_items = 1;
+	bool m_running = false;
+	Clock::time_point m_start;
+	Clock::duration m_elapsed{0};
+	uint64_t m_allocStart = 0;
+	uint64_t m_bytesStart = 0;
+	uint64_t m_allocations = 0;
+	uint64_t m_bytes = 0;
+	std::string m_skipReason;
+};
+
+using Function = std::function<void(State &)>;
+
+struct Case {
+	std::string name;
+	Function function;
+};
+
+// Cases register themselves during static initialization
+std::vector<Case> &registry();
+bool registerCase(const std::string &name, Function function);
+
+// Process-wide allocation counters fed by the operator new replacement
+uint64_t allocationCount();
+uint64_t allocatedBytes();
+
+// Keep the optimizer from discarding a computed value
+template <typename T> inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void *sink;
+	sink = &value;
+#endif
+}
+
+} // namespace bench
+} // namespace blot
+
+#define BLOT_BENCH_CONCAT_(a, b) a##b
+#define BLOT_BENCH_CONCAT(a, b) BLOT_BENCH_CONCAT_(a, b)
+
+// BLOT_BENCH(functionName, "group/case") { while (state.next()) { ... } }
+#define BLOT_BENCH(function, name)                                             \
+	static void function(::blot::bench::State &state);                         \
+	static const bool BLOT_BENCH_CONCAT(function, Registered) =                \
+		::blot::bench::registerCase(name, function);                           \
+	static void function(::blot::bench::State &state)
@@ -0,0 +1,48 @@
+#pragma once
+
+// Scene helpers shared by the cases.
+
+#include <random>
+
+#include "ecs/MEcs.h"
+#include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CShape.h"
+#include "ecs/components/CTransform.h"
+
+namespace blot {
+namespace bench {
+
+inline entt::entity addShape(MEcs &ecs, ecs::CShape::Type type, float x,
+							 float y, float width, float height) {
+	entt::entity entity = ecs.createEntity();
+	ecs.addComponent<ecs::CTransform>(entity);
+	ecs::CShape shape;
+	shape.type = type;
+	shape.x1 = x;
+	shape.y1 = y;
+	shape.x2 = x + width;
+	shape.y2 = y + height;
+	ecs.addComponent<ecs::CShape>(entity, shape);
+	ecs::CDrawStyle style;
+	style.setFillColor(0.8f, 0.3f, 0.2f, 0.9f);
+	style.setStrokeColor(0.1f, 0.1f, 0.1f);
+	ecs.addComponent<ecs::CDrawStyle>(entity, style);
+	return entity;
+}
+
+// `count` small shapes of every type spread over a width x height area
+inline void populateShapes(MEcs &ecs, size_t count, float width,
+						   float height, unsigned seed = 1) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> x(0.0f, width);
+	std::uniform_real_distribution<float> y(0.0f, height);
+	std::uniform_real_distribution<float> size(4.0f, 40.0f);
+	for (size_t i = 0; i < count; ++i) {
+		auto type = static_cast<ecs::CShape::Type>(i % 5);
+		addShape(ecs, type, x(rng), y(rng), size(rng), size(rng));
+	}
+	ecs.updateRenderProxies();
+}
+
+} // namespace bench
+} // namespace blot
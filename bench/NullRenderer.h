@@ -0,0 +1,90 @@
+#pragma once
+
+// Renderer that accepts every call and draws nothing, so shape submission
+// can be timed without a backend's rasterization cost.
+
+#include "rendering/IRenderer.h"
+
+namespace blot {
+namespace bench {
+
+class NullRenderer : public IRenderer {
+  public:
+	bool initialize(int width, int height) override {
+		m_width = width;
+		m_height = height;
+		return true;
+	}
+	void shutdown() override {}
+	void resize(int width, int height) override {
+		m_width = width;
+		m_height = height;
+	}
+
+	void beginFrame() override {}
+	void endFrame() override {}
+	void clear(const glm::vec4 &) override {}
+
+	void drawLine(float, float, float, float) override { ++m_calls; }
+	void drawRect(float, float, float, float) override { ++m_calls; }
+	void drawCircle(float, float, float) override { ++m_calls; }
+	void drawEllipse(float, float, float, float) override { ++m_calls; }
+	void drawTriangle(float, float, float, float, float, float) override {
+		++m_calls;
+	}
+	void drawPolygon(const std::vector<glm::vec2> &) override { ++m_calls; }
+
+	void beginPath() override {}
+	void moveTo(float, float) override {}
+	void lineTo(float, float) override {}
+	void curveTo(float, float, float, float, float, float) override {}
+	void closePath() override {}
+	void fill(const glm::vec4 &) override { ++m_calls; }
+	void stroke(const glm::vec4 &, float) override { ++m_calls; }
+
+	void setFont(const std::string &, float) override {}
+	void drawText(const std::string &, float, float,
+				  const glm::vec4 &) override {
+		++m_calls;
+	}
+	glm::vec2 getTextBounds(const std::string &) override { return {}; }
+
+	void pushMatrix() override {}
+	void popMatrix() override {}
+	void translate(float, float) override {}
+	void rotate(float) override {}
+	void scale(float, float) override {}
+	void resetMatrix() override {}
+
+	void setFillColor(const glm::vec4 &) override {}
+	void setStrokeColor(const glm::vec4 &) override {}
+	void setStrokeWidth(float) override {}
+
+	void setLinearGradient(float, float, float, float,
+						   const std::vector<GradientStop> &) override {}
+	void setRadialGradient(float, float, float,
+						   const std::vector<GradientStop> &) override {}
+	void setConicGradient(float, float, float,
+						  const std::vector<GradientStop> &) override {}
+	void clearGradient() override {}
+
+	bool saveToFile(const std::string &) override { return false; }
+	bool saveToMemory(std::vector<uint8_t> &) override { return false; }
+
+	RendererType getType() const override { return RendererType::OpenGL; }
+	std::string getName() const override { return "Null"; }
+	bool isInitialized() const override { return true; }
+	int getWidth() const override { return m_width; }
+	int getHeight() const override { return m_height; }
+	uint8_t *getPixelBuffer() override { return nullptr; }
+
+	size_t getCallCount() const { return m_calls; }
+
+  private:
+	int m_width = 0;
+	int m_height = 0;
+	size_t m_calls = 0;
+};
+
+} // namespace bench
+} // namespace blot
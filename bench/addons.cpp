@@ -0,0 +1,50 @@
+// Per-frame addon dispatch through MAddon.
+
+#include "Bench.h"
+#include "core/addon/IAddon.h"
+#include "core/addon/MAddon.h"
+
+using namespace blot;
+
+namespace {
+
+class BenchAddon : public IAddon {
+  public:
+	explicit BenchAddon(const std::string &name) : IAddon(name) {}
+	void update(float deltaTime) override { m_accumulated += deltaTime; }
+	void draw() override { ++m_draws; }
+
+  private:
+	float m_accumulated = 0.0f;
+	size_t m_draws = 0;
+};
+
+constexpr size_t kAddons = 16;
+
+void addAddons(MAddon &addons) {
+	for (size_t i = 0; i < kAddons; ++i) {
+		addons.registerAddon(
+			std::make_shared<BenchAddon>("bench" + std::to_string(i)));
+	}
+	addons.initAll();
+}
+
+} // namespace
+
+BLOT_BENCH(addonsUpdateAll, "addons/update_all") {
+	MAddon addons(nullptr);
+	addAddons(addons);
+	state.setItemsPerIteration(kAddons);
+	while (state.next()) {
+		addons.updateAll(1.0f / 60.0f);
+	}
+}
+
+BLOT_BENCH(addonsDrawAll, "addons/draw_all") {
+	MAddon addons(nullptr);
+	addAddons(addons);
+	state.setItemsPerIteration(kAddons);
+	while (state.next()) {
+		addons.drawAll();
+	}
+}
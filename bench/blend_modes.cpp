@@ -0,0 +1,56 @@
+// Every blend mode's span kernel, SIMD and scalar, on a canvas-sized
+// buffer. One op is one pixel.
+
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "rendering/BlendKernels.h"
+
+using namespace blot;
+
+namespace {
+
+using Kernel = void (*)(BlendMode, const uint8_t *, const uint8_t *,
+						uint8_t *, size_t, float);
+
+constexpr size_t kPixels = 1920 * 1080;
+
+// Fill with valid premultiplied pixels (color <= alpha)
+void fillPremultiplied(std::vector<uint8_t> &pixels, std::mt19937 &rng) {
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		uint8_t alpha = static_cast<uint8_t>(rng() % 256);
+		for (size_t k = 0; k < 3; ++k) {
+			pixels[i + k] = static_cast<uint8_t>(rng() % (alpha + 1u));
+		}
+		pixels[i + 3] = alpha;
+	}
+}
+
+void blendCase(bench::State &state, Kernel kernel, BlendMode mode) {
+	std::mt19937 rng(42);
+	std::vector<uint8_t> src(kPixels * 4), dst(kPixels * 4), out(kPixels * 4);
+	fillPremultiplied(src, rng);
+	fillPremultiplied(dst, rng);
+	state.setItemsPerIteration(kPixels);
+	while (state.next()) {
+		kernel(mode, src.data(), dst.data(), out.data(), kPixels, 1.0f);
+	}
+	bench::doNotOptimize(out[0]);
+}
+
+const bool registered = [] {
+	for (int m = 0; m < static_cast<int>(BlendMode::Count); ++m) {
+		BlendMode mode = static_cast<BlendMode>(m);
+		std::string name = std::string("blend/") + getBlendModeName(mode);
+		bench::registerCase(name + "/simd", [mode](bench::State &state) {
+			blendCase(state, blendSpan, mode);
+		});
+		bench::registerCase(name + "/scalar", [mode](bench::State &state) {
+			blendCase(state, blendSpanScalar, mode);
+		});
+	}
+	return true;
+}();
+
+} // namespace
@@ -0,0 +1,230 @@
+// Entity lifetime and system updates through MEcs.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchScene.h"
+#include "core/util/ThreadPool.h"
+#include "ecs/components/CParameter.h"
+
+using namespace blot;
+
+namespace {
+
+constexpr size_t kEntities = 1000;
+
+} // namespace
+
+BLOT_BENCH(ecsCreateDestroy, "ecs/create_destroy") {
+	MEcs ecs;
+	std::vector<entt::entity> entities(kEntities);
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		for (entt::entity &entity : entities) {
+			entity = ecs.createEntity();
+		}
+		for (auto it = entities.rbegin(); it != entities.rend(); ++it) {
+			ecs.destroyEntity(*it);
+		}
+	}
+}
+
+BLOT_BENCH(ecsCreateDestroyNamed, "ecs/create_destroy_named") {
+	MEcs ecs;
+	std::vector<std::string> names;
+	for (size_t i = 0; i < kEntities; ++i) {
+		names.push_back("entity" + std::to_string(i));
+	}
+	std::vector<entt::entity> entities(kEntities);
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		for (size_t i = 0; i < kEntities; ++i) {
+			entities[i] = ecs.createEntity(names[i]);
+		}
+		// Oldest first, the order a scene teardown usually goes in
+		for (entt::entity entity : entities) {
+			ecs.destroyEntity(entity);
+		}
+	}
+}
+
+BLOT_BENCH(ecsDestroyBatch, "ecs/destroy_entities") {
+	MEcs ecs;
+	std::vector<entt::entity> entities(kEntities);
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		for (entt::entity &entity : entities) {
+			entity = ecs.createEntity();
+		}
+		ecs.destroyEntities(entities);
+	}
+}
+
+BLOT_BENCH(ecsCreateShapes, "ecs/create_destroy_rectangles") {
+	MEcs ecs;
+	std::vector<entt::entity> entities(kEntities);
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		for (size_t i = 0; i < kEntities; ++i) {
+			float offset = static_cast<float>(i % 100) * 10.0f;
+			entities[i] = bench::addShape(ecs, ecs::CShape::Type::Rectangle,
+										  offset, offset, 8.0f, 8.0f);
+		}
+		for (auto it = entities.rbegin(); it != entities.rend(); ++it) {
+			ecs.destroyEntity(*it);
+		}
+	}
+}
+
+// Same scene as ecs/create_destroy_rectangles, stamped from a prefab
+BLOT_BENCH(ecsInstantiatePrefab, "ecs/instantiate_destroy_rectangles") {
+	MEcs ecs;
+	ecs::CShape shape;
+	shape.x2 = 8.0f;
+	shape.y2 = 8.0f;
+	ecs::CDrawStyle style;
+	style.setFillColor(0.8f, 0.3f, 0.2f, 0.9f);
+	style.setStrokeColor(0.1f, 0.1f, 0.1f);
+	Prefab rectangle;
+	rectangle.with(ecs::CTransform{}).with(shape).with(style);
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		std::vector<entt::entity> entities = ecs.instantiate(
+			rectangle, kEntities, [&](size_t i, entt::entity entity) {
+				float offset = static_cast<float>(i % 100) * 10.0f;
+				ecs.getComponent<ecs::CTransform>(entity).position =
+					glm::vec3(offset, offset, 0.0f);
+			});
+		ecs.destroyEntities(entities);
+	}
+}
+
+BLOT_BENCH(ecsPatchTransform, "ecs/patch_transform") {
+	MEcs ecs;
+	std::vector<entt::entity> entities;
+	for (size_t i = 0; i < kEntities; ++i) {
+		entities.push_back(bench::addShape(
+			ecs, ecs::CShape::Type::Rectangle, 0.0f, 0.0f, 8.0f, 8.0f));
+	}
+	ecs.updateRenderProxies();
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		for (entt::entity entity : entities) {
+			ecs.patchComponent<ecs::CTransform>(
+				entity, [](ecs::CTransform &t) { t.position.x += 1.0f; });
+		}
+		ecs.updateRenderProxies();
+	}
+}
+
+namespace {
+
+// Every shape moved, as when they all animate: the proxies are rebuilt
+// from the queue, or with a pool by walking the shapes in parallel
+void rebuildAllProxies(bench::State &state, ThreadPool *pool) {
+	constexpr size_t kCount = 64 * kEntities;
+	MEcs ecs;
+	ecs.setThreadPool(pool);
+	std::vector<entt::entity> entities;
+	for (size_t i = 0; i < kCount; ++i) {
+		entities.push_back(bench::addShape(
+			ecs, ecs::CShape::Type::Rectangle, 0.0f, 0.0f, 8.0f, 8.0f));
+	}
+	ecs.updateRenderProxies();
+	state.setItemsPerIteration(kCount);
+	while (state.next()) {
+		state.pause();
+		for (entt::entity entity : entities) {
+			ecs.getComponent<ecs::CTransform>(entity).position.x += 1.0f;
+			ecs.markShapeDirty(entity);
+		}
+		state.resume();
+		ecs.updateRenderProxies();
+	}
+}
+
+} // namespace
+
+BLOT_BENCH(ecsRebuildProxies, "ecs/rebuild_proxies") {
+	rebuildAllProxies(state, nullptr);
+}
+
+BLOT_BENCH(ecsRebuildProxiesPool, "ecs/rebuild_proxies_pool") {
+	ThreadPool pool;
+	rebuildAllProxies(state, &pool);
+}
+
+// The built-in systems over animated shapes and parameters, scheduled on a
+// thread pool
+BLOT_BENCH(ecsUpdateSystems, "ecs/update_systems") {
+	MEcs ecs;
+	ThreadPool pool;
+	ecs.setThreadPool(&pool);
+	std::vector<ecs::Keyframe> keys = {{0.0f, 0.0f, ecs::Ease::EaseInOut},
+									   {1.0f, 100.0f}};
+	for (size_t i = 0; i < kEntities; ++i) {
+		entt::entity entity = bench::addShape(
+			ecs, ecs::CShape::Type::Rectangle, 0.0f, 0.0f, 8.0f, 8.0f);
+		ecs.getAnimations().addTrack(entity, ecs::AnimProperty::PositionX,
+									 keys, true);
+		ecs.addComponent(entity, ecs::CParameter{});
+	}
+	ecs.updateRenderProxies();
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		ecs.updateSystems(nullptr, 1.0f / 60.0f);
+		ecs.updateRenderProxies();
+	}
+}
+
+// Connected parameters in chains of eight, one root in eight changing per
+// update
+BLOT_BENCH(ecsParameterGraph, "ecs/parameter_graph") {
+	constexpr size_t kDepth = 8;
+	MEcs ecs;
+	std::vector<entt::entity> roots;
+	entt::entity previous = entt::null;
+	for (size_t i = 0; i < kEntities; ++i) {
+		entt::entity entity = ecs.createEntity();
+		ecs.addComponent(entity, ecs::CParameter{});
+		if (i % kDepth == 0) {
+			roots.push_back(entity);
+		} else {
+			ecs.connectParameters(previous, "", entity, "");
+		}
+		previous = entity;
+	}
+	size_t frame = 0;
+	state.setItemsPerIteration(kEntities);
+	while (state.next()) {
+		for (size_t i = frame % kDepth; i < roots.size(); i += kDepth) {
+			ecs.getComponent<ecs::CParameter>(roots[i]).value += 1.0f;
+		}
+		++frame;
+		ecs.updateSystems(nullptr, 1.0f / 60.0f);
+	}
+}
+
+// Per-entity work split over the thread pool by MEcs::parallelEach()
+BLOT_BENCH(ecsParallelEach, "ecs/parallel_each") {
+	constexpr size_t kCount = 64 * kEntities;
+	MEcs ecs;
+	ThreadPool pool;
+	ecs.setThreadPool(&pool);
+	for (size_t i = 0; i < kCount; ++i) {
+		ecs.addComponent(ecs.createEntity(), ecs::CTransform{});
+	}
+	float time = 0.0f;
+	state.setItemsPerIteration(kCount);
+	while (state.next()) {
+		time += 1.0f / 60.0f;
+		ecs.parallelEach<ecs::CTransform>(
+			[time](entt::entity entity, ecs::CTransform &transform) {
+				float phase = static_cast<float>(entt::to_entity(entity));
+				transform.position.x = std::sin(time + phase) * 100.0f;
+				transform.position.y = std::cos(time + phase) * 100.0f;
+			});
+	}
+}
@@ -0,0 +1,48 @@
+// Event and action dispatch through SEvent.
+
+#include "Bench.h"
+#include "ecs/systems/SEvent.h"
+
+using namespace blot;
+
+BLOT_BENCH(eventsEmit, "events/emit") {
+	entt::registry registry;
+	ecs::SEvent events(registry);
+	size_t handled = 0;
+	events.registerEvent("bench.event",
+						 [&handled](const ecs::CEvent &) { ++handled; });
+	const std::string id = "bench.event";
+	while (state.next()) {
+		events.emitEvent(ecs::EET_EventType::Custom, id);
+	}
+	bench::doNotOptimize(handled);
+}
+
+BLOT_BENCH(eventsEmitListeners, "events/emit_with_listeners") {
+	// ECS listeners on top of the global handler
+	entt::registry registry;
+	ecs::SEvent events(registry);
+	size_t handled = 0;
+	for (int i = 0; i < 16; ++i) {
+		events.createListener("bench.event",
+							  [&handled](const ecs::CEvent &) { ++handled; });
+	}
+	const std::string id = "bench.event";
+	while (state.next()) {
+		events.emitEvent(ecs::EET_EventType::Custom, id);
+	}
+	bench::doNotOptimize(handled);
+}
+
+BLOT_BENCH(eventsTriggerAction, "events/trigger_action") {
+	entt::registry registry;
+	ecs::SEvent events(registry);
+	size_t triggered = 0;
+	events.registerAction("bench.action",
+						  std::function<void()>([&triggered] { ++triggered; }));
+	const std::string id = "bench.action";
+	while (state.next()) {
+		events.triggerAction(id);
+	}
+	bench::doNotOptimize(triggered);
+}
@@ -0,0 +1,49 @@
+// Node graphs compiled and evaluated by the SNodeGraph system.
+
+#include <string>
+
+#include "Bench.h"
+#include "BenchScene.h"
+#include "ecs/components/CNode.h"
+
+using namespace blot;
+
+namespace {
+
+void setProperty(MEcs &ecs, entt::entity node, const std::string &name,
+				 float value) {
+	ecs.getComponent<ecs::CNodeComponent>(node).properties[name] = value;
+}
+
+} // namespace
+
+// A 100 x 100 grid of circles whose radius waves along the cell index. One
+// property changes per update, so the kernel runs and writes every circle;
+// rebuilding the proxies is left out.
+BLOT_BENCH(nodesGridCircles, "nodes/grid_circles_10k") {
+	MEcs ecs;
+	entt::entity grid = ecs.createNode("grid", 0.0f, 0.0f);
+	entt::entity phase = ecs.createNode("multiply", 0.0f, 0.0f);
+	entt::entity wave = ecs.createNode("sin", 0.0f, 0.0f);
+	entt::entity radius = ecs.createNode("multiply", 0.0f, 0.0f);
+	entt::entity circle = ecs.createNode("circle", 0.0f, 0.0f);
+	setProperty(ecs, grid, "columns", 100.0f);
+	setProperty(ecs, grid, "rows", 100.0f);
+	setProperty(ecs, phase, "b", 0.1f);
+	setProperty(ecs, radius, "b", 8.0f);
+	ecs.connectNodes(grid, "x", circle, "x");
+	ecs.connectNodes(grid, "y", circle, "y");
+	ecs.connectNodes(grid, "index", phase, "a");
+	ecs.connectNodes(phase, "result", wave, "x");
+	ecs.connectNodes(wave, "result", radius, "a");
+	ecs.connectNodes(radius, "result", circle, "radius");
+	ecs.connectNodes(grid, "index", circle, "color");
+
+	float amplitude = 8.0f;
+	state.setItemsPerIteration(100 * 100);
+	while (state.next()) {
+		amplitude = amplitude == 8.0f ? 9.0f : 8.0f;
+		setProperty(ecs, radius, "b", amplitude);
+		ecs.updateSystems(nullptr, 1.0f / 60.0f);
+	}
+}
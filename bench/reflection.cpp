@@ -0,0 +1,39 @@
+// Property reflection as used by the inspector every frame.
+
+#include "Bench.h"
+#include "ecs/PropertyReflection.h"
+#include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CShape.h"
+#include "ecs/components/CTransform.h"
+
+using namespace blot;
+
+BLOT_BENCH(reflectionGetProperties, "reflection/get_properties") {
+	ecs::CTransform transform;
+	ecs::CShape shape;
+	ecs::CDrawStyle style;
+	state.setItemsPerIteration(3);
+	while (state.next()) {
+		auto a = TryGetProperties(transform);
+		auto b = TryGetProperties(shape);
+		auto c = TryGetProperties(style);
+		bench::doNotOptimize(a.size() + b.size() + c.size());
+	}
+}
+
+BLOT_BENCH(reflectionWriteFloats, "reflection/write_floats") {
+	// Editor-style write through the type-erased pointers
+	ecs::CTransform transform;
+	std::vector<sProp> properties = TryGetProperties(transform);
+	float value = 0.0f;
+	state.setItemsPerIteration(properties.size());
+	while (state.next()) {
+		value += 1.0f;
+		for (const sProp &property : properties) {
+			if (property.type == EPT_FLOAT) {
+				*static_cast<float *>(property.data) = value;
+			}
+		}
+	}
+	bench::doNotOptimize(transform.position.x);
+}
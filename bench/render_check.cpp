@@ -0,0 +1,602 @@
+// blot_render_check: golden-image and timing regression check for renderers.
+//
+// Usage: blot_render_check [--references dir] [--timings file.json]
+//                          [--filter text] [--threshold t]
+//                          [--max-mismatch fraction] [--time-tolerance f]
+//                          [--out-dir dir] [--update] [--record-timings]
+//
+// Every scene in the catalogue is drawn through every registered renderer
+// at a fixed size. The result is compared with references/<renderer>/
+// <scene>.pam, and the best render time with the timings baseline. The
+// exit status is non-zero if any image diverges or any scene slows down
+// past the tolerance. Renderers that cannot start here (no GPU context) or
+// have no CPU pixel buffer are reported as skipped.
+//
+// The software renderer is always registered, so the check runs headless.
+// Timings only mean something on the machine that recorded them, so the
+// baseline is not checked in: --record-timings writes it (by default to
+// <out-dir>/timings.json) and later runs on that machine compare against
+// it. Without one, times are reported but not checked. --update rewrites
+// the reference images after an intended rendering change.
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "BenchScene.h"
+#include "core/json.h"
+#include "ecs/systems/SShapeRendering.h"
+#include "rendering/PamImage.h"
+#include "rendering/RendererRegistry.h"
+
+#ifndef BLOT_RENDER_REFERENCES
+#define BLOT_RENDER_REFERENCES "bench/references"
+#endif
+
+using namespace blot;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kWidth = 128;
+constexpr int kHeight = 128;
+constexpr float kPi = 3.14159265358979f;
+
+struct Scene {
+	const char *name;
+	std::function<void(IRenderer &)> draw;
+};
+
+// ---------------------------------------------------------------------------
+// Scene catalogue. Each scene draws onto a cleared canvas; keep them small,
+// deterministic and focused on one feature so a failure points somewhere.
+
+void drawRects(IRenderer &r) {
+	r.setFillColor(glm::vec4(0.85f, 0.25f, 0.2f, 1.0f));
+	r.drawRect(8.0f, 8.0f, 48.0f, 32.0f);
+	r.setFillColor(glm::vec4(0.2f, 0.4f, 0.9f, 0.6f));
+	r.drawRect(32.5f, 24.5f, 56.0f, 40.0f);
+	r.setStrokeColor(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+	r.setStrokeWidth(3.0f);
+	r.drawRect(72.0f, 72.0f, 44.0f, 44.0f);
+	r.setStrokeWidth(1.0f);
+	r.drawRect(10.5f, 80.5f, 40.0f, 30.0f);
+}
+
+void drawEllipses(IRenderer &r) {
+	r.setFillColor(glm::vec4(0.95f, 0.7f, 0.1f, 1.0f));
+	r.drawCircle(40.0f, 40.0f, 30.0f);
+	r.setFillColor(glm::vec4(0.1f, 0.6f, 0.5f, 0.5f));
+	r.drawEllipse(76.0f, 56.0f, 44.0f, 20.0f);
+	r.setStrokeColor(glm::vec4(0.3f, 0.1f, 0.5f, 1.0f));
+	r.setStrokeWidth(4.0f);
+	r.drawEllipse(64.0f, 96.0f, 50.0f, 20.0f);
+	r.setFillColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	for (int i = 0; i < 8; ++i) {
+		r.drawCircle(12.0f + i * 14.0f, 8.0f, 0.5f + i * 0.5f);
+	}
+}
+
+void drawLines(IRenderer &r) {
+	r.setStrokeColor(glm::vec4(0.1f, 0.1f, 0.2f, 1.0f));
+	for (int i = 0; i < 12; ++i) {
+		float angle = i * kPi / 12.0f;
+		r.setStrokeWidth(0.5f + i * 0.5f);
+		r.drawLine(64.0f, 64.0f, 64.0f + 58.0f * std::cos(angle),
+				   64.0f + 58.0f * std::sin(angle));
+	}
+	r.setStrokeColor(glm::vec4(0.9f, 0.2f, 0.3f, 0.7f));
+	r.setStrokeWidth(1.0f);
+	for (int i = 0; i < 8; ++i) {
+		r.drawLine(4.0f, 4.0f + i * 6.0f, 124.0f, 10.0f + i * 6.0f);
+	}
+}
+
+void drawPaths(IRenderer &r) {
+	r.beginPath();
+	r.moveTo(16.0f, 64.0f);
+	r.curveTo(16.0f, 8.0f, 112.0f, 8.0f, 112.0f, 64.0f);
+	r.curveTo(112.0f, 96.0f, 64.0f, 72.0f, 16.0f, 64.0f);
+	r.closePath();
+	r.fill(glm::vec4(0.3f, 0.7f, 0.3f, 1.0f));
+	r.stroke(glm::vec4(0.0f, 0.2f, 0.0f, 1.0f), 2.0f);
+
+	// Sharp zig-zag to exercise miter joins and the miter limit
+	r.beginPath();
+	r.moveTo(8.0f, 120.0f);
+	for (int i = 1; i <= 6; ++i) {
+		r.lineTo(8.0f + i * 18.0f, i % 2 ? 92.0f : 120.0f);
+	}
+	r.stroke(glm::vec4(0.2f, 0.2f, 0.8f, 1.0f), 4.0f);
+
+	std::vector<glm::vec2> star;
+	for (int i = 0; i < 10; ++i) {
+		float angle = i * kPi / 5.0f - kPi / 2.0f;
+		float radius = i % 2 ? 8.0f : 20.0f;
+		star.emplace_back(100.0f + radius * std::cos(angle),
+						  28.0f + radius * std::sin(angle));
+	}
+	r.setFillColor(glm::vec4(0.9f, 0.5f, 0.0f, 0.8f));
+	r.drawPolygon(star);
+}
+
+void drawGradients(IRenderer &r) {
+	std::vector<GradientStop> stops = {
+		{0.0f, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f)},
+		{0.5f, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f)},
+		{1.0f, glm::vec4(0.0f, 0.0f, 1.0f, 0.5f)}};
+	r.setLinearGradient(4.0f, 0.0f, 124.0f, 0.0f, stops);
+	r.drawRect(4.0f, 4.0f, 120.0f, 36.0f);
+	r.setRadialGradient(34.0f, 84.0f, 30.0f, stops);
+	r.drawCircle(34.0f, 84.0f, 30.0f);
+	r.setConicGradient(94.0f, 84.0f, 0.0f, stops);
+	r.drawCircle(94.0f, 84.0f, 30.0f);
+	r.clearGradient();
+}
+
+void drawTransforms(IRenderer &r) {
+	r.translate(64.0f, 64.0f);
+	for (int i = 0; i < 6; ++i) {
+		r.pushMatrix();
+		r.rotate(i * kPi / 6.0f);
+		r.scale(1.0f, 0.5f + i * 0.1f);
+		r.setFillColor(glm::vec4(i / 6.0f, 0.3f, 1.0f - i / 6.0f, 0.4f));
+		r.drawRect(-50.0f, -10.0f, 100.0f, 20.0f);
+		r.popMatrix();
+	}
+	r.setStrokeColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	r.setStrokeWidth(2.0f);
+	r.drawCircle(0.0f, 0.0f, 12.0f);
+}
+
+// One cell per blend mode: a Normal backdrop, then three overlapping
+// circles in the mode, so each also blends with the circles before it
+void drawBlendModes(IRenderer &r) {
+	const glm::vec4 colors[] = {glm::vec4(0.9f, 0.2f, 0.2f, 0.8f),
+								glm::vec4(0.2f, 0.8f, 0.3f, 0.8f),
+								glm::vec4(0.2f, 0.3f, 0.9f, 0.8f)};
+	for (int m = 0; m < static_cast<int>(BlendMode::Count); ++m) {
+		float x = (m % 4) * 32.0f;
+		float y = (m / 4) * 32.0f;
+		r.setBlendMode(BlendMode::Normal);
+		r.setFillColor(glm::vec4(0.5f, 0.45f, 0.3f, 1.0f));
+		r.drawRect(x + 2.0f, y + 2.0f, 20.0f, 28.0f);
+		r.setBlendMode(static_cast<BlendMode>(m));
+		for (int i = 0; i < 3; ++i) {
+			float angle = i * 2.0f * kPi / 3.0f;
+			r.setFillColor(colors[i]);
+			r.drawCircle(x + 16.0f + 5.0f * std::cos(angle),
+						 y + 16.0f + 5.0f * std::sin(angle), 9.0f);
+		}
+	}
+	r.setBlendMode(BlendMode::Normal);
+}
+
+// Shapes from the ECS through SShapeRendering, as an app would draw them
+void drawEcsShapes(IRenderer &r) {
+	static MEcs scene;
+	static bool populated = [] {
+		for (int i = 0; i < 36; ++i) {
+			auto type = static_cast<ecs::CShape::Type>(i % 5);
+			float x = 6.0f + (i % 6) * 20.0f;
+			float y = 6.0f + (i / 6) * 20.0f;
+			bench::addShape(scene, type, x, y, 16.0f, 14.0f);
+		}
+		scene.updateRenderProxies();
+		return true;
+	}();
+	(void)populated;
+	ecs::SShapeRendering(scene, r);
+}
+
+const std::vector<Scene> &scenes() {
+	static const std::vector<Scene> catalogue = {
+		{"rects", drawRects},			 {"ellipses", drawEllipses},
+		{"lines", drawLines},			 {"paths", drawPaths},
+		{"gradients", drawGradients},	 {"transforms", drawTransforms},
+		{"blend_modes", drawBlendModes}, {"ecs_shapes", drawEcsShapes}};
+	return catalogue;
+}
+
+// ---------------------------------------------------------------------------
+
+struct Options {
+	std::string references = BLOT_RENDER_REFERENCES;
+	std::string timings;
+	std::string filter;
+	std::string outDir = "render_check";
+	float threshold = 0.1f;	   // Per-pixel perceptual tolerance, 0-1
+	float maxMismatch = 0.001f; // Fraction of pixels allowed to differ
+	double timeTolerance = 0.5; // Allowed slowdown over the baseline
+	double timeSlackUs = 50.0;	// Ignore regressions smaller than this
+	bool update = false;
+	bool recordTimings = false;
+};
+
+bool parseOptions(int argc, char **argv, Options &options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--references" && hasValue) {
+			options.references = argv[++i];
+		} else if (arg == "--timings" && hasValue) {
+			options.timings = argv[++i];
+		} else if (arg == "--filter" && hasValue) {
+			options.filter = argv[++i];
+		} else if (arg == "--out-dir" && hasValue) {
+			options.outDir = argv[++i];
+		} else if (arg == "--threshold" && hasValue) {
+			options.threshold = static_cast<float>(std::atof(argv[++i]));
+		} else if (arg == "--max-mismatch" && hasValue) {
+			options.maxMismatch = static_cast<float>(std::atof(argv[++i]));
+		} else if (arg == "--time-tolerance" && hasValue) {
+			options.timeTolerance = std::atof(argv[++i]);
+		} else if (arg == "--update") {
+			options.update = true;
+		} else if (arg == "--record-timings") {
+			options.recordTimings = true;
+		} else {
+			return false;
+		}
+	}
+	if (options.timings.empty()) {
+		options.timings = options.outDir + "/timings.json";
+	}
+	return true;
+}
+
+std::string toLower(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(),
+				   [](unsigned char c) { return std::tolower(c); });
+	return text;
+}
+
+// Premultiplied pixel composited over white, then to YIQ, so differences in
+// fully transparent color do not count and luma weighs more than chroma
+glm::vec3 toYiq(const uint8_t *pixel) {
+	float white = 255.0f - pixel[3];
+	float r = pixel[0] + white;
+	float g = pixel[1] + white;
+	float b = pixel[2] + white;
+	return glm::vec3(0.29889531f * r + 0.58662247f * g + 0.11448223f * b,
+					 0.59597799f * r - 0.27417610f * g - 0.32180189f * b,
+					 0.21147017f * r - 0.52261711f * g + 0.31114694f * b);
+}
+
+float colorDelta(const uint8_t *a, const uint8_t *b) {
+	glm::vec3 d = toYiq(a) - toYiq(b);
+	return 0.5053f * d.x * d.x + 0.299f * d.y * d.y + 0.1957f * d.z * d.z;
+}
+
+const uint8_t *pixelAt(const uint8_t *image, int width, int x, int y) {
+	return image + (static_cast<size_t>(y) * width + x) * 4;
+}
+
+bool samePixel(const uint8_t *a, const uint8_t *b) {
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+// True if more than two neighbours of (x, y) equal it, i.e. it sits in a
+// flat area rather than on an edge
+bool hasManySiblings(const uint8_t *image, int x, int y, int width,
+					 int height) {
+	const uint8_t *center = pixelAt(image, width, x, y);
+	int same = (x == 0 || y == 0 || x == width - 1 || y == height - 1);
+	for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1);
+		 ++ny) {
+		for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1);
+			 ++nx) {
+			if ((nx != x || ny != y) &&
+				samePixel(center, pixelAt(image, width, nx, ny)) &&
+				++same > 2) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Antialiasing test from pixelmatch: the pixel has both a darker and a
+// brighter neighbour, few equal ones, and the darkest or brightest
+// neighbour lies in a flat area of both images
+bool isAntialiased(const uint8_t *image, const uint8_t *other, int x, int y,
+				   int width, int height) {
+	float center = toYiq(pixelAt(image, width, x, y)).x;
+	int zeroes = (x == 0 || y == 0 || x == width - 1 || y == height - 1);
+	float darkest = 0.0f;
+	float brightest = 0.0f;
+	int minX = 0, minY = 0, maxX = 0, maxY = 0;
+	for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1);
+		 ++ny) {
+		for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1);
+			 ++nx) {
+			if (nx == x && ny == y) {
+				continue;
+			}
+			float delta = toYiq(pixelAt(image, width, nx, ny)).x - center;
+			if (delta == 0.0f) {
+				if (++zeroes > 2) {
+					return false;
+				}
+			} else if (delta < darkest) {
+				darkest = delta;
+				minX = nx;
+				minY = ny;
+			} else if (delta > brightest) {
+				brightest = delta;
+				maxX = nx;
+				maxY = ny;
+			}
+		}
+	}
+	if (darkest == 0.0f || brightest == 0.0f) {
+		return false;
+	}
+	return (hasManySiblings(image, minX, minY, width, height) &&
+			hasManySiblings(other, minX, minY, width, height)) ||
+		   (hasManySiblings(image, maxX, maxY, width, height) &&
+			hasManySiblings(other, maxX, maxY, width, height));
+}
+
+struct Comparison {
+	size_t mismatched = 0;
+	std::vector<uint8_t> diff; // Straight RGBA visualisation
+};
+
+// Pixelmatch-style comparison of two premultiplied images. Pixels beyond
+// the perceptual threshold count as different unless they look like
+// antialiasing in either image, so edges that shift slightly between
+// backends or compilers are tolerated.
+Comparison compareImages(const uint8_t *actual, const uint8_t *expected,
+						 int width, int height, float threshold) {
+	// 35215 is the largest possible YIQ delta
+	float maxDelta = 35215.0f * threshold * threshold;
+	Comparison result;
+	result.diff.resize(static_cast<size_t>(width) * height * 4);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			const uint8_t *a = pixelAt(actual, width, x, y);
+			const uint8_t *e = pixelAt(expected, width, x, y);
+			uint8_t *out = result.diff.data() + (a - actual);
+			out[3] = 255;
+			if (colorDelta(a, e) <= maxDelta) {
+				// Faded reference luma for context
+				uint8_t luma = static_cast<uint8_t>(
+					std::min(255.0f, 192.0f + toYiq(e).x / 4));
+				out[0] = out[1] = out[2] = luma;
+			} else if (isAntialiased(actual, expected, x, y, width, height) ||
+					   isAntialiased(expected, actual, x, y, width, height)) {
+				out[0] = 255;
+				out[1] = 255;
+				out[2] = 0;
+			} else {
+				++result.mismatched;
+				out[0] = 255;
+				out[1] = 0;
+				out[2] = 0;
+			}
+		}
+	}
+	return result;
+}
+
+// Time of one render in microseconds, the fastest of several batches so
+// scheduler noise does not read as a regression
+double timeScene(IRenderer &renderer, const Scene &scene) {
+	using Clock = std::chrono::steady_clock;
+	auto renderOnce = [&] {
+		renderer.beginFrame();
+		renderer.clear(glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
+		scene.draw(renderer);
+		renderer.endFrame();
+	};
+	// Batch renders so one sample is long enough to time reliably
+	int batch = 1;
+	for (;;) {
+		auto start = Clock::now();
+		for (int i = 0; i < batch; ++i) {
+			renderOnce();
+		}
+		double seconds =
+			std::chrono::duration<double>(Clock::now() - start).count();
+		if (seconds >= 0.005 || batch >= (1 << 16)) {
+			break;
+		}
+		batch *= 2;
+	}
+	std::vector<double> samples;
+	for (int sample = 0; sample < 7; ++sample) {
+		auto start = Clock::now();
+		for (int i = 0; i < batch; ++i) {
+			renderOnce();
+		}
+		std::chrono::duration<double, std::micro> elapsed =
+			Clock::now() - start;
+		samples.push_back(elapsed.count() / batch);
+	}
+	return *std::min_element(samples.begin(), samples.end());
+}
+
+json loadJson(const std::string &path) {
+	std::ifstream file(path);
+	if (!file) {
+		return json();
+	}
+	return json::parse(file, nullptr, false);
+}
+
+bool saveJson(const std::string &path, const json &value) {
+	std::ofstream file(path, std::ios::trunc);
+	file << value.dump(2) << std::endl;
+	return static_cast<bool>(file);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		std::fprintf(stderr,
+					 "usage: %s [--references dir] [--timings file.json] "
+					 "[--filter text] [--threshold t] [--max-mismatch f] "
+					 "[--time-tolerance f] [--out-dir dir] [--update] "
+					 "[--record-timings]\n",
+					 argv[0]);
+		return 2;
+	}
+	spdlog::set_level(spdlog::level::warn);
+#ifndef NDEBUG
+	std::fprintf(stderr, "warning: debug build, timings are not meaningful\n");
+#endif
+
+	json baseline = loadJson(options.timings);
+	bool checkTimings = !options.recordTimings && baseline.is_object() &&
+						baseline.contains("scenes");
+	if (!checkTimings && !options.recordTimings) {
+		std::fprintf(stderr,
+					 "no timings baseline at %s; times are not checked\n",
+					 options.timings.c_str());
+	}
+	json recorded = {{"format", 1}, {"scenes", json::object()}};
+
+	int failures = 0;
+	std::printf("%-28s %-8s %10s %10s  %s\n", "scene", "result", "us",
+				"baseline", "detail");
+	RendererRegistry &registry = RendererRegistry::instance();
+	for (RendererType type : registry.getRegisteredTypes()) {
+		std::shared_ptr<IRenderer> renderer = registry.create(type);
+		if (!renderer) {
+			continue;
+		}
+		std::string rendererName = toLower(renderer->getName());
+		if (!renderer->initialize(kWidth, kHeight)) {
+			std::printf("%-28s %-8s %10s %10s  %s\n", rendererName.c_str(),
+						"skipped", "", "", "backend failed to initialize");
+			continue;
+		}
+		if (!renderer->getPixelBuffer()) {
+			std::printf("%-28s %-8s %10s %10s  %s\n", rendererName.c_str(),
+						"skipped", "", "", "no CPU pixel buffer");
+			renderer->shutdown();
+			continue;
+		}
+
+		fs::path referenceDir = fs::path(options.references) / rendererName;
+		fs::path outDir = fs::path(options.outDir) / rendererName;
+		for (const Scene &scene : scenes()) {
+			std::string name = rendererName + "/" + scene.name;
+			if (!options.filter.empty() &&
+				name.find(options.filter) == std::string::npos) {
+				continue;
+			}
+			double micros = timeScene(*renderer, scene);
+			recorded["scenes"][name] = micros;
+
+			const uint8_t *pixels = renderer->getPixelBuffer();
+			size_t count = static_cast<size_t>(kWidth) * kHeight;
+			std::vector<uint8_t> straight(count * 4);
+			unpremultiplyRgba(pixels, straight.data(), count);
+			fs::path reference = referenceDir / (scene.name + std::string(
+														 ".pam"));
+
+			std::string result = "ok";
+			std::string detail;
+			if (options.update) {
+				fs::create_directories(referenceDir);
+				if (!writePam(reference.string(), straight.data(), kWidth,
+							  kHeight)) {
+					result = "FAIL";
+					detail = "could not write " + reference.string();
+				} else {
+					detail = "reference updated";
+				}
+			} else {
+				std::vector<uint8_t> expected;
+				int width = 0;
+				int height = 0;
+				if (!readPam(reference.string(), expected, width, height)) {
+					result = "FAIL";
+					detail = "no reference (run with --update)";
+				} else if (width != kWidth || height != kHeight) {
+					result = "FAIL";
+					detail = "reference size differs";
+				} else {
+					premultiplyRgba(expected.data(), expected.data(), count);
+					Comparison comparison = compareImages(
+						pixels, expected.data(), kWidth, kHeight,
+						options.threshold);
+					float fraction =
+						static_cast<float>(comparison.mismatched) / count;
+					if (fraction > options.maxMismatch) {
+						result = "FAIL";
+						detail = std::to_string(comparison.mismatched) +
+								 " pixels differ";
+						fs::create_directories(outDir);
+						std::string stem = (outDir / scene.name).string();
+						writePam(stem + ".actual.pam", straight.data(),
+								 kWidth, kHeight);
+						writePam(stem + ".diff.pam", comparison.diff.data(),
+								 kWidth, kHeight);
+						detail += ", see " + stem + ".diff.pam";
+					}
+				}
+			}
+
+			std::string baselineText;
+			if (checkTimings && baseline["scenes"].contains(name)) {
+				double expected = baseline["scenes"][name].get<double>();
+				baselineText = std::to_string(
+					static_cast<int>(std::lround(expected)));
+				double allowed = expected * (1.0 + options.timeTolerance);
+				if (micros > allowed &&
+					micros - expected > options.timeSlackUs) {
+					result = "FAIL";
+					if (!detail.empty()) {
+						detail += "; ";
+					}
+					detail += "slower than baseline by " +
+							  std::to_string(static_cast<int>(
+								  std::lround((micros / expected - 1) * 100))) +
+							  "%";
+				}
+			}
+			if (result == "FAIL") {
+				++failures;
+			}
+			std::printf("%-28s %-8s %10.1f %10s  %s\n", name.c_str(),
+						result.c_str(), micros, baselineText.c_str(),
+						detail.c_str());
+		}
+		renderer->shutdown();
+	}
+
+	if (options.recordTimings) {
+		fs::path timingsDir = fs::path(options.timings).parent_path();
+		if (!timingsDir.empty()) {
+			fs::create_directories(timingsDir);
+		}
+		if (!saveJson(options.timings, recorded)) {
+			std::fprintf(stderr, "could not write %s\n",
+						 options.timings.c_str());
+			return 1;
+		}
+		std::fprintf(stderr, "timings written to %s\n",
+					 options.timings.c_str());
+	}
+	if (failures > 0) {
+		std::fprintf(stderr, "%d scene(s) failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
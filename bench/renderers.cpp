@@ -0,0 +1,57 @@
+// The same shape scene through every registered renderer backend.
+// GPU and library backends come from addons; a build that links none
+// reports them as skipped, as does one whose backend needs a context it
+// cannot get here. The software renderer is always available.
+
+#include <string>
+
+#include "Bench.h"
+#include "BenchScene.h"
+#include "ecs/systems/SShapeRendering.h"
+#include "rendering/RendererRegistry.h"
+
+using namespace blot;
+
+namespace {
+
+constexpr size_t kShapes = 2000;
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+
+void drawScene(bench::State &state, RendererType type) {
+	std::shared_ptr<IRenderer> renderer =
+		RendererRegistry::instance().create(type);
+	if (!renderer) {
+		state.skip("backend not registered");
+		return;
+	}
+	if (!renderer->initialize(kWidth, kHeight)) {
+		state.skip("backend failed to initialize");
+		return;
+	}
+	MEcs ecs;
+	bench::populateShapes(ecs, kShapes, static_cast<float>(kWidth),
+						  static_cast<float>(kHeight));
+	state.setItemsPerIteration(kShapes);
+	while (state.next()) {
+		renderer->beginFrame();
+		renderer->clear(glm::vec4(1.0f));
+		ecs::SShapeRendering(ecs, *renderer);
+		renderer->endFrame();
+	}
+	renderer->shutdown();
+}
+
+} // namespace
+
+BLOT_BENCH(renderersOpenGL, "renderers/opengl") {
+	drawScene(state, RendererType::OpenGL);
+}
+
+BLOT_BENCH(renderersBlend2D, "renderers/blend2d") {
+	drawScene(state, RendererType::Blend2D);
+}
+
+BLOT_BENCH(renderersSoftware, "renderers/software") {
+	drawScene(state, RendererType::Software);
+}
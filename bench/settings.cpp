@@ -0,0 +1,27 @@
+// JSON settings round trip: serialize, dump, parse and apply.
+
+#include <string>
+
+#include "Bench.h"
+#include "core/AppSettings.h"
+#include "core/json.h"
+
+using namespace blot;
+
+BLOT_BENCH(settingsAppRoundTrip, "settings/app_round_trip") {
+	AppSettings settings;
+	AppSettings loaded;
+	while (state.next()) {
+		std::string text = settings.getSettings().dump();
+		loaded.setSettings(json::parse(text));
+	}
+	bench::doNotOptimize(loaded.graphics.targetFps);
+}
+
+BLOT_BENCH(settingsParse, "settings/app_parse") {
+	std::string text = AppSettings().getSettings().dump(4);
+	while (state.next()) {
+		json parsed = json::parse(text);
+		bench::doNotOptimize(parsed.size());
+	}
+}
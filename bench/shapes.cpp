@@ -0,0 +1,38 @@
+// Shape submission through SShapeRendering into a renderer that draws
+// nothing, so only the system's own cost is measured.
+
+#include "Bench.h"
+#include "BenchScene.h"
+#include "NullRenderer.h"
+#include "ecs/systems/SShapeRendering.h"
+
+using namespace blot;
+
+namespace {
+
+constexpr size_t kShapes = 10000;
+
+void submitShapes(bench::State &state, const ecs::ShapeRenderView &view) {
+	MEcs ecs;
+	bench::populateShapes(ecs, kShapes, 1920.0f, 1080.0f);
+	bench::NullRenderer renderer;
+	renderer.initialize(1920, 1080);
+	state.setItemsPerIteration(kShapes);
+	while (state.next()) {
+		ecs::ShapeRenderStats stats = ecs::SShapeRendering(ecs, renderer, view);
+		bench::doNotOptimize(stats.submitted);
+	}
+}
+
+} // namespace
+
+BLOT_BENCH(shapesSubmit, "shapes/submit") {
+	submitShapes(state, ecs::ShapeRenderView());
+}
+
+BLOT_BENCH(shapesSubmitCulled, "shapes/submit_mostly_culled") {
+	// Zoomed in on one corner: most shapes are rejected by the cull
+	ecs::ShapeRenderView view;
+	view.zoom = 8.0f;
+	submitShapes(state, view);
+}
@@ -5,13 +5,36 @@
 #include "core/ISettings.h"
 #include "core/WindowSettings.h"
 #include "core/json.h"
+#include "core/util/AppPaths.h"
 
 namespace blot {
 
 struct GraphicsSettings {
 	bool vsync = true;
 	int targetFps = 60; // 0 = uncapped (but still limited by vsync)
+	std::string framePacing = "hybrid"; // "sleep", "hybrid" or "spin"
 	glm::vec4 clearColor{0.4f, 0.4f, 0.4f, 1.0f};
+	// Program binaries, "" = off
+	std::string shaderCache = AppPaths::getShaderCacheDir();
+	// Submit GL from a render thread so update of frame N+1 overlaps the
+	// submission of frame N, with at most one frame in flight. Update,
+	// draw(), addons and UI still run on the main thread, which no longer
+	// has the GL context: GL work goes through
+	// BlotEngine::submitRenderCommand(). The render thread only sees what
+	// was recorded: CPU canvas pixels, copies of the shapes GL canvases
+	// draw, and those commands. GL canvas post-process chains and renderers
+	// belong to the render thread.
+	bool renderThread = false;
+	// Frames submitted ahead of the render thread. Recorded frames hold
+	// their own copies, so more than one only adds latency for smoother
+	// frame times.
+	int frameQueueDepth = 1;
+};
+
+// Only builds with BLOT_ENABLE_PROFILER record zones
+struct ProfilerSettings {
+	int zonesPerThread = 65536; // Ring per recording thread, 24 bytes a zone
+	std::string traceOnExit;	// Chrome trace written at shutdown, "" = off
 };
 
 struct AppSettings : public ISettings {
@@ -20,7 +43,9 @@ struct AppSettings : public ISettings {
 
 	WindowSettings window; // default constructed (1280x720, etc.)
 	GraphicsSettings graphics;
+	ProfilerSettings profiler;
 	bool debugMode = false;
+	int workerThreads = 0; // Engine thread pool size, 0 = one per core
 
 	// ISettings implementation (JSON serialisation)
 	json getSettings() const override {
@@ -28,6 +53,7 @@ struct AppSettings : public ISettings {
 		j["appName"] = appName;
 		j["version"] = version;
 		j["debugMode"] = debugMode;
+		j["workerThreads"] = workerThreads;
 		// Window
 		j["window"]["width"] = window.width;
 		j["window"]["height"] = window.height;
@@ -36,9 +62,16 @@ struct AppSettings : public ISettings {
 		// Graphics
 		j["graphics"]["vsync"] = graphics.vsync;
 		j["graphics"]["targetFps"] = graphics.targetFps;
+		j["graphics"]["framePacing"] = graphics.framePacing;
 		j["graphics"]["clearColor"] = {
 			graphics.clearColor.r, graphics.clearColor.g, graphics.clearColor.b,
 			graphics.clearColor.a};
+		j["graphics"]["shaderCache"] = graphics.shaderCache;
+		j["graphics"]["renderThread"] = graphics.renderThread;
+		j["graphics"]["frameQueueDepth"] = graphics.frameQueueDepth;
+		// Profiler
+		j["profiler"]["zonesPerThread"] = profiler.zonesPerThread;
+		j["profiler"]["traceOnExit"] = profiler.traceOnExit;
 		return j;
 	}
 
@@ -49,6 +82,8 @@ struct AppSettings : public ISettings {
 			version = j["version"].get<float>();
 		if (j.contains("debugMode"))
 			debugMode = j["debugMode"].get<bool>();
+		if (j.contains("workerThreads"))
+			workerThreads = j["workerThreads"].get<int>();
 
 		if (j.contains("window")) {
 			const auto &w = j["window"];
@@ -68,6 +103,8 @@ struct AppSettings : public ISettings {
 				graphics.vsync = g["vsync"].get<bool>();
 			if (g.contains("targetFps"))
 				graphics.targetFps = g["targetFps"].get<int>();
+			if (g.contains("framePacing"))
+				graphics.framePacing = g["framePacing"].get<std::string>();
 			if (g.contains("clearColor")) {
 				auto c = g["clearColor"];
 				if (c.is_array() && c.size() == 4) {
@@ -76,6 +113,20 @@ struct AppSettings : public ISettings {
 								  c[2].get<float>(), c[3].get<float>());
 				}
 			}
+			if (g.contains("shaderCache"))
+				graphics.shaderCache = g["shaderCache"].get<std::string>();
+			if (g.contains("renderThread"))
+				graphics.renderThread = g["renderThread"].get<bool>();
+			if (g.contains("frameQueueDepth"))
+				graphics.frameQueueDepth = g["frameQueueDepth"].get<int>();
+		}
+
+		if (j.contains("profiler")) {
+			const auto &p = j["profiler"];
+			if (p.contains("zonesPerThread"))
+				profiler.zonesPerThread = p["zonesPerThread"].get<int>();
+			if (p.contains("traceOnExit"))
+				profiler.traceOnExit = p["traceOnExit"].get<std::string>();
 		}
 	}
 };
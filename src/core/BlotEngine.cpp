@@ -3,8 +3,9 @@
 #include "rendering/U_gladGlfw.h"
 
 #include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
 
-#include <chrono>
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
@@ -14,6 +15,12 @@
 #include "core/U_core.h"
 #include "core/addon/MAddon.h"
 #include "core/util/MSettings.h"
+#include "core/util/MemoryTracker.h"
+#include "core/util/Profiler.h"
+#include "core/util/FrameCommandQueue.h"
+#include "core/util/ThreadPool.h"
+#include "rendering/GlState.h"
+#include "rendering/ShaderRegistry.h"
 #include "rendering/U_rendering.h"
 
 namespace blot {
@@ -22,6 +29,8 @@ namespace blot {
 BlotEngine *BlotEngine::s_instance = nullptr;
 
 BlotEngine::~BlotEngine() {
+	// Only still running if run() was left by an exception
+	stopRenderThread();
 	// Clear global engine instance
 	s_instance = nullptr;
 }
@@ -33,6 +42,8 @@ BlotEngine::BlotEngine(std::unique_ptr<IApp> app)
 
 BlotEngine::BlotEngine(std::unique_ptr<IApp> app, const AppSettings &settings)
 	: m_settings(settings), m_app(std::move(app)),
+	  m_threadPool(std::make_unique<ThreadPool>(
+		  static_cast<size_t>(std::max(settings.workerThreads, 0)))),
 	  m_addonManager(std::make_unique<MAddon>(this)),
 	  m_ecsManager(std::make_unique<MEcs>()),
 	  m_renderingManager(std::make_unique<MRendering>()),
@@ -41,6 +52,9 @@ BlotEngine::BlotEngine(std::unique_ptr<IApp> app, const AppSettings &settings)
 
 	// Set global engine instance
 	s_instance = this;
+	m_ecsManager->setThreadPool(m_threadPool.get());
+	Profiler::instance().setZonesPerThread(
+		static_cast<size_t>(std::max(m_settings.profiler.zonesPerThread, 1)));
 	// Apply settings
 	WindowSettings ws = m_settings.window;
 	if (m_app) {
@@ -70,6 +84,8 @@ BlotEngine::BlotEngine(std::unique_ptr<IApp> app, const AppSettings &settings)
 		throw std::runtime_error("Failed to initialize GLAD (GLES2)");
 	}
 #endif
+	ShaderRegistry::instance().setCacheDirectory(
+		m_settings.graphics.shaderCache);
 
 	// Applications are now responsible for registering and initializing any
 	// addons they require via MAddon. The engine no longer loads default
@@ -80,7 +96,10 @@ BlotEngine::BlotEngine(std::unique_ptr<IApp> app, const AppSettings &settings)
 
 	// Apply graphics settings
 	setVerticalSync(m_settings.graphics.vsync);
+	m_pacer.setMode(
+		FramePacer::getModeFromString(m_settings.graphics.framePacing));
 	setTargetFrameRate(m_settings.graphics.targetFps);
+	setFrameQueueDepth(m_settings.graphics.frameQueueDepth);
 	setClearColor(
 		m_settings.graphics.clearColor.r, m_settings.graphics.clearColor.g,
 		m_settings.graphics.clearColor.b, m_settings.graphics.clearColor.a);
@@ -103,53 +122,138 @@ void BlotEngine::init(const std::string &appName, float appVersion) {
 }
 
 void BlotEngine::run() {
+	BLOT_PROFILE_THREAD("Main");
 
-	using clock = std::chrono::high_resolution_clock;
-	auto lastTime = clock::now();
+	if (m_settings.graphics.renderThread) {
+		startRenderThread();
+	}
 
 	while (!glfwWindowShouldClose(m_window)) {
-		auto frameStart = clock::now();
-		float deltaTime =
-			std::chrono::duration<float>(frameStart - lastTime).count();
-		if (deltaTime > 0.0f) {
-			m_currentFps = static_cast<int>(1.0f / deltaTime);
-		}
-		lastTime = frameStart;
+		BLOT_PROFILE_SCOPE("Frame");
+		float deltaTime = m_pacer.beginFrame();
+		m_currentFps = static_cast<int>(m_pacer.getSmoothedFps() + 0.5f);
 
 		++m_frameCount;
+		// UI backends and addons touch GL behind the state cache's back
+		submitRenderCommand([] { GlState::instance().beginFrame(); });
 		m_app->blotUpdate(deltaTime);
 
-		// Clear window with user-defined clear colour before custom drawing
-		glm::vec4 cc = m_clearColor;
-		glClearColor(cc.r, cc.g, cc.b, cc.a);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		m_app->blotDraw();
-		glfwSwapBuffers(m_window);
+		if (m_frameQueue) {
+			// CPU canvases rasterize here and GL canvases copy out the shapes
+			// they draw; the render thread only consumes what is recorded
+			m_canvasManager->recordAll(*m_frameQueue);
+			m_frameQueue->record(
+				[this, color = m_clearColor] { clearWindow(color); });
+			// App and addon code stays on this thread; GL work in draw()
+			// goes through submitRenderCommand()
+			m_app->blotDraw();
+			m_frameQueue->record([this] {
+				BLOT_PROFILE_SCOPE("SwapBuffers");
+				glfwSwapBuffers(m_window);
+			});
+			// Blocks only while the previous frame is still rendering
+			BLOT_PROFILE_SCOPE("WaitForRenderThread");
+			m_frameQueue->submitFrame();
+		} else {
+			// Redraw canvases whose contents changed during the update
+			m_canvasManager->renderAll();
+			clearWindow(m_clearColor);
+			m_app->blotDraw();
+			BLOT_PROFILE_SCOPE("SwapBuffers");
+			glfwSwapBuffers(m_window);
+		}
 		glfwPollEvents();
 
 		// Frame rate limiting (if VSync disabled or monitor faster than target)
-		if (m_targetFps > 0) {
-			float targetFrame = 1.0f / static_cast<float>(m_targetFps);
-			auto frameEnd = clock::now();
-			float frameDuration =
-				std::chrono::duration<float>(frameEnd - frameStart).count();
-			if (frameDuration < targetFrame) {
-				std::this_thread::sleep_for(
-					std::chrono::duration<float>(targetFrame - frameDuration));
-			}
-		}
+		BLOT_PROFILE_SCOPE("FramePacing");
+		m_pacer.waitForDeadline();
+	}
+	stopRenderThread();
+	if (!m_settings.profiler.traceOnExit.empty()) {
+#ifdef BLOT_ENABLE_PROFILER
+		Profiler::instance().writeChromeTrace(m_settings.profiler.traceOnExit);
+#else
+		spdlog::warn("[Profiler] traceOnExit is set but this build has no "
+					 "BLOT_ENABLE_PROFILER; no trace written");
+#endif
+	}
+	if (m_debugMode) {
+		// Totals and high-water marks for the session
+		MemoryTracker::instance().logSnapshot();
 	}
+	// Shared programs go while their context is still alive
+	ShaderRegistry::instance().clear();
 	glfwDestroyWindow(m_window);
 	glfwTerminate();
 }
 
+void BlotEngine::clearWindow(const glm::vec4 &color) {
+	// Clear window with user-defined clear colour before custom drawing
+	glClearColor(color.r, color.g, color.b, color.a);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// -------------------- Render thread ----------------------
+
+void BlotEngine::startRenderThread() {
+	// The next update overlaps the frames in flight; submitting one more
+	// waits for the oldest
+	m_frameQueue = std::make_unique<FrameCommandQueue>(
+		static_cast<size_t>(m_frameQueueDepth));
+	// A context is current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	m_renderThread = std::thread([this] {
+		BLOT_PROFILE_THREAD("Render");
+		glfwMakeContextCurrent(m_window);
+		while (m_frameQueue->executeNext()) {
+		}
+		glfwMakeContextCurrent(nullptr);
+	});
+}
+
+void BlotEngine::stopRenderThread() {
+	if (!m_frameQueue) {
+		return;
+	}
+	// Flush whatever was recorded since the last frame (e.g. releases)
+	m_frameQueue->submitFrame();
+	m_frameQueue->close();
+	m_renderThread.join();
+	m_frameQueue.reset();
+	glfwMakeContextCurrent(m_window);
+}
+
+void BlotEngine::submitRenderCommand(std::function<void()> command) {
+	if (m_frameQueue && !m_frameQueue->isConsumerThread()) {
+		m_frameQueue->record(std::move(command));
+	} else {
+		command();
+	}
+}
+
+void BlotEngine::runOnRenderThread(const std::function<void()> &command) {
+	if (m_frameQueue) {
+		m_frameQueue->runSync(command);
+	} else {
+		command();
+	}
+}
+
 // -------------------- VSync & Frame Rate -----------------
 
 void BlotEngine::setVerticalSync(bool enabled) {
 	m_vsync = enabled;
-	glfwMakeContextCurrent(m_window);
-	glfwSwapInterval(enabled ? 1 : 0);
+	runOnRenderThread([this, enabled] {
+		glfwMakeContextCurrent(m_window);
+		glfwSwapInterval(enabled ? 1 : 0);
+	});
+}
+
+void BlotEngine::setFrameQueueDepth(int frames) {
+	m_frameQueueDepth = std::max(frames, 1);
+	if (m_frameQueue) {
+		m_frameQueue->setMaxFrames(static_cast<size_t>(m_frameQueueDepth));
+	}
 }
 
 void BlotEngine::setTargetFrameRate(int fps) {
@@ -158,6 +262,7 @@ void BlotEngine::setTargetFrameRate(int fps) {
 	} else {
 		m_targetFps = fps;
 	}
+	m_pacer.setTargetFrameRate(m_targetFps);
 }
 
 // -------------- UI Manager attach/detach ----------------
@@ -1,10 +1,14 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <thread>
 #include "core/AppSettings.h"
 #include "core/Iui.h"
 #include "core/U_core.h"
 #include "core/WindowSettings.h"
+#include "core/util/FramePacer.h"
 #include "rendering/U_gladGlfw.h"
 
 // Forward declarations for all managers and IApp
@@ -17,6 +21,8 @@ class Iui;
 class MRendering;
 class MCanvas;
 class MSettings;
+class ThreadPool;
+class FrameCommandQueue;
 } // namespace blot
 
 namespace blot {
@@ -41,6 +47,21 @@ class BlotEngine {
 	MRendering *getRenderingManager() { return m_renderingManager.get(); }
 	MCanvas *getCanvasManager() { return m_canvasManager.get(); }
 	MSettings *getSettings() { return m_settingsManager.get(); }
+	// Shared worker threads, sized by AppSettings::workerThreads
+	ThreadPool *getThreadPool() { return m_threadPool.get(); }
+
+	// Render thread (GraphicsSettings::renderThread). While it runs, the
+	// GL context is current there only: GL work from update and draw code
+	// goes through these, which run it directly when there is no thread.
+	bool isRenderThreaded() const { return m_frameQueue != nullptr; }
+	FrameCommandQueue *getFrameQueue() { return m_frameQueue.get(); }
+	// Record into the frame being built, after everything recorded so far
+	void submitRenderCommand(std::function<void()> command);
+	// Run ahead of the queued frames and wait for it
+	void runOnRenderThread(const std::function<void()> &command);
+	// Frames in flight on the render thread, at least 1
+	void setFrameQueueDepth(int frames);
+	int getFrameQueueDepth() const { return m_frameQueueDepth; }
 
 	void setDebugMode(bool enabled) { m_debugMode = enabled; }
 	bool getDebugMode() const { return m_debugMode; }
@@ -51,10 +72,14 @@ class BlotEngine {
 	bool getVerticalSync() const { return m_vsync; }
 	void setTargetFrameRate(int fps);
 	int getTargetFrameRate() const { return m_targetFps; }
+	// Smoothed over recent frames
 	int getCurrentFrameRate() const { return m_currentFps; }
+	FramePacer &getFramePacer() { return m_pacer; }
+	// Smoothed FPS, frame-time percentiles and missed deadlines
+	FramePacer::Stats getFrameStats() const { return m_pacer.getStats(); }
 
 	// Frame counter (increments once per main loop iteration)
-	uint64_t getFrameCount() const { return m_frameCount; }
+	uint64_t getFrameCount() const { return m_frameCount.load(); }
 
 	// Background clear colour used each frame (for apps without a Canvas)
 	void setClearColor(float r, float g, float b, float a = 1.0f) {
@@ -78,12 +103,20 @@ class BlotEngine {
 	static void setEngine(BlotEngine *engine) { s_instance = engine; }
 
   private:
+	void startRenderThread();
+	void stopRenderThread();
+	void clearWindow(const glm::vec4 &color);
+
 	std::string m_appName = "Blot App";
 	float m_appVersion = 0.1f;
-	uint64_t m_frameCount = 0;
+	std::atomic<uint64_t> m_frameCount{0};
 
 	AppSettings m_settings;
 	std::unique_ptr<IApp> m_app;
+	// Declared before the managers so it outlives their pending work
+	std::unique_ptr<ThreadPool> m_threadPool;
+	std::unique_ptr<FrameCommandQueue> m_frameQueue;
+	std::thread m_renderThread;
 	std::unique_ptr<MEcs> m_ecsManager;
 	std::unique_ptr<MAddon> m_addonManager;
 	std::unique_ptr<Iui> m_uiManager;
@@ -96,7 +129,9 @@ class BlotEngine {
 	bool m_debugMode = false;
 	bool m_vsync = true;
 	int m_targetFps = 60;
+	int m_frameQueueDepth = 1;
 	int m_currentFps = 0;
+	FramePacer m_pacer;
 	glm::vec4 m_clearColor{0.4f, 0.4f, 0.4f, 1.0f};
 	// Tracks whether Mui::init() has been called (addon may call it).
 	bool m_uiInitialised = false;
@@ -2,6 +2,7 @@
 #include "core/BlotEngine.h"
 #include "core/Iui.h"
 #include "core/util/AppPaths.h"
+#include "core/util/Profiler.h"
 
 namespace blot {
 
@@ -55,6 +56,7 @@ void IApp::blotSetup(BlotEngine *engine) {
 }
 
 void IApp::blotUpdate(float deltaTime) {
+	BLOT_PROFILE_SCOPE("IApp::blotUpdate");
 	m_deltaTime = deltaTime;
 	// Framework-level update
 	// 1) Update ECS-related systems (canvas, scripts, generic systems)
@@ -65,14 +67,19 @@ void IApp::blotUpdate(float deltaTime) {
 
 	// 2) Update UI – this also internally updates the WindowManager
 	if (auto ui = getUiManager()) {
+		BLOT_PROFILE_SCOPE("Iui::update");
 		ui->update();
 	}
 
 	// User-level update
+	BLOT_PROFILE_SCOPE("IApp::update");
 	update(deltaTime);
 }
 
-void IApp::blotDraw() { draw(); }
+void IApp::blotDraw() {
+	BLOT_PROFILE_SCOPE("IApp::blotDraw");
+	draw();
+}
 
 // -----------------------------------------------------------------------------
 // Convenience helpers
@@ -88,6 +88,8 @@ class IAddon : public ISettings {
 	virtual void update(float deltaTime) { (void)deltaTime; }
 	virtual void draw() {}
 	virtual void cleanup() {}
+	// Host bytes the addon holds, reported under MAddon in MemoryTracker
+	virtual size_t getMemoryUsage() const { return 0; }
 
   protected:
 	// Addon state
@@ -11,11 +11,27 @@
 #include "IAddon.h"
 #include "ISettings.h"
 #include "json.h"
+#include "core/util/MemoryTracker.h"
+#include "core/util/Profiler.h"
 
 blot::MAddon::MAddon(blot::BlotEngine *engine)
-	: m_engine(engine), m_addonDirectory("addons") {}
+	: m_addonDirectory("addons"), m_engine(engine) {
+	m_memoryProvider = MemoryTracker::instance().addProvider(
+		MemoryTag::Addon, MemoryDomain::Cpu, [this] {
+			size_t bytes = 0;
+			for (const auto &entry : m_addons) {
+				if (entry.second) {
+					bytes += entry.second->getMemoryUsage();
+				}
+			}
+			return bytes;
+		});
+}
 
-blot::MAddon::~MAddon() { cleanupAll(); }
+blot::MAddon::~MAddon() {
+	MemoryTracker::instance().removeProvider(m_memoryProvider);
+	cleanupAll();
+}
 
 void blot::MAddon::unregisterAddon(const std::string &name) {
 	auto it = m_addons.find(name);
@@ -85,18 +101,22 @@ void blot::MAddon::setupAll() {
 }
 
 void blot::MAddon::updateAll(float deltaTime) {
+	BLOT_PROFILE_SCOPE("MAddon::updateAll");
 	for (const auto &name : m_addonOrder) {
 		auto addon = m_addons[name];
 		if (addon && addon->isEnabled() && addon->isInitialized()) {
+			BLOT_PROFILE_SCOPE_DYNAMIC(name);
 			addon->blotUpdate(deltaTime);
 		}
 	}
 }
 
 void blot::MAddon::drawAll() {
+	BLOT_PROFILE_SCOPE("MAddon::drawAll");
 	for (const auto &name : m_addonOrder) {
 		auto addon = m_addons[name];
 		if (addon && addon->isEnabled() && addon->isInitialized()) {
+			BLOT_PROFILE_SCOPE_DYNAMIC(name);
 			addon->blotDraw();
 		}
 	}
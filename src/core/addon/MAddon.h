@@ -93,5 +93,6 @@ class MAddon : public IManager, public ISettings {
 	std::vector<std::string> getCircularDependencies() const;
 
 	blot::BlotEngine *m_engine = nullptr;
+	int m_memoryProvider = 0;
 };
 } // namespace blot 
\ No newline at end of file
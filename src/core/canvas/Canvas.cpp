@@ -4,22 +4,36 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <filesystem>
+#include <mutex>
 #include <spdlog/spdlog.h>
 
 #include "core/BlotEngine.h"
 #include "core/ISettings.h"
 #include "core/addon/MAddon.h"
 #include "core/json.h"
+#include "core/util/MemoryTracker.h"
 #include "ecs/MEcs.h"
 #include "ecs/components/CDrawStyle.h"
 #include "ecs/components/CShape.h"
 #include "ecs/components/CTransform.h"
+#include "ecs/systems/SShapeRendering.h"
+#include "rendering/GlState.h"
 #include "rendering/Graphics.h"
 #include "rendering/IRenderer.h"
+#include "rendering/PostProcess.h"
+#include "rendering/RendererRegistry.h"
+#include "rendering/ShaderRegistry.h"
+#include "rendering/ShapeInstancer.h"
 
 namespace blot {
 
+struct Canvas::ShapeSnapshot {
+	blot::ecs::ShapeRenderView view;
+	std::vector<blot::ecs::CRenderProxy> proxies;
+};
+
 struct Canvas::Impl {
 	GLuint framebuffer = 0;
 	GLuint colorTexture = 0;
@@ -27,6 +41,16 @@ struct Canvas::Impl {
 	GLuint shaderProgram = 0;
 	GLuint VAO = 0;
 	GLuint VBO = 0;
+	// Created on first use by an OpenGL renderer
+	std::unique_ptr<ShapeInstancer> instancer;
+	PostProcessChain postProcess;
+	// Chain output shown instead of the plain render, when there is one
+	GLuint postTexture = 0;
+	const uint8_t *postPixels = nullptr;
+	TrackedMemory framebufferMemory{MemoryTag::Canvas, MemoryDomain::Gpu};
+	// Written by the render thread, read by the app
+	mutable std::mutex statsMutex;
+	blot::ecs::ShapeRenderStats stats;
 };
 
 Canvas::Canvas(const CanvasSettings &settings, BlotEngine *engine)
@@ -39,6 +63,11 @@ Canvas::Canvas(const CanvasSettings &settings, BlotEngine *engine)
 	  m_textAlign(0), m_time(0.0f), m_frameRate(60.0f), m_frameCount(0) {
 	m_currentMatrix = glm::mat4(1.0f);
 	m_graphics->setCanvasSize(m_width, m_height);
+	m_graphics->setLodTolerance(m_settings.lodTolerance);
+	if (m_engine) {
+		m_graphics->setThreadPool(m_engine->getThreadPool());
+		m_impl->postProcess.setThreadPool(m_engine->getThreadPool());
+	}
 	initFramebuffer();
 	initShaders();
 	// Set default background to white
@@ -46,20 +75,18 @@ Canvas::Canvas(const CanvasSettings &settings, BlotEngine *engine)
 }
 
 Canvas::~Canvas() {
+	GlState &state = GlState::instance();
 	if (m_impl->framebuffer) {
-		glDeleteFramebuffers(1, &m_impl->framebuffer);
+		state.deleteFramebuffers(1, &m_impl->framebuffer);
 	}
 	if (m_impl->colorTexture) {
-		glDeleteTextures(1, &m_impl->colorTexture);
+		state.deleteTextures(1, &m_impl->colorTexture);
 	}
 	if (m_impl->depthRenderbuffer) {
 		glDeleteRenderbuffers(1, &m_impl->depthRenderbuffer);
 	}
-	if (m_impl->shaderProgram) {
-		glDeleteProgram(m_impl->shaderProgram);
-	}
 	if (m_impl->VAO) {
-		glDeleteVertexArrays(1, &m_impl->VAO);
+		state.deleteVertexArrays(1, &m_impl->VAO);
 	}
 	if (m_impl->VBO) {
 		glDeleteBuffers(1, &m_impl->VBO);
@@ -70,18 +97,32 @@ void Canvas::resize(int width, int height) {
 	m_width = width;
 	m_height = height;
 	m_graphics->setCanvasSize(m_width, m_height);
-	initFramebuffer();
-	// Set default background to white after resize
-	clear(1.0f, 1.0f, 1.0f, 1.0f);
+	if (m_renderer) {
+		m_renderer->resize(m_width, m_height);
+	}
+	m_dirty = true;
+	auto rebuild = [this] {
+		initFramebuffer();
+		// Set default background to white after resize
+		clear(1.0f, 1.0f, 1.0f, 1.0f);
+	};
+	if (m_engine) {
+		m_engine->runOnRenderThread(rebuild);
+	} else {
+		rebuild();
+	}
 }
 
 void Canvas::clear() { clear(1.0f, 1.0f, 1.0f, 1.0f); }
 
 void Canvas::clear(float r, float g, float b, float a) {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_impl->framebuffer);
+	// Both binds are skipped when the canvas target is already current
+	GlState &state = GlState::instance();
+	const uint32_t previous = state.getFramebuffer();
+	state.bindFramebuffer(m_impl->framebuffer);
 	glClearColor(r, g, b, a);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	state.bindFramebuffer(previous);
 }
 
 void Canvas::background(float r, float g, float b, float a) {
@@ -203,19 +244,128 @@ void Canvas::update(float deltaTime) {
 }
 
 void Canvas::render() {
+	// Read before drawing so edits made meanwhile are caught next frame
+	uint64_t revision = m_ecs ? m_ecs->getShapeRevision() : 0;
+	draw(nullptr);
+	m_renderedRevision = revision;
+	m_dirty = false;
+}
+
+std::shared_ptr<const Canvas::ShapeSnapshot> Canvas::takeSnapshot() {
+	auto shapes = std::make_shared<ShapeSnapshot>();
+	shapes->view = getShapeRenderView();
+	if (m_ecs) {
+		m_renderedRevision = m_ecs->getShapeRevision();
+		blot::ecs::collectVisibleProxies(*m_ecs, shapes->view,
+										 shapes->proxies);
+	}
+	m_dirty = false;
+	return shapes;
+}
+
+void Canvas::render(const ShapeSnapshot &shapes) { draw(&shapes); }
+
+void Canvas::draw(const ShapeSnapshot *shapes) {
 	// Shape rendering is now handled by ECS system
 	if (m_graphics) {
 		// Clear the canvas with white background
 		m_graphics->clear(1.0f, 1.0f, 1.0f, 1.0f);
 
 		// Render ECS shapes
-		renderECSShapes();
+		renderShapes(shapes);
 	}
 	// Remove Blend2D-specific image upload and BLImage logic from core
+
+	m_impl->postProcess.invalidate();
+	applyPostProcess();
+}
+
+PostProcessChain &Canvas::getPostProcess() { return m_impl->postProcess; }
+
+void Canvas::setRenderTargetPool(RenderTargetPool *pool) {
+	m_impl->postProcess.setTargetPool(pool);
+	m_impl->postTexture = 0;
+	m_impl->postPixels = nullptr;
+}
+
+bool Canvas::needsPostProcess() const { return m_impl->postProcess.isStale(); }
+
+void Canvas::applyPostProcess() {
+	PostProcessChain &chain = m_impl->postProcess;
+	IRenderer *renderer = getRenderer();
+	if (rendersOnCpu()) {
+		const uint8_t *pixels = renderer->getPixelBuffer();
+		if (!pixels) {
+			return;
+		}
+		const uint8_t *result = chain.processCpu(
+			pixels, renderer->getWidth(), renderer->getHeight());
+		m_impl->postPixels = result != pixels ? result : nullptr;
+		m_impl->postTexture = 0;
+		return;
+	}
+	GLuint result =
+		chain.processGpu(m_impl->colorTexture, m_width, m_height);
+	m_impl->postTexture = result != m_impl->colorTexture ? result : 0;
+	m_impl->postPixels = nullptr;
+}
+
+void Canvas::present() {
+	int rowLength = 0;
+	int rows = 0;
+	if (const uint8_t *pixels = getPresentPixels(&rowLength, &rows)) {
+		present(pixels, rowLength, rows);
+	}
+}
+
+const uint8_t *Canvas::getPresentPixels(int *rowLength, int *rows) const {
+	IRenderer *renderer = getRenderer();
+	if (!rendersOnCpu()) {
+		return nullptr;
+	}
+	*rowLength = renderer->getWidth();
+	*rows = renderer->getHeight();
+	return m_impl->postPixels ? m_impl->postPixels
+							  : renderer->getPixelBuffer();
+}
+
+void Canvas::present(const uint8_t *pixels, int rowLength, int rows) {
+	if (!pixels || !m_impl->colorTexture) {
+		return;
+	}
+	// Tightly packed RGBA8 rows at the renderer's own width
+	int width = std::min(rowLength, m_width);
+	int height = std::min(rows, m_height);
+	GlState::instance().bindTexture(m_impl->colorTexture);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+					GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+bool Canvas::needsRender() const {
+	return m_dirty || (m_ecs && m_ecs->getShapeRevision() != m_renderedRevision);
+}
+
+void Canvas::renderECSShapes() { renderShapes(nullptr); }
+
+blot::ecs::ShapeRenderView Canvas::getShapeRenderView() const {
+	blot::ecs::ShapeRenderView viewState;
+	viewState.size = glm::vec2(static_cast<float>(m_width),
+							   static_cast<float>(m_height));
+	viewState.tolerance = m_settings.lodTolerance;
+	viewState.offset = m_viewOffset;
+	viewState.zoom = m_viewZoom;
+	return viewState;
 }
 
-void Canvas::renderECSShapes() {
-	if (!m_ecs || !m_graphics) {
+blot::ecs::ShapeRenderStats Canvas::getShapeRenderStats() const {
+	std::lock_guard<std::mutex> lock(m_impl->statsMutex);
+	return m_impl->stats;
+}
+
+void Canvas::renderShapes(const ShapeSnapshot *shapes) {
+	if ((!shapes && !m_ecs) || !m_graphics) {
 		spdlog::debug(
 			"[Canvas] renderECSShapes: m_ecs=0x{:X}, m_graphics=0x{:X}",
 			reinterpret_cast<uintptr_t>(m_ecs),
@@ -230,121 +380,71 @@ void Canvas::renderECSShapes() {
 		return;
 	}
 
-	// Get all entities with Transform, Shape, and Style components
-	auto view = m_ecs->view<blot::ecs::CTransform, blot::ecs::CShape,
-							blot::ecs::CDrawStyle>();
+	// Same path as the ECS shape system, so culling and level of detail
+	// apply to canvases too
+	blot::ecs::ShapeRenderView viewState =
+		shapes ? shapes->view : getShapeRenderView();
+	auto drawShapes = [&] {
+		// The instancer applies the view itself; the renderer gets it as
+		// its transform
+		bool transformed =
+			viewState.zoom != 1.0f || viewState.offset != glm::vec2(0.0f);
+		if (transformed) {
+			renderer->pushMatrix();
+			renderer->translate(viewState.offset.x, viewState.offset.y);
+			renderer->scale(viewState.zoom, viewState.zoom);
+		}
+		blot::ecs::ShapeRenderStats stats =
+			shapes ? blot::ecs::SShapeRendering(shapes->proxies, *renderer,
+												viewState)
+				   : blot::ecs::SShapeRendering(*m_ecs, *renderer, viewState);
+		if (transformed) {
+			renderer->popMatrix();
+		}
+		std::lock_guard<std::mutex> lock(m_impl->statsMutex);
+		m_impl->stats = stats;
+	};
 
-	spdlog::debug(
-		"[Canvas] renderECSShapes: Checking for entities with shapes...");
-	spdlog::debug("[Canvas] Total entities in registry: {}",
-				  m_ecs->getEntityCount());
+	if (renderer->getType() != RendererType::OpenGL) {
+		drawShapes();
+		return;
+	}
 
-	// Debug: Check what components each entity has
-	auto allEntities = m_ecs->getAllEntities();
-	spdlog::debug("[Canvas] All entities: {}", allEntities.size());
-	for (auto entity : allEntities) {
-		bool hasTransform = m_ecs->hasComponent<blot::ecs::CTransform>(entity);
-		bool hasShape = m_ecs->hasComponent<blot::ecs::CShape>(entity);
-		bool hasStyle = m_ecs->hasComponent<blot::ecs::CDrawStyle>(entity);
-		spdlog::debug("[Canvas] Entity {}: CTransform={}, Shape={}, Style={}",
-					  (unsigned int)entity, hasTransform, hasShape, hasStyle);
+	// Simple shapes are drawn as instances straight into the canvas target
+	if (!m_impl->instancer) {
+		m_impl->instancer = std::make_unique<ShapeInstancer>();
 	}
+	m_impl->instancer->setBlendMode(m_graphics->getBlendMode());
+	viewState.instancer = m_impl->instancer.get();
 
-	for (auto entity : view) {
-		auto &transform = view.get<blot::ecs::CTransform>(entity);
-		auto &shape = view.get<blot::ecs::CShape>(entity);
-		auto &style = view.get<blot::ecs::CDrawStyle>(entity);
+	GlState &state = GlState::instance();
+	const uint32_t previousFramebuffer = state.getFramebuffer();
+	const std::array<int, 4> previousViewport = state.getViewport();
+	state.bindFramebuffer(m_impl->framebuffer);
+	state.setViewport(0, 0, m_width, m_height);
 
-		// Set fill and stroke colors
-		if (style.hasFill) {
-			m_graphics->setFillColor(style.fillR, style.fillG, style.fillB,
-									 style.fillA);
-		}
-		if (style.hasStroke) {
-			m_graphics->setStrokeColor(style.strokeR, style.strokeG,
-									   style.strokeB, style.strokeA);
-			m_graphics->setStrokeWidth(style.strokeWidth);
-		}
+	drawShapes();
 
-		// Calculate position with transform
-		float x = transform.position.x + shape.x1;
-		float y = transform.position.y + shape.y1;
-		float width = shape.x2 - shape.x1;
-		float height = shape.y2 - shape.y1;
-
-		// Apply transform scaling
-		x *= transform.scale.x;
-		y *= transform.scale.y;
-		width *= transform.scale.x;
-		height *= transform.scale.y;
-
-		// Debug: Print raw shape coordinates
-		spdlog::debug("[Canvas] Raw shape coords: x1={:.2f}, y1={:.2f}, "
-					  "x2={:.2f}, y2={:.2f}",
-					  shape.x1, shape.y1, shape.x2, shape.y2);
-		spdlog::debug(
-			"[Canvas] Transform: x={:.2f}, y={:.2f}, scale=(%.2f,%.2f)",
-			transform.position.x, transform.position.y, transform.scale.x,
-			transform.scale.y);
-
-		// Render based on shape type
-		spdlog::debug("[Canvas] Rendering shape: type={}, x={:.2f}, y={:.2f}, "
-					  "w={:.2f}, h={:.2f}, hasFill={}, hasStroke={}",
-					  (int)shape.type, x, y, width, height, style.hasFill,
-					  style.hasStroke);
-
-		switch (shape.type) {
-		case blot::ecs::CShape::Type::Rectangle:
-			if (style.hasFill) {
-				spdlog::debug("[Canvas] Drawing filled rectangle");
-				m_graphics->drawRect(x, y, width, height);
-			}
-			if (style.hasStroke) {
-				spdlog::debug("[Canvas] Drawing stroked rectangle");
-				m_graphics->drawRect(x, y, width, height);
-			}
-			break;
-
-		case blot::ecs::CShape::Type::Ellipse:
-			if (style.hasFill)
-				m_graphics->drawEllipse(x + width * 0.5f, y + height * 0.5f,
-										width * 0.5f, height * 0.5f);
-			if (style.hasStroke)
-				m_graphics->drawEllipse(x + width * 0.5f, y + height * 0.5f,
-										width * 0.5f, height * 0.5f);
-			break;
-
-		case blot::ecs::CShape::Type::Line:
-			if (style.hasStroke) {
-				float x2 = transform.position.x + shape.x2;
-				float y2 = transform.position.y + shape.y2;
-				x2 *= transform.scale.x;
-				y2 *= transform.scale.y;
-				m_graphics->drawLine(x, y, x2, y2);
-			}
-			break;
-
-		case blot::ecs::CShape::Type::Polygon:
-			// For now, render as circle - can be enhanced later
-			if (style.hasFill)
-				m_graphics->drawEllipse(x + width * 0.5f, y + height * 0.5f,
-										width * 0.5f, height * 0.5f);
-			if (style.hasStroke)
-				m_graphics->drawEllipse(x + width * 0.5f, y + height * 0.5f,
-										width * 0.5f, height * 0.5f);
-			break;
-
-		case blot::ecs::CShape::Type::Star:
-			// For now, render as circle - can be enhanced later
-			if (style.hasFill)
-				m_graphics->drawEllipse(x + width * 0.5f, y + height * 0.5f,
-										width * 0.5f, height * 0.5f);
-			if (style.hasStroke)
-				m_graphics->drawEllipse(x + width * 0.5f, y + height * 0.5f,
-										width * 0.5f, height * 0.5f);
-			break;
-		}
+	state.bindFramebuffer(previousFramebuffer);
+	state.setViewport(previousViewport[0], previousViewport[1],
+					  previousViewport[2], previousViewport[3]);
+}
+
+void Canvas::setLodTolerance(float tolerance) {
+	m_settings.lodTolerance = tolerance;
+	m_dirty = true;
+	if (m_graphics)
+		m_graphics->setLodTolerance(tolerance);
+}
+
+void Canvas::setView(const glm::vec2 &offset, float zoom) {
+	zoom = zoom > 0.0f ? zoom : 1.0f;
+	if (offset == m_viewOffset && zoom == m_viewZoom) {
+		return;
 	}
+	m_viewOffset = offset;
+	m_viewZoom = zoom;
+	m_dirty = true;
 }
 
 void Canvas::saveFrame(const std::string &filename) {
@@ -357,16 +457,29 @@ void Canvas::exportSVG(const std::string &filename) {
 	(void)filename;
 }
 
-unsigned int Canvas::getColorTexture() const { return m_impl->colorTexture; }
+unsigned int Canvas::getColorTexture() const {
+	return m_impl->postTexture ? m_impl->postTexture : m_impl->colorTexture;
+}
 
 void Canvas::initFramebuffer() {
 	// Create framebuffer for off-screen rendering
+	GlState &state = GlState::instance();
+	// Resizing rebuilds the attachments; drop the old ones first
+	if (m_impl->framebuffer) {
+		state.deleteFramebuffers(1, &m_impl->framebuffer);
+		state.deleteTextures(1, &m_impl->colorTexture);
+		glDeleteRenderbuffers(1, &m_impl->depthRenderbuffer);
+		m_impl->framebuffer = 0;
+		m_impl->colorTexture = 0;
+		m_impl->depthRenderbuffer = 0;
+	}
+	const uint32_t previousFramebuffer = state.getFramebuffer();
 	glGenFramebuffers(1, &m_impl->framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_impl->framebuffer);
+	state.bindFramebuffer(m_impl->framebuffer);
 
 	// Create color texture
 	glGenTextures(1, &m_impl->colorTexture);
-	glBindTexture(GL_TEXTURE_2D, m_impl->colorTexture);
+	state.bindTexture(m_impl->colorTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA,
 				 GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -381,12 +494,15 @@ void Canvas::initFramebuffer() {
 						  m_height);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
 							  GL_RENDERBUFFER, m_impl->depthRenderbuffer);
+	// RGBA8 color plus packed 24/8 depth-stencil
+	m_impl->framebufferMemory.set(
+		2 * MemoryTracker::estimateTextureBytes(m_width, m_height, 4));
 
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
 		// Handle framebuffer error
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	state.bindFramebuffer(previousFramebuffer);
 }
 
 void Canvas::initShaders() {
@@ -418,28 +534,16 @@ void Canvas::initShaders() {
 		}
 	)";
 
-	// Compile and link shaders
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-
-	m_impl->shaderProgram = glCreateProgram();
-	glAttachShader(m_impl->shaderProgram, vertexShader);
-	glAttachShader(m_impl->shaderProgram, fragmentShader);
-	glLinkProgram(m_impl->shaderProgram);
-
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	// Shared by every canvas; the registry compiles it once per process
+	m_impl->shaderProgram = ShaderRegistry::instance().getProgram(
+		vertexShaderSource, fragmentShaderSource);
 
 	// Set up vertex data
 	glGenVertexArrays(1, &m_impl->VAO);
 	glGenBuffers(1, &m_impl->VBO);
 
-	glBindVertexArray(m_impl->VAO);
+	GlState &state = GlState::instance();
+	state.bindVertexArray(m_impl->VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_impl->VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 5, NULL, GL_DYNAMIC_DRAW);
 
@@ -450,42 +554,65 @@ void Canvas::initShaders() {
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
 						  (void *)(3 * sizeof(float)));
 
-	glBindVertexArray(0);
+	state.bindVertexArray(0);
 }
 
 void Canvas::switchRenderer(RendererType type) {
-	auto *addonManager = m_engine->getAddonManager();
-	// Remove or replace the line: auto newRenderer =
-	// addonManager->createRenderer(type); The original code had this line, but
-	// the user's edit hint implies its removal. Assuming the user's intent is
-	// to remove this line. If the user intended to replace it with a new
-	// renderer, they would need to provide the new renderer object. For now,
-	// we'll just log an error if the renderer type is not found.
-	spdlog::error("switchRenderer: Renderer type {} not found or implemented.",
-				  static_cast<int>(type));
-}
-
-void Canvas::setRenderer(std::unique_ptr<IRenderer> renderer) {
-	if (renderer) {
+	if (m_renderer && m_renderer->getType() == type) {
+		return;
+	}
+	std::shared_ptr<IRenderer> renderer =
+		RendererRegistry::instance().create(type);
+	if (!renderer) {
+		spdlog::error("[Canvas] Renderer type {} is not registered",
+					  static_cast<int>(type));
+		return;
+	}
+	setRenderer(std::move(renderer));
+}
+
+void Canvas::setRenderer(std::shared_ptr<IRenderer> renderer) {
+	if (!renderer) {
+		return;
+	}
+	// GPU backends create objects in the context, and queued frames may
+	// still draw with the current renderer
+	auto install = [&] {
 		// Initialize the renderer with current canvas dimensions
 		if (renderer->initialize(m_width, m_height)) {
 			// Set the new renderer in graphics
 			m_graphics->setRenderer(renderer.get());
 			spdlog::info("Set canvas renderer to: {}", renderer->getName());
+			m_renderer = std::move(renderer);
+			m_dirty = true;
 		} else {
 			spdlog::error("Failed to initialize renderer: {}",
 						  renderer->getName());
 		}
+	};
+	if (m_engine) {
+		m_engine->runOnRenderThread(install);
+	} else {
+		install();
 	}
 }
 
+IRenderer *Canvas::getRenderer() const {
+	return m_graphics ? m_graphics->getRenderer() : nullptr;
+}
+
 RendererType Canvas::getRendererType() const {
-	if (m_graphics && m_graphics->getRenderer()) {
-		return m_graphics->getRenderer()->getType();
+	if (IRenderer *renderer = getRenderer()) {
+		return renderer->getType();
 	}
 	return RendererType::Blend2D; // Default or fallback
 }
 
+bool Canvas::rendersOnCpu() const {
+	IRenderer *renderer = getRenderer();
+	return renderer && renderer->getType() != RendererType::OpenGL;
+}
+
 json Canvas::getSettings() const {
 	json j;
 	j["width"] = m_width;
@@ -493,6 +620,7 @@ json Canvas::getSettings() const {
 	j["name"] = m_name;
 	j["background"] = {m_settings.r, m_settings.g, m_settings.b, m_settings.a};
 	j["samples"] = m_settings.samples;
+	j["lodTolerance"] = m_settings.lodTolerance;
 	return j;
 }
 
@@ -514,6 +642,8 @@ void Canvas::setSettings(const json &settings) {
 	}
 	if (settings.contains("samples"))
 		m_settings.samples = settings["samples"].get<int>();
+	if (settings.contains("lodTolerance"))
+		setLodTolerance(settings["lodTolerance"].get<float>());
 	resize(m_width, m_height);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 // Standard library
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <variant>
@@ -19,6 +20,12 @@ namespace blot {
 class BlotEngine;
 class Graphics;
 class MEcs;
+class PostProcessChain;
+class RenderTargetPool;
+namespace ecs {
+struct ShapeRenderStats;
+struct ShapeRenderView;
+} // namespace ecs
 
 /**
  * @brief Settings/configuration for Canvas creation.
@@ -28,6 +35,7 @@ struct CanvasSettings {
 	int height = 600;
 	float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f; // Default white
 	int samples = 0;							  // Multisampling
+	float lodTolerance = 0.25f;					  // Curve error in pixels
 												  // Add more options as needed
 };
 
@@ -70,23 +78,75 @@ class Canvas : public ISettings {
 	void rotate(float angle);
 	void scale(float x, float y);
 	void update(float deltaTime);
+	// Draw the canvas contents. With a CPU renderer this makes no GL calls
+	// and may run on a worker thread; call present() afterwards on the GL
+	// thread to upload the pixels to the color texture.
 	void render();
+	// render() split for the render thread: takeSnapshot() copies the view
+	// and the shapes in it out of the ECS on the thread that updates it, and
+	// render() with the snapshot draws them without reading the registry.
+	struct ShapeSnapshot;
+	std::shared_ptr<const ShapeSnapshot> takeSnapshot();
+	void render(const ShapeSnapshot &shapes);
+	void present();
+	// Pixels present() would upload, with the renderer's row length and row
+	// count; nullptr for GL canvases
+	const uint8_t *getPresentPixels(int *rowLength, int *rows) const;
+	// Upload a copy of getPresentPixels(), possibly taken frames earlier
+	void present(const uint8_t *pixels, int rowLength, int rows);
+
+	// Effects applied after render(), on the GPU or tile-parallel on the
+	// CPU. The color texture and present() show the processed image.
+	PostProcessChain &getPostProcess();
+	// Run only the post-process chain, reusing the last rendered image
+	void applyPostProcess();
+	bool needsPostProcess() const;
+	// Targets and buffers shared with other canvases
+	void setRenderTargetPool(RenderTargetPool *pool);
 	void saveFrame(const std::string &filename);
 	void exportSVG(const std::string &filename);
 
 	// ECS integration
-	void setECSManager(MEcs *ecs) { m_ecs = ecs; }
+	void setECSManager(MEcs *ecs) {
+		m_ecs = ecs;
+		m_dirty = true;
+	}
 	MEcs *getECSManager() const { return m_ecs; }
 	void renderECSShapes();
 
+	// Level of detail
+	void setLodTolerance(float tolerance);
+	float getLodTolerance() const { return m_settings.lodTolerance; }
+
+	// View the canvas is shown with, as in CTexture: screen = canvas * zoom
+	// + offset. ECS shapes are drawn through it, culled against it and get
+	// their level of detail from its zoom. Graphics content is drawn
+	// without it, so its level of detail stays at zoom 1.
+	void setView(const glm::vec2 &offset, float zoom);
+	glm::vec2 getViewOffset() const { return m_viewOffset; }
+	float getViewZoom() const { return m_viewZoom; }
+
 	// Engine access
 	void setEngine(BlotEngine *engine) { m_engine = engine; }
 	BlotEngine *getEngine() const { return m_engine; }
 
-	// Renderer management
+	// Renderer management. The canvas owns the renderer it is given.
+	// switchRenderer() creates one from the RendererRegistry. The renderer
+	// is initialized and swapped in on the render thread, between frames.
 	void switchRenderer(RendererType type);
-	void setRenderer(std::unique_ptr<IRenderer> renderer);
+	void setRenderer(std::shared_ptr<IRenderer> renderer);
+	IRenderer *getRenderer() const;
 	RendererType getRendererType() const;
+	bool rendersOnCpu() const;
+
+	// Change tracking: a canvas needs rendering after markDirty() or when
+	// shapes in its ECS manager changed since the last render().
+	void markDirty() { m_dirty = true; }
+	bool needsRender() const;
+
+	// Counts from the last shape render (shapes drawn, culled, instanced
+	// and instanced draw calls); safe to call while the render thread draws
+	ecs::ShapeRenderStats getShapeRenderStats() const;
 
 	// Getters
 	int getWidth() const { return m_width; }
@@ -102,6 +162,10 @@ class Canvas : public ISettings {
 
   private:
 	void initFramebuffer();
+	// Draw the snapshot, or the ECS shapes when it is null
+	void draw(const ShapeSnapshot *shapes);
+	void renderShapes(const ShapeSnapshot *shapes);
+	ecs::ShapeRenderView getShapeRenderView() const;
 	void initShaders();
 
 	int m_width;
@@ -113,6 +177,9 @@ class Canvas : public ISettings {
 	struct Impl;
 	std::unique_ptr<Impl> m_impl;
 
+	// Declared before m_graphics, which keeps a raw pointer to it
+	std::shared_ptr<IRenderer> m_renderer;
+
 	// Graphics state
 	std::shared_ptr<Graphics> m_graphics;
 
@@ -129,6 +196,10 @@ class Canvas : public ISettings {
 	float m_textSize;
 	int m_textAlign;
 
+	// View
+	glm::vec2 m_viewOffset{0.0f, 0.0f};
+	float m_viewZoom = 1.0f;
+
 	// Animation
 	float m_time;
 	float m_frameRate;
@@ -136,6 +207,8 @@ class Canvas : public ISettings {
 
 	// ECS
 	MEcs *m_ecs = nullptr;
+	bool m_dirty = true;
+	uint64_t m_renderedRevision = 0;
 
 	// Engine
 	BlotEngine *m_engine = nullptr;
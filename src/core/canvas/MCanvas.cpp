@@ -1,8 +1,13 @@
 #include "core/canvas/MCanvas.h"
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include "core/BlotEngine.h"
 #include "core/ISettings.h"
+#include "core/util/FrameCommandQueue.h"
+#include "core/util/Profiler.h"
+#include "core/util/ThreadPool.h"
 #include "ecs/MEcs.h"
 #include "ecs/components/CCanvas.h"
 #include "ecs/components/CTexture.h"
@@ -22,7 +27,17 @@ MCanvas::createCanvas(const CanvasSettings &settings,
 		throw std::runtime_error("Canvas with name '" + canvasName +
 								 "' already exists");
 	}
-	auto canvas = std::make_shared<Canvas>(settings, m_engine);
+	std::shared_ptr<Canvas> canvas;
+	auto construct = [&] {
+		canvas = std::make_shared<Canvas>(settings, m_engine);
+	};
+	// The constructor creates GL objects
+	if (m_engine) {
+		m_engine->runOnRenderThread(construct);
+	} else {
+		construct();
+	}
+	canvas->setRenderTargetPool(&m_renderTargets);
 	canvas->setName(canvasName);
 	m_canvases.push_back(canvas);
 	size_t newIndex = m_canvases.size() - 1;
@@ -65,6 +80,7 @@ void MCanvas::removeCanvas(size_t index) {
 
 	std::string removedName = m_canvases[index]->getName();
 
+	releaseCanvases({m_canvases[index]});
 	m_canvases.erase(m_canvases.begin() + index);
 
 	// Adjust active canvas index if necessary
@@ -220,8 +236,119 @@ MCanvas::getAllCanvasInfo() const {
 	return info;
 }
 
+// Canvases whose content is unchanged only rerun stale effects. A job
+// with a snapshot draws that instead of reading the ECS.
+struct MCanvas::RenderJob {
+	std::shared_ptr<Canvas> canvas;
+	bool draw;
+	std::shared_ptr<const Canvas::ShapeSnapshot> shapes;
+	void run() const {
+		if (shapes) {
+			canvas->render(*shapes);
+		} else if (draw) {
+			canvas->render();
+		} else if (canvas->needsPostProcess()) {
+			canvas->applyPostProcess();
+		}
+	}
+};
+
+void MCanvas::collectRenderJobs(std::vector<RenderJob> &cpuJobs,
+								std::vector<RenderJob> &gpuJobs) {
+	// GL canvas effects belong to the render thread; it checks them there
+	bool threaded = m_engine && m_engine->isRenderThreaded();
+	for (const auto &canvas : m_canvases) {
+		RenderJob job{canvas, canvas->needsRender(), nullptr};
+		bool cpu = canvas->rendersOnCpu();
+		if (!job.draw && (cpu || !threaded) && !canvas->needsPostProcess()) {
+			continue;
+		}
+		// Proxy rebuilds write to the registry; do them here so the render
+		// passes below only read it
+		MEcs *ecs = canvas->getECSManager();
+		if (job.draw && ecs) {
+			ecs->updateRenderProxies();
+		}
+		if (cpu) {
+			cpuJobs.push_back(std::move(job));
+		} else {
+			gpuJobs.push_back(std::move(job));
+		}
+	}
+}
+
+void MCanvas::runCpuJobs(const std::vector<RenderJob> &jobs) {
+	ThreadPool *pool = m_engine ? m_engine->getThreadPool() : nullptr;
+	if (pool && jobs.size() > 1) {
+		pool->parallelFor(jobs.size(), [&](size_t i) { jobs[i].run(); });
+	} else {
+		for (const RenderJob &job : jobs) {
+			job.run();
+		}
+	}
+}
+
+void MCanvas::renderAll() {
+	BLOT_PROFILE_SCOPE("MCanvas::renderAll");
+	std::vector<RenderJob> cpuJobs;
+	std::vector<RenderJob> gpuJobs;
+	collectRenderJobs(cpuJobs, gpuJobs);
+	for (const RenderJob &job : gpuJobs) {
+		job.run();
+	}
+	runCpuJobs(cpuJobs);
+	for (const RenderJob &job : cpuJobs) {
+		job.canvas->present();
+	}
+}
+
+void MCanvas::recordAll(FrameCommandQueue &queue) {
+	BLOT_PROFILE_SCOPE("MCanvas::recordAll");
+	std::vector<RenderJob> cpuJobs;
+	std::vector<RenderJob> gpuJobs;
+	collectRenderJobs(cpuJobs, gpuJobs);
+	// The next update changes the ECS while this frame renders, so GL
+	// canvases draw a copy of their shapes
+	for (RenderJob &job : gpuJobs) {
+		if (job.draw) {
+			job.shapes = job.canvas->takeSnapshot();
+		}
+		queue.record([job = std::move(job)] { job.run(); });
+	}
+	runCpuJobs(cpuJobs);
+
+	// Likewise the next update may redraw the pixels, so the upload works
+	// from a pooled copy
+	for (const RenderJob &job : cpuJobs) {
+		int rowLength = 0;
+		int rows = 0;
+		const uint8_t *pixels = job.canvas->getPresentPixels(&rowLength, &rows);
+		if (!pixels) {
+			continue;
+		}
+		size_t bytes = static_cast<size_t>(rowLength) * rows * 4;
+		auto copy = std::make_shared<std::vector<uint8_t>>(
+			m_renderTargets.acquireBuffer(bytes));
+		std::memcpy(copy->data(), pixels, bytes);
+		queue.record([this, canvas = job.canvas, copy, rowLength, rows] {
+			canvas->present(copy->data(), rowLength, rows);
+			m_renderTargets.releaseBuffer(std::move(*copy));
+		});
+	}
+}
+
+void MCanvas::releaseCanvases(std::vector<std::shared_ptr<Canvas>> canvases) {
+	if (m_engine && m_engine->isRenderThreaded()) {
+		// Queued frames may still use them; the last reference goes with
+		// the command, on the render thread
+		m_engine->submitRenderCommand(
+			[canvases = std::move(canvases)]() mutable { canvases.clear(); });
+	}
+}
+
 void MCanvas::clear() {
 	size_t oldCount = m_canvases.size();
+	releaseCanvases(std::move(m_canvases));
 	m_canvases.clear();
 	m_activeCanvasIndex = 0;
 
@@ -265,8 +392,6 @@ blot::json MCanvas::getSettings() const {
 
 void MCanvas::setSettings(const blot::json &settings) {
 	clear();
-	if (settings.contains("activeCanvasIndex"))
-		m_activeCanvasIndex = settings["activeCanvasIndex"];
 	if (settings.contains("canvases")) {
 		for (const auto &cj : settings["canvases"]) {
 			CanvasSettings cs;
@@ -284,13 +409,18 @@ void MCanvas::setSettings(const blot::json &settings) {
 				cs.a = cj["a"];
 			if (cj.contains("samples"))
 				cs.samples = cj["samples"];
-			std::string name = cj.value("name", "");
-			auto canvas = std::make_shared<Canvas>(cs, m_engine);
+			if (cj.contains("lodTolerance"))
+				cs.lodTolerance = cj["lodTolerance"];
+			// Same construction path as any other canvas
+			auto canvas = createCanvas(cs, cj.value("name", ""));
 			canvas->setSettings(cj);
-			canvas->setName(name);
-			m_canvases.push_back(canvas);
 		}
 	}
+	if (settings.contains("activeCanvasIndex") && !m_canvases.empty()) {
+		m_activeCanvasIndex =
+			std::min(settings["activeCanvasIndex"].get<size_t>(),
+					 m_canvases.size() - 1);
+	}
 }
 
 } // namespace blot
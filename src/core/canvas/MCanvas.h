@@ -8,10 +8,12 @@
 #include "Canvas.h"
 #include "core/IManager.h"
 #include "core/ISettings.h"
+#include "rendering/RenderTargetPool.h"
 
 namespace blot {
 
 class BlotEngine; // Forward declaration
+class FrameCommandQueue;
 
 class MCanvas : public IManager, public ISettings {
   public:
@@ -69,6 +71,17 @@ class MCanvas : public IManager, public ISettings {
 		m_onCanvasRenamed = callback;
 	}
 
+	// Render every canvas that needs it. CPU canvases render concurrently
+	// on the engine thread pool, then upload on the calling (GL) thread.
+	void renderAll();
+	// Render-thread variant: CPU canvases render here and record an upload
+	// of a pixel copy, GL canvases record a render of a snapshot of their
+	// shapes. Nothing recorded reads the ECS, so the next update may run
+	// while the frame renders.
+	void recordAll(FrameCommandQueue &queue);
+	// Offscreen targets shared by the canvases' post-process chains
+	RenderTargetPool &getRenderTargetPool() { return m_renderTargets; }
+
 	// Utility
 	void clear();
 	bool isEmpty() const { return m_canvases.empty(); }
@@ -82,6 +95,8 @@ class MCanvas : public IManager, public ISettings {
 	void setSettings(const json &settings) override;
 
   private:
+	// Declared first so it outlives the canvases borrowing from it
+	RenderTargetPool m_renderTargets;
 	std::vector<std::shared_ptr<Canvas>> m_canvases;
 	size_t m_activeCanvasIndex;
 	BlotEngine *m_engine;
@@ -93,6 +108,13 @@ class MCanvas : public IManager, public ISettings {
 	std::function<void(size_t, const std::string &, const std::string &)>
 		m_onCanvasRenamed;
 
+	struct RenderJob;
+	void collectRenderJobs(std::vector<RenderJob> &cpuJobs,
+						   std::vector<RenderJob> &gpuJobs);
+	void runCpuJobs(const std::vector<RenderJob> &jobs);
+	// Drop canvases on the thread that owns their GL objects
+	void releaseCanvases(std::vector<std::shared_ptr<Canvas>> canvases);
+
 	// Helper methods
 	void validateIndex(size_t index) const;
 	void validateName(const std::string &name) const;
@@ -10,4 +10,7 @@ std::string getUserSettingsFile() {
 }
 std::string getImGuiIniPath() { return getWorkspacesDir() + "/imgui.ini"; }
 std::string getManifestPath() { return "app.json"; }
+std::string getShaderCacheDir() {
+	return getAssetsDir() + "/user/cache/shaders";
+}
 } // namespace AppPaths
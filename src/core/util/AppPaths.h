@@ -8,4 +8,5 @@ std::string getUserSettingsFile();
 std::string getWorkspacesDir();
 std::string getImGuiIniPath();
 std::string getManifestPath();
+std::string getShaderCacheDir();
 } // namespace AppPaths
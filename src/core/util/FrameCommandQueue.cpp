@@ -0,0 +1,116 @@
+#include "core/util/FrameCommandQueue.h"
+
+#include <algorithm>
+#include <exception>
+
+#include <spdlog/spdlog.h>
+
+namespace blot {
+
+FrameCommandQueue::FrameCommandQueue(size_t maxFrames)
+	: m_maxFrames(std::max<size_t>(maxFrames, 1)) {}
+
+void FrameCommandQueue::setMaxFrames(size_t maxFrames) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_maxFrames = std::max<size_t>(maxFrames, 1);
+	m_wakeProducer.notify_all();
+}
+
+void FrameCommandQueue::record(Command command) {
+	// Only the producer touches the open frame
+	m_recording.push_back(std::move(command));
+}
+
+void FrameCommandQueue::submitFrame() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_wakeProducer.wait(lock, [this] {
+		return m_closed || m_submitted - m_completed < m_maxFrames;
+	});
+	Frame frame;
+	frame.id = ++m_submitted;
+	frame.commands.swap(m_recording);
+	m_frames.push_back(std::move(frame));
+	m_wakeConsumer.notify_one();
+}
+
+void FrameCommandQueue::runSync(Command command) {
+	if (isConsumerThread()) {
+		command();
+		return;
+	}
+	std::future<void> done;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_closed) {
+			spdlog::error("[FrameCommandQueue] runSync after close");
+			return;
+		}
+		m_syncCommands.push_back({std::move(command), std::promise<void>()});
+		done = m_syncCommands.back().done.get_future();
+		m_wakeConsumer.notify_one();
+	}
+	done.get();
+}
+
+void FrameCommandQueue::close() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_closed = true;
+	m_wakeConsumer.notify_all();
+	m_wakeProducer.notify_all();
+}
+
+bool FrameCommandQueue::executeNext() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_consumer = std::this_thread::get_id();
+	m_wakeConsumer.wait(lock, [this] {
+		return m_closed || !m_frames.empty() || !m_syncCommands.empty();
+	});
+
+	while (!m_syncCommands.empty()) {
+		SyncCommand sync = std::move(m_syncCommands.front());
+		m_syncCommands.pop_front();
+		lock.unlock();
+		try {
+			sync.command();
+			sync.done.set_value();
+		} catch (...) {
+			sync.done.set_exception(std::current_exception());
+		}
+		lock.lock();
+	}
+	m_wakeProducer.notify_all();
+
+	if (m_frames.empty()) {
+		return !m_closed;
+	}
+	Frame frame = std::move(m_frames.front());
+	m_frames.pop_front();
+	lock.unlock();
+
+	for (Command &command : frame.commands) {
+		// One bad command must not take the render thread down with it
+		try {
+			command();
+		} catch (const std::exception &e) {
+			spdlog::error("[FrameCommandQueue] Frame {} command failed: {}",
+						  frame.id, e.what());
+		} catch (...) {
+			spdlog::error("[FrameCommandQueue] Frame {} command failed",
+						  frame.id);
+		}
+	}
+	// Release captured resources before the producer moves on
+	frame.commands.clear();
+
+	lock.lock();
+	m_completed = frame.id;
+	m_wakeProducer.notify_all();
+	return true;
+}
+
+bool FrameCommandQueue::isConsumerThread() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_consumer == std::this_thread::get_id();
+}
+
+} // namespace blot
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blot {
+
+/**
+ * @brief Hands recorded frames from the update thread to the render thread.
+ *
+ * The producer records commands into the open frame and submits it; the
+ * consumer runs whole frames in order. At most `maxFrames` submitted frames
+ * are in flight (queued or executing); submitFrame() blocks beyond that, so
+ * the update side can run ahead of the GPU by a bounded amount only.
+ *
+ * runSync() slips a single command in ahead of the queued frames and waits
+ * for it, for work that needs the context right away (creating GL objects
+ * during an update).
+ */
+class FrameCommandQueue {
+  public:
+	using Command = std::function<void()>;
+
+	explicit FrameCommandQueue(size_t maxFrames = 1);
+	FrameCommandQueue(const FrameCommandQueue &) = delete;
+	FrameCommandQueue &operator=(const FrameCommandQueue &) = delete;
+
+	// Takes effect from the next submitFrame()
+	void setMaxFrames(size_t maxFrames);
+
+	// Producer side
+	void record(Command command);
+	// Close the open frame
+	void submitFrame();
+	// Run on the consumer ahead of queued frames and wait; rethrows.
+	// Runs inline when called from the consumer thread itself.
+	void runSync(Command command);
+	// Wake the consumer for the last time; queued frames still run
+	void close();
+
+	// Consumer side: run pending sync commands, then the next frame.
+	// Blocks until there is work; false once closed and drained.
+	bool executeNext();
+	bool isConsumerThread() const;
+
+  private:
+	struct Frame {
+		uint64_t id = 0;
+		std::vector<Command> commands;
+	};
+	struct SyncCommand {
+		Command command;
+		std::promise<void> done;
+	};
+
+	std::vector<Command> m_recording;
+	std::deque<Frame> m_frames;
+	std::deque<SyncCommand> m_syncCommands;
+	size_t m_maxFrames;
+	uint64_t m_submitted = 0;
+	uint64_t m_completed = 0;
+	bool m_closed = false;
+	std::thread::id m_consumer;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wakeConsumer;
+	std::condition_variable m_wakeProducer;
+};
+
+} // namespace blot
@@ -0,0 +1,154 @@
+#include "core/util/FramePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace blot {
+
+namespace {
+
+constexpr float kSmoothing = 0.1f; // Weight of the newest frame
+constexpr double kMinMargin = 0.0005;
+constexpr double kMaxMargin = 0.004;
+
+using Seconds = std::chrono::duration<double>;
+
+} // namespace
+
+FramePacer::FramePacer(size_t historySize)
+	: m_history(std::max<size_t>(historySize, 1), 0.0f) {}
+
+void FramePacer::setTargetFrameRate(int fps) {
+	m_targetFps = std::max(fps, 0);
+	m_period = m_targetFps > 0
+				   ? std::chrono::duration_cast<Clock::duration>(
+						 Seconds(1.0 / m_targetFps))
+				   : Clock::duration(0);
+	m_deadline = m_frameStart + m_period;
+}
+
+float FramePacer::beginFrame() {
+	Clock::time_point now = Clock::now();
+	if (!m_started) {
+		m_started = true;
+		m_frameStart = now;
+		m_deadline = now + m_period;
+		return 0.0f;
+	}
+	float delta = std::chrono::duration<float>(now - m_frameStart).count();
+	m_frameStart = now;
+
+	float ms = delta * 1000.0f;
+	m_history[m_historyNext] = ms;
+	m_historyNext = (m_historyNext + 1) % m_history.size();
+	m_historyCount = std::min(m_historyCount + 1, m_history.size());
+	m_smoothedMs = m_frames == 0
+					   ? ms
+					   : m_smoothedMs + kSmoothing * (ms - m_smoothedMs);
+	++m_frames;
+	return delta;
+}
+
+void FramePacer::waitForDeadline() {
+	if (m_targetFps <= 0) {
+		return;
+	}
+	Clock::time_point now = Clock::now();
+	if (now > m_deadline) {
+		++m_missed;
+		// More than a period behind: resynchronise instead of rushing to
+		// catch up with a burst of short frames
+		if (now - m_deadline > m_period) {
+			m_deadline = now;
+		}
+	} else {
+		sleepUntil(m_deadline);
+	}
+	m_deadline += m_period;
+}
+
+void FramePacer::sleepUntil(Clock::time_point deadline) {
+	if (m_mode == Mode::Sleep) {
+		std::this_thread::sleep_until(deadline);
+		return;
+	}
+	if (m_mode == Mode::Hybrid) {
+		// Leave room for the scheduler to be late waking us
+		double margin = std::clamp(m_overshoot * 2.0, kMinMargin, kMaxMargin);
+		Clock::time_point wake =
+			deadline - std::chrono::duration_cast<Clock::duration>(
+						   Seconds(margin));
+		Clock::time_point before = Clock::now();
+		if (wake > before) {
+			std::this_thread::sleep_until(wake);
+			double late = Seconds(Clock::now() - wake).count();
+			m_overshoot += 0.1 * (std::max(late, 0.0) - m_overshoot);
+		}
+	}
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
+
+float FramePacer::getSmoothedFps() const {
+	return m_smoothedMs > 0.0f ? 1000.0f / m_smoothedMs : 0.0f;
+}
+
+FramePacer::Stats FramePacer::getStats() const {
+	Stats stats;
+	stats.fps = getSmoothedFps();
+	stats.frames = m_frames;
+	stats.missedDeadlines = m_missed;
+	if (m_historyCount == 0) {
+		return stats;
+	}
+	std::vector<float> times(m_history.begin(),
+							 m_history.begin() + m_historyCount);
+	float total = 0.0f;
+	for (float ms : times) {
+		total += ms;
+	}
+	stats.averageMs = total / static_cast<float>(times.size());
+	auto percentile = [&](float p) {
+		size_t index = static_cast<size_t>(p * (times.size() - 1) + 0.5f);
+		std::nth_element(times.begin(), times.begin() + index, times.end());
+		return times[index];
+	};
+	stats.p50Ms = percentile(0.5f);
+	stats.p99Ms = percentile(0.99f);
+	stats.maxMs = *std::max_element(times.begin(), times.end());
+	return stats;
+}
+
+void FramePacer::resetStats() {
+	std::fill(m_history.begin(), m_history.end(), 0.0f);
+	m_historyNext = 0;
+	m_historyCount = 0;
+	m_smoothedMs = 0.0f;
+	m_frames = 0;
+	m_missed = 0;
+}
+
+const char *FramePacer::getModeName(Mode mode) {
+	switch (mode) {
+	case Mode::Sleep:
+		return "sleep";
+	case Mode::Spin:
+		return "spin";
+	case Mode::Hybrid:
+	default:
+		return "hybrid";
+	}
+}
+
+FramePacer::Mode FramePacer::getModeFromString(const std::string &name) {
+	if (name == "sleep") {
+		return Mode::Sleep;
+	}
+	if (name == "spin") {
+		return Mode::Spin;
+	}
+	return Mode::Hybrid; // Default
+}
+
+} // namespace blot
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace blot {
+
+/**
+ * @brief Holds the main loop to a target frame rate and keeps timing stats.
+ *
+ * In Hybrid mode the wait sleeps until shortly before the deadline and
+ * spins the rest of the way; the margin follows how far sleeps have been
+ * overshooting. Deadlines advance by whole periods from the previous one,
+ * so an early or late frame does not shift the ones after it.
+ *
+ * Frame times go into a ring buffer for percentiles; FPS is smoothed with
+ * an exponential moving average.
+ */
+class FramePacer {
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Mode {
+		Sleep,	// sleep_for the remaining time only (jittery, no CPU cost)
+		Hybrid, // coarse sleep, then spin to the deadline
+		Spin	// spin the whole wait (most precise, burns a core)
+	};
+
+	struct Stats {
+		float fps = 0.0f;	  // Smoothed
+		float averageMs = 0.0f; // Over the ring buffer
+		float p50Ms = 0.0f;
+		float p99Ms = 0.0f;
+		float maxMs = 0.0f;
+		uint64_t frames = 0;
+		uint64_t missedDeadlines = 0;
+	};
+
+	explicit FramePacer(size_t historySize = 240);
+
+	// 0 = uncapped: the wait returns at once
+	void setTargetFrameRate(int fps);
+	int getTargetFrameRate() const { return m_targetFps; }
+	void setMode(Mode mode) { m_mode = mode; }
+	Mode getMode() const { return m_mode; }
+
+	// Mark the start of a frame; returns seconds since the previous one
+	float beginFrame();
+	// Block until this frame's deadline
+	void waitForDeadline();
+
+	float getSmoothedFps() const;
+	Stats getStats() const;
+	void resetStats();
+
+	static const char *getModeName(Mode mode);
+	static Mode getModeFromString(const std::string &name);
+
+  private:
+	void sleepUntil(Clock::time_point deadline);
+
+	Mode m_mode = Mode::Hybrid;
+	int m_targetFps = 0;
+	Clock::duration m_period{0};
+	Clock::time_point m_frameStart;
+	Clock::time_point m_deadline;
+	bool m_started = false;
+
+	// Sleep overshoot estimate, in seconds, driving the spin margin
+	double m_overshoot = 0.001;
+
+	std::vector<float> m_history; // Frame times in ms
+	size_t m_historyNext = 0;
+	size_t m_historyCount = 0;
+	float m_smoothedMs = 0.0f;
+	uint64_t m_frames = 0;
+	uint64_t m_missed = 0;
+};
+
+} // namespace blot
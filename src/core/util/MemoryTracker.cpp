@@ -0,0 +1,182 @@
+#include "core/util/MemoryTracker.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace blot {
+
+namespace {
+
+json usageToJson(const MemoryTracker::Usage &usage) {
+	return {{"bytes", usage.bytes},
+			{"peakBytes", usage.peakBytes},
+			{"allocations", usage.allocations}};
+}
+
+double toMegabytes(int64_t bytes) {
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+void MemoryTracker::Counter::add(int64_t delta) {
+	int64_t now = bytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+	if (delta > 0) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	int64_t peak = peakBytes.load(std::memory_order_relaxed);
+	while (now > peak && !peakBytes.compare_exchange_weak(
+							 peak, now, std::memory_order_relaxed)) {
+	}
+}
+
+MemoryTracker::Usage MemoryTracker::Counter::load() const {
+	Usage usage;
+	usage.bytes = bytes.load(std::memory_order_relaxed);
+	usage.peakBytes = peakBytes.load(std::memory_order_relaxed);
+	usage.allocations = allocations.load(std::memory_order_relaxed);
+	return usage;
+}
+
+void MemoryTracker::Counter::resetPeak() {
+	peakBytes.store(bytes.load(std::memory_order_relaxed),
+					std::memory_order_relaxed);
+}
+
+json MemoryTracker::Snapshot::toJson() const {
+	json j;
+	for (size_t i = 0; i < kTagCount; ++i) {
+		const char *name = getTagName(static_cast<MemoryTag>(i));
+		j["cpu"][name] = usageToJson(cpu[i]);
+		j["gpu"][name] = usageToJson(gpu[i]);
+	}
+	j["cpu"]["total"] = usageToJson(cpuTotal);
+	j["gpu"]["total"] = usageToJson(gpuTotal);
+	return j;
+}
+
+MemoryTracker &MemoryTracker::instance() {
+	static MemoryTracker tracker;
+	return tracker;
+}
+
+MemoryTracker::Counter &MemoryTracker::counter(MemoryTag tag,
+											   MemoryDomain domain) {
+	size_t index = std::min(static_cast<size_t>(tag), kTagCount - 1);
+	return domain == MemoryDomain::Gpu ? m_gpu[index] : m_cpu[index];
+}
+
+void MemoryTracker::add(MemoryTag tag, MemoryDomain domain, int64_t bytes) {
+	counter(tag, domain).add(bytes);
+	(domain == MemoryDomain::Gpu ? m_gpuTotal : m_cpuTotal).add(bytes);
+}
+
+void MemoryTracker::remove(MemoryTag tag, MemoryDomain domain, int64_t bytes) {
+	add(tag, domain, -bytes);
+}
+
+int MemoryTracker::addProvider(MemoryTag tag, MemoryDomain domain,
+							   Provider provider) {
+	std::lock_guard<std::mutex> lock(m_providerMutex);
+	int id = m_nextProviderId++;
+	m_providers.push_back({id, tag, domain, std::move(provider)});
+	return id;
+}
+
+void MemoryTracker::removeProvider(int id) {
+	std::lock_guard<std::mutex> lock(m_providerMutex);
+	auto it = std::find_if(
+		m_providers.begin(), m_providers.end(),
+		[id](const ProviderEntry &entry) { return entry.id == id; });
+	if (it == m_providers.end()) {
+		return;
+	}
+	remove(it->tag, it->domain, static_cast<int64_t>(it->lastBytes));
+	m_providers.erase(it);
+}
+
+void MemoryTracker::sample() {
+	std::lock_guard<std::mutex> lock(m_providerMutex);
+	for (ProviderEntry &entry : m_providers) {
+		size_t bytes = entry.provider();
+		if (bytes != entry.lastBytes) {
+			add(entry.tag, entry.domain,
+				static_cast<int64_t>(bytes) -
+					static_cast<int64_t>(entry.lastBytes));
+			entry.lastBytes = bytes;
+		}
+	}
+}
+
+MemoryTracker::Snapshot MemoryTracker::snapshot() {
+	sample();
+	Snapshot snapshot;
+	for (size_t i = 0; i < kTagCount; ++i) {
+		snapshot.cpu[i] = m_cpu[i].load();
+		snapshot.gpu[i] = m_gpu[i].load();
+	}
+	snapshot.cpuTotal = m_cpuTotal.load();
+	snapshot.gpuTotal = m_gpuTotal.load();
+	return snapshot;
+}
+
+void MemoryTracker::resetPeaks() {
+	for (size_t i = 0; i < kTagCount; ++i) {
+		m_cpu[i].resetPeak();
+		m_gpu[i].resetPeak();
+	}
+	m_cpuTotal.resetPeak();
+	m_gpuTotal.resetPeak();
+}
+
+void MemoryTracker::logSnapshot() {
+	Snapshot current = snapshot();
+	spdlog::info("[MemoryTracker] CPU {:.1f} MB (peak {:.1f}), GPU {:.1f} MB "
+				 "(peak {:.1f})",
+				 toMegabytes(current.cpuTotal.bytes),
+				 toMegabytes(current.cpuTotal.peakBytes),
+				 toMegabytes(current.gpuTotal.bytes),
+				 toMegabytes(current.gpuTotal.peakBytes));
+	for (size_t i = 0; i < kTagCount; ++i) {
+		const Usage &cpu = current.cpu[i];
+		const Usage &gpu = current.gpu[i];
+		if (cpu.peakBytes == 0 && gpu.peakBytes == 0) {
+			continue;
+		}
+		spdlog::info("[MemoryTracker]   {:<9} CPU {:.1f} MB (peak {:.1f}), "
+					 "GPU {:.1f} MB (peak {:.1f})",
+					 getTagName(static_cast<MemoryTag>(i)),
+					 toMegabytes(cpu.bytes), toMegabytes(cpu.peakBytes),
+					 toMegabytes(gpu.bytes), toMegabytes(gpu.peakBytes));
+	}
+}
+
+const char *MemoryTracker::getTagName(MemoryTag tag) {
+	switch (tag) {
+	case MemoryTag::Ecs:
+		return "MEcs";
+	case MemoryTag::Rendering:
+		return "MRendering";
+	case MemoryTag::Canvas:
+		return "MCanvas";
+	case MemoryTag::Addon:
+		return "MAddon";
+	case MemoryTag::Cache:
+		return "Cache";
+	case MemoryTag::Other:
+	default:
+		return "Other";
+	}
+}
+
+size_t MemoryTracker::estimateTextureBytes(int width, int height,
+										   int bytesPerPixel, bool mipmaps) {
+	size_t bytes = static_cast<size_t>(std::max(width, 0)) *
+				   static_cast<size_t>(std::max(height, 0)) *
+				   static_cast<size_t>(std::max(bytesPerPixel, 0));
+	// A full chain adds a third on top of the base level
+	return mipmaps ? bytes + bytes / 3 : bytes;
+}
+
+} // namespace blot
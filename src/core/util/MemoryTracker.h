@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/json.h"
+
+namespace blot {
+
+enum class MemoryTag : uint8_t {
+	Ecs,
+	Rendering,
+	Canvas,
+	Addon,
+	Cache,
+	Other,
+	Count
+};
+
+enum class MemoryDomain : uint8_t { Cpu, Gpu };
+
+/**
+ * @brief Running byte counts per subsystem, for host and GPU memory.
+ *
+ * Allocation sites report with add()/remove() (or a TrackedMemory member);
+ * the counters are relaxed atomics, so this stays on in release builds.
+ * GPU figures are estimates from texture and buffer dimensions, not what
+ * the driver actually reserves.
+ *
+ * Memory that is cheaper to measure than to count (ECS storages, addon
+ * state) comes from providers, which are polled by sample() and
+ * snapshot(). High-water marks only see provider values at those polls.
+ * Providers run on the calling thread; take snapshots from the main
+ * thread.
+ */
+class MemoryTracker {
+  public:
+	static constexpr size_t kTagCount = static_cast<size_t>(MemoryTag::Count);
+
+	struct Usage {
+		int64_t bytes = 0;
+		int64_t peakBytes = 0;
+		uint64_t allocations = 0; // add() calls so far
+	};
+
+	struct Snapshot {
+		std::array<Usage, kTagCount> cpu{};
+		std::array<Usage, kTagCount> gpu{};
+		Usage cpuTotal;
+		Usage gpuTotal;
+
+		json toJson() const;
+	};
+
+	using Provider = std::function<size_t()>;
+
+	static MemoryTracker &instance();
+
+	void add(MemoryTag tag, MemoryDomain domain, int64_t bytes);
+	void remove(MemoryTag tag, MemoryDomain domain, int64_t bytes);
+
+	// Returns an id for removeProvider()
+	int addProvider(MemoryTag tag, MemoryDomain domain, Provider provider);
+	// Drops the provider and the bytes it last reported
+	void removeProvider(int id);
+	// Poll providers and fold their change into the counters
+	void sample();
+
+	Snapshot snapshot();
+	void resetPeaks();
+	void logSnapshot();
+
+	static const char *getTagName(MemoryTag tag);
+	// Estimated bytes of a texture, including a full mip chain if asked
+	static size_t estimateTextureBytes(int width, int height,
+									   int bytesPerPixel, bool mipmaps = false);
+
+  private:
+	struct Counter {
+		std::atomic<int64_t> bytes{0};
+		std::atomic<int64_t> peakBytes{0};
+		std::atomic<uint64_t> allocations{0};
+
+		void add(int64_t delta);
+		Usage load() const;
+		void resetPeak();
+	};
+	struct ProviderEntry {
+		int id;
+		MemoryTag tag;
+		MemoryDomain domain;
+		Provider provider;
+		size_t lastBytes = 0;
+	};
+
+	MemoryTracker() = default;
+	Counter &counter(MemoryTag tag, MemoryDomain domain);
+
+	std::array<Counter, kTagCount> m_cpu;
+	std::array<Counter, kTagCount> m_gpu;
+	Counter m_cpuTotal;
+	Counter m_gpuTotal;
+
+	std::mutex m_providerMutex;
+	std::vector<ProviderEntry> m_providers;
+	int m_nextProviderId = 1;
+};
+
+/**
+ * @brief Owned byte count that reports itself to the MemoryTracker.
+ *
+ * Keep one next to the allocation it describes and set() it whenever the
+ * allocation changes size; it removes its bytes when destroyed.
+ */
+class TrackedMemory {
+  public:
+	TrackedMemory(MemoryTag tag, MemoryDomain domain)
+		: m_tag(tag), m_domain(domain) {}
+	~TrackedMemory() { set(0); }
+	TrackedMemory(const TrackedMemory &) = delete;
+	TrackedMemory &operator=(const TrackedMemory &) = delete;
+
+	void set(size_t bytes) {
+		MemoryTracker &tracker = MemoryTracker::instance();
+		if (bytes > m_bytes) {
+			tracker.add(m_tag, m_domain, static_cast<int64_t>(bytes - m_bytes));
+		} else if (bytes < m_bytes) {
+			tracker.remove(m_tag, m_domain,
+						   static_cast<int64_t>(m_bytes - bytes));
+		}
+		m_bytes = bytes;
+	}
+	size_t get() const { return m_bytes; }
+
+  private:
+	MemoryTag m_tag;
+	MemoryDomain m_domain;
+	size_t m_bytes = 0;
+};
+
+} // namespace blot
@@ -0,0 +1,178 @@
+#include "core/util/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "core/json.h"
+
+namespace blot {
+
+namespace {
+
+int64_t steadyNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+} // namespace
+
+Profiler &Profiler::instance() {
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() : m_epoch(steadyNanoseconds()) {}
+
+void Profiler::setEnabled(bool enabled) {
+	m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setZonesPerThread(size_t zones) {
+	size_t size = 1;
+	while (size < zones) {
+		size <<= 1;
+	}
+	m_zonesPerThread.store(size, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string &name) {
+	ThreadRing &ring = localRing();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	ring.name = name;
+}
+
+const char *Profiler::intern(const std::string &name) {
+	thread_local std::unordered_map<std::string, const char *> cache;
+	auto it = cache.find(name);
+	if (it != cache.end()) {
+		return it->second;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const char *stable = m_names.insert(name).first->c_str();
+	cache.emplace(name, stable);
+	return stable;
+}
+
+int64_t Profiler::now() const { return steadyNanoseconds() - m_epoch; }
+
+Profiler::ThreadRing &Profiler::localRing() {
+	thread_local ThreadRing *ring = nullptr;
+	if (!ring) {
+		auto created = std::make_unique<ThreadRing>();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		created->id = static_cast<uint32_t>(m_rings.size() + 1);
+		created->name = "Thread " + std::to_string(created->id);
+		ring = created.get();
+		m_rings.push_back(std::move(created));
+	}
+	return *ring;
+}
+
+void Profiler::allocateZones(ThreadRing &ring) {
+	std::vector<Zone> zones(getZonesPerThread());
+	// Readers only look at a ring's zones under the lock
+	std::lock_guard<std::mutex> lock(m_mutex);
+	ring.zones.swap(zones);
+	ring.mask = ring.zones.size() - 1;
+}
+
+void Profiler::record(const char *name, int64_t start, int64_t end) {
+	ThreadRing &ring = localRing();
+	if (ring.zones.empty()) {
+		allocateZones(ring);
+	}
+	uint64_t index = ring.head.load(std::memory_order_relaxed);
+	// Pairs with the fence in toChromeTrace(): a reader that sees any of
+	// these stores also sees head at `index`, and discards the slot
+	std::atomic_thread_fence(std::memory_order_release);
+	Zone &zone = ring.zones[index & ring.mask];
+	zone.name.store(name, std::memory_order_relaxed);
+	zone.start.store(start, std::memory_order_relaxed);
+	zone.end.store(end, std::memory_order_relaxed);
+	ring.head.store(index + 1, std::memory_order_release);
+}
+
+std::string Profiler::toChromeTrace() const {
+	struct Copied {
+		uint64_t index;
+		const char *name;
+		int64_t start;
+		int64_t end;
+	};
+
+	json events = json::array();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto &ring : m_rings) {
+		events.push_back({{"name", "thread_name"},
+						  {"ph", "M"},
+						  {"pid", 1},
+						  {"tid", ring->id},
+						  {"args", {{"name", ring->name}}}});
+
+		const uint64_t size = ring->zones.size();
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		uint64_t first = head > size ? head - size : 0;
+		first = std::max(first, ring->tail.load(std::memory_order_relaxed));
+		std::vector<Copied> copied;
+		copied.reserve(static_cast<size_t>(head - first));
+		for (uint64_t i = first; i < head; ++i) {
+			const Zone &zone = ring->zones[i & ring->mask];
+			copied.push_back({i, zone.name.load(std::memory_order_relaxed),
+							  zone.start.load(std::memory_order_relaxed),
+							  zone.end.load(std::memory_order_relaxed)});
+		}
+		// Slots the writer reached while we copied may be torn
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t after = ring->head.load(std::memory_order_relaxed);
+
+		for (const Copied &zone : copied) {
+			if (zone.index + size <= after || !zone.name) {
+				continue;
+			}
+			events.push_back(
+				{{"name", zone.name},
+				 {"cat", "blot"},
+				 {"ph", "X"},
+				 {"pid", 1},
+				 {"tid", ring->id},
+				 {"ts", static_cast<double>(zone.start) / 1000.0},
+				 {"dur", static_cast<double>(zone.end - zone.start) / 1000.0}});
+		}
+	}
+	json trace;
+	trace["traceEvents"] = std::move(events);
+	trace["displayTimeUnit"] = "ms";
+	return trace.dump();
+}
+
+bool Profiler::writeChromeTrace(const std::string &path) const {
+	std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(parent, error);
+	}
+	std::ofstream file(path, std::ios::trunc);
+	file << toChromeTrace();
+	if (!file) {
+		spdlog::error("[Profiler] Could not write trace to {}", path);
+		return false;
+	}
+	spdlog::info("[Profiler] Wrote trace to {}", path);
+	return true;
+}
+
+void Profiler::reset() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto &ring : m_rings) {
+		ring->tail.store(ring->head.load(std::memory_order_acquire),
+						 std::memory_order_relaxed);
+	}
+}
+
+} // namespace blot
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace blot {
+
+/**
+ * @brief Scoped timing zones kept per thread, exportable as a Chrome trace.
+ *
+ * Each thread writes finished zones into its own fixed-size ring, so
+ * recording takes no locks and never allocates after the thread's first
+ * zone; when a ring wraps, the oldest zones are overwritten. A ring is
+ * allocated on its thread's first zone, at the size set when that
+ * happens. Dumping reads every ring without stopping the writers and
+ * drops any zone that was overwritten while it was being copied.
+ *
+ * The macros below compile to nothing unless BLOT_ENABLE_PROFILER is
+ * defined (CMake option of the same name). Load the JSON in
+ * chrome://tracing or https://ui.perfetto.dev.
+ */
+class Profiler {
+  public:
+	static constexpr size_t kDefaultZonesPerThread = 1 << 16; // 1.5 MB
+
+	static Profiler &instance();
+
+	// Ring size for threads that record their first zone from now on,
+	// rounded up to a power of two. Rings already allocated keep theirs.
+	void setZonesPerThread(size_t zones);
+	size_t getZonesPerThread() const {
+		return m_zonesPerThread.load(std::memory_order_relaxed);
+	}
+
+	// Recording can be paused at runtime; zones are dropped while disabled
+	void setEnabled(bool enabled);
+	bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+	// Label for the calling thread in the trace
+	void setThreadName(const std::string &name);
+	// Stable pointer for a runtime-built zone name; cached per thread
+	const char *intern(const std::string &name);
+
+	// Nanoseconds since the profiler started
+	int64_t now() const;
+	void record(const char *name, int64_t start, int64_t end);
+
+	// Everything still held in the rings, as Chrome trace event JSON
+	std::string toChromeTrace() const;
+	bool writeChromeTrace(const std::string &path) const;
+	// Forget recorded zones; threads keep their rings
+	void reset();
+
+  private:
+	struct Zone {
+		std::atomic<const char *> name{nullptr};
+		std::atomic<int64_t> start{0};
+		std::atomic<int64_t> end{0};
+	};
+	struct ThreadRing {
+		std::vector<Zone> zones; // Power of two, allocated on first record
+		uint64_t mask = 0;
+		std::atomic<uint64_t> head{0}; // Total zones ever written
+		std::atomic<uint64_t> tail{0}; // Zones before this were reset()
+		uint32_t id = 0;
+		std::string name;
+	};
+
+	Profiler();
+	ThreadRing &localRing();
+	void allocateZones(ThreadRing &ring);
+
+	std::atomic<bool> m_enabled{true};
+	std::atomic<size_t> m_zonesPerThread{kDefaultZonesPerThread};
+	int64_t m_epoch;
+
+	mutable std::mutex m_mutex; // Guards the lists, not the rings
+	std::vector<std::unique_ptr<ThreadRing>> m_rings;
+	std::unordered_set<std::string> m_names; // Nodes never move
+};
+
+/**
+ * @brief Records the time between its construction and destruction.
+ */
+class ProfileScope {
+  public:
+	explicit ProfileScope(const char *name) : m_name(name) {
+		Profiler &profiler = Profiler::instance();
+		if (profiler.isEnabled()) {
+			m_start = profiler.now();
+		} else {
+			m_name = nullptr;
+		}
+	}
+	~ProfileScope() {
+		if (m_name) {
+			Profiler &profiler = Profiler::instance();
+			profiler.record(m_name, m_start, profiler.now());
+		}
+	}
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+  private:
+	const char *m_name;
+	int64_t m_start = 0;
+};
+
+} // namespace blot
+
+#define BLOT_PROFILE_CONCAT_(a, b) a##b
+#define BLOT_PROFILE_CONCAT(a, b) BLOT_PROFILE_CONCAT_(a, b)
+
+#ifdef BLOT_ENABLE_PROFILER
+// Zone named by a string literal
+#define BLOT_PROFILE_SCOPE(name)                                               \
+	::blot::ProfileScope BLOT_PROFILE_CONCAT(blotProfileScope, __LINE__)(name)
+// Zone named by a std::string built at runtime (addon names and the like)
+#define BLOT_PROFILE_SCOPE_DYNAMIC(name)                                       \
+	::blot::ProfileScope BLOT_PROFILE_CONCAT(blotProfileScope, __LINE__)(      \
+		::blot::Profiler::instance().isEnabled()                               \
+			? ::blot::Profiler::instance().intern(name)                        \
+			: nullptr)
+#define BLOT_PROFILE_THREAD(name)                                              \
+	::blot::Profiler::instance().setThreadName(name)
+#else
+#define BLOT_PROFILE_SCOPE(name) ((void)0)
+#define BLOT_PROFILE_SCOPE_DYNAMIC(name) ((void)0)
+#define BLOT_PROFILE_THREAD(name) ((void)0)
+#endif
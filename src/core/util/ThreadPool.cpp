@@ -0,0 +1,135 @@
+#include "core/util/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace blot {
+
+namespace {
+
+// Shared by the caller and the helper tasks of one parallelForRange call.
+// Helpers that start after every chunk is claimed return without touching
+// `fn`, so the caller only waits for chunks actually in progress.
+struct RangeJob {
+	const std::function<void(size_t, size_t)> *fn = nullptr;
+	size_t count = 0;
+	size_t grain = 1;
+	size_t chunks = 0;
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> done{0};
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::exception_ptr error;
+
+	void run() {
+		size_t chunk;
+		while ((chunk = next.fetch_add(1)) < chunks) {
+			size_t begin = chunk * grain;
+			size_t end = std::min(begin + grain, count);
+			try {
+				(*fn)(begin, end);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+			if (done.fetch_add(1) + 1 == chunks) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+	}
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) {
+	if (threadCount == 0) {
+		unsigned int hardware = std::thread::hardware_concurrency();
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+	m_workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto &worker : m_workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_wake.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+			if (m_tasks.empty()) {
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void ThreadPool::parallelFor(size_t count,
+							 const std::function<void(size_t)> &fn) {
+	parallelForRange(count, 1, [&fn](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			fn(i);
+		}
+	});
+}
+
+void ThreadPool::parallelForRange(
+	size_t count, size_t grain,
+	const std::function<void(size_t, size_t)> &fn) {
+	if (count == 0) {
+		return;
+	}
+	grain = std::max<size_t>(grain, 1);
+	size_t chunks = (count + grain - 1) / grain;
+	if (chunks == 1) {
+		fn(0, count);
+		return;
+	}
+
+	auto job = std::make_shared<RangeJob>();
+	job->fn = &fn;
+	job->count = count;
+	job->grain = grain;
+	job->chunks = chunks;
+
+	size_t helpers = std::min(m_workers.size(), chunks - 1);
+	for (size_t i = 0; i < helpers; ++i) {
+		enqueue([job]() { job->run(); });
+	}
+	job->run();
+
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->finished.wait(lock, [&] { return job->done.load() == chunks; });
+	if (job->error) {
+		std::rethrow_exception(job->error);
+	}
+}
+
+} // namespace blot
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace blot {
+
+/**
+ * @brief Fixed set of worker threads shared by the engine.
+ *
+ * Owned by BlotEngine and handed to the managers that fan work out (canvas
+ * rendering, image filters). The parallelFor helpers block until every
+ * index has run, with the calling thread taking part, so they are safe to
+ * call from inside a task.
+ */
+class ThreadPool {
+  public:
+	// 0 = one worker per hardware thread, minus the calling thread
+	explicit ThreadPool(size_t threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	size_t getThreadCount() const { return m_workers.size(); }
+
+	// Queue a task; the future carries its result or exception
+	template <typename F>
+	auto submit(F &&task) -> std::future<std::invoke_result_t<F>>;
+
+	// Run fn(i) for every i in [0, count). Rethrows the first exception.
+	void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+	// Run fn(begin, end) over [0, count) in chunks of about `grain` items
+	void parallelForRange(size_t count, size_t grain,
+						  const std::function<void(size_t, size_t)> &fn);
+
+  private:
+	void enqueue(std::function<void()> task);
+	void workerLoop();
+
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_stopping = false;
+};
+
+template <typename F>
+auto ThreadPool::submit(F &&task) -> std::future<std::invoke_result_t<F>> {
+	using Result = std::invoke_result_t<F>;
+	auto packaged =
+		std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+	std::future<Result> future = packaged->get_future();
+	enqueue([packaged]() { (*packaged)(); });
+	return future;
+}
+
+} // namespace blot
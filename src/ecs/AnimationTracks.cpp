@@ -0,0 +1,537 @@
+#include "ecs/AnimationTracks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <spdlog/spdlog.h>
+
+#include "core/util/ThreadPool.h"
+#include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CShape.h"
+#include "ecs/components/CTransform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOT_ANIM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace blot {
+namespace ecs {
+
+namespace {
+
+// Below this many tracks a frame is cheaper than handing chunks out
+constexpr size_t kParallelTracks = 16384;
+constexpr size_t kParallelGrain = 8192;
+
+// The lane math is written once against these helpers and instantiated
+// for plain floats (scalar tail) and 4-lane vectors, as in BlendKernels.
+inline float vmin(float a, float b) { return std::min(a, b); }
+inline float vmax(float a, float b) { return std::max(a, b); }
+// Inputs are never negative, so truncation is floor
+inline float vfloor(float a) { return std::floor(a); }
+
+#ifdef BLOT_ANIM_SSE2
+struct F4 {
+	__m128 v;
+	F4(__m128 x) : v(x) {}
+	F4(float x) : v(_mm_set1_ps(x)) {}
+};
+inline F4 operator+(F4 a, F4 b) { return _mm_add_ps(a.v, b.v); }
+inline F4 operator-(F4 a, F4 b) { return _mm_sub_ps(a.v, b.v); }
+inline F4 operator*(F4 a, F4 b) { return _mm_mul_ps(a.v, b.v); }
+inline F4 vmin(F4 a, F4 b) { return _mm_min_ps(a.v, b.v); }
+inline F4 vmax(F4 a, F4 b) { return _mm_max_ps(a.v, b.v); }
+inline F4 vfloor(F4 a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)); }
+inline F4 load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, F4 a) { _mm_storeu_ps(p, a.v); }
+#endif
+
+// Time after deltaTime: wrapped into [0, duration) when looping, held at
+// duration otherwise. `loop` and `rate` are 0 or 1.
+template <typename T>
+inline T advanceTime(T time, T rate, T loop, T duration, T invDuration,
+					 T deltaTime) {
+	T t = time + deltaTime * rate;
+	T wrapped = t - duration * vfloor(t * invDuration);
+	T held = vmin(t, duration);
+	return held + loop * (wrapped - held);
+}
+
+template <typename T>
+inline T evaluateSegment(T time, T start, T invLength, T from, T delta, T a,
+						 T b, T c) {
+	T u = vmin(vmax((time - start) * invLength, T(0.0f)), T(1.0f));
+	return from + delta * (u * (a + u * (b + u * c)));
+}
+
+// The curves that are not polynomials, for u in [0, 1]
+float evaluateCurve(Ease ease, float u) {
+	if (ease == Ease::Bounce) {
+		constexpr float kScale = 7.5625f;
+		constexpr float kWidth = 2.75f;
+		if (u < 1.0f / kWidth) {
+			return kScale * u * u;
+		}
+		if (u < 2.0f / kWidth) {
+			u -= 1.5f / kWidth;
+			return kScale * u * u + 0.75f;
+		}
+		if (u < 2.5f / kWidth) {
+			u -= 2.25f / kWidth;
+			return kScale * u * u + 0.9375f;
+		}
+		u -= 2.625f / kWidth;
+		return kScale * u * u + 0.984375f;
+	}
+	if (u <= 0.0f || u >= 1.0f) {
+		return u <= 0.0f ? 0.0f : 1.0f;
+	}
+	constexpr float kPeriod = 2.0f * 3.14159265f / 3.0f;
+	return std::exp2(-10.0f * u) * std::sin((u * 10.0f - 0.75f) * kPeriod) +
+		   1.0f;
+}
+
+// ease(u) = u * (a + u * (b + u * c)); Bounce and Elastic get Linear here
+// and are corrected after the vector pass
+void getEaseCoefficients(Ease ease, float &a, float &b, float &c) {
+	switch (ease) {
+	case Ease::Step:
+		a = 0.0f, b = 0.0f, c = 0.0f;
+		return;
+	case Ease::Linear:
+		a = 1.0f, b = 0.0f, c = 0.0f;
+		return;
+	case Ease::EaseIn:
+		a = 0.0f, b = 1.0f, c = 0.0f;
+		return;
+	case Ease::EaseOut:
+		a = 2.0f, b = -1.0f, c = 0.0f;
+		return;
+	case Ease::EaseInOut:
+		a = 0.0f, b = 3.0f, c = -2.0f;
+		return;
+	case Ease::EaseInCubic:
+		a = 0.0f, b = 0.0f, c = 1.0f;
+		return;
+	case Ease::EaseOutCubic:
+		a = 3.0f, b = -3.0f, c = 1.0f;
+		return;
+	default:
+		break;
+	}
+	a = 1.0f, b = 0.0f, c = 0.0f;
+}
+
+// Outcome of a track's write-back, collected after the parallel pass
+enum Written : uint8_t { kNotWritten, kShapeWritten, kOrphaned };
+
+float *getTarget(CTransform *transform, CDrawStyle *style,
+				 AnimProperty property) {
+	if (property <= AnimProperty::ScaleZ) {
+		if (!transform) {
+			return nullptr;
+		}
+		switch (property) {
+		case AnimProperty::PositionX:
+			return &transform->position.x;
+		case AnimProperty::PositionY:
+			return &transform->position.y;
+		case AnimProperty::PositionZ:
+			return &transform->position.z;
+		case AnimProperty::ScaleX:
+			return &transform->scale.x;
+		case AnimProperty::ScaleY:
+			return &transform->scale.y;
+		default:
+			return &transform->scale.z;
+		}
+	}
+	if (!style) {
+		return nullptr;
+	}
+	switch (property) {
+	case AnimProperty::FillR:
+		return &style->fillR;
+	case AnimProperty::FillG:
+		return &style->fillG;
+	case AnimProperty::FillB:
+		return &style->fillB;
+	case AnimProperty::FillA:
+		return &style->fillA;
+	case AnimProperty::StrokeR:
+		return &style->strokeR;
+	case AnimProperty::StrokeG:
+		return &style->strokeG;
+	case AnimProperty::StrokeB:
+		return &style->strokeB;
+	case AnimProperty::StrokeA:
+		return &style->strokeA;
+	default:
+		return &style->strokeWidth;
+	}
+}
+
+} // namespace
+
+AnimationTracks::TrackId
+AnimationTracks::addTrack(entt::entity entity, AnimProperty property,
+						  const std::vector<Keyframe> &keyframes, bool loop) {
+	if (keyframes.empty()) {
+		spdlog::error("[AnimationTracks] A track needs at least one keyframe");
+		return kInvalidTrack;
+	}
+	std::vector<Keyframe> sorted = keyframes;
+	std::stable_sort(sorted.begin(), sorted.end(),
+					 [](const Keyframe &a, const Keyframe &b) {
+						 return a.time < b.time;
+					 });
+
+	size_t slot = m_entities.size();
+	auto keyFirst = static_cast<uint32_t>(m_keyTime.size());
+	for (const Keyframe &key : sorted) {
+		m_keyTime.push_back(key.time);
+		m_keyValue.push_back(key.value);
+		m_keyEase.push_back(key.ease);
+	}
+	float duration = std::max(sorted.back().time, 0.0f);
+
+	TrackId id;
+	if (!m_freeIds.empty()) {
+		id = m_freeIds.back();
+		m_freeIds.pop_back();
+	} else {
+		id = static_cast<TrackId>(m_slots.size());
+		m_slots.push_back(0);
+	}
+	m_slots[id] = static_cast<uint32_t>(slot);
+
+	m_entities.push_back(entity);
+	m_properties.push_back(property);
+	m_ids.push_back(id);
+	m_time.push_back(0.0f);
+	m_duration.push_back(duration);
+	m_invDuration.push_back(duration > 0.0f ? 1.0f / duration : 0.0f);
+	m_rate.push_back(1.0f);
+	m_loop.push_back(loop && duration > 0.0f ? 1.0f : 0.0f);
+	m_keyFirst.push_back(keyFirst);
+	m_keyCount.push_back(static_cast<uint32_t>(sorted.size()));
+	m_cursor.push_back(keyFirst);
+	for (auto *field : {&m_segStart, &m_segEnd, &m_segInvLength, &m_segFrom,
+						&m_segDelta, &m_easeA, &m_easeB, &m_easeC, &m_value}) {
+		field->push_back(0.0f);
+	}
+	m_segCurve.push_back(Ease::Linear);
+	m_applied.push_back(std::numeric_limits<float>::quiet_NaN());
+	seekSegment(slot);
+	return id;
+}
+
+void AnimationTracks::removeTrack(TrackId id) {
+	if (isValid(id)) {
+		removeSlot(m_slots[id]);
+	}
+}
+
+void AnimationTracks::removeTracks(entt::entity entity) {
+	for (size_t slot = m_entities.size(); slot-- > 0;) {
+		if (m_entities[slot] == entity) {
+			removeSlot(slot);
+		}
+	}
+}
+
+void AnimationTracks::clear() { *this = AnimationTracks(); }
+
+void AnimationTracks::setPlaying(TrackId id, bool playing) {
+	if (isValid(id)) {
+		m_rate[m_slots[id]] = playing ? 1.0f : 0.0f;
+	}
+}
+
+void AnimationTracks::seek(TrackId id, float time) {
+	if (!isValid(id)) {
+		return;
+	}
+	size_t slot = m_slots[id];
+	m_time[slot] = std::clamp(time, 0.0f, m_duration[slot]);
+	seekSegment(slot);
+}
+
+bool AnimationTracks::isValid(TrackId id) const {
+	return id < m_slots.size() && m_slots[id] != kInvalidTrack;
+}
+
+float AnimationTracks::getTime(TrackId id) const {
+	return isValid(id) ? m_time[m_slots[id]] : 0.0f;
+}
+
+void AnimationTracks::removeSlot(size_t slot) {
+	m_deadKeys += m_keyCount[slot];
+	m_slots[m_ids[slot]] = kInvalidTrack;
+	m_freeIds.push_back(m_ids[slot]);
+
+	size_t last = m_entities.size() - 1;
+	auto moveLast = [slot, last](auto &field) {
+		field[slot] = field[last];
+		field.pop_back();
+	};
+	moveLast(m_entities);
+	moveLast(m_properties);
+	moveLast(m_ids);
+	moveLast(m_segCurve);
+	for (auto *field :
+		 {&m_time, &m_duration, &m_invDuration, &m_rate, &m_loop, &m_segStart,
+		  &m_segEnd, &m_segInvLength, &m_segFrom, &m_segDelta, &m_easeA,
+		  &m_easeB, &m_easeC, &m_value, &m_applied}) {
+		moveLast(*field);
+	}
+	for (auto *field : {&m_keyFirst, &m_keyCount, &m_cursor}) {
+		moveLast(*field);
+	}
+	if (slot != last) {
+		m_slots[m_ids[slot]] = static_cast<uint32_t>(slot);
+	}
+
+	if (m_deadKeys * 2 > m_keyTime.size()) {
+		compactKeys();
+	}
+}
+
+void AnimationTracks::compactKeys() {
+	std::vector<float> keyTime;
+	std::vector<float> keyValue;
+	std::vector<Ease> keyEase;
+	size_t liveKeys = m_keyTime.size() - m_deadKeys;
+	keyTime.reserve(liveKeys);
+	keyValue.reserve(liveKeys);
+	keyEase.reserve(liveKeys);
+	for (size_t slot = 0; slot < m_entities.size(); ++slot) {
+		uint32_t first = m_keyFirst[slot];
+		auto newFirst = static_cast<uint32_t>(keyTime.size());
+		keyTime.insert(keyTime.end(), m_keyTime.begin() + first,
+					   m_keyTime.begin() + first + m_keyCount[slot]);
+		keyValue.insert(keyValue.end(), m_keyValue.begin() + first,
+						m_keyValue.begin() + first + m_keyCount[slot]);
+		keyEase.insert(keyEase.end(), m_keyEase.begin() + first,
+					   m_keyEase.begin() + first + m_keyCount[slot]);
+		m_cursor[slot] = m_cursor[slot] - first + newFirst;
+		m_keyFirst[slot] = newFirst;
+	}
+	m_keyTime = std::move(keyTime);
+	m_keyValue = std::move(keyValue);
+	m_keyEase = std::move(keyEase);
+	m_deadKeys = 0;
+}
+
+void AnimationTracks::seekSegment(size_t slot) {
+	// Finite bounds: the hold segment's start is scaled by a zero length
+	constexpr float kLowest = std::numeric_limits<float>::lowest();
+	constexpr float kHighest = std::numeric_limits<float>::max();
+	float time = m_time[slot];
+	uint32_t first = m_keyFirst[slot];
+	uint32_t last = first + m_keyCount[slot] - 1;
+
+	// Before the first or from the last keyframe on, hold its value
+	uint32_t hold = time < m_keyTime[first] ? first : last;
+	if (time < m_keyTime[first] || time >= m_keyTime[last]) {
+		m_cursor[slot] = hold;
+		m_segStart[slot] = hold == first ? kLowest : m_keyTime[last];
+		m_segEnd[slot] = hold == first ? m_keyTime[first] : kHighest;
+		m_segInvLength[slot] = 0.0f;
+		m_segFrom[slot] = m_keyValue[hold];
+		m_segDelta[slot] = 0.0f;
+		m_easeA[slot] = m_easeB[slot] = m_easeC[slot] = 0.0f;
+		m_segCurve[slot] = Ease::Linear;
+		return;
+	}
+
+	// Tracks mostly move forward by less than a segment, so search on
+	// from the cached keyframe unless time went back (loop, seek)
+	uint32_t key = m_cursor[slot];
+	if (key >= last || m_keyTime[key] > time) {
+		key = first;
+	}
+	while (m_keyTime[key + 1] <= time) {
+		++key;
+	}
+	m_cursor[slot] = key;
+	m_segStart[slot] = m_keyTime[key];
+	m_segEnd[slot] = m_keyTime[key + 1];
+	m_segInvLength[slot] = 1.0f / (m_keyTime[key + 1] - m_keyTime[key]);
+	m_segFrom[slot] = m_keyValue[key];
+	m_segDelta[slot] = m_keyValue[key + 1] - m_keyValue[key];
+	Ease ease = m_keyEase[key];
+	getEaseCoefficients(ease, m_easeA[slot], m_easeB[slot], m_easeC[slot]);
+	bool curve = ease == Ease::Bounce || ease == Ease::Elastic;
+	m_segCurve[slot] = curve ? ease : Ease::Linear;
+}
+
+void AnimationTracks::advance(size_t begin, size_t end, float deltaTime) {
+	float *time = m_time.data();
+	const float *rate = m_rate.data();
+	const float *loop = m_loop.data();
+	const float *duration = m_duration.data();
+	const float *invDuration = m_invDuration.data();
+	size_t i = begin;
+#ifdef BLOT_ANIM_SSE2
+	// Two 4-lane vectors per step
+	for (; i + 8 <= end; i += 8) {
+		for (size_t j = i; j < i + 8; j += 4) {
+			store(time + j, advanceTime<F4>(load(time + j), load(rate + j),
+											 load(loop + j), load(duration + j),
+											 load(invDuration + j), deltaTime));
+		}
+	}
+#endif
+	for (; i < end; ++i) {
+		time[i] = advanceTime<float>(time[i], rate[i], loop[i], duration[i],
+									 invDuration[i], deltaTime);
+	}
+}
+
+void AnimationTracks::evaluate(size_t begin, size_t end) {
+	const float *time = m_time.data();
+	const float *start = m_segStart.data();
+	const float *invLength = m_segInvLength.data();
+	const float *from = m_segFrom.data();
+	const float *delta = m_segDelta.data();
+	const float *a = m_easeA.data();
+	const float *b = m_easeB.data();
+	const float *c = m_easeC.data();
+	float *value = m_value.data();
+	size_t i = begin;
+#ifdef BLOT_ANIM_SSE2
+	for (; i + 8 <= end; i += 8) {
+		for (size_t j = i; j < i + 8; j += 4) {
+			store(value + j,
+				  evaluateSegment<F4>(load(time + j), load(start + j),
+									  load(invLength + j), load(from + j),
+									  load(delta + j), load(a + j),
+									  load(b + j), load(c + j)));
+		}
+	}
+#endif
+	for (; i < end; ++i) {
+		value[i] = evaluateSegment<float>(time[i], start[i], invLength[i],
+										  from[i], delta[i], a[i], b[i], c[i]);
+	}
+	// Bounce and Elastic lanes were evaluated as Linear above
+	const Ease *curve = m_segCurve.data();
+	for (i = begin; i < end; ++i) {
+		if (curve[i] != Ease::Linear) {
+			float u = std::clamp((time[i] - start[i]) * invLength[i], 0.0f,
+								 1.0f);
+			value[i] = from[i] + delta[i] * evaluateCurve(curve[i], u);
+		}
+	}
+}
+
+void AnimationTracks::collectWritten(
+	std::vector<entt::entity> &changedShapes) {
+	std::vector<size_t> orphans;
+	for (size_t slot = 0; slot < m_written.size(); ++slot) {
+		if (m_written[slot] == kOrphaned) {
+			orphans.push_back(slot);
+		} else if (m_written[slot] == kShapeWritten &&
+				   (changedShapes.empty() ||
+					changedShapes.back() != m_entities[slot])) {
+			changedShapes.push_back(m_entities[slot]);
+		}
+	}
+	// Highest first, so moving the last track in never moves an orphan
+	for (auto it = orphans.rbegin(); it != orphans.rend(); ++it) {
+		removeSlot(*it);
+	}
+}
+
+void AnimationTracks::update(entt::registry &registry, float deltaTime,
+							 ThreadPool *pool,
+							 std::vector<entt::entity> &changedShapes) {
+	// Fetched up front: looking a pool up can create it, which the
+	// threads below must not do
+	auto &transforms = registry.storage<CTransform>();
+	auto &styles = registry.storage<CDrawStyle>();
+	auto &shapes = registry.storage<CShape>();
+	m_written.resize(m_entities.size());
+
+	auto run = [&](size_t begin, size_t end) {
+		advance(begin, end, deltaTime);
+		for (size_t slot = begin; slot < end; ++slot) {
+			if (m_time[slot] < m_segStart[slot] ||
+				m_time[slot] >= m_segEnd[slot]) {
+				seekSegment(slot);
+			}
+		}
+		evaluate(begin, end);
+
+		// An entity's tracks are usually neighbours, so its components are
+		// looked up once per run of slots rather than once per track
+		entt::entity entity = entt::null;
+		bool live = false;
+		bool shape = false;
+		CTransform *transform = nullptr;
+		CDrawStyle *style = nullptr;
+		for (size_t slot = begin; slot < end; ++slot) {
+			if (slot == begin || m_entities[slot] != entity) {
+				entity = m_entities[slot];
+				live = registry.valid(entity);
+				shape = live && shapes.contains(entity);
+				transform = live && transforms.contains(entity)
+								? &transforms.get(entity)
+								: nullptr;
+				style = live && styles.contains(entity) ? &styles.get(entity)
+														: nullptr;
+			}
+			if (!live) {
+				m_written[slot] = kOrphaned;
+				continue;
+			}
+			float value = m_value[slot];
+			float *target = nullptr;
+			if (value != m_applied[slot]) {
+				target = getTarget(transform, style, m_properties[slot]);
+			}
+			if (!target) {
+				m_written[slot] = kNotWritten;
+				continue;
+			}
+			*target = value;
+			m_applied[slot] = value;
+			m_written[slot] = shape ? kShapeWritten : kNotWritten;
+		}
+	};
+	size_t count = m_entities.size();
+	if (pool && count >= kParallelTracks) {
+		pool->parallelForRange(count, kParallelGrain, run);
+	} else {
+		run(0, count);
+	}
+	collectWritten(changedShapes);
+}
+
+size_t AnimationTracks::getMemoryUsage() const {
+	size_t bytes = m_entities.capacity() * sizeof(entt::entity) +
+				   m_properties.capacity() * sizeof(AnimProperty) +
+				   m_ids.capacity() * sizeof(TrackId) +
+				   m_keyEase.capacity() * sizeof(Ease) +
+				   m_segCurve.capacity() * sizeof(Ease) +
+				   m_written.capacity() * sizeof(uint8_t) +
+				   m_slots.capacity() * sizeof(uint32_t) +
+				   m_freeIds.capacity() * sizeof(TrackId);
+	for (const auto *field :
+		 {&m_time, &m_duration, &m_invDuration, &m_rate, &m_loop, &m_segStart,
+		  &m_segEnd, &m_segInvLength, &m_segFrom, &m_segDelta, &m_easeA,
+		  &m_easeB, &m_easeC, &m_value, &m_applied, &m_keyTime, &m_keyValue}) {
+		bytes += field->capacity() * sizeof(float);
+	}
+	for (const auto *field : {&m_keyFirst, &m_keyCount, &m_cursor}) {
+		bytes += field->capacity() * sizeof(uint32_t);
+	}
+	return bytes;
+}
+
+} // namespace ecs
+} // namespace blot
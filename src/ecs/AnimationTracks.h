@@ -0,0 +1,152 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blot {
+class ThreadPool;
+
+namespace ecs {
+
+// Component field a track drives
+enum class AnimProperty : uint8_t {
+	PositionX,
+	PositionY,
+	PositionZ,
+	ScaleX,
+	ScaleY,
+	ScaleZ,
+	FillR,
+	FillG,
+	FillB,
+	FillA,
+	StrokeR,
+	StrokeG,
+	StrokeB,
+	StrokeA,
+	StrokeWidth
+};
+
+// Easing of the segment from a keyframe to the next. Up to EaseOutCubic
+// each curve is a cubic in the segment's progress, so lanes never branch
+// on it; Bounce and Elastic segments are evaluated per track instead.
+enum class Ease : uint8_t {
+	Step, // Hold the keyframe value until the next keyframe
+	Linear,
+	EaseIn,	   // Quadratic
+	EaseOut,   // Quadratic
+	EaseInOut, // Smoothstep
+	EaseInCubic,
+	EaseOutCubic,
+	Bounce,	 // Settles onto the next value in decaying bounces
+	Elastic // Overshoots and rings out onto the next value
+};
+
+struct Keyframe {
+	float time = 0.0f; // Seconds from the start of the track
+	float value = 0.0f;
+	Ease ease = Ease::Linear;
+};
+
+/**
+ * @brief Keyframed property animation for every entity, stored as arrays
+ * of track fields rather than per-entity components.
+ *
+ * Each track caches the segment its time falls in (start, length, values
+ * and easing coefficients), so a frame only seeks when a track crosses a
+ * keyframe. Advancing and evaluating then run over plain float arrays,
+ * in 4-lane SSE2 vectors (two per loop step) where available, and each
+ * chunk of tracks writes its results to CTransform and CDrawStyle in the
+ * same pass, so large track counts run on the thread pool end to end.
+ * Tracks that did not change value write nothing; shapes that did get
+ * their render proxy queued.
+ *
+ * Tracks of destroyed entities are dropped on the next update. Track ids
+ * stay valid until the track is removed.
+ */
+class AnimationTracks {
+  public:
+	using TrackId = uint32_t;
+	static constexpr TrackId kInvalidTrack = UINT32_MAX;
+
+	// Keyframes need not be sorted; kInvalidTrack if there are none. The
+	// track lasts until its last keyframe, then holds that value or, with
+	// `loop`, starts over. An entity should have one track per property:
+	// tracks are written in parallel, so two on one field race.
+	TrackId addTrack(entt::entity entity, AnimProperty property,
+					 const std::vector<Keyframe> &keyframes, bool loop = false);
+	void removeTrack(TrackId id);
+	void removeTracks(entt::entity entity);
+	void clear();
+
+	void setPlaying(TrackId id, bool playing);
+	void seek(TrackId id, float time);
+	bool isValid(TrackId id) const;
+	float getTime(TrackId id) const;
+	size_t size() const { return m_entities.size(); }
+
+	// Advance every playing track by deltaTime, evaluate, and write the
+	// values that changed. Shapes among the written entities are appended
+	// to `changedShapes` for their render proxies. With a pool, large
+	// track counts are evaluated and written in parallel.
+	void update(entt::registry &registry, float deltaTime, ThreadPool *pool,
+				std::vector<entt::entity> &changedShapes);
+
+	size_t getMemoryUsage() const;
+
+  private:
+	// Track fields, one array each, indexed by slot. Removal moves the
+	// last track into the freed slot.
+	std::vector<entt::entity> m_entities;
+	std::vector<AnimProperty> m_properties;
+	std::vector<TrackId> m_ids;
+	std::vector<float> m_time;
+	std::vector<float> m_duration;
+	std::vector<float> m_invDuration; // 0 for a single keyframe
+	std::vector<float> m_rate;	   // 1 playing, 0 paused
+	std::vector<float> m_loop;	   // 1 looping, 0 holding at the end
+	std::vector<uint32_t> m_keyFirst; // Into the keyframe arrays
+	std::vector<uint32_t> m_keyCount;
+	std::vector<uint32_t> m_cursor; // Keyframe the cached segment starts at
+
+	// Cached segment: value = from + delta * ease(u), with
+	// u = clamp((time - start) * invLength, 0, 1) and
+	// ease(u) = u * (easeA + u * (easeB + u * easeC))
+	std::vector<float> m_segStart;
+	std::vector<float> m_segEnd;
+	std::vector<float> m_segInvLength;
+	std::vector<float> m_segFrom;
+	std::vector<float> m_segDelta;
+	std::vector<float> m_easeA;
+	std::vector<float> m_easeB;
+	std::vector<float> m_easeC;
+	// Bounce or Elastic, else Linear: the cubic covers it
+	std::vector<Ease> m_segCurve;
+
+	std::vector<float> m_value;
+	std::vector<float> m_applied; // Last value written, NaN before any
+	std::vector<uint8_t> m_written; // What this update's write-back did
+
+	// Keyframes of every track, back to back
+	std::vector<float> m_keyTime;
+	std::vector<float> m_keyValue;
+	std::vector<Ease> m_keyEase;
+	size_t m_deadKeys = 0;
+
+	// Slot of each id, UINT32_MAX when free
+	std::vector<uint32_t> m_slots;
+	std::vector<TrackId> m_freeIds;
+
+	void removeSlot(size_t slot);
+	void compactKeys();
+	void seekSegment(size_t slot);
+	void advance(size_t begin, size_t end, float deltaTime);
+	void evaluate(size_t begin, size_t end);
+	// Queue written shapes and drop the tracks of destroyed entities
+	void collectWritten(std::vector<entt::entity> &changedShapes);
+};
+
+} // namespace ecs
+} // namespace blot
@@ -1,58 +1,323 @@
 #include "ecs/MEcs.h"
 #include <algorithm>
+#include <chrono>
 #include <entt/entt.hpp>
 #include <iostream>
 #include "core/ISettings.h"
-#include "ecs/components/CAnimation.h"
+#include "core/util/MemoryTracker.h"
+#include "core/util/Profiler.h"
+#include "core/util/ThreadPool.h"
 #include "ecs/components/CDrawStyle.h"
 #include "ecs/components/CDrawing.h"
+#include "ecs/components/CName.h"
 #include "ecs/components/CNode.h"
 #include "ecs/components/CParameter.h"
+#include "ecs/components/CRenderProxy.h"
 #include "ecs/components/CScript.h"
 #include "ecs/components/CSelection.h"
 #include "ecs/components/CShape.h"
+#include "ecs/components/CTexture.h"
 #include "ecs/components/CTransform.h"
 #include "ecs/systems/SCanvas.h"
+#include "ecs/systems/SNodeGraph.h"
 #include "ecs/systems/SShapeRendering.h"
 
 namespace blot {
 
+namespace {
+
+// Below this many changed shapes the queue is cheaper than a parallel walk
+constexpr size_t kParallelProxies = 8192;
+constexpr size_t kProxyGrain = 4096;
+
+template <typename... Components>
+size_t componentStorageBytes(const entt::registry &registry) {
+	size_t bytes = 0;
+	(
+		[&] {
+			if (const auto *pool = registry.storage<Components>()) {
+				// Packed value and entity plus a sparse slot per element
+				bytes += pool->capacity() *
+						 (sizeof(Components) + 2 * sizeof(entt::entity));
+			}
+		}(),
+		...);
+	return bytes;
+}
+
+blot::ecs::CNodeType getNodeType(const std::string &name) {
+	static const std::pair<const char *, blot::ecs::CNodeType> types[] = {
+		{"circle", blot::ecs::CNodeType::Circle},
+		{"rectangle", blot::ecs::CNodeType::Rectangle},
+		{"line", blot::ecs::CNodeType::Line},
+		{"polygon", blot::ecs::CNodeType::Polygon},
+		{"star", blot::ecs::CNodeType::Star},
+		{"add", blot::ecs::CNodeType::Add},
+		{"multiply", blot::ecs::CNodeType::Multiply},
+		{"sin", blot::ecs::CNodeType::Sin},
+		{"cos", blot::ecs::CNodeType::Cos},
+		{"grid", blot::ecs::CNodeType::Grid},
+		{"copy", blot::ecs::CNodeType::Copy}};
+	for (const auto &type : types) {
+		if (name == type.first) {
+			return type.second;
+		}
+	}
+	return blot::ecs::CNodeType::Custom;
+}
+
+} // namespace
+
 MEcs::MEcs() {
 	// Initialize event system
 	m_eventSystem = std::make_unique<blot::ecs::SEvent>(m_registry);
+
+	// Keep render proxies in sync with the components they derive from
+	observeShapeComponent<blot::ecs::CShape>();
+	observeShapeComponent<blot::ecs::CTransform>();
+	observeShapeComponent<blot::ecs::CDrawStyle>();
+	// Create the proxy pool up front so render passes on worker threads
+	// only ever read the registry
+	m_registry.storage<blot::ecs::CRenderProxy>();
+	m_registry.on_destroy<blot::ecs::CParameter>()
+		.connect<&MEcs::onParameterRemoved>(*this);
+
+	// Scripts may touch anything, so they run first and alone
+	addSystem(std::make_unique<blot::ecs::FunctionSystem>(
+		"SScript", blot::ecs::SystemAccess().exclusive(),
+		[this](MEcs &, float deltaTime) { updateScriptSystem(deltaTime); }));
+	// Generated shapes exist before anything animates them
+	addSystem(std::make_unique<blot::ecs::SNodeGraph>());
+	addSystem(std::make_unique<blot::ecs::FunctionSystem>(
+		"SAnimation",
+		blot::ecs::SystemAccess()
+			.reads<blot::ecs::CShape>()
+			.writes<blot::ecs::CTransform, blot::ecs::CDrawStyle>(),
+		[this](MEcs &, float deltaTime) {
+			updateAnimationSystem(deltaTime);
+		}));
+	addSystem(std::make_unique<blot::ecs::FunctionSystem>(
+		"SParameter",
+		blot::ecs::SystemAccess().writes<blot::ecs::CParameter>(),
+		[this](MEcs &, float) { updateParameterSystem(); }));
+
+	m_memoryProvider = MemoryTracker::instance().addProvider(
+		MemoryTag::Ecs, MemoryDomain::Cpu, [this] { return getMemoryUsage(); });
 }
 
-MEcs::~MEcs() { clear(); }
+MEcs::~MEcs() {
+	MemoryTracker::instance().removeProvider(m_memoryProvider);
+	clear();
+}
 
 entt::entity MEcs::createEntity(const std::string &name) {
 	auto entity = m_registry.create();
+	size_t index = entt::to_entity(entity);
+	if (index >= m_entitySlots.size()) {
+		m_entitySlots.resize(index + 1);
+	}
+	m_entitySlots[index] = static_cast<uint32_t>(m_entities.size());
 	m_entities.push_back(entity);
 
 	if (!name.empty()) {
-		m_namedEntities[name] = entity;
+		setEntityName(entity, name);
 	}
 
 	return entity;
 }
 
-void MEcs::destroyEntity(entt::entity entity) {
-	// Remove from named entities
-	for (auto it = m_namedEntities.begin(); it != m_namedEntities.end(); ++it) {
-		if (it->second == entity) {
+size_t MEcs::appendEntities(size_t count) {
+	size_t first = m_entities.size();
+	m_entities.resize(first + count);
+	m_registry.create(m_entities.begin() + first, m_entities.end());
+	for (size_t slot = first; slot < m_entities.size(); ++slot) {
+		size_t index = entt::to_entity(m_entities[slot]);
+		if (index >= m_entitySlots.size()) {
+			// Fresh entities come in ascending order, so this resizes once
+			m_entitySlots.resize(
+				std::max(index + 1, m_entitySlots.size() + count));
+		}
+		m_entitySlots[index] = static_cast<uint32_t>(slot);
+	}
+	return first;
+}
+
+std::vector<entt::entity> MEcs::createEntities(size_t count) {
+	size_t first = appendEntities(count);
+	return std::vector<entt::entity>(m_entities.begin() + first,
+									 m_entities.end());
+}
+
+std::vector<entt::entity> MEcs::instantiate(const Prefab &prefab,
+											size_t count,
+											const PrefabFill &fill,
+											bool parallel) {
+	BLOT_PROFILE_SCOPE("MEcs::instantiate");
+	size_t first = appendEntities(count);
+	std::vector<entt::entity> entities(m_entities.begin() + first,
+									   m_entities.end());
+	if (prefab.has<blot::ecs::CShape>()) {
+		auto &proxies = m_registry.storage<blot::ecs::CRenderProxy>();
+		proxies.reserve(proxies.size() + count);
+		m_dirtyProxies.reserve(m_dirtyProxies.size() + count);
+	}
+	prefab.stamp(m_registry, entities.data(), count);
+
+	if (!fill) {
+		return entities;
+	}
+	if (parallel && m_threadPool) {
+		parallelForRange(count, 1024, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				fill(i, entities[i]);
+			}
+		});
+	} else {
+		for (size_t i = 0; i < count; ++i) {
+			fill(i, entities[i]);
+		}
+	}
+	return entities;
+}
+
+void MEcs::releaseEntity(entt::entity entity) {
+	if (const auto *name = m_registry.try_get<blot::ecs::CName>(entity)) {
+		auto it = m_namedEntities.find(name->name);
+		if (it != m_namedEntities.end() && it->second == entity) {
 			m_namedEntities.erase(it);
-			break;
 		}
 	}
 
-	// Remove from entities list
-	auto it = std::find(m_entities.begin(), m_entities.end(), entity);
-	if (it != m_entities.end()) {
-		m_entities.erase(it);
+	// Swap-remove from the entity list. Entities made on the registry
+	// directly were never listed.
+	size_t index = entt::to_entity(entity);
+	if (index >= m_entitySlots.size()) {
+		return;
 	}
+	uint32_t slot = m_entitySlots[index];
+	if (slot >= m_entities.size() || m_entities[slot] != entity) {
+		return;
+	}
+	entt::entity last = m_entities.back();
+	m_entities[slot] = last;
+	m_entitySlots[entt::to_entity(last)] = slot;
+	m_entities.pop_back();
+}
 
+void MEcs::destroyEntity(entt::entity entity) {
+	if (!m_registry.valid(entity)) {
+		return;
+	}
+	releaseEntity(entity);
 	m_registry.destroy(entity);
 }
 
+void MEcs::destroyEntities(const entt::entity *entities, size_t count) {
+	m_destroyed.clear();
+	m_destroyed.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		if (m_registry.valid(entities[i])) {
+			releaseEntity(entities[i]);
+			m_destroyed.push_back(entities[i]);
+		}
+	}
+	// One pass over each pool rather than one lookup per entity
+	m_registry.destroy(m_destroyed.begin(), m_destroyed.end());
+}
+
+void MEcs::setEntityName(entt::entity entity, const std::string &name) {
+	if (!m_registry.valid(entity)) {
+		return;
+	}
+	if (auto *current = m_registry.try_get<blot::ecs::CName>(entity)) {
+		auto it = m_namedEntities.find(current->name);
+		if (it != m_namedEntities.end() && it->second == entity) {
+			m_namedEntities.erase(it);
+		}
+		if (name.empty()) {
+			m_registry.remove<blot::ecs::CName>(entity);
+			return;
+		}
+		current->name = name;
+	} else if (name.empty()) {
+		return;
+	} else {
+		m_registry.emplace<blot::ecs::CName>(entity, blot::ecs::CName{name});
+	}
+	m_namedEntities[name] = entity;
+}
+
+const std::string &MEcs::getEntityName(entt::entity entity) const {
+	static const std::string empty;
+	if (!m_registry.valid(entity)) {
+		return empty;
+	}
+	const auto *name = m_registry.try_get<blot::ecs::CName>(entity);
+	return name ? name->name : empty;
+}
+
+template <typename T> void MEcs::observeShapeComponent() {
+	m_registry.on_construct<T>().template connect<&MEcs::onShapeChanged>(*this);
+	m_registry.on_update<T>().template connect<&MEcs::onShapeChanged>(*this);
+	m_registry.on_destroy<T>().template connect<&MEcs::onShapeRemoved>(*this);
+}
+
+void MEcs::markShapeDirty(entt::entity entity) {
+	if (m_registry.valid(entity)) {
+		onShapeChanged(m_registry, entity);
+	}
+}
+
+void MEcs::onShapeChanged(entt::registry &registry, entt::entity entity) {
+	// Only shapes get proxies; transforms on nodes, canvases etc. are ignored
+	if (!registry.all_of<blot::ecs::CShape>(entity)) {
+		return;
+	}
+	++m_shapeRevision;
+	auto &proxy = registry.get_or_emplace<blot::ecs::CRenderProxy>(entity);
+	if (!proxy.has(blot::ecs::CRenderProxy::Dirty)) {
+		proxy.flags |= blot::ecs::CRenderProxy::Dirty;
+		m_dirtyProxies.push_back(entity);
+	}
+}
+
+void MEcs::onShapeRemoved(entt::registry &registry, entt::entity entity) {
+	if (registry.remove<blot::ecs::CRenderProxy>(entity)) {
+		++m_shapeRevision;
+	}
+}
+
+void MEcs::onParameterRemoved(entt::registry & /*registry*/,
+							  entt::entity entity) {
+	m_parameters.remove(entity);
+}
+
+void MEcs::updateRenderProxies() {
+	if (m_dirtyProxies.empty()) {
+		return;
+	}
+	using blot::ecs::CDrawStyle;
+	using blot::ecs::CRenderProxy;
+	using blot::ecs::CShape;
+	using blot::ecs::CTransform;
+	// When most shapes changed (e.g. all of them animating), rebuild them
+	// in parallel over the shape pools. The queue then only has the
+	// proxies of shapes that are not drawable left to drop.
+	size_t proxies = m_registry.storage<CRenderProxy>().size();
+	if (m_threadPool && m_dirtyProxies.size() >= kParallelProxies &&
+		m_dirtyProxies.size() * 2 >= proxies) {
+		parallelEach<CRenderProxy, CTransform, CShape, CDrawStyle>(
+			[](entt::entity, CRenderProxy &proxy, const CTransform &transform,
+			   const CShape &shape, const CDrawStyle &style) {
+				if (proxy.has(CRenderProxy::Dirty)) {
+					blot::ecs::buildRenderProxy(transform, shape, style, proxy);
+				}
+			},
+			kProxyGrain);
+	}
+	blot::ecs::SRenderProxyUpdate(m_registry, m_dirtyProxies);
+}
+
 entt::entity MEcs::findEntity(const std::string &name) {
 	auto it = m_namedEntities.find(name);
 	if (it != m_namedEntities.end()) {
@@ -62,61 +327,84 @@ entt::entity MEcs::findEntity(const std::string &name) {
 }
 
 void MEcs::updateSystems(MRendering *renderingManager, float deltaTime) {
+	BLOT_PROFILE_SCOPE("MEcs::updateSystems");
+	auto start = std::chrono::steady_clock::now();
 	// Update event system first (input, queued actions, etc.)
 	if (m_eventSystem) {
+		BLOT_PROFILE_SCOPE("SEvent");
 		m_eventSystem->update();
 	}
 
 	// --- Canvas-specific update (driven by SCanvas system) ---
 	if (renderingManager) {
+		BLOT_PROFILE_SCOPE("SCanvas");
 		blot::ecs::SCanvasUpdate(*this, renderingManager, deltaTime);
 	}
 
 	// --- Generic ECS systems ---
-	updateAnimationSystem(deltaTime);
-	updateScriptSystem(deltaTime);
-	updateParameterSystem();
+	m_scheduler.run(*this, deltaTime, m_threadPool);
+
+	std::chrono::duration<float, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	m_updateMs = elapsed.count();
 }
 
+void MEcs::addSystem(std::unique_ptr<blot::ecs::ISystem> system) {
+	if (!system) {
+		return;
+	}
+	blot::ecs::SystemAccess access;
+	system->declareAccess(access);
+	// Editing a shape's components queues its render proxy for rebuild
+	if (access.isWritten(typeid(blot::ecs::CShape)) ||
+		access.isWritten(typeid(blot::ecs::CTransform)) ||
+		access.isWritten(typeid(blot::ecs::CDrawStyle))) {
+		access.writes<blot::ecs::CRenderProxy>();
+	}
+	access.createStorage(m_registry);
+	m_scheduler.add(std::move(system), access);
+}
+
+void MEcs::parallelForRange(size_t count, size_t grain,
+							const std::function<void(size_t, size_t)> &fn) {
+	if (m_threadPool) {
+		m_threadPool->parallelForRange(count, grain, fn);
+	} else {
+		fn(0, count);
+	}
+}
+
+bool MEcs::removeSystem(const std::string &name) {
+	return m_scheduler.remove(name);
+}
 void MEcs::renderSystems() { renderShapeSystem(); }
 
-void MEcs::connectParameters(entt::entity source,
+bool MEcs::connectParameters(entt::entity source,
 							 const std::string &sourceParam,
 							 entt::entity target,
 							 const std::string &targetParam) {
-	if (!m_registry.valid(source) || !m_registry.valid(target)) {
-		return;
+	// An entity holds one CParameter, so the names are informational
+	if (!m_registry.valid(source) || !m_registry.valid(target) ||
+		!m_registry.all_of<blot::ecs::CParameter>(source) ||
+		!m_registry.all_of<blot::ecs::CParameter>(target)) {
+		return false;
 	}
-
-	if (m_registry.all_of<blot::ecs::CParameter>(source) &&
-		m_registry.all_of<blot::ecs::CParameter>(target)) {
-		auto &sourceParamComp = m_registry.get<blot::ecs::CParameter>(source);
-		auto &targetParamComp = m_registry.get<blot::ecs::CParameter>(target);
-
-		sourceParamComp.isConnected = true;
-		sourceParamComp.connectedTo = target;
-		targetParamComp.isConnected = true;
-		targetParamComp.connectedTo = source;
-
-		// Transfer value
-		targetParamComp.value = sourceParamComp.value;
+	if (!m_parameters.connect(source, target)) {
+		return false;
 	}
+	// Transfer value now; the target's own targets follow on update
+	m_registry.get<blot::ecs::CParameter>(target).value =
+		m_registry.get<blot::ecs::CParameter>(source).value;
+	return true;
 }
 
 void MEcs::disconnectParameters(entt::entity source,
 								const std::string &sourceParam) {
-	if (!m_registry.valid(source)) {
-		return;
-	}
-
-	if (m_registry.all_of<blot::ecs::CParameter>(source)) {
-		auto &sourceParamComp = m_registry.get<blot::ecs::CParameter>(source);
-		sourceParamComp.isConnected = false;
-		sourceParamComp.connectedTo = entt::null;
-	}
+	m_parameters.disconnectTargets(source);
 }
 
-void MEcs::createNode(const std::string &nodeType, float x, float y) {
+entt::entity MEcs::createNode(const std::string &nodeType, float x,
+							  float y) {
 	auto entity = createEntity("node_" + nodeType);
 
 	// Add transform component
@@ -126,10 +414,10 @@ void MEcs::createNode(const std::string &nodeType, float x, float y) {
 	addComponent<blot::ecs::CTransform>(entity, transform);
 
 	// Add node component
-	blot::ecs::CNodeComponent node;
-	node.type = blot::ecs::CNodeType::Custom; // or map nodeType string to
-											  // enum if needed
-	node.name = nodeType;
+	blot::ecs::CNodeComponent node(getNodeType(nodeType), nodeType);
+	node.nodeId = m_nextNodeId++;
+	node.posX = x;
+	node.posY = y;
 	addComponent<blot::ecs::CNodeComponent>(entity, node);
 
 	// Add default parameters based on node type
@@ -162,6 +450,7 @@ void MEcs::createNode(const std::string &nodeType, float x, float y) {
 		resonance.maxValue = 1.0f;
 		addComponent<blot::ecs::CParameter>(entity, resonance);
 	}
+	return entity;
 }
 
 void MEcs::connectNodes(entt::entity sourceNode, const std::string &output,
@@ -197,6 +486,16 @@ void MEcs::connectNodes(entt::entity sourceNode, const std::string &output,
 			targetNodeComp.pins.push_back(
 				{input, "float", true, false, 0.0f, "Input"});
 		}
+
+		auto &connections = targetNodeComp.connections;
+		connections.erase(
+			std::remove_if(connections.begin(), connections.end(),
+						   [&](const blot::ecs::CNodeConnection &connection) {
+							   return connection.toPin == input;
+						   }),
+			connections.end());
+		connections.push_back(
+			{sourceNodeComp.nodeId, output, targetNodeComp.nodeId, input});
 	}
 }
 
@@ -204,60 +503,40 @@ void MEcs::clear() {
 	m_registry.clear();
 	m_namedEntities.clear();
 	m_entities.clear();
+	m_entitySlots.clear();
+	m_dirtyProxies.clear();
+	m_animations.clear();
+	m_parameters.clear();
 }
 
 size_t MEcs::getEntityCount() const { return m_entities.size(); }
 
-std::vector<entt::entity> MEcs::getAllEntities() const { return m_entities; }
+size_t MEcs::getMemoryUsage() const {
+	size_t bytes = m_entities.capacity() * sizeof(entt::entity) +
+				   m_entitySlots.capacity() * sizeof(uint32_t) +
+				   m_dirtyProxies.capacity() * sizeof(entt::entity) +
+				   m_animations.getMemoryUsage() +
+				   m_parameters.getMemoryUsage();
+	for (const auto &named : m_namedEntities) {
+		bytes += sizeof(named) + named.first.capacity();
+	}
+	bytes += componentStorageBytes<
+		blot::ecs::CDrawStyle, blot::ecs::CDrawing,
+		blot::ecs::CName, blot::ecs::CNodeComponent, blot::ecs::CParameter,
+		blot::ecs::CRenderProxy, blot::ecs::CScript, blot::ecs::CSelection,
+		blot::ecs::CShape, blot::ecs::CTexture, blot::ecs::CTransform>(
+		m_registry);
+	return bytes;
+}
 
 void MEcs::updateAnimationSystem(float deltaTime) {
-	auto view = m_registry.view<blot::ecs::CAnimation, blot::ecs::CTransform>();
-
-	for (auto entity : view) {
-		auto &animation = view.get<blot::ecs::CAnimation>(entity);
-		auto &transform = view.get<blot::ecs::CTransform>(entity);
-
-		if (animation.isPlaying) {
-			animation.currentTime += deltaTime;
-
-			if (animation.currentTime >= animation.duration) {
-				if (animation.loop) {
-					animation.currentTime = 0.0f;
-				} else {
-					animation.isPlaying = false;
-				}
-			}
-
-			// Apply animation curve
-			float progress = animation.currentTime / animation.duration;
-			float easedProgress = progress; // Default linear
-
-			switch (animation.curve) {
-			case blot::ecs::CAnimation::EaseIn:
-				easedProgress = progress * progress;
-				break;
-			case blot::ecs::CAnimation::EaseOut:
-				easedProgress = 1.0f - (1.0f - progress) * (1.0f - progress);
-				break;
-			case blot::ecs::CAnimation::EaseInOut:
-				easedProgress =
-					progress < 0.5f
-						? 2.0f * progress * progress
-						: 1.0f - 2.0f * (1.0f - progress) * (1.0f - progress);
-				break;
-			case blot::ecs::CAnimation::Bounce:
-				easedProgress = 1.0f - std::cos(progress * 3.14159f * 2.0f) *
-										   std::exp(-progress * 3.0f);
-				break;
-			case blot::ecs::CAnimation::Elastic:
-				easedProgress = std::sin(progress * 3.14159f * 2.0f) *
-								std::exp(-progress * 2.0f);
-				break;
-			}
-
-			// Apply to transform (example: animate position)
-			transform.position.x = easedProgress * 100.0f; // Simple example
-		}
+	// Written shapes are collected, then queued here: registry observers
+	// must not run from the evaluation threads
+	m_animatedShapes.clear();
+	m_animations.update(m_registry, deltaTime, m_threadPool,
+						m_animatedShapes);
+	for (entt::entity entity : m_animatedShapes) {
+		markShapeDirty(entity);
 	}
 }
 
@@ -270,23 +549,7 @@ void MEcs::renderShapeSystem() {
 	// IRenderer.
 }
 
-void MEcs::updateParameterSystem() {
-	auto view = m_registry.view<blot::ecs::CParameter>();
-
-	for (auto entity : view) {
-		auto &parameter = view.get<blot::ecs::CParameter>(entity);
-
-		// Update connected parameters
-		if (parameter.isConnected && m_registry.valid(parameter.connectedTo)) {
-			if (m_registry.all_of<blot::ecs::CParameter>(
-					parameter.connectedTo)) {
-				auto &connectedParam = m_registry.get<blot::ecs::CParameter>(
-					parameter.connectedTo);
-				connectedParam.value = parameter.value;
-			}
-		}
-	}
-}
+void MEcs::updateParameterSystem() { m_parameters.update(m_registry); }
 
 void MEcs::runCanvasSystems(MRendering *renderingManager, float deltaTime) {
 	blot::ecs::SCanvasUpdate(*this, renderingManager, deltaTime);
@@ -313,11 +576,9 @@ blot::json MEcs::getSettings() const {
 		// exists if (m_registry.all_of<blot::ecs::CTransform>(entity)) {
 		// ... } Repeat for other component types as needed... Optionally, add
 		// entity name if available
-		for (const auto &[name, ent] : m_namedEntities) {
-			if (ent == entity) {
-				entityJson["name"] = name;
-				break;
-			}
+		const std::string &name = getEntityName(entity);
+		if (!name.empty()) {
+			entityJson["name"] = name;
 		}
 		j["entities"].push_back(entityJson);
 	}
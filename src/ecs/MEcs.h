@@ -2,13 +2,21 @@
 
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "core/IManager.h"
 #include "core/ISettings.h"
+#include "ecs/AnimationTracks.h"
+#include "ecs/ParameterGraph.h"
+#include "ecs/Prefab.h"
 #include "ecs/systems/SEvent.h"
+#include "ecs/systems/SRenderProxy.h"
+#include "ecs/systems/SystemScheduler.h"
 #include "rendering/IRenderer.h"
 
 // Forward declarations
@@ -17,6 +25,7 @@ class bxScriptEngine;
 namespace blot {
 class Canvas;
 class MRendering;
+class ThreadPool;
 class MEcs : public IManager, public ISettings {
   public:
 	MEcs();
@@ -24,10 +33,34 @@ class MEcs : public IManager, public ISettings {
 	void init() override {}
 	void shutdown() override {}
 
-	// Entity management
+	// Entity management. Creation, destruction and name lookup are O(1);
+	// destroying an invalid entity is a no-op. A batch must not list an
+	// entity twice.
 	entt::entity createEntity(const std::string &name = "");
 	void destroyEntity(entt::entity entity);
+	void destroyEntities(const entt::entity *entities, size_t count);
+	void destroyEntities(const std::vector<entt::entity> &entities) {
+		destroyEntities(entities.data(), entities.size());
+	}
 	entt::entity findEntity(const std::string &name);
+	bool isValid(entt::entity entity) const {
+		return m_registry.valid(entity);
+	}
+	// Bulk creation: `count` entities with no components, in one pass
+	std::vector<entt::entity> createEntities(size_t count);
+	// Stamp `count` copies of a prefab, reserving every pool once. `fill`
+	// then runs for each instance as fill(index, entity) and may edit its
+	// components by reference: render proxies are rebuilt afterwards, by
+	// updateRenderProxies(). With `parallel`, fill runs on the thread pool
+	// and must only touch the entity it is given.
+	using PrefabFill = std::function<void(size_t, entt::entity)>;
+	std::vector<entt::entity> instantiate(const Prefab &prefab, size_t count,
+										  const PrefabFill &fill = {},
+										  bool parallel = false);
+	// An empty name removes it. Names are unique: giving one to a second
+	// entity makes findEntity() return that entity from then on.
+	void setEntityName(entt::entity entity, const std::string &name);
+	const std::string &getEntityName(entt::entity entity) const;
 
 	// Component management
 	template <typename T>
@@ -39,21 +72,65 @@ class MEcs : public IManager, public ISettings {
 
 	template <typename T> void removeComponent(entt::entity entity);
 
-	// System management
+	// Modify a component in place and notify observers (e.g. render
+	// proxies). Prefer this over getComponent() for transforms and shapes.
+	template <typename T, typename... Func>
+	T &patchComponent(entt::entity entity, Func &&...func);
+
+	// Queue a shape's render proxy for rebuild after editing its components
+	// by reference
+	void markShapeDirty(entt::entity entity);
+
+	// Rebuild the render proxies of shapes changed since the last call, on
+	// the thread pool when most shapes changed
+	void updateRenderProxies();
+
+	// Bumped whenever a shape is added, edited or removed
+	uint64_t getShapeRevision() const { return m_shapeRevision; }
+
+	// System management. updateSystems() runs events and canvases, then
+	// every added system, concurrently where their declared access allows.
 	void updateSystems(MRendering *renderingManager, float deltaTime);
 	void renderSystems();
+	void addSystem(std::unique_ptr<ecs::ISystem> system);
+	bool removeSystem(const std::string &name);
+	const std::vector<ecs::SystemScheduler::Timing> &getSystemTimings() const {
+		return m_scheduler.getTimings();
+	}
+	// Wall time of the last updateSystems() call, in milliseconds
+	float getUpdateMs() const { return m_updateMs; }
+
+	// Keyframe tracks, advanced and written by updateSystems()
+	ecs::AnimationTracks &getAnimations() { return m_animations; }
 
 	// Query systems
 	template <typename... Components> auto view();
 
-	// Parameter patching
-	void connectParameters(entt::entity source, const std::string &sourceParam,
+	// Run fn(entity, Components &...) for every entity of
+	// view<Components...>(), in chunks of about `grain` entities on the
+	// thread pool; serially without one or when there is one chunk. fn may
+	// write the components it is given and read other entities' components
+	// that nothing writes meanwhile. It must not create or destroy
+	// entities, add or remove components, or patch() them: registry
+	// observers are not thread-safe, so call markShapeDirty() afterwards.
+	template <typename... Components, typename Func>
+	void parallelEach(Func &&fn, size_t grain = 1024);
+
+	// Parameter patching. A parameter drives any number of others and
+	// follows at most one; connecting replaces the target's source and
+	// fails if it would close a cycle. updateSystems() copies changed
+	// values down each chain, so a chain settles within a frame.
+	bool connectParameters(entt::entity source, const std::string &sourceParam,
 						   entt::entity target, const std::string &targetParam);
+	// Drops every connection `source` drives
 	void disconnectParameters(entt::entity source,
 							  const std::string &sourceParam);
+	ecs::ParameterGraph &getParameterGraph() { return m_parameters; }
 
-	// Node editor integration
-	void createNode(const std::string &nodeType, float x, float y);
+	// Node editor integration. Nodes get unique ids; a connection is kept
+	// on the target node and replaces any other into the same input. The
+	// SNodeGraph system turns shape nodes into shapes on update.
+	entt::entity createNode(const std::string &nodeType, float x, float y);
 	void connectNodes(entt::entity sourceNode, const std::string &output,
 					  entt::entity targetNode, const std::string &input);
 
@@ -72,10 +149,22 @@ class MEcs : public IManager, public ISettings {
 	void selectEntity(entt::entity entity, bool multiSelect = false);
 	void clearSelection();
 
+	// Pool for parallel work; without one it runs on the calling thread
+	void setThreadPool(ThreadPool *pool) { m_threadPool = pool; }
+	ThreadPool *getThreadPool() const { return m_threadPool; }
+
 	// Utility functions
 	void clear();
 	size_t getEntityCount() const;
-	std::vector<entt::entity> getAllEntities() const;
+	// Estimated bytes of entity lists, animation tracks, parameter
+	// connections and core component storages; heap memory owned by
+	// components (strings, vectors) is not included
+	size_t getMemoryUsage() const;
+	// Live entities, unordered: destroying one moves the last into its
+	// place. The reference is invalidated by creating or destroying.
+	const std::vector<entt::entity> &getAllEntities() const {
+		return m_entities;
+	}
 
 	// Integration with other systems
 	// void setGraphics(std::shared_ptr<Graphics> graphics); // Removed, not
@@ -96,14 +185,46 @@ class MEcs : public IManager, public ISettings {
 
   private:
 	entt::registry m_registry;
+	// Reverse index of the CName components
 	std::unordered_map<std::string, entt::entity> m_namedEntities;
 	std::vector<entt::entity> m_entities;
+	// Position in m_entities, indexed by entt::to_entity()
+	std::vector<uint32_t> m_entitySlots;
+	ThreadPool *m_threadPool = nullptr;
 
 	// System references
 	// std::shared_ptr<Canvas> m_canvas; // Removed, not needed
 
 	// Event system
 	std::unique_ptr<ecs::SEvent> m_eventSystem;
+	ecs::SystemScheduler m_scheduler;
+
+	// Shapes whose CRenderProxy needs rebuilding
+	std::vector<entt::entity> m_dirtyProxies;
+	ecs::AnimationTracks m_animations;
+	// Scratch for updateAnimationSystem()
+	std::vector<entt::entity> m_animatedShapes;
+	// Scratch for destroyEntities()
+	std::vector<entt::entity> m_destroyed;
+	ecs::ParameterGraph m_parameters;
+	int m_nextNodeId = 1;
+	uint64_t m_shapeRevision = 0;
+	float m_updateMs = 0.0f;
+	int m_memoryProvider = 0;
+
+	// Create `count` entities at the end of m_entities; returns where they
+	// start
+	size_t appendEntities(size_t count);
+	void releaseEntity(entt::entity entity);
+	// Forwards to m_threadPool, keeping ThreadPool.h out of this header
+	void parallelForRange(size_t count, size_t grain,
+						  const std::function<void(size_t, size_t)> &fn);
+
+	// Registry observers
+	template <typename T> void observeShapeComponent();
+	void onShapeChanged(entt::registry &registry, entt::entity entity);
+	void onShapeRemoved(entt::registry &registry, entt::entity entity);
+	void onParameterRemoved(entt::registry &registry, entt::entity entity);
 
 	// Systems
 	void updateAnimationSystem(float deltaTime);
@@ -130,7 +251,35 @@ template <typename T> void MEcs::removeComponent(entt::entity entity) {
 	m_registry.remove<T>(entity);
 }
 
+template <typename T, typename... Func>
+T &MEcs::patchComponent(entt::entity entity, Func &&...func) {
+	return m_registry.patch<T>(entity, std::forward<Func>(func)...);
+}
+
 template <typename... Components> auto MEcs::view() {
 	return m_registry.view<Components...>();
 }
+
+template <typename... Components, typename Func>
+void MEcs::parallelEach(Func &&fn, size_t grain) {
+	auto view = m_registry.view<Components...>();
+	grain = std::max<size_t>(grain, 1);
+	if (!m_threadPool || view.size_hint() <= grain) {
+		for (auto entity : view) {
+			fn(entity, view.template get<Components>(entity)...);
+		}
+		return;
+	}
+	// Views over several pools are not random access; list them once
+	std::vector<entt::entity> entities;
+	entities.reserve(view.size_hint());
+	for (auto entity : view) {
+		entities.push_back(entity);
+	}
+	parallelForRange(entities.size(), grain, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			fn(entities[i], view.template get<Components>(entities[i])...);
+		}
+	});
+}
 } // namespace blot
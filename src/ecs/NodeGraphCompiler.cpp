@@ -0,0 +1,626 @@
+#include "ecs/NodeGraphCompiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "core/util/ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOT_NODES_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace blot {
+namespace ecs {
+
+namespace {
+
+// Instances per register: a kernel's registers for one block stay in L1
+constexpr size_t kBlock = 256;
+// Below this many instances a kernel is cheaper than handing blocks out
+constexpr size_t kParallelInstances = 16384;
+constexpr size_t kParallelBlocks = 32;
+constexpr uint32_t kNoValue = UINT32_MAX;
+
+int getOperandCount(NodeOp op) {
+	switch (op) {
+	case NodeOp::Add:
+	case NodeOp::Sub:
+	case NodeOp::Mul:
+		return 2;
+	case NodeOp::Mad:
+		return 3;
+	case NodeOp::Sin:
+	case NodeOp::Cos:
+	case NodeOp::Store:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+bool isShape(CNodeType type) {
+	switch (type) {
+	case CNodeType::Circle:
+	case CNodeType::Rectangle:
+	case CNodeType::Line:
+	case CNodeType::Polygon:
+	case CNodeType::Star:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Counts and strides of a kernel's domains for one evaluation
+struct DomainState {
+	size_t stride = 1;
+	size_t count = 1;
+	size_t columns = 1;
+};
+
+size_t readCount(const float *constants, uint32_t index) {
+	float value = constants[index];
+	if (!(value >= 1.0f)) { // NaN, zero or negative
+		return 0;
+	}
+	return static_cast<size_t>(
+		std::min(value, static_cast<float>(kMaxNodeInstances)));
+}
+
+size_t getDomainCount(const NodeDomain &domain, const float *constants,
+					  size_t &columns) {
+	columns = readCount(constants, domain.countConstant);
+	if (domain.rowsConstant == UINT32_MAX) {
+		return columns;
+	}
+	size_t rows = readCount(constants, domain.rowsConstant);
+	return columns == 0 || rows <= kMaxNodeInstances / columns
+			   ? columns * rows
+			   : kMaxNodeInstances;
+}
+
+template <typename Op>
+void binary(float *dst, const float *a, const float *b, size_t lanes, Op op) {
+	for (size_t i = 0; i < lanes; ++i) {
+		dst[i] = op(a[i], b[i]);
+	}
+}
+
+// Index, Fraction, Column or Row for instances [base, base + n), a run of
+// lanes at a time: within a run the value is constant (domains with a
+// stride) or counts up by one, so no lane divides.
+void writeIndices(NodeOp op, const DomainState &domain, size_t base,
+				  size_t n, float *d) {
+	size_t step = base % domain.stride;
+	size_t index = base / domain.stride % domain.count;
+	float scale =
+		op == NodeOp::Fraction ? 1.0f / static_cast<float>(domain.count) : 1.0f;
+	bool cells = op == NodeOp::Column || op == NodeOp::Row;
+	for (size_t i = 0; i < n;) {
+		size_t column = index % domain.columns;
+		size_t first = op == NodeOp::Column ? column
+					   : op == NodeOp::Row	? index / domain.columns
+											: index;
+		size_t run;
+		if (domain.stride > 1) {
+			run = std::min(n - i, domain.stride - step);
+			std::fill(d + i, d + i + run, static_cast<float>(first) * scale);
+			step += run;
+			if (step == domain.stride) {
+				step = 0;
+				index = index + 1 == domain.count ? 0 : index + 1;
+			}
+		} else {
+			// Up to the end of the domain or, for cells, of the row
+			run = std::min(n - i, domain.count - index);
+			if (cells) {
+				run = std::min(run, domain.columns - column);
+			}
+			if (op == NodeOp::Row) {
+				std::fill(d + i, d + i + run, static_cast<float>(first));
+			} else {
+				for (size_t k = 0; k < run; ++k) {
+					d[i + k] = static_cast<float>(first + k) * scale;
+				}
+			}
+			index += run;
+			if (index == domain.count) {
+				index = 0;
+			}
+		}
+		i += run;
+	}
+}
+
+// Run every instruction over instances [base, base + n). Registers are
+// kBlock floats each; lanes past n hold stale values that are never
+// stored.
+void runBlock(const NodeKernel &kernel, const float *constants,
+			  const std::vector<DomainState> &domains, size_t base, size_t n,
+			  float *scratch, float *fields, size_t count) {
+	// SSE2 ops cover whole groups of four; registers are padded to kBlock
+	size_t lanes = (n + 3) & ~size_t(3);
+	for (const NodeInstruction &ins : kernel.code) {
+		float *d = scratch + ins.dst * kBlock;
+		const float *a = scratch + ins.a * kBlock;
+		const float *b = scratch + ins.b * kBlock;
+		const float *c = scratch + ins.c * kBlock;
+		switch (ins.op) {
+		case NodeOp::Constant:
+			std::fill(d, d + lanes, constants[ins.imm]);
+			break;
+		case NodeOp::Index:
+		case NodeOp::Fraction:
+		case NodeOp::Column:
+		case NodeOp::Row: {
+			writeIndices(ins.op, domains[ins.imm], base, n, d);
+			break;
+		}
+#ifdef BLOT_NODES_SSE2
+		case NodeOp::Add:
+			for (size_t i = 0; i < lanes; i += 4) {
+				_mm_storeu_ps(d + i, _mm_add_ps(_mm_loadu_ps(a + i),
+												_mm_loadu_ps(b + i)));
+			}
+			break;
+		case NodeOp::Sub:
+			for (size_t i = 0; i < lanes; i += 4) {
+				_mm_storeu_ps(d + i, _mm_sub_ps(_mm_loadu_ps(a + i),
+												_mm_loadu_ps(b + i)));
+			}
+			break;
+		case NodeOp::Mul:
+			for (size_t i = 0; i < lanes; i += 4) {
+				_mm_storeu_ps(d + i, _mm_mul_ps(_mm_loadu_ps(a + i),
+												_mm_loadu_ps(b + i)));
+			}
+			break;
+		case NodeOp::Mad:
+			for (size_t i = 0; i < lanes; i += 4) {
+				__m128 product =
+					_mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+				_mm_storeu_ps(d + i,
+							  _mm_add_ps(product, _mm_loadu_ps(c + i)));
+			}
+			break;
+#else
+		case NodeOp::Add:
+			binary(d, a, b, n, [](float x, float y) { return x + y; });
+			break;
+		case NodeOp::Sub:
+			binary(d, a, b, n, [](float x, float y) { return x - y; });
+			break;
+		case NodeOp::Mul:
+			binary(d, a, b, n, [](float x, float y) { return x * y; });
+			break;
+		case NodeOp::Mad:
+			for (size_t i = 0; i < n; ++i) {
+				d[i] = a[i] * b[i] + c[i];
+			}
+			break;
+#endif
+		case NodeOp::Sin:
+			for (size_t i = 0; i < n; ++i) {
+				d[i] = std::sin(a[i]);
+			}
+			break;
+		case NodeOp::Cos:
+			for (size_t i = 0; i < n; ++i) {
+				d[i] = std::cos(a[i]);
+			}
+			break;
+		case NodeOp::Store:
+			std::memcpy(fields + ins.imm * count + base, a, n * sizeof(float));
+			break;
+		}
+	}
+}
+
+} // namespace
+
+// Instructions before register allocation: operands and results are value
+// ids, one per instruction that produces something
+struct NodeGraphCompiler::Kernel {
+	struct Value {
+		NodeOp op;
+		uint32_t a, b, c, imm;
+	};
+	std::vector<Value> code;
+	std::vector<NodeDomain> domains;
+	std::vector<size_t> domainNodes;
+	std::vector<uint32_t> constants;
+	std::map<std::pair<size_t, std::string>, uint32_t> outputs;
+	std::map<uint32_t, uint32_t> constantValues;
+	std::vector<size_t> visiting;
+	bool failed = false;
+
+	uint32_t emit(NodeOp op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0,
+				  uint32_t imm = 0) {
+		code.push_back({op, a, b, c, imm});
+		return static_cast<uint32_t>(code.size() - 1);
+	}
+	void readConstant(uint32_t index) {
+		if (std::find(constants.begin(), constants.end(), index) ==
+			constants.end()) {
+			constants.push_back(index);
+		}
+	}
+};
+
+bool NodeGraphCompiler::compile(const std::vector<Node> &nodes,
+								NodeProgram &program) {
+	program = NodeProgram();
+	m_nodes = &nodes;
+	m_program = &program;
+	m_nodeIndex.clear();
+	m_inputs.clear();
+	m_constantIndex.clear();
+
+	bool ok = true;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const CNodeComponent &node = *nodes[i].second;
+		if (!m_nodeIndex.emplace(node.nodeId, i).second) {
+			spdlog::error("[NodeGraph] Duplicate node id {}", node.nodeId);
+			ok = false;
+		}
+		for (const CNodeConnection &connection : node.connections) {
+			m_inputs[{connection.toNodeId, connection.toPin}] = {
+				connection.fromNodeId, connection.fromPin};
+		}
+	}
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		if (!isShape(nodes[i].second->type)) {
+			continue;
+		}
+		NodeKernel kernel;
+		if (lowerShape(i, kernel)) {
+			program.kernels.push_back(std::move(kernel));
+		} else {
+			ok = false;
+		}
+	}
+	m_nodes = nullptr;
+	m_program = nullptr;
+	return ok;
+}
+
+uint32_t NodeGraphCompiler::constant(size_t node, const std::string &pin) {
+	auto found = m_constantIndex.find({node, pin});
+	if (found != m_constantIndex.end()) {
+		return found->second;
+	}
+	NodeConstant entry;
+	entry.node = (*m_nodes)[node].first;
+	entry.pin = pin;
+	for (const CNodePin &candidate : (*m_nodes)[node].second->pins) {
+		if (candidate.isInput && candidate.name == pin) {
+			entry.fallback = candidate.defaultValue;
+			break;
+		}
+	}
+	auto index = static_cast<uint32_t>(m_program->constants.size());
+	m_program->constants.push_back(std::move(entry));
+	m_constantIndex.emplace(std::make_pair(node, pin), index);
+	return index;
+}
+
+uint32_t NodeGraphCompiler::input(Kernel &kernel, size_t node,
+								  const std::string &pin) {
+	const CNodeComponent &target = *(*m_nodes)[node].second;
+	auto connected = m_inputs.find({target.nodeId, pin});
+	if (connected == m_inputs.end()) {
+		uint32_t index = constant(node, pin);
+		kernel.readConstant(index);
+		auto value = kernel.constantValues.find(index);
+		if (value != kernel.constantValues.end()) {
+			return value->second;
+		}
+		uint32_t id = kernel.emit(NodeOp::Constant, 0, 0, 0, index);
+		kernel.constantValues.emplace(index, id);
+		return id;
+	}
+	auto source = m_nodeIndex.find(connected->second.first);
+	if (source == m_nodeIndex.end()) {
+		spdlog::error("[NodeGraph] {}.{} is connected to missing node {}",
+					  target.name, pin, connected->second.first);
+		kernel.failed = true;
+		return 0;
+	}
+	return output(kernel, source->second, connected->second.second);
+}
+
+uint32_t NodeGraphCompiler::output(Kernel &kernel, size_t node,
+								   const std::string &pin) {
+	auto memo = kernel.outputs.find({node, pin});
+	if (memo != kernel.outputs.end()) {
+		return memo->second;
+	}
+	const CNodeComponent &source = *(*m_nodes)[node].second;
+	if (std::find(kernel.visiting.begin(), kernel.visiting.end(), node) !=
+		kernel.visiting.end()) {
+		spdlog::error("[NodeGraph] Cycle through node {}", source.name);
+		kernel.failed = true;
+		return 0;
+	}
+	kernel.visiting.push_back(node);
+
+	uint32_t value = kNoValue;
+	switch (source.type) {
+	case CNodeType::Add:
+	case CNodeType::Multiply:
+		if (pin == "result") {
+			uint32_t a = input(kernel, node, "a");
+			uint32_t b = input(kernel, node, "b");
+			value = kernel.emit(source.type == CNodeType::Add ? NodeOp::Add
+															  : NodeOp::Mul,
+								a, b);
+		}
+		break;
+	case CNodeType::Sin:
+	case CNodeType::Cos:
+		if (pin == "result") {
+			uint32_t x = input(kernel, node, "x");
+			value = kernel.emit(
+				source.type == CNodeType::Sin ? NodeOp::Sin : NodeOp::Cos, x);
+		}
+		break;
+	case CNodeType::Copy:
+		if (pin == "index" || pin == "t") {
+			uint32_t slot = domain(kernel, node);
+			value = kernel.emit(pin == "index" ? NodeOp::Index
+											   : NodeOp::Fraction,
+								0, 0, 0, slot);
+		}
+		break;
+	case CNodeType::Grid:
+		if (pin == "index") {
+			value = kernel.emit(NodeOp::Index, 0, 0, 0, domain(kernel, node));
+		} else if (pin == "x" || pin == "y") {
+			bool isX = pin == "x";
+			uint32_t cell =
+				kernel.emit(isX ? NodeOp::Column : NodeOp::Row, 0, 0, 0,
+							domain(kernel, node));
+			uint32_t spacing =
+				input(kernel, node, isX ? "spacingX" : "spacingY");
+			uint32_t origin = input(kernel, node, isX ? "originX" : "originY");
+			value = kernel.emit(NodeOp::Mad, cell, spacing, origin);
+		}
+		break;
+	default:
+		break;
+	}
+	if (value == kNoValue) {
+		spdlog::error("[NodeGraph] Node {} has no output {}", source.name,
+					  pin);
+		kernel.failed = true;
+		value = 0;
+	}
+
+	kernel.visiting.pop_back();
+	kernel.outputs.emplace(std::make_pair(node, pin), value);
+	return value;
+}
+
+uint32_t NodeGraphCompiler::domain(Kernel &kernel, size_t node) {
+	auto found =
+		std::find(kernel.domainNodes.begin(), kernel.domainNodes.end(), node);
+	if (found != kernel.domainNodes.end()) {
+		return static_cast<uint32_t>(found - kernel.domainNodes.begin());
+	}
+	const CNodeComponent &source = *(*m_nodes)[node].second;
+	bool isGrid = source.type == CNodeType::Grid;
+	const char *countPin = isGrid ? "columns" : "count";
+	const char *pins[] = {countPin, "rows"};
+	for (int i = 0; i < (isGrid ? 2 : 1); ++i) {
+		if (m_inputs.count({source.nodeId, pins[i]})) {
+			spdlog::error("[NodeGraph] {}.{} must be set, not connected",
+						  source.name, pins[i]);
+			kernel.failed = true;
+		}
+	}
+	NodeDomain entry;
+	entry.countConstant = constant(node, countPin);
+	kernel.readConstant(entry.countConstant);
+	if (isGrid) {
+		entry.rowsConstant = constant(node, "rows");
+		kernel.readConstant(entry.rowsConstant);
+	}
+	kernel.domains.push_back(entry);
+	kernel.domainNodes.push_back(node);
+	return static_cast<uint32_t>(kernel.domains.size() - 1);
+}
+
+bool NodeGraphCompiler::lowerShape(size_t node, NodeKernel &out) {
+	const CNodeComponent &shape = *(*m_nodes)[node].second;
+	Kernel kernel;
+	auto store = [&](NodeField field, uint32_t value) {
+		kernel.emit(NodeOp::Store, value, 0, 0, static_cast<uint32_t>(field));
+		out.fields |= 1u << static_cast<uint32_t>(field);
+	};
+	auto in = [&](const char *pin) { return input(kernel, node, pin); };
+
+	switch (shape.type) {
+	case CNodeType::Circle: {
+		out.shape = CShape::Type::Ellipse;
+		uint32_t x = in("x");
+		uint32_t y = in("y");
+		uint32_t radius = in("radius");
+		store(NodeField::X1, kernel.emit(NodeOp::Sub, x, radius));
+		store(NodeField::Y1, kernel.emit(NodeOp::Sub, y, radius));
+		store(NodeField::X2, kernel.emit(NodeOp::Add, x, radius));
+		store(NodeField::Y2, kernel.emit(NodeOp::Add, y, radius));
+		break;
+	}
+	case CNodeType::Rectangle: {
+		out.shape = CShape::Type::Rectangle;
+		uint32_t x = in("x");
+		uint32_t y = in("y");
+		store(NodeField::X1, x);
+		store(NodeField::Y1, y);
+		store(NodeField::X2, kernel.emit(NodeOp::Add, x, in("width")));
+		store(NodeField::Y2, kernel.emit(NodeOp::Add, y, in("height")));
+		break;
+	}
+	case CNodeType::Line:
+		out.shape = CShape::Type::Line;
+		store(NodeField::X1, in("x1"));
+		store(NodeField::Y1, in("y1"));
+		store(NodeField::X2, in("x2"));
+		store(NodeField::Y2, in("y2"));
+		break;
+	default: {
+		// Polygons and stars are centered on x1, y1 with radius x2 - x1
+		bool isStar = shape.type == CNodeType::Star;
+		out.shape = isStar ? CShape::Type::Star : CShape::Type::Polygon;
+		uint32_t x = in("x");
+		uint32_t y = in("y");
+		uint32_t radius = in("radius");
+		store(NodeField::X1, x);
+		store(NodeField::Y1, y);
+		store(NodeField::X2, kernel.emit(NodeOp::Add, x, radius));
+		store(NodeField::Y2, kernel.emit(NodeOp::Add, y, radius));
+		store(NodeField::Sides, in(isStar ? "points" : "sides"));
+		if (isStar) {
+			store(NodeField::InnerRadius, in("innerRadius"));
+		}
+		break;
+	}
+	}
+	// Colors are hues; left to CDrawStyle's defaults unless set
+	auto hasColor = [&](const char *pin) {
+		return m_inputs.count({shape.nodeId, pin}) ||
+			   shape.properties.count(pin);
+	};
+	if (shape.type != CNodeType::Line && hasColor("color")) {
+		store(NodeField::Fill, in("color"));
+	}
+	if (hasColor("stroke")) {
+		store(NodeField::Stroke, in("stroke"));
+	}
+	store(NodeField::StrokeWidth, in("strokeWidth"));
+
+	if (kernel.code.size() > UINT16_MAX) {
+		spdlog::error("[NodeGraph] {} needs too many instructions", shape.name);
+		kernel.failed = true;
+	}
+	if (kernel.failed) {
+		return false;
+	}
+	out.sink = (*m_nodes)[node].first;
+	out.domains = std::move(kernel.domains);
+	out.constants = std::move(kernel.constants);
+	allocateRegisters(kernel, out);
+	return true;
+}
+
+void NodeGraphCompiler::allocateRegisters(Kernel &kernel, NodeKernel &out) {
+	// Linear scan: a value's register is free once its last reader ran
+	std::vector<uint32_t> lastUse(kernel.code.size(), kNoValue);
+	for (uint32_t i = 0; i < kernel.code.size(); ++i) {
+		const Kernel::Value &value = kernel.code[i];
+		const uint32_t operands[] = {value.a, value.b, value.c};
+		for (int k = 0; k < getOperandCount(value.op); ++k) {
+			lastUse[operands[k]] = i;
+		}
+	}
+	std::vector<uint16_t> registerOf(kernel.code.size(), 0);
+	std::vector<uint16_t> free;
+	uint16_t registers = 0;
+	out.code.clear();
+	out.code.reserve(kernel.code.size());
+	for (uint32_t i = 0; i < kernel.code.size(); ++i) {
+		const Kernel::Value &value = kernel.code[i];
+		NodeInstruction ins;
+		ins.op = value.op;
+		ins.imm = value.imm;
+		const uint32_t operands[] = {value.a, value.b, value.c};
+		uint16_t *fields[] = {&ins.a, &ins.b, &ins.c};
+		int count = getOperandCount(value.op);
+		for (int k = 0; k < count; ++k) {
+			*fields[k] = registerOf[operands[k]];
+		}
+		// Operands die before the result is placed, so elementwise ops may
+		// write over an input they were the last to read
+		for (int k = 0; k < count; ++k) {
+			uint32_t operand = operands[k];
+			if (lastUse[operand] == i) {
+				free.push_back(registerOf[operand]);
+				lastUse[operand] = kNoValue; // Once, if read twice
+			}
+		}
+		if (value.op != NodeOp::Store) {
+			if (free.empty()) {
+				ins.dst = registers++;
+			} else {
+				ins.dst = free.back();
+				free.pop_back();
+			}
+			registerOf[i] = ins.dst;
+			if (lastUse[i] == kNoValue) {
+				free.push_back(ins.dst); // Never read
+			}
+		}
+		out.code.push_back(ins);
+	}
+	out.registers = registers;
+}
+
+size_t getNodeInstanceCount(const NodeKernel &kernel,
+							const float *constants) {
+	size_t count = 1;
+	for (const NodeDomain &domain : kernel.domains) {
+		size_t columns = 0;
+		size_t size = getDomainCount(domain, constants, columns);
+		if (size == 0) {
+			return 0;
+		}
+		if (count > kMaxNodeInstances / size) {
+			return kMaxNodeInstances;
+		}
+		count *= size;
+	}
+	return count;
+}
+
+void evaluateNodeKernel(const NodeKernel &kernel, const float *constants,
+						size_t count, ThreadPool *pool,
+						std::vector<float> &fields) {
+	fields.resize(static_cast<size_t>(NodeField::Count) * count);
+	if (count == 0) {
+		return;
+	}
+	std::vector<DomainState> domains(kernel.domains.size());
+	size_t stride = 1;
+	for (size_t k = 0; k < domains.size(); ++k) {
+		domains[k].stride = stride;
+		domains[k].count = std::max<size_t>(
+			getDomainCount(kernel.domains[k], constants, domains[k].columns),
+			1);
+		domains[k].columns = std::max<size_t>(domains[k].columns, 1);
+		stride *= domains[k].count;
+	}
+
+	size_t blocks = (count + kBlock - 1) / kBlock;
+	auto run = [&](size_t begin, size_t end) {
+		std::vector<float> scratch(size_t(kernel.registers) * kBlock);
+		for (size_t block = begin; block < end; ++block) {
+			size_t base = block * kBlock;
+			runBlock(kernel, constants, domains, base,
+					 std::min(kBlock, count - base), scratch.data(),
+					 fields.data(), count);
+		}
+	};
+	if (pool && count >= kParallelInstances) {
+		pool->parallelForRange(blocks, kParallelBlocks, run);
+	} else {
+		run(0, blocks);
+	}
+}
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ecs/components/CNode.h"
+#include "ecs/components/CShape.h"
+
+namespace blot {
+class ThreadPool;
+
+namespace ecs {
+
+enum class NodeOp : uint8_t {
+	Constant, // dst = constants[imm]
+	Index,	  // dst = index of the instance in domain imm
+	Fraction, // dst = index / count of domain imm
+	Column,	  // dst = index % columns of grid domain imm
+	Row,	  // dst = index / columns of grid domain imm
+	Add,	  // dst = a + b
+	Sub,	  // dst = a - b
+	Mul,	  // dst = a * b
+	Mad,	  // dst = a * b + c
+	Sin,	  // dst = sin(a)
+	Cos,	  // dst = cos(a)
+	Store	  // field imm = a
+};
+
+struct NodeInstruction {
+	NodeOp op = NodeOp::Constant;
+	uint16_t dst = 0;
+	uint16_t a = 0;
+	uint16_t b = 0;
+	uint16_t c = 0;
+	uint32_t imm = 0;
+};
+
+// What a kernel stores per instance
+enum class NodeField : uint8_t {
+	X1,
+	Y1,
+	X2,
+	Y2,
+	Sides,
+	InnerRadius,
+	Fill,	// Hue in turns
+	Stroke, // Hue in turns
+	StrokeWidth,
+	Count
+};
+
+// A Copy or Grid node: the kernel runs once per combination of the
+// indices of its domains
+struct NodeDomain {
+	uint32_t countConstant = 0; // Copy count, or grid columns
+	uint32_t rowsConstant = UINT32_MAX; // Grid rows; none for Copy
+};
+
+// Everything one shape node needs, lowered to instructions over registers
+// of one float per instance
+struct NodeKernel {
+	entt::entity sink = entt::null;
+	CShape::Type shape = CShape::Type::Rectangle;
+	std::vector<NodeDomain> domains;
+	std::vector<NodeInstruction> code;
+	std::vector<uint32_t> constants; // Read by the kernel, for dirty checks
+	uint16_t registers = 0;
+	uint32_t fields = 0; // Bit per NodeField stored
+};
+
+// An unconnected input: the node's property of the same name, else the
+// pin's default
+struct NodeConstant {
+	entt::entity node = entt::null;
+	std::string pin;
+	float fallback = 0.0f;
+};
+
+struct NodeProgram {
+	std::vector<NodeConstant> constants;
+	std::vector<NodeKernel> kernels;
+};
+
+/**
+ * @brief Lowers a CNodeComponent graph to one flat kernel per shape node.
+ *
+ * Connections are looked up by node id and pin name once, here, so
+ * evaluation only runs instruction lists. Values are registers of one
+ * float per instance, reused once their last reader has run. Copy and Grid
+ * nodes fan the kernels that depend on them out over their instances;
+ * their counts must come from properties, not connections, so they are
+ * known before a kernel runs.
+ */
+class NodeGraphCompiler {
+  public:
+	using Node = std::pair<entt::entity, const CNodeComponent *>;
+
+	// False, with the error logged, if the graph has a cycle, a connection
+	// to a missing node or pin, or a connected count. `program` then holds
+	// the kernels of the shapes that did compile.
+	bool compile(const std::vector<Node> &nodes, NodeProgram &program);
+
+  private:
+	struct Kernel;
+
+	const std::vector<Node> *m_nodes = nullptr;
+	NodeProgram *m_program = nullptr;
+	std::map<int, size_t> m_nodeIndex;
+	// Source of each connected input, by target node id and pin
+	std::map<std::pair<int, std::string>, std::pair<int, std::string>>
+		m_inputs;
+	std::map<std::pair<size_t, std::string>, uint32_t> m_constantIndex;
+
+	uint32_t constant(size_t node, const std::string &pin);
+	uint32_t input(Kernel &kernel, size_t node, const std::string &pin);
+	uint32_t output(Kernel &kernel, size_t node, const std::string &pin);
+	uint32_t domain(Kernel &kernel, size_t node);
+	bool lowerShape(size_t node, NodeKernel &out);
+	void allocateRegisters(Kernel &kernel, NodeKernel &out);
+};
+
+// Instances of the kernel for the current constants: the product of its
+// domain counts, capped at kMaxNodeInstances
+constexpr size_t kMaxNodeInstances = 1000000;
+size_t getNodeInstanceCount(const NodeKernel &kernel, const float *constants);
+
+// Run the kernel for `count` instances. Each stored field goes to
+// fields[field * count + instance]. With a pool, large counts are split
+// across threads.
+void evaluateNodeKernel(const NodeKernel &kernel, const float *constants,
+						size_t count, ThreadPool *pool,
+						std::vector<float> &fields);
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,235 @@
+#include "ecs/ParameterGraph.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <spdlog/spdlog.h>
+
+#include "ecs/components/CParameter.h"
+
+namespace blot {
+namespace ecs {
+
+bool ParameterGraph::connect(entt::entity source, entt::entity target) {
+	if (source == entt::null || target == entt::null || source == target) {
+		return false;
+	}
+	uint32_t sourceNode = find(source);
+	uint32_t targetNode = find(target);
+	if (sourceNode != kNone && targetNode != kNone) {
+		if (m_nodes[targetNode].source == sourceNode) {
+			return true;
+		}
+		// The target must not already drive the source
+		for (uint32_t node = sourceNode; node != kNone;
+			 node = m_nodes[node].source) {
+			if (node == targetNode) {
+				spdlog::error("[ParameterGraph] Connection would form a cycle");
+				return false;
+			}
+		}
+	}
+
+	sourceNode = acquire(source);
+	targetNode = acquire(target);
+	if (m_nodes[targetNode].source != kNone) {
+		uint32_t previous = m_nodes[targetNode].source;
+		detach(targetNode);
+		releaseIfIsolated(previous);
+	}
+	m_nodes[targetNode].source = sourceNode;
+	m_nodes[sourceNode].targets.push_back(targetNode);
+	// Send the current value to every target on the next update
+	m_nodes[sourceNode].sent = std::numeric_limits<float>::quiet_NaN();
+	++m_connections;
+	m_orderDirty = true;
+	return true;
+}
+
+bool ParameterGraph::disconnect(entt::entity source, entt::entity target) {
+	uint32_t sourceNode = find(source);
+	uint32_t targetNode = find(target);
+	if (sourceNode == kNone || targetNode == kNone ||
+		m_nodes[targetNode].source != sourceNode) {
+		return false;
+	}
+	detach(targetNode);
+	releaseIfIsolated(targetNode);
+	releaseIfIsolated(sourceNode);
+	return true;
+}
+
+void ParameterGraph::disconnectTargets(entt::entity entity) {
+	uint32_t node = find(entity);
+	if (node == kNone || m_nodes[node].targets.empty()) {
+		return;
+	}
+	for (uint32_t target : m_nodes[node].targets) {
+		m_nodes[target].source = kNone;
+		--m_connections;
+	}
+	// Released targets go back to the free list, so clear before that
+	std::vector<uint32_t> targets;
+	targets.swap(m_nodes[node].targets);
+	for (uint32_t target : targets) {
+		releaseIfIsolated(target);
+	}
+	m_orderDirty = true;
+	releaseIfIsolated(node);
+}
+
+void ParameterGraph::remove(entt::entity entity) {
+	uint32_t node = find(entity);
+	if (node == kNone) {
+		return;
+	}
+	uint32_t source = m_nodes[node].source;
+	if (source != kNone) {
+		detach(node);
+		releaseIfIsolated(source);
+	}
+	disconnectTargets(entity);
+	releaseIfIsolated(node);
+}
+
+void ParameterGraph::clear() { *this = ParameterGraph(); }
+
+entt::entity ParameterGraph::getSource(entt::entity entity) const {
+	uint32_t node = find(entity);
+	if (node == kNone || m_nodes[node].source == kNone) {
+		return entt::null;
+	}
+	return m_nodes[m_nodes[node].source].entity;
+}
+
+std::vector<entt::entity>
+ParameterGraph::getTargets(entt::entity entity) const {
+	std::vector<entt::entity> targets;
+	uint32_t node = find(entity);
+	if (node != kNone) {
+		for (uint32_t target : m_nodes[node].targets) {
+			targets.push_back(m_nodes[target].entity);
+		}
+	}
+	return targets;
+}
+
+bool ParameterGraph::isConnected(entt::entity entity) const {
+	// Nodes only exist while they have a connection
+	return find(entity) != kNone;
+}
+
+void ParameterGraph::update(entt::registry &registry) {
+	if (m_orderDirty) {
+		buildOrder();
+	}
+	for (uint32_t index : m_order) {
+		Node &node = m_nodes[index];
+		const auto *parameter = registry.try_get<CParameter>(node.entity);
+		// NaN never compares equal, so a new connection always sends
+		if (!parameter || parameter->value == node.sent) {
+			continue;
+		}
+		node.sent = parameter->value;
+		for (uint32_t target : node.targets) {
+			if (auto *driven =
+					registry.try_get<CParameter>(m_nodes[target].entity)) {
+				driven->value = node.sent;
+			}
+		}
+	}
+}
+
+size_t ParameterGraph::getMemoryUsage() const {
+	size_t bytes = m_nodes.capacity() * sizeof(Node) +
+				   (m_freeNodes.capacity() + m_nodeOf.capacity() +
+					m_order.capacity()) *
+					   sizeof(uint32_t);
+	for (const Node &node : m_nodes) {
+		bytes += node.targets.capacity() * sizeof(uint32_t);
+	}
+	return bytes;
+}
+
+uint32_t ParameterGraph::find(entt::entity entity) const {
+	if (entity == entt::null) {
+		return kNone;
+	}
+	size_t index = entt::to_entity(entity);
+	if (index >= m_nodeOf.size()) {
+		return kNone;
+	}
+	uint32_t node = m_nodeOf[index];
+	if (node == kNone || m_nodes[node].entity != entity) {
+		return kNone;
+	}
+	return node;
+}
+
+uint32_t ParameterGraph::acquire(entt::entity entity) {
+	uint32_t node = find(entity);
+	if (node != kNone) {
+		return node;
+	}
+	size_t index = entt::to_entity(entity);
+	if (index >= m_nodeOf.size()) {
+		m_nodeOf.resize(index + 1, kNone);
+	}
+	if (m_freeNodes.empty()) {
+		node = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	} else {
+		node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+	m_nodes[node].entity = entity;
+	m_nodes[node].source = kNone;
+	m_nodes[node].sent = std::numeric_limits<float>::quiet_NaN();
+	m_nodeOf[index] = node;
+	return node;
+}
+
+void ParameterGraph::detach(uint32_t node) {
+	std::vector<uint32_t> &targets = m_nodes[m_nodes[node].source].targets;
+	auto it = std::find(targets.begin(), targets.end(), node);
+	*it = targets.back();
+	targets.pop_back();
+	m_nodes[node].source = kNone;
+	--m_connections;
+	m_orderDirty = true;
+}
+
+void ParameterGraph::releaseIfIsolated(uint32_t node) {
+	Node &entry = m_nodes[node];
+	if (entry.entity == entt::null || entry.source != kNone ||
+		!entry.targets.empty()) {
+		return;
+	}
+	m_nodeOf[entt::to_entity(entry.entity)] = kNone;
+	entry.entity = entt::null;
+	m_freeNodes.push_back(node);
+}
+
+void ParameterGraph::buildOrder() {
+	m_order.clear();
+	for (uint32_t node = 0; node < m_nodes.size(); ++node) {
+		const Node &entry = m_nodes[node];
+		if (entry.entity != entt::null && entry.source == kNone &&
+			!entry.targets.empty()) {
+			m_order.push_back(node);
+		}
+	}
+	// Breadth first from the roots; each node has one source, so it is
+	// reached once
+	for (size_t i = 0; i < m_order.size(); ++i) {
+		for (uint32_t target : m_nodes[m_order[i]].targets) {
+			if (!m_nodes[target].targets.empty()) {
+				m_order.push_back(target);
+			}
+		}
+	}
+	m_orderDirty = false;
+}
+
+} // namespace ecs
+} // namespace blot
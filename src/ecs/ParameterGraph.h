@@ -0,0 +1,72 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blot {
+namespace ecs {
+
+/**
+ * @brief Connections between CParameter entities, evaluated in dependency
+ * order.
+ *
+ * A parameter can drive any number of others and is driven by at most one,
+ * so the connections form a forest. update() walks it from the roots down:
+ * a chain settles in one frame. Only parameters that drive others are
+ * checked for changes, and a parameter's targets are written only when its
+ * value differs from what it last sent them.
+ */
+class ParameterGraph {
+  public:
+	// Drive `target` from `source`, replacing the target's current source.
+	// False, with nothing changed, if either is null or the connection
+	// would close a cycle.
+	bool connect(entt::entity source, entt::entity target);
+	bool disconnect(entt::entity source, entt::entity target);
+	// Drop the connections `entity` drives
+	void disconnectTargets(entt::entity entity);
+	// Drop every connection of `entity`, e.g. when it is destroyed
+	void remove(entt::entity entity);
+	void clear();
+
+	// entt::null when nothing drives the parameter
+	entt::entity getSource(entt::entity entity) const;
+	std::vector<entt::entity> getTargets(entt::entity entity) const;
+	bool isConnected(entt::entity entity) const;
+	size_t getConnectionCount() const { return m_connections; }
+
+	// Copy every changed source value down to its targets, parents first
+	void update(entt::registry &registry);
+
+	size_t getMemoryUsage() const;
+
+  private:
+	static constexpr uint32_t kNone = UINT32_MAX;
+
+	struct Node {
+		entt::entity entity = entt::null;
+		uint32_t source = kNone;
+		std::vector<uint32_t> targets;
+		float sent = 0.0f; // Value last copied to the targets, NaN if none
+	};
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_freeNodes;
+	// Node of each entity, indexed by entt::to_entity()
+	std::vector<uint32_t> m_nodeOf;
+	// Nodes with targets, parents before children
+	std::vector<uint32_t> m_order;
+	bool m_orderDirty = false;
+	size_t m_connections = 0;
+
+	uint32_t find(entt::entity entity) const;
+	uint32_t acquire(entt::entity entity);
+	void detach(uint32_t node); // From its source
+	void releaseIfIsolated(uint32_t node);
+	void buildOrder();
+};
+
+} // namespace ecs
+} // namespace blot
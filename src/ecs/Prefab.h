@@ -0,0 +1,77 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <typeindex>
+#include <vector>
+
+namespace blot {
+
+/**
+ * @brief Component set with default values, stamped out in bulk by
+ * MEcs::instantiate().
+ *
+ * Instancing reserves each component pool once for the whole batch and
+ * inserts one component type at a time, instead of growing every pool
+ * entity by entity. Adding a type that is already in the prefab replaces
+ * its defaults.
+ *
+ * @code
+ * Prefab dot;
+ * dot.with(ecs::CTransform{}).with(ecs::CShape{}).with(style);
+ * auto dots = ecs.instantiate(dot, 100000);
+ * @endcode
+ */
+class Prefab {
+  public:
+	template <typename T> Prefab &with(const T &defaults = T{}) {
+		Component component{std::type_index(typeid(T)),
+							[defaults](entt::registry &registry,
+									   const entt::entity *entities,
+									   size_t count) {
+								auto &pool = registry.storage<T>();
+								pool.reserve(pool.size() + count);
+								registry.insert<T>(entities, entities + count,
+												   defaults);
+							}};
+		for (Component &existing : m_components) {
+			if (existing.type == component.type) {
+				existing = std::move(component);
+				return *this;
+			}
+		}
+		m_components.push_back(std::move(component));
+		return *this;
+	}
+
+	template <typename T> bool has() const {
+		return std::any_of(m_components.begin(), m_components.end(),
+						   [](const Component &component) {
+							   return component.type == typeid(T);
+						   });
+	}
+
+	size_t getComponentCount() const { return m_components.size(); }
+
+	// Add every component, in the order they were first given, to each of
+	// `count` existing entities
+	void stamp(entt::registry &registry, const entt::entity *entities,
+			   size_t count) const {
+		for (const Component &component : m_components) {
+			component.insert(registry, entities, count);
+		}
+	}
+
+  private:
+	struct Component {
+		std::type_index type;
+		std::function<void(entt::registry &, const entt::entity *, size_t)>
+			insert;
+	};
+
+	std::vector<Component> m_components;
+};
+
+} // namespace blot
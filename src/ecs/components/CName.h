@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../PropertyReflection.h"
+
+namespace blot {
+namespace ecs {
+
+// Name given to MEcs::createEntity() or MEcs::setEntityName(). MEcs keeps
+// a name -> entity index beside it; rename through MEcs, not directly.
+struct CName {
+	std::string name;
+
+	std::vector<sProp> GetProperties() {
+		return {{0, "Name", EPT_STRING, &name}};
+	}
+};
+
+} // namespace ecs
+} // namespace blot
@@ -51,10 +51,11 @@ struct CNodeComponent {
 	// Pins (inputs/outputs)
 	std::vector<CNodePin> pins;
 
-	// Connections
+	// Connections into this node's inputs
 	std::vector<CNodeConnection> connections;
 
-	// Node properties (serializable)
+	// Node properties (serializable); a property named after an input pin
+	// sets its value while the pin is not connected
 	std::unordered_map<std::string, float> properties;
 
 	// Visual properties
@@ -110,6 +111,37 @@ struct CNodeComponent {
 				{"stroke", "color", true, false, 0.0f, "Stroke color"},
 				{"strokeWidth", "float", true, false, 1.0f, "Stroke width"}};
 			break;
+		case CNodeType::Line:
+			pins = {
+				{"x1", "float", true, false, 0.0f, "Start X"},
+				{"y1", "float", true, false, 0.0f, "Start Y"},
+				{"x2", "float", true, false, 100.0f, "End X"},
+				{"y2", "float", true, false, 100.0f, "End Y"},
+				{"stroke", "color", true, false, 0.0f, "Stroke color"},
+				{"strokeWidth", "float", true, false, 1.0f, "Stroke width"}};
+			break;
+		case CNodeType::Polygon:
+			pins = {
+				{"x", "float", true, false, 0.0f, "Center X"},
+				{"y", "float", true, false, 0.0f, "Center Y"},
+				{"radius", "float", true, false, 50.0f, "Radius"},
+				{"sides", "float", true, false, 6.0f, "Sides"},
+				{"color", "color", true, false, 0.0f, "Fill color"},
+				{"stroke", "color", true, false, 0.0f, "Stroke color"},
+				{"strokeWidth", "float", true, false, 1.0f, "Stroke width"}};
+			break;
+		case CNodeType::Star:
+			pins = {
+				{"x", "float", true, false, 0.0f, "Center X"},
+				{"y", "float", true, false, 0.0f, "Center Y"},
+				{"radius", "float", true, false, 50.0f, "Outer radius"},
+				{"innerRadius", "float", true, false, 0.5f,
+				 "Inner radius, as a fraction of the outer"},
+				{"points", "float", true, false, 5.0f, "Points"},
+				{"color", "color", true, false, 0.0f, "Fill color"},
+				{"stroke", "color", true, false, 0.0f, "Stroke color"},
+				{"strokeWidth", "float", true, false, 1.0f, "Stroke width"}};
+			break;
 		case CNodeType::Add:
 			pins = {{"a", "float", true, false, 0.0f, "First value"},
 					{"b", "float", true, false, 0.0f, "Second value"},
@@ -120,6 +152,30 @@ struct CNodeComponent {
 					{"b", "float", true, false, 1.0f, "Second value"},
 					{"result", "float", false, true, 1.0f, "Product"}};
 			break;
+		case CNodeType::Sin:
+			pins = {{"x", "float", true, false, 0.0f, "Angle in radians"},
+					{"result", "float", false, true, 0.0f, "Sine"}};
+			break;
+		case CNodeType::Cos:
+			pins = {{"x", "float", true, false, 0.0f, "Angle in radians"},
+					{"result", "float", false, true, 1.0f, "Cosine"}};
+			break;
+		case CNodeType::Grid:
+			pins = {{"columns", "float", true, false, 10.0f, "Columns"},
+					{"rows", "float", true, false, 10.0f, "Rows"},
+					{"originX", "float", true, false, 0.0f, "First cell X"},
+					{"originY", "float", true, false, 0.0f, "First cell Y"},
+					{"spacingX", "float", true, false, 20.0f, "Cell width"},
+					{"spacingY", "float", true, false, 20.0f, "Cell height"},
+					{"x", "float", false, true, 0.0f, "Cell X"},
+					{"y", "float", false, true, 0.0f, "Cell Y"},
+					{"index", "float", false, true, 0.0f, "Cell index"}};
+			break;
+		case CNodeType::Copy:
+			pins = {{"count", "float", true, false, 10.0f, "Copies"},
+					{"index", "float", false, true, 0.0f, "Copy index"},
+					{"t", "float", false, true, 0.0f, "Index / count"}};
+			break;
 		default:
 			// Add some default pins for unknown types
 			pins = {{"input", "float", true, false, 0.0f, "Input"},
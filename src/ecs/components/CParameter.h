@@ -1,5 +1,4 @@
 #pragma once
-#include <entt/entt.hpp>
 #include <string>
 
 namespace blot {
@@ -10,8 +9,6 @@ struct CParameter {
 	float value = 0.0f;
 	float minValue = 0.0f;
 	float maxValue = 1.0f;
-	bool isConnected = false;
-	entt::entity connectedTo = entt::null;
 };
 
 } // namespace ecs
@@ -0,0 +1,59 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <cstdint>
+#include <vector>
+#include "../PropertyReflection.h"
+
+namespace blot {
+namespace ecs {
+
+// Render-ready copy of a shape entity's CTransform, CShape and CDrawStyle,
+// packed so the shape renderer streams one dense array instead of three
+// pools. Rebuilt by SRenderProxyUpdate when a source component changes
+// (see MEcs::markShapeDirty()); do not edit it directly.
+struct CRenderProxy {
+	enum Flags : uint8_t {
+		Fill = 1 << 0,
+		Stroke = 1 << 1,
+		Dashed = 1 << 2,
+		MiterJoin = 1 << 3,
+		CapShift = 4, // CDrawStyle::StrokeCap in bits 4-5
+		CapMask = 3 << CapShift,
+		Dirty = 1 << 7 // Queued for rebuild
+	};
+
+	// Scale/translate affine mapping the unit square onto the shape's box
+	// in canvas space. Lines run from origin to origin + extent; polygons
+	// and stars are centered in the box with radius extent.x / 2.
+	glm::vec2 origin{0.0f, 0.0f};
+	glm::vec2 extent{0.0f, 0.0f};
+	uint32_t fill = 0;		  // RGBA8, as glm::packUnorm4x8
+	uint32_t stroke = 0;	  // RGBA8
+	uint16_t strokeWidth = 0; // Half float
+	uint16_t innerRadius = 0; // Half float, star inner/outer ratio
+	uint16_t sides = 0;
+	uint8_t type = 0; // CShape::Type
+	uint8_t flags = 0;
+
+	bool has(uint8_t flag) const { return (flags & flag) != 0; }
+	int getCap() const { return (flags & CapMask) >> CapShift; }
+	float getStrokeWidth() const { return glm::unpackHalf1x16(strokeWidth); }
+	float getInnerRadius() const { return glm::unpackHalf1x16(innerRadius); }
+	glm::vec2 getCenter() const { return origin + extent * 0.5f; }
+
+	std::vector<sProp> GetProperties() {
+		return {{0, "Origin X", EPT_FLOAT, &origin.x},
+				{1, "Origin Y", EPT_FLOAT, &origin.y},
+				{2, "Extent X", EPT_FLOAT, &extent.x},
+				{3, "Extent Y", EPT_FLOAT, &extent.y},
+				{4, "Fill", EPT_UINT, &fill},
+				{5, "Stroke", EPT_UINT, &stroke}};
+	}
+};
+
+static_assert(sizeof(CRenderProxy) == 32,
+			  "CRenderProxy must stay one half cache line");
+
+} // namespace ecs
+} // namespace blot
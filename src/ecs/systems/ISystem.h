@@ -0,0 +1,127 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <functional>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+namespace blot {
+class MEcs;
+
+namespace ecs {
+
+/**
+ * @brief Components a system reads and writes.
+ *
+ * The scheduler runs two systems at the same time only when neither writes
+ * a component the other touches. Exclusive systems (ones that create or
+ * destroy entities, or add and remove components) run alone.
+ */
+class SystemAccess {
+  public:
+	template <typename... T> SystemAccess &reads() {
+		(add<T>(m_reads), ...);
+		return *this;
+	}
+	template <typename... T> SystemAccess &writes() {
+		(add<T>(m_writes), ...);
+		return *this;
+	}
+	SystemAccess &exclusive() {
+		m_exclusive = true;
+		return *this;
+	}
+
+	bool isExclusive() const { return m_exclusive; }
+	bool isWritten(std::type_index type) const { return has(m_writes, type); }
+	bool conflictsWith(const SystemAccess &other) const {
+		if (m_exclusive || other.m_exclusive) {
+			return true;
+		}
+		for (std::type_index type : m_writes) {
+			if (has(other.m_reads, type) || has(other.m_writes, type)) {
+				return true;
+			}
+		}
+		for (std::type_index type : m_reads) {
+			if (has(other.m_writes, type)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Create the pools of every declared component, so concurrent systems
+	// never add one to the registry while another is looking one up
+	void createStorage(entt::registry &registry) const {
+		for (auto create : m_createStorage) {
+			create(registry);
+		}
+	}
+
+  private:
+	static bool has(const std::vector<std::type_index> &types,
+					std::type_index type) {
+		for (std::type_index entry : types) {
+			if (entry == type) {
+				return true;
+			}
+		}
+		return false;
+	}
+	template <typename T> void add(std::vector<std::type_index> &types) {
+		if (!has(types, typeid(T))) {
+			types.push_back(typeid(T));
+			m_createStorage.push_back(
+				[](entt::registry &registry) { registry.storage<T>(); });
+		}
+	}
+
+	std::vector<std::type_index> m_reads;
+	std::vector<std::type_index> m_writes;
+	std::vector<void (*)(entt::registry &)> m_createStorage;
+	bool m_exclusive = false;
+};
+
+/**
+ * @brief An update step over the registry, run by MEcs::updateSystems().
+ *
+ * declareAccess() is called once, when the system is added. update() may
+ * run on a worker thread, concurrently with systems whose access does not
+ * conflict; it must only touch the components it declared.
+ */
+class ISystem {
+  public:
+	virtual ~ISystem() = default;
+	virtual std::string getName() const = 0;
+	virtual void declareAccess(SystemAccess &access) const = 0;
+	virtual void update(MEcs &ecs, float deltaTime) = 0;
+};
+
+// System from a function, for small steps that need no state of their own
+class FunctionSystem : public ISystem {
+  public:
+	using UpdateFunc = std::function<void(MEcs &, float)>;
+
+	FunctionSystem(std::string name, SystemAccess access, UpdateFunc update)
+		: m_name(std::move(name)), m_access(std::move(access)),
+		  m_update(std::move(update)) {}
+
+	std::string getName() const override { return m_name; }
+	void declareAccess(SystemAccess &access) const override {
+		access = m_access;
+	}
+	void update(MEcs &ecs, float deltaTime) override {
+		m_update(ecs, deltaTime);
+	}
+
+  private:
+	std::string m_name;
+	SystemAccess m_access;
+	UpdateFunc m_update;
+};
+
+} // namespace ecs
+} // namespace blot
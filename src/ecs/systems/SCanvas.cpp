@@ -10,6 +10,9 @@ void SCanvasUpdate(MEcs &ecs, MRendering *renderingManager, float deltaTime) {
 	for (auto entity : view) {
 		auto canvasPtr = renderingManager->getCanvas(entity);
 		if (canvasPtr && *canvasPtr) {
+			// Pan and zoom from the canvas entity decide what gets drawn
+			const auto &texture = view.template get<ecs::CTexture>(entity);
+			(*canvasPtr)->setView(texture.offset, texture.zoom);
 			(*canvasPtr)->update(deltaTime);
 		}
 	}
@@ -0,0 +1,198 @@
+#include "ecs/systems/SNodeGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "ecs/MEcs.h"
+#include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CShape.h"
+#include "ecs/components/CTransform.h"
+
+namespace blot {
+namespace ecs {
+
+namespace {
+
+void mix(uint64_t &hash, uint64_t value) {
+	hash = (hash ^ value) * 1099511628211ull; // FNV-1a prime
+}
+
+// Full saturation and value
+void hueToRgb(float hue, float &r, float &g, float &b) {
+	float h = (hue - std::floor(hue)) * 6.0f;
+	r = std::clamp(std::fabs(h - 3.0f) - 1.0f, 0.0f, 1.0f);
+	g = std::clamp(2.0f - std::fabs(h - 2.0f), 0.0f, 1.0f);
+	b = std::clamp(2.0f - std::fabs(h - 4.0f), 0.0f, 1.0f);
+}
+
+// Changes whenever compiling would give a different program: nodes,
+// connections, or which properties are set
+uint64_t getSignature(const std::vector<NodeGraphCompiler::Node> &nodes) {
+	std::hash<std::string> hashString;
+	uint64_t hash = 14695981039346656037ull; // FNV-1a offset basis
+	for (const auto &[entity, node] : nodes) {
+		mix(hash, static_cast<uint64_t>(entt::to_integral(entity)));
+		mix(hash, static_cast<uint64_t>(node->nodeId));
+		mix(hash, static_cast<uint64_t>(node->type));
+		for (const CNodeConnection &connection : node->connections) {
+			mix(hash, static_cast<uint64_t>(connection.fromNodeId));
+			mix(hash, hashString(connection.fromPin));
+			mix(hash, static_cast<uint64_t>(connection.toNodeId));
+			mix(hash, hashString(connection.toPin));
+		}
+		// Summed, as the map's order is unspecified
+		uint64_t properties = 0;
+		for (const auto &property : node->properties) {
+			properties += hashString(property.first);
+		}
+		mix(hash, properties);
+	}
+	return hash;
+}
+
+} // namespace
+
+void SNodeGraph::update(MEcs &ecs, float /*deltaTime*/) {
+	m_nodes.clear();
+	auto view = ecs.view<CNodeComponent>();
+	for (entt::entity entity : view) {
+		auto &node = view.template get<CNodeComponent>(entity);
+		m_nodes.emplace_back(entity, &node);
+	}
+	if (m_nodes.empty() && m_sinks.empty()) {
+		return;
+	}
+
+	uint64_t signature = getSignature(m_nodes);
+	bool recompiled = !m_compiled || signature != m_signature;
+	if (recompiled) {
+		m_compiler.compile(m_nodes, m_program);
+		m_signature = signature;
+		m_compiled = true;
+		m_values.assign(m_program.constants.size(),
+						std::numeric_limits<float>::quiet_NaN());
+		m_changed.assign(m_program.constants.size(), 1);
+	}
+	for (size_t i = 0; i < m_program.constants.size(); ++i) {
+		const NodeConstant &constant = m_program.constants[i];
+		const auto &properties =
+			ecs.getComponent<CNodeComponent>(constant.node).properties;
+		auto property = properties.find(constant.pin);
+		float value = property != properties.end() ? property->second
+												   : constant.fallback;
+		m_changed[i] = recompiled || value != m_values[i];
+		m_values[i] = value;
+	}
+
+	for (auto &entry : m_sinks) {
+		entry.second.live = false;
+	}
+	for (const NodeKernel &kernel : m_program.kernels) {
+		Sink &sink = m_sinks[kernel.sink];
+		sink.live = true;
+		bool dirty = recompiled;
+		for (uint32_t constant : kernel.constants) {
+			dirty = dirty || m_changed[constant];
+		}
+		if (!dirty) {
+			continue;
+		}
+		size_t count = getNodeInstanceCount(kernel, m_values.data());
+		evaluateNodeKernel(kernel, m_values.data(), count,
+						   ecs.getThreadPool(), sink.fields);
+		sync(ecs, kernel, sink, count);
+	}
+	// Shape nodes that were removed or no longer compile
+	for (auto it = m_sinks.begin(); it != m_sinks.end();) {
+		if (it->second.live) {
+			++it;
+		} else {
+			ecs.destroyEntities(it->second.instances);
+			it = m_sinks.erase(it);
+		}
+	}
+}
+
+const std::vector<entt::entity> &
+SNodeGraph::getInstances(entt::entity node) const {
+	static const std::vector<entt::entity> s_none;
+	auto found = m_sinks.find(node);
+	return found != m_sinks.end() ? found->second.instances : s_none;
+}
+
+void SNodeGraph::sync(MEcs &ecs, const NodeKernel &kernel, Sink &sink,
+					  size_t count) {
+	std::vector<entt::entity> &instances = sink.instances;
+	if (instances.size() > count) {
+		ecs.destroyEntities(instances.data() + count,
+							instances.size() - count);
+		instances.resize(count);
+	}
+	// Instances destroyed elsewhere are replaced when their kernel next runs
+	for (entt::entity &entity : instances) {
+		if (!ecs.isValid(entity)) {
+			entity = ecs.createEntity();
+			ecs.addComponent<CTransform>(entity);
+			ecs.addComponent<CShape>(entity);
+			ecs.addComponent<CDrawStyle>(entity);
+		}
+	}
+	if (instances.size() < count) {
+		std::vector<entt::entity> created =
+			ecs.createEntities(count - instances.size());
+		for (entt::entity entity : created) {
+			ecs.addComponent<CTransform>(entity);
+			ecs.addComponent<CShape>(entity);
+			ecs.addComponent<CDrawStyle>(entity);
+		}
+		instances.insert(instances.end(), created.begin(), created.end());
+	}
+
+	auto has = [&](NodeField field) {
+		return (kernel.fields >> static_cast<uint32_t>(field)) & 1u;
+	};
+	auto data = [&](NodeField field) {
+		return sink.fields.data() + static_cast<size_t>(field) * count;
+	};
+	const float *x1 = data(NodeField::X1);
+	const float *y1 = data(NodeField::Y1);
+	const float *x2 = data(NodeField::X2);
+	const float *y2 = data(NodeField::Y2);
+	const float *sides = data(NodeField::Sides);
+	const float *innerRadius = data(NodeField::InnerRadius);
+	const float *fill = data(NodeField::Fill);
+	const float *stroke = data(NodeField::Stroke);
+	const float *strokeWidth = data(NodeField::StrokeWidth);
+	for (size_t i = 0; i < count; ++i) {
+		entt::entity entity = instances[i];
+		CShape &shape = ecs.getComponent<CShape>(entity);
+		shape.type = kernel.shape;
+		shape.x1 = x1[i];
+		shape.y1 = y1[i];
+		shape.x2 = x2[i];
+		shape.y2 = y2[i];
+		if (has(NodeField::Sides)) {
+			shape.sides = static_cast<int>(std::lround(sides[i]));
+		}
+		if (has(NodeField::InnerRadius)) {
+			shape.innerRadius = innerRadius[i];
+		}
+		CDrawStyle &style = ecs.getComponent<CDrawStyle>(entity);
+		float r, g, b;
+		if (has(NodeField::Fill)) {
+			hueToRgb(fill[i], r, g, b);
+			style.setFillColor(r, g, b, style.fillA);
+		}
+		if (has(NodeField::Stroke)) {
+			hueToRgb(stroke[i], r, g, b);
+			style.setStrokeColor(r, g, b, style.strokeA);
+		}
+		style.strokeWidth = strokeWidth[i];
+		ecs.markShapeDirty(entity);
+	}
+}
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ecs/NodeGraphCompiler.h"
+#include "ecs/systems/ISystem.h"
+
+namespace blot {
+namespace ecs {
+
+/**
+ * @brief Turns the CNodeComponent graph into shapes, once per update.
+ *
+ * The graph is compiled again only when its nodes, connections or set
+ * properties change; property values are read into the compiled program
+ * each frame. A shape node's kernel runs again only when a value it reads
+ * changed, and then writes its instances' CShape and CDrawStyle. Instances
+ * are entities owned by the system: they are created and destroyed to
+ * match the kernel's instance count, and with their node.
+ */
+class SNodeGraph : public ISystem {
+  public:
+	std::string getName() const override { return "SNodeGraph"; }
+	void declareAccess(SystemAccess &access) const override {
+		access.exclusive(); // Creates and destroys instances
+	}
+	void update(MEcs &ecs, float deltaTime) override;
+
+	// Entities generated for the shape node, empty if it has none
+	const std::vector<entt::entity> &getInstances(entt::entity node) const;
+
+  private:
+	struct Sink {
+		std::vector<entt::entity> instances;
+		std::vector<float> fields;
+		bool live = false;
+	};
+
+	NodeGraphCompiler m_compiler;
+	NodeProgram m_program;
+	std::vector<NodeGraphCompiler::Node> m_nodes;
+	uint64_t m_signature = 0;
+	bool m_compiled = false;
+	// Current value and whether it changed this update, per constant
+	std::vector<float> m_values;
+	std::vector<uint8_t> m_changed;
+	std::unordered_map<entt::entity, Sink> m_sinks;
+
+	void sync(MEcs &ecs, const NodeKernel &kernel, Sink &sink, size_t count);
+};
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,114 @@
+#include "SRenderProxy.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+#include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CRenderProxy.h"
+#include "ecs/components/CShape.h"
+#include "ecs/components/CTransform.h"
+
+namespace blot {
+namespace ecs {
+
+void buildRenderProxy(const CTransform &transform, const CShape &shape,
+					  const CDrawStyle &style, CRenderProxy &proxy) {
+	glm::vec2 position(transform.position.x, transform.position.y);
+	glm::vec2 scale(transform.scale.x, transform.scale.y);
+	glm::vec2 p1 = (position + glm::vec2(shape.x1, shape.y1)) * scale;
+
+	switch (shape.type) {
+	case CShape::Type::Rectangle:
+	case CShape::Type::Ellipse:
+		proxy.origin = p1;
+		proxy.extent =
+			glm::vec2(shape.x2 - shape.x1, shape.y2 - shape.y1) * scale;
+		break;
+	case CShape::Type::Line:
+		proxy.origin = p1;
+		proxy.extent = (position + glm::vec2(shape.x2, shape.y2)) * scale - p1;
+		break;
+	case CShape::Type::Polygon:
+	case CShape::Type::Star: {
+		// Radius follows the x scale only, as it always has
+		float radius = (shape.x2 - shape.x1) * transform.scale.x;
+		proxy.origin = p1 - glm::vec2(radius);
+		proxy.extent = glm::vec2(2.0f * radius);
+		break;
+	}
+	}
+
+	proxy.fill = glm::packUnorm4x8(
+		glm::vec4(style.fillR, style.fillG, style.fillB, style.fillA));
+	proxy.stroke = glm::packUnorm4x8(
+		glm::vec4(style.strokeR, style.strokeG, style.strokeB, style.strokeA));
+	proxy.strokeWidth = glm::packHalf1x16(style.strokeWidth);
+	proxy.innerRadius = glm::packHalf1x16(shape.innerRadius);
+	proxy.sides = static_cast<uint16_t>(std::clamp(shape.sides, 0, 0xFFFF));
+	proxy.type = static_cast<uint8_t>(shape.type);
+
+	uint8_t flags = 0;
+	if (style.hasFill)
+		flags |= CRenderProxy::Fill;
+	if (style.hasStroke)
+		flags |= CRenderProxy::Stroke;
+	if (!style.dashPattern.empty())
+		flags |= CRenderProxy::Dashed;
+	if (style.strokeJoin == CDrawStyle::StrokeJoin::Miter)
+		flags |= CRenderProxy::MiterJoin;
+	flags |= static_cast<uint8_t>(static_cast<int>(style.strokeCap)
+								  << CRenderProxy::CapShift);
+	proxy.flags = flags;
+}
+
+void getProxyBounds(const CRenderProxy &proxy, glm::vec2 &min,
+					glm::vec2 &max) {
+	auto type = static_cast<CShape::Type>(proxy.type);
+	if (type == CShape::Type::Star) {
+		float radius = std::fabs(proxy.extent.x) * 0.5f;
+		radius = std::max(radius, radius * std::fabs(proxy.getInnerRadius()));
+		min = proxy.getCenter() - glm::vec2(radius);
+		max = proxy.getCenter() + glm::vec2(radius);
+	} else {
+		min = glm::min(proxy.origin, proxy.origin + proxy.extent);
+		max = glm::max(proxy.origin, proxy.origin + proxy.extent);
+	}
+
+	if (proxy.has(CRenderProxy::Stroke)) {
+		// A full stroke width covers caps and right-angle miters; mitered
+		// star spikes can reach further, up to the usual 4x miter limit.
+		float pad = proxy.getStrokeWidth();
+		if (type == CShape::Type::Star && proxy.has(CRenderProxy::MiterJoin)) {
+			pad *= 2.0f;
+		}
+		min -= glm::vec2(pad);
+		max += glm::vec2(pad);
+	}
+}
+
+size_t SRenderProxyUpdate(entt::registry &registry,
+						  std::vector<entt::entity> &dirty) {
+	size_t rebuilt = 0;
+	for (auto entity : dirty) {
+		if (!registry.valid(entity)) {
+			continue;
+		}
+		auto *proxy = registry.try_get<CRenderProxy>(entity);
+		if (!proxy || !proxy->has(CRenderProxy::Dirty)) {
+			continue;
+		}
+		if (!registry.all_of<CTransform, CShape, CDrawStyle>(entity)) {
+			// Not drawable (yet); a later emplace queues it again
+			registry.remove<CRenderProxy>(entity);
+			continue;
+		}
+		buildRenderProxy(registry.get<CTransform>(entity),
+						 registry.get<CShape>(entity),
+						 registry.get<CDrawStyle>(entity), *proxy);
+		++rebuilt;
+	}
+	dirty.clear();
+	return rebuilt;
+}
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace blot {
+namespace ecs {
+
+struct CDrawStyle;
+struct CRenderProxy;
+struct CShape;
+struct CTransform;
+
+// Pack a shape's components into its render proxy, applying the transform
+// the same way the shape renderer always has (position, then scale;
+// rotation is not applied to 2D shapes).
+void buildRenderProxy(const CTransform &transform, const CShape &shape,
+					  const CDrawStyle &style, CRenderProxy &proxy);
+
+// Canvas-space bounding box of a proxy, stroke included
+void getProxyBounds(const CRenderProxy &proxy, glm::vec2 &min, glm::vec2 &max);
+
+// Rebuild the proxies of the queued entities and clear the queue. Entities
+// that were destroyed or lost a source component since being queued are
+// skipped. Returns the number of proxies rebuilt.
+size_t SRenderProxyUpdate(entt::registry &registry,
+						  std::vector<entt::entity> &dirty);
+
+} // namespace ecs
+} // namespace blot
@@ -1,212 +1,427 @@
 #include "SShapeRendering.h"
+#include <algorithm>
 #include <cmath>
+#include <glm/gtc/packing.hpp>
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 #include "ecs/components/CSelection.h"
 #include "ecs/components/CTransform.h"
 #include "rendering/IRenderer.h"
+#include "rendering/ShapeInstancer.h"
 
 namespace blot {
 namespace ecs {
 
-// TODO: This should be a class that inherits from ISystem?
-void SShapeRendering(MEcs &ecs, std::shared_ptr<IRenderer> renderer) {
-	// If Blend2D-specific logic is needed, use dynamic_cast here
-	// Blend2DRenderer* blend2d =
-	// dynamic_cast<Blend2DRenderer*>(renderer.get());
-	auto view = ecs.view<ecs::CTransform, ecs::CShape, ecs::CDrawStyle>();
-
-	for (auto entity : view) {
-		auto &transform = view.get<ecs::CTransform>(entity);
-		auto &shape = view.get<ecs::CShape>(entity);
-		auto &style = view.get<ecs::CDrawStyle>(entity);
-
-		switch (shape.type) {
-		case ecs::CShape::Type::Rectangle:
-			renderRectangle(transform, shape, style, renderer);
-			break;
-		case ecs::CShape::Type::Ellipse:
-			renderEllipse(transform, shape, style, renderer);
-			break;
-		case ecs::CShape::Type::Line:
-			renderLine(transform, shape, style, renderer);
-			break;
-		case ecs::CShape::Type::Polygon:
-			renderPolygon(transform, shape, style, renderer);
-			break;
-		case ecs::CShape::Type::Star:
-			renderStar(transform, shape, style, renderer);
-			break;
-		}
-	}
+namespace {
+
+// Scratch outline reused across shapes to avoid an allocation per draw
+thread_local std::vector<glm::vec2> s_points;
+
+// Analytic backends (Blend2D) flatten curves adaptively on their own;
+// tessellating ones get an outline sized by the LOD policy instead of
+// whatever fixed count they would pick.
+bool tessellatesCurves(const IRenderer &renderer) {
+	return renderer.getType() == RendererType::OpenGL;
 }
 
-void renderRectangle(const ecs::CTransform &transform, const ecs::CShape &shape,
-					 const ecs::CDrawStyle &style,
-					 std::shared_ptr<IRenderer> renderer) {
-	if (!renderer)
-		return;
+// Walk `count` evenly spaced directions by rotating a unit vector, instead of
+// calling sin/cos for every vertex. Radii alternate between r0 and r1.
+void appendRing(std::vector<glm::vec2> &points, const glm::vec2 &center,
+				const glm::vec2 &r0, const glm::vec2 &r1, int count) {
+	float step = 2.0f * static_cast<float>(M_PI) / count;
+	float c = std::cos(step), s = std::sin(step);
+	glm::vec2 dir(1.0f, 0.0f);
+	for (int i = 0; i < count; ++i) {
+		const glm::vec2 &r = (i % 2 == 0) ? r0 : r1;
+		points.push_back(center + dir * r);
+		dir = glm::vec2(dir.x * c - dir.y * s, dir.x * s + dir.y * c);
+	}
+}
 
-	float x = transform.position.x + shape.x1;
-	float y = transform.position.y + shape.y1;
-	float width = shape.x2 - shape.x1;
-	float height = shape.y2 - shape.y1;
+void setFill(const CRenderProxy &proxy, IRenderer &renderer) {
+	renderer.setFillColor(glm::unpackUnorm4x8(proxy.fill));
+}
 
-	// Apply transform
-	x *= transform.scale.x;
-	y *= transform.scale.y;
-	width *= transform.scale.x;
-	height *= transform.scale.y;
+void setStroke(const CRenderProxy &proxy, IRenderer &renderer) {
+	renderer.setStrokeColor(glm::unpackUnorm4x8(proxy.stroke));
+	renderer.setStrokeWidth(proxy.getStrokeWidth());
+}
 
-	if (style.hasFill) {
-		setFillStyle(style, renderer);
-		renderer->drawRect(x, y, width, height);
+void drawOutline(const std::vector<glm::vec2> &points,
+				 const CRenderProxy &proxy, IRenderer &renderer) {
+	if (proxy.has(CRenderProxy::Fill)) {
+		setFill(proxy, renderer);
+		renderer.drawPolygon(points);
 	}
 
-	if (style.hasStroke) {
-		setStrokeStyle(style, renderer);
-		renderer->drawRect(x, y, width, height);
+	if (proxy.has(CRenderProxy::Stroke)) {
+		setStroke(proxy, renderer);
+		renderer.drawPolygon(points);
 	}
 }
 
-void renderEllipse(const ecs::CTransform &transform, const ecs::CShape &shape,
-				   const ecs::CDrawStyle &style,
-				   std::shared_ptr<IRenderer> renderer) {
-	if (!renderer)
-		return;
+// True if the shape, stroke included, is smaller than a point on screen
+bool collapsesToPoint(const CRenderProxy &proxy, const LodPolicy &lod) {
+	float pad =
+		proxy.has(CRenderProxy::Stroke) ? proxy.getStrokeWidth() : 0.0f;
+	return lod.isSubPixel(std::fabs(proxy.extent.x) + pad,
+						  std::fabs(proxy.extent.y) + pad);
+}
 
-	float x = transform.position.x + shape.x1;
-	float y = transform.position.y + shape.y1;
-	float width = shape.x2 - shape.x1;
-	float height = shape.y2 - shape.y1;
+// Fraction of a point covered by the proxy's box
+float pointCoverage(const CRenderProxy &proxy, const LodPolicy &lod) {
+	float area = std::fabs(proxy.extent.x * proxy.extent.y) * lod.zoom *
+				 lod.zoom;
+	return std::min(area / (lod.pointSize * lod.pointSize), 1.0f);
+}
 
-	// Apply transform
-	x *= transform.scale.x;
-	y *= transform.scale.y;
-	width *= transform.scale.x;
-	height *= transform.scale.y;
+void drawRectangle(const CRenderProxy &proxy, IRenderer &renderer) {
+	const glm::vec2 &p = proxy.origin;
+	const glm::vec2 &size = proxy.extent;
 
-	float centerX = x + width * 0.5f;
-	float centerY = y + height * 0.5f;
-	float radiusX = width * 0.5f;
-	float radiusY = height * 0.5f;
+	if (proxy.has(CRenderProxy::Fill)) {
+		setFill(proxy, renderer);
+		renderer.drawRect(p.x, p.y, size.x, size.y);
+	}
 
-	if (style.hasFill) {
-		setFillStyle(style, renderer);
-		renderer->drawEllipse(centerX, centerY, radiusX, radiusY);
+	if (proxy.has(CRenderProxy::Stroke)) {
+		setStroke(proxy, renderer);
+		renderer.drawRect(p.x, p.y, size.x, size.y);
 	}
+}
 
-	if (style.hasStroke) {
-		setStrokeStyle(style, renderer);
-		renderer->drawEllipse(centerX, centerY, radiusX, radiusY);
+void drawEllipse(const CRenderProxy &proxy, IRenderer &renderer,
+				 const LodPolicy &lod) {
+	glm::vec2 center = proxy.getCenter();
+	glm::vec2 radius = proxy.extent * 0.5f;
+
+	if (collapsesToPoint(proxy, lod)) {
+		// An ellipse fills pi/4 of its bounding box
+		renderPoint(center, pointCoverage(proxy, lod) * 0.785398f, proxy,
+					renderer, lod);
+		return;
+	}
+
+	if (tessellatesCurves(renderer)) {
+		int segments = lod.arcSegments(
+			std::max(std::fabs(radius.x), std::fabs(radius.y)));
+		s_points.clear();
+		appendRing(s_points, center, radius, radius, segments);
+		drawOutline(s_points, proxy, renderer);
+		return;
+	}
+
+	if (proxy.has(CRenderProxy::Fill)) {
+		setFill(proxy, renderer);
+		renderer.drawEllipse(center.x, center.y, radius.x, radius.y);
+	}
+
+	if (proxy.has(CRenderProxy::Stroke)) {
+		setStroke(proxy, renderer);
+		renderer.drawEllipse(center.x, center.y, radius.x, radius.y);
 	}
 }
 
-void renderLine(const ecs::CTransform &transform, const ecs::CShape &shape,
-				const ecs::CDrawStyle &style,
-				std::shared_ptr<IRenderer> renderer) {
-	if (!renderer || !style.hasStroke)
+void drawLine(const CRenderProxy &proxy, IRenderer &renderer) {
+	if (!proxy.has(CRenderProxy::Stroke))
 		return;
 
-	float x1 = transform.position.x + shape.x1;
-	float y1 = transform.position.y + shape.y1;
-	float x2 = transform.position.x + shape.x2;
-	float y2 = transform.position.y + shape.y2;
+	glm::vec2 p1 = proxy.origin;
+	glm::vec2 p2 = proxy.origin + proxy.extent;
+	setStroke(proxy, renderer);
+	renderer.drawLine(p1.x, p1.y, p2.x, p2.y);
+}
+
+void drawPolygon(const CRenderProxy &proxy, IRenderer &renderer,
+				 const LodPolicy &lod) {
+	if (proxy.sides < 3)
+		return;
+
+	glm::vec2 center = proxy.getCenter();
+	float radius = proxy.extent.x * 0.5f;
+
+	if (collapsesToPoint(proxy, lod)) {
+		renderPoint(center, pointCoverage(proxy, lod) * 0.75f, proxy,
+					renderer, lod);
+		return;
+	}
 
-	// Apply transform
-	x1 *= transform.scale.x;
-	y1 *= transform.scale.y;
-	x2 *= transform.scale.x;
-	y2 *= transform.scale.y;
+	// Beyond the count needed for a circle of this size, extra sides are
+	// indistinguishable on screen
+	int sides = std::min(static_cast<int>(proxy.sides),
+						 std::max(3, lod.arcSegments(radius)));
 
-	setStrokeStyle(style, renderer);
-	renderer->drawLine(x1, y1, x2, y2);
+	s_points.clear();
+	appendRing(s_points, center, glm::vec2(radius), glm::vec2(radius), sides);
+	drawOutline(s_points, proxy, renderer);
 }
 
-void renderPolygon(const ecs::CTransform &transform, const ecs::CShape &shape,
-				   const ecs::CDrawStyle &style,
-				   std::shared_ptr<IRenderer> renderer) {
-	if (!renderer)
+void drawStar(const CRenderProxy &proxy, IRenderer &renderer,
+			  const LodPolicy &lod) {
+	if (proxy.sides < 2)
 		return;
 
-	float centerX = transform.position.x + shape.x1;
-	float centerY = transform.position.y + shape.y1;
-	float radius = shape.x2 - shape.x1;
+	glm::vec2 center = proxy.getCenter();
+	float outerRadius = proxy.extent.x * 0.5f;
+	float innerRadius = outerRadius * proxy.getInnerRadius();
 
-	// Apply transform
-	centerX *= transform.scale.x;
-	centerY *= transform.scale.y;
-	radius *= transform.scale.x;
+	if (collapsesToPoint(proxy, lod)) {
+		renderPoint(center, pointCoverage(proxy, lod) * 0.5f, proxy,
+					renderer, lod);
+		return;
+	}
 
-	std::vector<float> points;
-	int sides = shape.sides;
-	for (int i = 0; i < sides; ++i) {
-		float angle = 2.0f * M_PI * i / sides;
-		float x = centerX + radius * cos(angle);
-		float y = centerY + radius * sin(angle);
-		points.push_back(x);
-		points.push_back(y);
+	s_points.clear();
+
+	// When neighbouring spikes are closer than a pixel they blur into a
+	// ring; draw the equivalent disc instead of thousands of slivers
+	float spacing =
+		2.0f * static_cast<float>(M_PI) * std::fabs(outerRadius) * lod.zoom;
+	if (spacing / proxy.sides < lod.pointSize) {
+		float meanRadius = 0.5f * (outerRadius + innerRadius);
+		appendRing(s_points, center, glm::vec2(meanRadius),
+				   glm::vec2(meanRadius),
+				   std::max(3, lod.arcSegments(meanRadius)));
+	} else {
+		appendRing(s_points, center, glm::vec2(outerRadius),
+				   glm::vec2(innerRadius), proxy.sides * 2);
 	}
+	drawOutline(s_points, proxy, renderer);
+}
 
-	std::vector<glm::vec2> glmPoints;
-	for (size_t i = 0; i < points.size(); i += 2) {
-		glmPoints.push_back(glm::vec2(points[i], points[i + 1]));
+// Queue a proxy as a GPU instance. Returns false for shapes the instancer
+// cannot express.
+bool queueInstance(ShapeInstancer &instancer, const CRenderProxy &proxy) {
+	uint32_t fill = proxy.has(CRenderProxy::Fill) ? proxy.fill : 0u;
+	bool stroked = proxy.has(CRenderProxy::Stroke);
+	uint32_t stroke = stroked ? proxy.stroke : 0u;
+	float strokeWidth = stroked ? proxy.getStrokeWidth() : 0.0f;
+	glm::vec4 geometry(proxy.origin, proxy.extent);
+
+	switch (static_cast<CShape::Type>(proxy.type)) {
+	case CShape::Type::Rectangle:
+		instancer.addRect(geometry, fill, stroke, strokeWidth);
+		return true;
+	case CShape::Type::Ellipse:
+		instancer.addEllipse(geometry, fill, stroke, strokeWidth);
+		return true;
+	case CShape::Type::Line:
+		if (proxy.has(CRenderProxy::Dashed))
+			return false;
+		if (stroked) {
+			// Both cap enums are ordered Butt, Square, Round
+			instancer.addLine(
+				glm::vec4(proxy.origin, proxy.origin + proxy.extent), stroke,
+				strokeWidth,
+				static_cast<ShapeInstancer::LineCap>(proxy.getCap()));
+		}
+		return true;
+	default:
+		return false;
 	}
-	if (style.hasFill) {
-		setFillStyle(style, renderer);
-		renderer->drawPolygon(glmPoints);
+}
+
+// The view with its size filled in from the renderer when unset
+ShapeRenderView resolveView(const ShapeRenderView &viewState,
+							const IRenderer &renderer) {
+	ShapeRenderView resolved = viewState;
+	if (resolved.size.x <= 0.0f || resolved.size.y <= 0.0f) {
+		resolved.size = glm::vec2(static_cast<float>(renderer.getWidth()),
+								  static_cast<float>(renderer.getHeight()));
+	}
+	return resolved;
+}
+
+// Cull and draw every proxy `forEach` visits. Proxies must stay in place
+// until this returns.
+template <typename ForEach>
+ShapeRenderStats drawProxies(ForEach &&forEach, IRenderer &renderer,
+							 const ShapeRenderView &viewState) {
+	ShapeRenderStats stats;
+
+	ShapeRenderView resolved = resolveView(viewState, renderer);
+	// Without a known viewport there is nothing to cull against
+	bool cull = resolved.size.x > 0.0f && resolved.size.y > 0.0f;
+	glm::vec2 visibleMin, visibleMax;
+	resolved.getVisibleRect(visibleMin, visibleMax);
+	LodPolicy lod = resolved.getLodPolicy();
+
+	ShapeInstancer *instancer = resolved.instancer;
+	if (instancer) {
+		instancer->setView(resolved.offset, resolved.zoom, resolved.size);
 	}
+	// Shapes the instancer cannot draw, when submission order is not kept
+	std::vector<const CRenderProxy *> deferred;
+
+	forEach([&](const CRenderProxy &proxy) {
+		if (cull) {
+			glm::vec2 min, max;
+			getProxyBounds(proxy, min, max);
+			if (!boundsOverlap(min, max, visibleMin, visibleMax)) {
+				++stats.culled;
+				return;
+			}
+		}
+		++stats.submitted;
+
+		if (instancer) {
+			if (queueInstance(*instancer, proxy)) {
+				++stats.instanced;
+				return;
+			}
+			if (!instancer->getPreserveOrder()) {
+				deferred.push_back(&proxy);
+				return;
+			}
+			// Draw what is queued so this shape lands on top of it
+			stats.batches += instancer->flush();
+		}
 
-	if (style.hasStroke) {
-		setStrokeStyle(style, renderer);
-		renderer->drawPolygon(glmPoints);
+		renderProxy(proxy, renderer, lod);
+	});
+
+	if (instancer) {
+		stats.batches += instancer->flush();
+		for (const CRenderProxy *proxy : deferred) {
+			renderProxy(*proxy, renderer, lod);
+		}
 	}
+
+	return stats;
 }
 
-void renderStar(const ecs::CTransform &transform, const ecs::CShape &shape,
-				const ecs::CDrawStyle &style,
-				std::shared_ptr<IRenderer> renderer) {
+} // namespace
+
+// Not an ISystem: it draws into the renderer and view a canvas hands it,
+// after MEcs::updateSystems() has run
+ShapeRenderStats SShapeRendering(MEcs &ecs, std::shared_ptr<IRenderer> renderer,
+								 const ShapeRenderView &viewState) {
 	if (!renderer)
-		return;
+		return {};
+	return SShapeRendering(ecs, *renderer, viewState);
+}
 
-	float centerX = transform.position.x + shape.x1;
-	float centerY = transform.position.y + shape.y1;
-	float outerRadius = shape.x2 - shape.x1;
-	float innerRadius = outerRadius * shape.innerRadius;
+ShapeRenderStats SShapeRendering(MEcs &ecs, IRenderer &renderer,
+								 const ShapeRenderView &viewState) {
+	// Bring proxies up to date; from here on shapes are only read
+	ecs.updateRenderProxies();
 
-	// Apply transform
-	centerX *= transform.scale.x;
-	centerY *= transform.scale.y;
-	outerRadius *= transform.scale.x;
-	innerRadius *= transform.scale.x;
+	// A single-component view walks the proxy pool's packed array
+	auto forEach = [&](auto &&draw) { ecs.view<CRenderProxy>().each(draw); };
+	return drawProxies(forEach, renderer, viewState);
+}
 
-	std::vector<float> points;
-	int points_count = shape.sides * 2;
-	for (int i = 0; i < points_count; ++i) {
-		float angle = 2.0f * M_PI * i / points_count;
-		float radius = (i % 2 == 0) ? outerRadius : innerRadius;
-		float x = centerX + radius * cos(angle);
-		float y = centerY + radius * sin(angle);
-		points.push_back(x);
-		points.push_back(y);
-	}
+ShapeRenderStats SShapeRendering(const std::vector<CRenderProxy> &proxies,
+								 IRenderer &renderer,
+								 const ShapeRenderView &viewState) {
+	auto forEach = [&](auto &&draw) {
+		for (const CRenderProxy &proxy : proxies) {
+			draw(proxy);
+		}
+	};
+	return drawProxies(forEach, renderer, viewState);
+}
 
-	std::vector<glm::vec2> glmPoints;
-	for (size_t i = 0; i < points.size(); i += 2) {
-		glmPoints.push_back(glm::vec2(points[i], points[i + 1]));
-	}
-	if (style.hasFill) {
-		setFillStyle(style, renderer);
-		renderer->drawPolygon(glmPoints);
+void collectVisibleProxies(MEcs &ecs, const ShapeRenderView &viewState,
+						   std::vector<CRenderProxy> &proxies) {
+	ecs.updateRenderProxies();
+
+	proxies.clear();
+	auto view = ecs.view<CRenderProxy>();
+	proxies.reserve(view.size());
+	if (viewState.size.x <= 0.0f || viewState.size.y <= 0.0f) {
+		view.each([&](const CRenderProxy &proxy) { proxies.push_back(proxy); });
+		return;
 	}
+	glm::vec2 visibleMin, visibleMax;
+	viewState.getVisibleRect(visibleMin, visibleMax);
+	view.each([&](const CRenderProxy &proxy) {
+		glm::vec2 min, max;
+		getProxyBounds(proxy, min, max);
+		if (boundsOverlap(min, max, visibleMin, visibleMax)) {
+			proxies.push_back(proxy);
+		}
+	});
+}
 
-	if (style.hasStroke) {
-		setStrokeStyle(style, renderer);
-		renderer->drawPolygon(glmPoints);
+void renderProxy(const CRenderProxy &proxy, IRenderer &renderer,
+				 const LodPolicy &lod) {
+	switch (static_cast<CShape::Type>(proxy.type)) {
+	case CShape::Type::Rectangle:
+		drawRectangle(proxy, renderer);
+		break;
+	case CShape::Type::Ellipse:
+		drawEllipse(proxy, renderer, lod);
+		break;
+	case CShape::Type::Line:
+		drawLine(proxy, renderer);
+		break;
+	case CShape::Type::Polygon:
+		drawPolygon(proxy, renderer, lod);
+		break;
+	case CShape::Type::Star:
+		drawStar(proxy, renderer, lod);
+		break;
 	}
 }
 
+void renderRectangle(const ecs::CTransform &transform, const ecs::CShape &shape,
+					 const ecs::CDrawStyle &style, IRenderer &renderer) {
+	CRenderProxy proxy;
+	buildRenderProxy(transform, shape, style, proxy);
+	drawRectangle(proxy, renderer);
+}
+
+void renderEllipse(const ecs::CTransform &transform, const ecs::CShape &shape,
+				   const ecs::CDrawStyle &style, IRenderer &renderer,
+				   const LodPolicy &lod) {
+	CRenderProxy proxy;
+	buildRenderProxy(transform, shape, style, proxy);
+	drawEllipse(proxy, renderer, lod);
+}
+
+void renderLine(const ecs::CTransform &transform, const ecs::CShape &shape,
+				const ecs::CDrawStyle &style, IRenderer &renderer) {
+	CRenderProxy proxy;
+	buildRenderProxy(transform, shape, style, proxy);
+	drawLine(proxy, renderer);
+}
+
+void renderPolygon(const ecs::CTransform &transform, const ecs::CShape &shape,
+				   const ecs::CDrawStyle &style, IRenderer &renderer,
+				   const LodPolicy &lod) {
+	CRenderProxy proxy;
+	buildRenderProxy(transform, shape, style, proxy);
+	drawPolygon(proxy, renderer, lod);
+}
+
+void renderStar(const ecs::CTransform &transform, const ecs::CShape &shape,
+				const ecs::CDrawStyle &style, IRenderer &renderer,
+				const LodPolicy &lod) {
+	CRenderProxy proxy;
+	buildRenderProxy(transform, shape, style, proxy);
+	drawStar(proxy, renderer, lod);
+}
+
+void renderPoint(const glm::vec2 &center, float coverage,
+				 const CRenderProxy &proxy, IRenderer &renderer,
+				 const LodPolicy &lod) {
+	bool filled = proxy.has(CRenderProxy::Fill);
+	if (!filled && !proxy.has(CRenderProxy::Stroke))
+		return;
+
+	glm::vec4 color = glm::unpackUnorm4x8(filled ? proxy.fill : proxy.stroke);
+
+	// A point is a single screen pixel whose opacity approximates the area
+	// the shape would have covered
+	color.a *= std::max(coverage, 1.0f / 255.0f);
+	float size = lod.pointSize / lod.zoom;
+	renderer.setFillColor(color);
+	renderer.drawRect(center.x - 0.5f * size, center.y - 0.5f * size, size,
+					  size);
+}
+
 void renderSelectionOverlay(MEcs &ecs, const glm::vec2 &canvasPos,
 							const glm::vec2 &canvasSize,
 							std::shared_ptr<IRenderer> renderer) {
@@ -221,24 +436,16 @@ void renderDrawingPreview(MEcs &ecs, const glm::vec2 &canvasPos,
 	// This should be moved to the UI layer, not the ECS system
 }
 
-void setFillStyle(const ecs::CDrawStyle &style,
-				  std::shared_ptr<IRenderer> renderer) {
-	if (!renderer)
-		return;
-
+void setFillStyle(const ecs::CDrawStyle &style, IRenderer &renderer) {
 	glm::vec4 fillColor(style.fillR, style.fillG, style.fillB, style.fillA);
-	renderer->setFillColor(fillColor);
+	renderer.setFillColor(fillColor);
 }
 
-void setStrokeStyle(const ecs::CDrawStyle &style,
-					std::shared_ptr<IRenderer> renderer) {
-	if (!renderer)
-		return;
-
+void setStrokeStyle(const ecs::CDrawStyle &style, IRenderer &renderer) {
 	glm::vec4 strokeColor(style.strokeR, style.strokeG, style.strokeB,
 						  style.strokeA);
-	renderer->setStrokeColor(strokeColor);
-	renderer->setStrokeWidth(style.strokeWidth);
+	renderer.setStrokeColor(strokeColor);
+	renderer.setStrokeWidth(style.strokeWidth);
 }
 
 void convertColor(float r, float g, float b, float a, uint32_t &color) {
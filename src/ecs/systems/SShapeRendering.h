@@ -2,34 +2,62 @@
 
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
 #include "ecs/MEcs.h"
 #include "ecs/components/CDrawStyle.h"
+#include "ecs/components/CRenderProxy.h"
 #include "ecs/components/CShape.h"
 #include "ecs/components/CTransform.h"
+#include "ecs/systems/SRenderProxy.h"
+#include "ecs/systems/ShapeCulling.h"
 #include "rendering/IRenderer.h"
+#include "rendering/LodPolicy.h"
 
 namespace blot {
 namespace ecs {
 
-// Main rendering function
-void SShapeRendering(MEcs &ecs, std::shared_ptr<IRenderer> renderer);
+// Main rendering function. Refreshes stale render proxies, then streams
+// the CRenderProxy pool; shapes outside the view are skipped before any
+// style or geometry work.
+ShapeRenderStats SShapeRendering(MEcs &ecs, std::shared_ptr<IRenderer> renderer,
+								 const ShapeRenderView &viewState = {});
+ShapeRenderStats SShapeRendering(MEcs &ecs, IRenderer &renderer,
+								 const ShapeRenderView &viewState = {});
+// Draw proxies copied out earlier, without touching the registry, so it
+// may run on another thread than the one updating the ECS
+ShapeRenderStats SShapeRendering(const std::vector<CRenderProxy> &proxies,
+								 IRenderer &renderer,
+								 const ShapeRenderView &viewState = {});
+// Refresh stale proxies, then copy the ones inside the view. An empty view
+// size keeps every proxy.
+void collectVisibleProxies(MEcs &ecs, const ShapeRenderView &viewState,
+						   std::vector<CRenderProxy> &proxies);
 
-// Individual shape rendering functions
+// Draw one proxy through the renderer
+void renderProxy(const ecs::CRenderProxy &proxy, IRenderer &renderer,
+				 const LodPolicy &lod = {});
+
+// Individual shape rendering functions. Curved and many-sided shapes take
+// their segment counts from the level of detail policy.
 void renderRectangle(const ecs::CTransform &transform, const ecs::CShape &shape,
-					 const ecs::CDrawStyle &style,
-					 std::shared_ptr<IRenderer> renderer);
+					 const ecs::CDrawStyle &style, IRenderer &renderer);
 void renderEllipse(const ecs::CTransform &transform, const ecs::CShape &shape,
-				   const ecs::CDrawStyle &style,
-				   std::shared_ptr<IRenderer> renderer);
+				   const ecs::CDrawStyle &style, IRenderer &renderer,
+				   const LodPolicy &lod = {});
 void renderLine(const ecs::CTransform &transform, const ecs::CShape &shape,
-				const ecs::CDrawStyle &style,
-				std::shared_ptr<IRenderer> renderer);
+				const ecs::CDrawStyle &style, IRenderer &renderer);
 void renderPolygon(const ecs::CTransform &transform, const ecs::CShape &shape,
-				   const ecs::CDrawStyle &style,
-				   std::shared_ptr<IRenderer> renderer);
+				   const ecs::CDrawStyle &style, IRenderer &renderer,
+				   const LodPolicy &lod = {});
 void renderStar(const ecs::CTransform &transform, const ecs::CShape &shape,
-				const ecs::CDrawStyle &style,
-				std::shared_ptr<IRenderer> renderer);
+				const ecs::CDrawStyle &style, IRenderer &renderer,
+				const LodPolicy &lod = {});
+
+// Stand-in for a shape smaller than a pixel. `coverage` is the fraction of
+// the point the shape would have covered.
+void renderPoint(const glm::vec2 &center, float coverage,
+				 const ecs::CRenderProxy &proxy, IRenderer &renderer,
+				 const LodPolicy &lod);
 
 // UI rendering for selection and preview
 void renderSelectionOverlay(MEcs &ecs, const glm::vec2 &canvasPos,
@@ -40,10 +68,8 @@ void renderDrawingPreview(MEcs &ecs, const glm::vec2 &canvasPos,
 						  std::shared_ptr<IRenderer> renderer);
 
 // Helper functions
-void setFillStyle(const ecs::CDrawStyle &style,
-				  std::shared_ptr<IRenderer> renderer);
-void setStrokeStyle(const ecs::CDrawStyle &style,
-					std::shared_ptr<IRenderer> renderer);
+void setFillStyle(const ecs::CDrawStyle &style, IRenderer &renderer);
+void setStrokeStyle(const ecs::CDrawStyle &style, IRenderer &renderer);
 void convertColor(float r, float g, float b, float a, uint32_t &color);
 
 } // namespace ecs
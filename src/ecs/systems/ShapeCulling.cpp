@@ -0,0 +1,21 @@
+#include "ShapeCulling.h"
+
+namespace blot {
+namespace ecs {
+
+LodPolicy ShapeRenderView::getLodPolicy() const {
+	LodPolicy lod;
+	lod.zoom = zoom > 0.0f ? zoom : 1.0f;
+	lod.tolerance = tolerance;
+	return lod;
+}
+
+void ShapeRenderView::getVisibleRect(glm::vec2 &min, glm::vec2 &max) const {
+	float z = zoom > 0.0f ? zoom : 1.0f;
+	float pad = 1.0f / z;
+	min = -offset / z - pad;
+	max = (size - offset) / z + pad;
+}
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include "rendering/LodPolicy.h"
+
+namespace blot {
+
+class ShapeInstancer;
+
+namespace ecs {
+
+// Visible region of a canvas. Uses the CTexture convention:
+// screen = canvas * zoom + offset
+struct ShapeRenderView {
+	glm::vec2 offset{0.0f, 0.0f};
+	float zoom = 1.0f;
+	glm::vec2 size{0.0f, 0.0f}; // Viewport in pixels, zero = renderer size
+	float tolerance = 0.25f;	// Curve flattening tolerance in pixels
+
+	// When set, rectangles, ellipses and lines are drawn as GPU instances
+	// into the bound framebuffer; other shapes still go to the renderer.
+	ShapeInstancer *instancer = nullptr;
+
+	// Level of detail matching this view's zoom and tolerance
+	LodPolicy getLodPolicy() const;
+
+	// Canvas-space rectangle covered by the viewport, padded by one pixel
+	// so antialiased edges of shapes just outside are not cut off.
+	void getVisibleRect(glm::vec2 &min, glm::vec2 &max) const;
+};
+
+// Per-pass counters reported by SShapeRendering
+struct ShapeRenderStats {
+	size_t submitted = 0;
+	size_t culled = 0;
+	size_t instanced = 0; // Drawn through the instancer
+	size_t batches = 0;	  // Instanced draw calls
+};
+
+inline bool boundsOverlap(const glm::vec2 &aMin, const glm::vec2 &aMax,
+						  const glm::vec2 &bMin, const glm::vec2 &bMax) {
+	return aMax.x >= bMin.x && aMin.x <= bMax.x && aMax.y >= bMin.y &&
+		   aMin.y <= bMax.y;
+}
+
+} // namespace ecs
+} // namespace blot
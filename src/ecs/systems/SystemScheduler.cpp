@@ -0,0 +1,166 @@
+#include "ecs/systems/SystemScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#include "core/util/Profiler.h"
+#include "core/util/ThreadPool.h"
+
+namespace blot {
+namespace ecs {
+
+namespace {
+
+// Shared by the worker loops of one run()
+struct RunState {
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<size_t> pending; // Unfinished dependencies per system
+	std::vector<size_t> ready;
+	size_t finished = 0;
+	std::exception_ptr error;
+};
+
+} // namespace
+
+void SystemScheduler::add(std::unique_ptr<ISystem> system,
+						  const SystemAccess &access) {
+	if (!system) {
+		return;
+	}
+	Timing timing;
+	timing.name = system->getName();
+	m_timings.push_back(timing);
+	m_nodes.push_back({std::move(system), access, {}, 0});
+	m_dirty = true;
+}
+
+bool SystemScheduler::remove(const std::string &name) {
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		if (m_timings[i].name == name) {
+			m_nodes.erase(m_nodes.begin() + i);
+			m_timings.erase(m_timings.begin() + i);
+			m_dirty = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SystemScheduler::build() {
+	std::vector<size_t> stageSizes;
+	for (size_t j = 0; j < m_nodes.size(); ++j) {
+		Node &node = m_nodes[j];
+		node.successors.clear();
+		node.dependencies = 0;
+		int stage = 0;
+		for (size_t i = 0; i < j; ++i) {
+			if (m_nodes[i].access.conflictsWith(node.access)) {
+				m_nodes[i].successors.push_back(j);
+				++node.dependencies;
+				stage = std::max(stage, m_timings[i].stage + 1);
+			}
+		}
+		m_timings[j].stage = stage;
+		if (static_cast<size_t>(stage) >= stageSizes.size()) {
+			stageSizes.resize(stage + 1);
+		}
+		++stageSizes[stage];
+	}
+	m_width = stageSizes.empty()
+				  ? 0
+				  : *std::max_element(stageSizes.begin(), stageSizes.end());
+	m_dirty = false;
+}
+
+void SystemScheduler::runNode(size_t index, MEcs &ecs, float deltaTime) {
+	Timing &timing = m_timings[index];
+	auto start = std::chrono::steady_clock::now();
+	{
+		BLOT_PROFILE_SCOPE_DYNAMIC(timing.name);
+		m_nodes[index].system->update(ecs, deltaTime);
+	}
+	std::chrono::duration<float, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	timing.lastMs = elapsed.count();
+	timing.averageMs = timing.averageMs == 0.0f
+						   ? timing.lastMs
+						   : timing.averageMs +
+								 (timing.lastMs - timing.averageMs) / 30.0f;
+}
+
+void SystemScheduler::run(MEcs &ecs, float deltaTime, ThreadPool *pool) {
+	if (m_dirty) {
+		build();
+	}
+	size_t count = m_nodes.size();
+	if (!pool || m_width <= 1) {
+		std::exception_ptr error;
+		for (size_t i = 0; i < count; ++i) {
+			try {
+				runNode(i, ecs, deltaTime);
+			} catch (...) {
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		return;
+	}
+
+	RunState state;
+	state.pending.resize(count);
+	for (size_t i = count; i-- > 0;) {
+		state.pending[i] = m_nodes[i].dependencies;
+		if (state.pending[i] == 0) {
+			state.ready.push_back(i); // Reversed, so pop_back() goes in order
+		}
+	}
+
+	// Each loop takes ready systems until all have run. A loop only waits
+	// while another loop is running a system, so one always makes progress.
+	auto workerLoop = [&](size_t) {
+		std::unique_lock<std::mutex> lock(state.mutex);
+		for (;;) {
+			state.wake.wait(lock, [&] {
+				return !state.ready.empty() || state.finished == count;
+			});
+			if (state.finished == count) {
+				return;
+			}
+			size_t index = state.ready.back();
+			state.ready.pop_back();
+			lock.unlock();
+			try {
+				runNode(index, ecs, deltaTime);
+			} catch (...) {
+				std::lock_guard<std::mutex> errorLock(state.mutex);
+				if (!state.error) {
+					state.error = std::current_exception();
+				}
+			}
+			lock.lock();
+			++state.finished;
+			for (size_t successor : m_nodes[index].successors) {
+				if (--state.pending[successor] == 0) {
+					state.ready.push_back(successor);
+				}
+			}
+			state.wake.notify_all();
+		}
+	};
+	size_t loops = std::min(m_width, pool->getThreadCount() + 1);
+	pool->parallelFor(loops, workerLoop);
+	if (state.error) {
+		std::rethrow_exception(state.error);
+	}
+}
+
+} // namespace ecs
+} // namespace blot
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ecs/systems/ISystem.h"
+
+namespace blot {
+class MEcs;
+class ThreadPool;
+
+namespace ecs {
+
+/**
+ * @brief Runs ISystems concurrently where their component access allows.
+ *
+ * Each system depends on every earlier-added system it conflicts with, so
+ * conflicting systems keep the order they were added in and the rest run
+ * side by side on the thread pool. A system starts as soon as the systems
+ * it depends on have finished, not when a whole stage has.
+ */
+class SystemScheduler {
+  public:
+	struct Timing {
+		std::string name;
+		float lastMs = 0.0f;
+		float averageMs = 0.0f; // Exponential, over about 30 runs
+		int stage = 0; // Longest chain of dependencies before the system
+	};
+
+	// `access` as declared by the system, plus anything its writes imply
+	void add(std::unique_ptr<ISystem> system, const SystemAccess &access);
+	bool remove(const std::string &name);
+	size_t size() const { return m_nodes.size(); }
+
+	// Run every system once. Without a pool, or when every system depends
+	// on the one before, they run in order on the calling thread. Rethrows
+	// the first exception a system threw, after the others have run.
+	void run(MEcs &ecs, float deltaTime, ThreadPool *pool);
+
+	// In the order systems were added
+	const std::vector<Timing> &getTimings() const { return m_timings; }
+
+  private:
+	struct Node {
+		std::unique_ptr<ISystem> system;
+		SystemAccess access;
+		std::vector<size_t> successors;
+		size_t dependencies = 0;
+	};
+
+	void build();
+	void runNode(size_t index, MEcs &ecs, float deltaTime);
+
+	std::vector<Node> m_nodes;
+	std::vector<Timing> m_timings;
+	size_t m_width = 0; // Most systems in one stage
+	bool m_dirty = true;
+};
+
+} // namespace ecs
+} // namespace blot
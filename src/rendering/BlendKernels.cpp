@@ -0,0 +1,265 @@
+#include "rendering/BlendKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOT_BLEND_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace blot {
+
+namespace {
+
+// The blend formulas are written once against these helpers and
+// instantiated for plain floats (scalar path) and 4-lane vectors.
+inline float vmin(float a, float b) { return std::min(a, b); }
+inline float vmax(float a, float b) { return std::max(a, b); }
+inline float vsqrt(float a) { return std::sqrt(a); }
+inline bool vle(float a, float b) { return a <= b; }
+inline float vselect(bool mask, float a, float b) { return mask ? a : b; }
+
+#ifdef BLOT_BLEND_SSE2
+struct F4 {
+	__m128 v;
+	F4(__m128 x) : v(x) {}
+	F4(float x) : v(_mm_set1_ps(x)) {}
+};
+inline F4 operator+(F4 a, F4 b) { return _mm_add_ps(a.v, b.v); }
+inline F4 operator-(F4 a, F4 b) { return _mm_sub_ps(a.v, b.v); }
+inline F4 operator*(F4 a, F4 b) { return _mm_mul_ps(a.v, b.v); }
+inline F4 operator/(F4 a, F4 b) { return _mm_div_ps(a.v, b.v); }
+inline F4 vmin(F4 a, F4 b) { return _mm_min_ps(a.v, b.v); }
+inline F4 vmax(F4 a, F4 b) { return _mm_max_ps(a.v, b.v); }
+inline F4 vsqrt(F4 a) { return _mm_sqrt_ps(a.v); }
+inline F4 vle(F4 a, F4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline F4 vselect(F4 mask, F4 a, F4 b) {
+	return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+#endif
+
+// a / b clamped to [0, 1], zero where b is zero (unpremultiply)
+template <typename T> inline T ratio(T a, T b) {
+	return vselect(vle(b, T(0.0f)), T(0.0f),
+				   vmin(a / vmax(b, T(1e-6f)), T(1.0f)));
+}
+
+// Premultiplied result color for source (cs, as) over backdrop (cd, ad):
+// cs(1 - ad) + cd(1 - as) + as*ad*B(Cb, Cs), with B from the W3C spec
+template <BlendMode M, typename T> inline T blendColor(T cs, T as, T cd, T ad) {
+	const T one(1.0f), two(2.0f);
+	T outside = cs * (one - ad) + cd * (one - as);
+
+	if constexpr (M == BlendMode::Normal) {
+		return cs + cd * (one - as);
+	} else if constexpr (M == BlendMode::Multiply) {
+		return outside + cs * cd;
+	} else if constexpr (M == BlendMode::Screen) {
+		return cs + cd - cs * cd;
+	} else if constexpr (M == BlendMode::Overlay) {
+		return outside + vselect(vle(two * cd, ad), two * cs * cd,
+								 as * ad - two * (ad - cd) * (as - cs));
+	} else if constexpr (M == BlendMode::Darken) {
+		return outside + vmin(cs * ad, cd * as);
+	} else if constexpr (M == BlendMode::Lighten) {
+		return outside + vmax(cs * ad, cd * as);
+	} else if constexpr (M == BlendMode::Add) {
+		return vmin(cs + cd, one);
+	} else if constexpr (M == BlendMode::Subtract) {
+		return vmax(cd - cs, T(0.0f));
+	} else if constexpr (M == BlendMode::Difference) {
+		return cs + cd - two * vmin(cs * ad, cd * as);
+	} else if constexpr (M == BlendMode::Exclusion) {
+		return cs + cd - two * cs * cd;
+	} else if constexpr (M == BlendMode::HardLight) {
+		return outside + vselect(vle(two * cs, as), two * cs * cd,
+								 as * ad - two * (as - cs) * (ad - cd));
+	} else {
+		// The remaining modes are not polynomial in premultiplied terms
+		T Cs = ratio(cs, as), Cb = ratio(cd, ad);
+		auto B = [&]() -> T {
+			if constexpr (M == BlendMode::ColorDodge) {
+				return vselect(vle(Cb, T(0.0f)), T(0.0f),
+							   vselect(vle(one, Cs), one, ratio(Cb, one - Cs)));
+			} else if constexpr (M == BlendMode::ColorBurn) {
+				return vselect(vle(one, Cb), one,
+							   vselect(vle(Cs, T(0.0f)), T(0.0f),
+									   one - ratio(one - Cb, Cs)));
+			} else {
+				static_assert(M == BlendMode::SoftLight,
+							  "Unhandled blend mode");
+				T D = vselect(vle(Cb, T(0.25f)),
+							  ((T(16.0f) * Cb - T(12.0f)) * Cb + T(4.0f)) * Cb,
+							  vsqrt(Cb));
+				return vselect(vle(Cs, T(0.5f)),
+							   Cb - (one - two * Cs) * Cb * (one - Cb),
+							   Cb + (two * Cs - one) * (D - Cb));
+			}
+		}();
+		return outside + as * ad * B;
+	}
+}
+
+template <BlendMode M, typename T> inline T blendAlpha(T as, T ad) {
+	if constexpr (M == BlendMode::Add) {
+		return vmin(as + ad, T(1.0f));
+	} else {
+		return as + ad - as * ad;
+	}
+}
+
+constexpr float kInv255 = 1.0f / 255.0f;
+
+inline uint8_t toByte(float x) {
+	return static_cast<uint8_t>(std::clamp(x, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+template <BlendMode M>
+void blendScalar(const uint8_t *src, const uint8_t *dst, uint8_t *out,
+				 size_t count, float opacity) {
+	for (size_t i = 0; i < count; ++i, src += 4, dst += 4, out += 4) {
+		float as = src[3] * kInv255 * opacity;
+		float ad = dst[3] * kInv255;
+		float c[3];
+		for (int k = 0; k < 3; ++k) {
+			c[k] = blendColor<M>(src[k] * kInv255 * opacity, as,
+								 dst[k] * kInv255, ad);
+		}
+		out[0] = toByte(c[0]);
+		out[1] = toByte(c[1]);
+		out[2] = toByte(c[2]);
+		out[3] = toByte(blendAlpha<M>(as, ad));
+	}
+}
+
+#ifdef BLOT_BLEND_SSE2
+inline __m128 broadcastAlpha(__m128 p) {
+	return _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// One pixel per vector: lanes hold the three colors and alpha. Colors are
+// computed in all lanes, then lane 3 is replaced with the result alpha.
+template <BlendMode M>
+inline __m128 blendPixel(__m128 s, __m128 d, __m128 opacity,
+						 __m128 alphaLane) {
+	s = _mm_mul_ps(s, opacity);
+	F4 as = broadcastAlpha(s), ad = broadcastAlpha(d);
+	F4 color = blendColor<M>(F4(s), as, F4(d), ad);
+	F4 alpha = blendAlpha<M>(as, ad);
+	return vselect(F4(alphaLane), alpha, color).v;
+}
+
+template <BlendMode M>
+void blendSse2(const uint8_t *src, const uint8_t *dst, uint8_t *out,
+			   size_t count, float opacity) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 toFloat = _mm_set1_ps(kInv255);
+	const __m128 toInt = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 opacityV = _mm_set1_ps(opacity);
+	const __m128 alphaLane =
+		_mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+	auto unpack = [&](__m128i px, __m128 p[4]) {
+		__m128i lo = _mm_unpacklo_epi8(px, zero);
+		__m128i hi = _mm_unpackhi_epi8(px, zero);
+		p[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+						  toFloat);
+		p[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+						  toFloat);
+		p[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)),
+						  toFloat);
+		p[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)),
+						  toFloat);
+	};
+	// Saturating packs clamp to [0, 255]
+	auto round = [&](__m128 p) {
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(p, toInt), half));
+	};
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 s[4], d[4], r[4];
+		unpack(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)),
+			   s);
+		unpack(_mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i * 4)),
+			   d);
+		for (int k = 0; k < 4; ++k) {
+			r[k] = _mm_max_ps(blendPixel<M>(s[k], d[k], opacityV, alphaLane),
+							  _mm_setzero_ps());
+		}
+		__m128i lo = _mm_packs_epi32(round(r[0]), round(r[1]));
+		__m128i hi = _mm_packs_epi32(round(r[2]), round(r[3]));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 4),
+						 _mm_packus_epi16(lo, hi));
+	}
+	blendScalar<M>(src + i * 4, dst + i * 4, out + i * 4, count - i, opacity);
+}
+#endif
+
+using SpanFn = void (*)(const uint8_t *, const uint8_t *, uint8_t *, size_t,
+						float);
+
+template <template <BlendMode> class Pick>
+SpanFn dispatch(BlendMode mode) {
+	switch (mode) {
+	case BlendMode::Multiply:
+		return Pick<BlendMode::Multiply>::fn;
+	case BlendMode::Screen:
+		return Pick<BlendMode::Screen>::fn;
+	case BlendMode::Overlay:
+		return Pick<BlendMode::Overlay>::fn;
+	case BlendMode::Darken:
+		return Pick<BlendMode::Darken>::fn;
+	case BlendMode::Lighten:
+		return Pick<BlendMode::Lighten>::fn;
+	case BlendMode::Add:
+		return Pick<BlendMode::Add>::fn;
+	case BlendMode::Subtract:
+		return Pick<BlendMode::Subtract>::fn;
+	case BlendMode::Difference:
+		return Pick<BlendMode::Difference>::fn;
+	case BlendMode::Exclusion:
+		return Pick<BlendMode::Exclusion>::fn;
+	case BlendMode::ColorDodge:
+		return Pick<BlendMode::ColorDodge>::fn;
+	case BlendMode::ColorBurn:
+		return Pick<BlendMode::ColorBurn>::fn;
+	case BlendMode::HardLight:
+		return Pick<BlendMode::HardLight>::fn;
+	case BlendMode::SoftLight:
+		return Pick<BlendMode::SoftLight>::fn;
+	default:
+		return Pick<BlendMode::Normal>::fn;
+	}
+}
+
+template <BlendMode M> struct ScalarKernel {
+	static constexpr SpanFn fn = &blendScalar<M>;
+};
+
+#ifdef BLOT_BLEND_SSE2
+template <BlendMode M> struct Sse2Kernel {
+	static constexpr SpanFn fn = &blendSse2<M>;
+};
+#endif
+
+} // namespace
+
+void blendSpan(BlendMode mode, const uint8_t *src, const uint8_t *dst,
+			   uint8_t *out, size_t count, float opacity) {
+#ifdef BLOT_BLEND_SSE2
+	dispatch<Sse2Kernel>(mode)(src, dst, out, count, opacity);
+#else
+	dispatch<ScalarKernel>(mode)(src, dst, out, count, opacity);
+#endif
+}
+
+void blendSpanScalar(BlendMode mode, const uint8_t *src, const uint8_t *dst,
+					 uint8_t *out, size_t count, float opacity) {
+	dispatch<ScalarKernel>(mode)(src, dst, out, count, opacity);
+}
+
+} // namespace blot
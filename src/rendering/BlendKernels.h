@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "rendering/BlendMode.h"
+
+namespace blot {
+
+// Composite `count` premultiplied 8-bit pixels: out = src blended onto dst.
+// Alpha must be the fourth byte of each pixel; every mode is separable, so
+// the color order (RGBA or BGRA) does not matter. `out` may alias `src` or
+// `dst`. `opacity` scales the source before blending.
+//
+// Uses SSE2 where available, processing four pixels per step.
+void blendSpan(BlendMode mode, const uint8_t *src, const uint8_t *dst,
+			   uint8_t *out, size_t count, float opacity = 1.0f);
+
+// Portable reference version of blendSpan()
+void blendSpanScalar(BlendMode mode, const uint8_t *src, const uint8_t *dst,
+					 uint8_t *out, size_t count, float opacity = 1.0f);
+
+} // namespace blot
@@ -0,0 +1,134 @@
+#include "rendering/BlendMode.h"
+
+#include "rendering/U_gladGlfw.h"
+
+#include "rendering/GlState.h"
+
+namespace blot {
+
+namespace {
+
+const char *const kBlendModeNames[] = {
+	"Normal",	  "Multiply",	"Screen",	  "Overlay",   "Darken",
+	"Lighten",	  "Add",		"Subtract",	  "Difference", "Exclusion",
+	"ColorDodge", "ColorBurn",	"HardLight",  "SoftLight"};
+
+static_assert(sizeof(kBlendModeNames) / sizeof(kBlendModeNames[0]) ==
+				  static_cast<size_t>(BlendMode::Count),
+			  "Every blend mode needs a name");
+
+GLenum advancedEquation(BlendMode mode) {
+	switch (mode) {
+	case BlendMode::Overlay:
+		return GL_OVERLAY_KHR;
+	// min/max of the premultiplied composites, as in BlendKernels
+	case BlendMode::Darken:
+		return GL_DARKEN_KHR;
+	case BlendMode::Lighten:
+		return GL_LIGHTEN_KHR;
+	case BlendMode::Difference:
+		return GL_DIFFERENCE_KHR;
+	case BlendMode::Exclusion:
+		return GL_EXCLUSION_KHR;
+	case BlendMode::ColorDodge:
+		return GL_COLORDODGE_KHR;
+	case BlendMode::ColorBurn:
+		return GL_COLORBURN_KHR;
+	case BlendMode::HardLight:
+		return GL_HARDLIGHT_KHR;
+	case BlendMode::SoftLight:
+		return GL_SOFTLIGHT_KHR;
+	default:
+		return 0;
+	}
+}
+
+} // namespace
+
+const char *getBlendModeName(BlendMode mode) {
+	int index = static_cast<int>(mode);
+	if (index < 0 || index >= static_cast<int>(BlendMode::Count)) {
+		return "Normal";
+	}
+	return kBlendModeNames[index];
+}
+
+BlendMode getBlendModeFromString(const std::string &name) {
+	for (int i = 0; i < static_cast<int>(BlendMode::Count); ++i) {
+		if (name == kBlendModeNames[i]) {
+			return static_cast<BlendMode>(i);
+		}
+	}
+	return BlendMode::Normal; // Default
+}
+
+bool isOrderIndependent(BlendMode mode) {
+	switch (mode) {
+	case BlendMode::Multiply:
+	case BlendMode::Screen:
+	case BlendMode::Add:
+	case BlendMode::Subtract:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool applyGlBlendMode(BlendMode mode, bool premultiplied) {
+	const GLenum source = premultiplied ? GL_ONE : GL_SRC_ALPHA;
+	GlState &state = GlState::instance();
+	state.setBlendEnabled(true);
+
+	switch (mode) {
+	case BlendMode::Normal:
+		state.setBlendEquation(GL_FUNC_ADD);
+		state.setBlendFunc(source, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+						   GL_ONE_MINUS_SRC_ALPHA);
+		return true;
+	case BlendMode::Multiply:
+		state.setBlendEquation(GL_FUNC_ADD);
+		state.setBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+						   GL_ONE_MINUS_SRC_ALPHA);
+		return true;
+	case BlendMode::Screen:
+		state.setBlendEquation(GL_FUNC_ADD);
+		state.setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_ONE,
+						   GL_ONE_MINUS_SRC_ALPHA);
+		return true;
+	case BlendMode::Add:
+		state.setBlendEquation(GL_FUNC_ADD);
+		state.setBlendFunc(source, GL_ONE, GL_ONE, GL_ONE);
+		return true;
+	case BlendMode::Subtract:
+		state.setBlendEquation(GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD);
+		state.setBlendFunc(source, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		return true;
+	default:
+		break;
+	}
+
+	GLenum equation = advancedEquation(mode);
+	if (equation && GLAD_GL_KHR_blend_equation_advanced) {
+		// Without the coherent variant, callers drawing overlapping
+		// geometry put GlState::blendBarrier() between draws
+		state.setBlendCoherent(true);
+		state.setBlendEquation(equation);
+		return true;
+	}
+
+	if (mode == BlendMode::Darken || mode == BlendMode::Lighten) {
+		// GL_MIN and GL_MAX ignore the blend factors, so coverage and
+		// translucency are lost: exact only for opaque sources
+		state.setBlendEquation(mode == BlendMode::Darken ? GL_MIN : GL_MAX,
+							   GL_FUNC_ADD);
+		state.setBlendFunc(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		return true;
+	}
+
+	state.setBlendEquation(GL_FUNC_ADD);
+	state.setBlendFunc(source, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+					   GL_ONE_MINUS_SRC_ALPHA);
+	return false;
+}
+
+} // namespace blot
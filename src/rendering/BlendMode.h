@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+namespace blot {
+
+// Separable blend modes, as defined by the W3C compositing spec (Add and
+// Subtract follow the usual Processing/Photoshop meaning). The integer
+// values are what Graphics::setBlendMode(int) accepts.
+enum class BlendMode : int {
+	Normal = 0,
+	Multiply,
+	Screen,
+	Overlay,
+	Darken,
+	Lighten,
+	Add,
+	Subtract,
+	Difference,
+	Exclusion,
+	ColorDodge,
+	ColorBurn,
+	HardLight,
+	SoftLight,
+	Count
+};
+
+const char *getBlendModeName(BlendMode mode);
+BlendMode getBlendModeFromString(const std::string &name);
+
+// True when overlapping draws give the same result in any order (up to
+// rounding), so a renderer may regroup them: Multiply, Screen, Add and
+// Subtract, whose GL blending scales or offsets the destination
+bool isOrderIndependent(BlendMode mode);
+
+// Set the GL blend state for a mode on the current context, through
+// GlState. Normal, Add and Subtract map to fixed-function blending
+// (Multiply and Screen too, exact for opaque sources). The remaining modes
+// use KHR_blend_equation_advanced, whose fragment shaders must declare
+// `layout(blend_support_all_equations) out;`; without the coherent variant
+// callers put GlState::blendBarrier() between draws that may overlap.
+// Darken and Lighten fall back to GL_MIN and GL_MAX, which ignore source
+// alpha. Pass `premultiplied` when the shader outputs premultiplied color.
+// Returns false and leaves Normal blending in place when the mode is
+// unavailable.
+bool applyGlBlendMode(BlendMode mode, bool premultiplied = false);
+
+} // namespace blot
@@ -0,0 +1,194 @@
+#include "rendering/Blur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOT_BLUR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "core/util/ThreadPool.h"
+
+namespace blot {
+
+namespace {
+
+constexpr int kPasses = 3;
+// Bytes of a row handled by one vertical task; a multiple of the SIMD width
+constexpr size_t kColumnStrip = 256;
+// Approximate bytes of work per horizontal task
+constexpr size_t kRowGrainBytes = 16 * 1024;
+
+// Box radii whose successive application best matches a Gaussian of
+// standard deviation sigma (W. Jarosz, "Fast Image Convolutions")
+void boxRadiiForGaussian(float sigma, int radii[kPasses]) {
+	float ideal = std::sqrt(12.0f * sigma * sigma / kPasses + 1.0f);
+	int lower = static_cast<int>(std::floor(ideal));
+	if (lower % 2 == 0) {
+		--lower;
+	}
+	int upper = lower + 2;
+	float split = (12.0f * sigma * sigma - kPasses * lower * lower -
+				   4.0f * kPasses * lower - 3.0f * kPasses) /
+				  (-4.0f * lower - 4.0f);
+	int lowerCount = static_cast<int>(std::round(split));
+	for (int i = 0; i < kPasses; ++i) {
+		radii[i] = ((i < lowerCount ? lower : upper) - 1) / 2;
+	}
+}
+
+inline uint8_t scaleSum(int32_t sum, float scale) {
+	return static_cast<uint8_t>(static_cast<float>(sum) * scale + 0.5f);
+}
+
+// One box pass along a row, per channel, clamping at the ends
+void boxRow(const uint8_t *in, uint8_t *out, int width, int channels,
+			int radius) {
+	const float scale = 1.0f / (2 * radius + 1);
+	const int last = width - 1;
+	for (int c = 0; c < channels; ++c) {
+		auto at = [&](int x) {
+			return in[std::clamp(x, 0, last) * channels + c];
+		};
+		int32_t sum = at(0) * (radius + 1);
+		for (int i = 1; i <= radius; ++i) {
+			sum += at(i);
+		}
+		for (int x = 0; x < width; ++x) {
+			out[x * channels + c] = scaleSum(sum, scale);
+			sum += at(x + radius + 1) - at(x - radius);
+		}
+	}
+}
+
+// One box pass down the bytes [begin, end) of every row. Sums are kept per
+// byte and advanced a whole row segment at a time, which vectorizes.
+void boxColumns(const uint8_t *in, uint8_t *out, size_t stride, int height,
+				size_t begin, size_t end, int radius) {
+	const size_t span = end - begin;
+	const float scale = 1.0f / (2 * radius + 1);
+	const int last = height - 1;
+	auto row = [&](int y) {
+		return in + std::clamp(y, 0, last) * stride + begin;
+	};
+
+	std::vector<int32_t> sums(span);
+	const uint8_t *first = row(0);
+	for (size_t i = 0; i < span; ++i) {
+		sums[i] = first[i] * (radius + 1);
+	}
+	for (int y = 1; y <= radius; ++y) {
+		const uint8_t *src = row(y);
+		for (size_t i = 0; i < span; ++i) {
+			sums[i] += src[i];
+		}
+	}
+
+	for (int y = 0; y < height; ++y) {
+		uint8_t *dst = out + y * stride + begin;
+		const uint8_t *add = row(y + radius + 1);
+		const uint8_t *sub = row(y - radius);
+		int32_t *sum = sums.data();
+		size_t i = 0;
+#ifdef BLOT_BLUR_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scaleV = _mm_set1_ps(scale);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 16 <= span; i += 16) {
+			__m128i a =
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(add + i));
+			__m128i s =
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(sub + i));
+			// Widen 16 bytes into four vectors of 32-bit lanes
+			__m128i a16[2] = {_mm_unpacklo_epi8(a, zero),
+							  _mm_unpackhi_epi8(a, zero)};
+			__m128i s16[2] = {_mm_unpacklo_epi8(s, zero),
+							  _mm_unpackhi_epi8(s, zero)};
+			__m128i result[4];
+			for (int k = 0; k < 4; ++k) {
+				__m128i *slot = reinterpret_cast<__m128i *>(sum + i + k * 4);
+				__m128i total = _mm_loadu_si128(slot);
+				__m128 value = _mm_add_ps(
+					_mm_mul_ps(_mm_cvtepi32_ps(total), scaleV), half);
+				result[k] = _mm_cvttps_epi32(value);
+				__m128i add32 = (k & 1) ? _mm_unpackhi_epi16(a16[k / 2], zero)
+										: _mm_unpacklo_epi16(a16[k / 2], zero);
+				__m128i sub32 = (k & 1) ? _mm_unpackhi_epi16(s16[k / 2], zero)
+										: _mm_unpacklo_epi16(s16[k / 2], zero);
+				_mm_storeu_si128(
+					slot, _mm_add_epi32(total, _mm_sub_epi32(add32, sub32)));
+			}
+			__m128i lo = _mm_packs_epi32(result[0], result[1]);
+			__m128i hi = _mm_packs_epi32(result[2], result[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+							 _mm_packus_epi16(lo, hi));
+		}
+#endif
+		for (; i < span; ++i) {
+			dst[i] = scaleSum(sum[i], scale);
+			sum[i] += add[i] - sub[i];
+		}
+	}
+}
+
+template <typename F>
+void forRange(ThreadPool *pool, size_t count, size_t grain, F &&fn) {
+	if (pool && count > grain) {
+		pool->parallelForRange(count, grain, fn);
+	} else {
+		fn(0, count);
+	}
+}
+
+} // namespace
+
+int getBlurExtent(float radius) {
+	if (radius <= 0.0f) {
+		return 0;
+	}
+	int radii[kPasses];
+	boxRadiiForGaussian(radius * 0.5f, radii);
+	return radii[0] + radii[1] + radii[2];
+}
+
+void blurImage(uint8_t *pixels, int width, int height, int channels,
+			   float radius, ThreadPool *pool) {
+	if (!pixels || width <= 0 || height <= 0 || channels <= 0 ||
+		radius <= 0.0f) {
+		return;
+	}
+	int radii[kPasses];
+	boxRadiiForGaussian(radius * 0.5f, radii);
+
+	const size_t stride = static_cast<size_t>(width) * channels;
+	std::vector<uint8_t> scratch(stride * height);
+	const size_t rowGrain = std::max<size_t>(1, kRowGrainBytes / stride);
+	const size_t strips = (stride + kColumnStrip - 1) / kColumnStrip;
+
+	for (int radius : radii) {
+		if (radius == 0) {
+			continue;
+		}
+		// Rows: pixels -> scratch
+		forRange(pool, height, rowGrain, [&](size_t begin, size_t end) {
+			for (size_t y = begin; y < end; ++y) {
+				boxRow(pixels + y * stride, scratch.data() + y * stride,
+					   width, channels, radius);
+			}
+		});
+		// Columns: scratch -> pixels
+		forRange(pool, strips, 1, [&](size_t begin, size_t end) {
+			for (size_t s = begin; s < end; ++s) {
+				size_t first = s * kColumnStrip;
+				size_t last = std::min(stride, first + kColumnStrip);
+				boxColumns(scratch.data(), pixels, stride, height, first,
+						   last, radius);
+			}
+		});
+	}
+}
+
+} // namespace blot
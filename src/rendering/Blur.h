@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blot {
+
+class ThreadPool;
+
+// How far, in pixels, blurImage() spreads content for a given radius
+int getBlurExtent(float radius);
+
+// Blur an 8-bit image in place with a Gaussian of standard deviation
+// radius / 2 (the convention of canvas shadowBlur), approximated by three
+// separable box passes. `channels` is 1 for masks or 4 for premultiplied
+// RGBA; rows are tightly packed. Edges are clamped. Rows and columns are
+// split across `pool` when one is given.
+void blurImage(uint8_t *pixels, int width, int height, int channels,
+			   float radius, ThreadPool *pool = nullptr);
+
+} // namespace blot
@@ -0,0 +1,305 @@
+#include "rendering/GlState.h"
+
+#include "rendering/U_gladGlfw.h"
+
+namespace blot {
+
+namespace {
+
+bool isAdvancedEquation(uint32_t equation) {
+	return equation >= GL_MULTIPLY_KHR && equation <= GL_HSL_LUMINOSITY_KHR;
+}
+
+} // namespace
+
+GlState &GlState::instance() {
+	static GlState state;
+	return state;
+}
+
+template <typename T> bool GlState::change(T &cached, const T &value) {
+	if (cached == value) {
+		++m_frame.skipped;
+		return false;
+	}
+	cached = value;
+	++m_frame.issued;
+	return true;
+}
+
+void GlState::bindFramebuffer(uint32_t framebuffer) {
+	if (change(m_framebuffer, framebuffer)) {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+}
+
+uint32_t GlState::getFramebuffer() {
+	if (m_framebuffer == kUnknown) {
+		GLint value = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &value);
+		m_framebuffer = static_cast<uint32_t>(value);
+	}
+	return m_framebuffer;
+}
+
+void GlState::setViewport(int x, int y, int width, int height) {
+	if (change(m_viewport, {x, y, width, height})) {
+		glViewport(x, y, width, height);
+	}
+}
+
+const std::array<int, 4> &GlState::getViewport() {
+	if (m_viewport[2] < 0) {
+		glGetIntegerv(GL_VIEWPORT, m_viewport.data());
+	}
+	return m_viewport;
+}
+
+void GlState::useProgram(uint32_t program) {
+	if (change(m_program, program)) {
+		glUseProgram(program);
+	}
+}
+
+uint32_t GlState::getProgram() {
+	if (m_program == kUnknown) {
+		GLint value = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+		m_program = static_cast<uint32_t>(value);
+	}
+	return m_program;
+}
+
+void GlState::bindVertexArray(uint32_t vertexArray) {
+	if (change(m_vertexArray, vertexArray)) {
+		glBindVertexArray(vertexArray);
+	}
+}
+
+uint32_t GlState::getVertexArray() {
+	if (m_vertexArray == kUnknown) {
+		GLint value = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+		m_vertexArray = static_cast<uint32_t>(value);
+	}
+	return m_vertexArray;
+}
+
+void GlState::bindTexture(uint32_t texture, int unit) {
+	if (unit < 0 || unit >= kTextureUnits) {
+		// Past the tracked units: issue directly and leave the copy alone
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		m_activeUnit = kUnknown;
+		m_frame.issued += 2;
+		return;
+	}
+	if (change(m_activeUnit, static_cast<uint32_t>(unit))) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	if (change(m_textures[unit], texture)) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+	}
+}
+
+void GlState::setBlendEnabled(bool enabled) {
+	if (change(m_blend.enabled, enabled ? 1 : 0)) {
+		if (enabled) {
+			glEnable(GL_BLEND);
+		} else {
+			glDisable(GL_BLEND);
+		}
+	}
+}
+
+bool GlState::isBlendEnabled() {
+	if (m_blend.enabled < 0) {
+		m_blend.enabled = glIsEnabled(GL_BLEND) ? 1 : 0;
+	}
+	return m_blend.enabled == 1;
+}
+
+void GlState::setBlendFunc(uint32_t source, uint32_t destination) {
+	setBlendFunc(source, destination, source, destination);
+}
+
+void GlState::setBlendFunc(uint32_t sourceRgb, uint32_t destinationRgb,
+						   uint32_t sourceAlpha, uint32_t destinationAlpha) {
+	if (change(m_blend.func,
+			   {sourceRgb, destinationRgb, sourceAlpha, destinationAlpha})) {
+		glBlendFuncSeparate(sourceRgb, destinationRgb, sourceAlpha,
+							destinationAlpha);
+	}
+}
+
+void GlState::setBlendEquation(uint32_t equation) {
+	if (change(m_blend.equation, {equation, equation})) {
+		// Advanced (KHR) equations are only valid through glBlendEquation
+		glBlendEquation(equation);
+	}
+}
+
+void GlState::setBlendEquation(uint32_t equationRgb, uint32_t equationAlpha) {
+	if (change(m_blend.equation, {equationRgb, equationAlpha})) {
+		glBlendEquationSeparate(equationRgb, equationAlpha);
+	}
+}
+
+const GlState::Blend &GlState::getBlend() {
+	isBlendEnabled();
+	if (m_blend.func[0] == kUnknown) {
+		const GLenum names[4] = {GL_BLEND_SRC_RGB, GL_BLEND_DST_RGB,
+								 GL_BLEND_SRC_ALPHA, GL_BLEND_DST_ALPHA};
+		for (int i = 0; i < 4; ++i) {
+			GLint value = 0;
+			glGetIntegerv(names[i], &value);
+			m_blend.func[i] = static_cast<uint32_t>(value);
+		}
+	}
+	if (m_blend.equation[0] == kUnknown) {
+		GLint rgb = 0;
+		GLint alpha = 0;
+		glGetIntegerv(GL_BLEND_EQUATION_RGB, &rgb);
+		glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &alpha);
+		m_blend.equation = {static_cast<uint32_t>(rgb),
+							static_cast<uint32_t>(alpha)};
+	}
+	return m_blend;
+}
+
+void GlState::setBlend(const Blend &blend) {
+	if (blend.equation[0] != kUnknown) {
+		if (blend.equation[0] == blend.equation[1]) {
+			setBlendEquation(blend.equation[0]);
+		} else {
+			setBlendEquation(blend.equation[0], blend.equation[1]);
+		}
+	}
+	if (blend.func[0] != kUnknown) {
+		setBlendFunc(blend.func[0], blend.func[1], blend.func[2],
+					 blend.func[3]);
+	}
+	if (blend.enabled >= 0) {
+		setBlendEnabled(blend.enabled == 1);
+	}
+	if (blend.coherent >= 0) {
+		setBlendCoherent(blend.coherent == 1);
+	}
+}
+
+void GlState::setBlendCoherent(bool enabled) {
+	if (!GLAD_GL_KHR_blend_equation_advanced_coherent) {
+		return;
+	}
+	if (change(m_blend.coherent, enabled ? 1 : 0)) {
+		if (enabled) {
+			glEnable(GL_BLEND_ADVANCED_COHERENT_KHR);
+		} else {
+			glDisable(GL_BLEND_ADVANCED_COHERENT_KHR);
+		}
+	}
+}
+
+bool GlState::needsBlendBarrier() {
+	if (!isBlendEnabled() || !isAdvancedEquation(getBlend().equation[0])) {
+		return false;
+	}
+	if (!GLAD_GL_KHR_blend_equation_advanced_coherent) {
+		return true;
+	}
+	if (m_blend.coherent < 0) {
+		m_blend.coherent = glIsEnabled(GL_BLEND_ADVANCED_COHERENT_KHR) ? 1 : 0;
+	}
+	return m_blend.coherent == 0;
+}
+
+void GlState::blendBarrier() {
+	if (needsBlendBarrier()) {
+		glBlendBarrierKHR();
+		++m_frame.issued;
+	}
+}
+
+void GlState::setScissorEnabled(bool enabled) {
+	if (change(m_scissorEnabled, enabled ? 1 : 0)) {
+		if (enabled) {
+			glEnable(GL_SCISSOR_TEST);
+		} else {
+			glDisable(GL_SCISSOR_TEST);
+		}
+	}
+}
+
+void GlState::setScissor(int x, int y, int width, int height) {
+	if (change(m_scissor, {x, y, width, height})) {
+		glScissor(x, y, width, height);
+	}
+}
+
+GlState::Snapshot GlState::save() {
+	Snapshot snapshot;
+	snapshot.framebuffer = getFramebuffer();
+	snapshot.viewport = getViewport();
+	snapshot.program = getProgram();
+	snapshot.vertexArray = getVertexArray();
+	snapshot.blend = getBlend();
+	return snapshot;
+}
+
+void GlState::restore(const Snapshot &snapshot) {
+	bindFramebuffer(snapshot.framebuffer);
+	setViewport(snapshot.viewport[0], snapshot.viewport[1],
+				snapshot.viewport[2], snapshot.viewport[3]);
+	useProgram(snapshot.program);
+	bindVertexArray(snapshot.vertexArray);
+	setBlend(snapshot.blend);
+}
+
+void GlState::deleteFramebuffers(int count, const uint32_t *framebuffers) {
+	for (int i = 0; i < count; ++i) {
+		if (framebuffers[i] && framebuffers[i] == m_framebuffer) {
+			m_framebuffer = 0; // GL falls back to the default framebuffer
+		}
+	}
+	glDeleteFramebuffers(count, framebuffers);
+}
+
+void GlState::deleteTextures(int count, const uint32_t *textures) {
+	for (int i = 0; i < count; ++i) {
+		for (uint32_t &bound : m_textures) {
+			if (textures[i] && bound == textures[i]) {
+				bound = 0;
+			}
+		}
+	}
+	glDeleteTextures(count, textures);
+}
+
+void GlState::deleteVertexArrays(int count, const uint32_t *vertexArrays) {
+	for (int i = 0; i < count; ++i) {
+		if (vertexArrays[i] && vertexArrays[i] == m_vertexArray) {
+			m_vertexArray = 0;
+		}
+	}
+	glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GlState::invalidate() {
+	m_framebuffer = kUnknown;
+	m_viewport = {-1, -1, -1, -1};
+	m_program = kUnknown;
+	m_vertexArray = kUnknown;
+	m_activeUnit = kUnknown;
+	m_textures.fill(kUnknown);
+	m_blend = Blend();
+	m_scissorEnabled = -1;
+	m_scissor = {-1, -1, -1, -1};
+}
+
+void GlState::beginFrame() {
+	m_lastFrame = m_frame;
+	m_frame = Stats();
+	invalidate();
+}
+
+} // namespace blot
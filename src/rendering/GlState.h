@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace blot {
+
+/**
+ * @brief Shadow copy of the GL state the engine touches most.
+ *
+ * Setters only reach the driver when the value actually changes, and
+ * getters answer from the copy instead of a glGet round trip (querying the
+ * driver once if the value is not known yet). Covers the draw framebuffer,
+ * viewport, program, vertex array, 2D texture units, blending and scissor.
+ *
+ * GL thread only. Code that changes any of this state behind the cache's
+ * back (third-party UI, renderer addons) must put it back or call
+ * invalidate() afterwards. The engine invalidates at the start of every
+ * frame.
+ */
+class GlState {
+  public:
+	static constexpr uint32_t kUnknown = 0xFFFFFFFFu;
+	static constexpr int kTextureUnits = 8;
+
+	struct Stats {
+		size_t issued = 0;	// State calls that reached the driver
+		size_t skipped = 0; // Calls dropped because nothing changed
+	};
+
+	struct Blend {
+		int enabled = -1; // -1 while unknown
+		std::array<uint32_t, 4> func{kUnknown, kUnknown, kUnknown, kUnknown};
+		std::array<uint32_t, 2> equation{kUnknown, kUnknown};
+		int coherent = -1; // GL_BLEND_ADVANCED_COHERENT_KHR, -1 while unknown
+	};
+
+	// Everything a pass needs to hand back when it is done
+	struct Snapshot {
+		uint32_t framebuffer = 0;
+		std::array<int, 4> viewport{0, 0, 0, 0};
+		uint32_t program = 0;
+		uint32_t vertexArray = 0;
+		Blend blend;
+	};
+
+	static GlState &instance();
+
+	void bindFramebuffer(uint32_t framebuffer);
+	uint32_t getFramebuffer();
+	void setViewport(int x, int y, int width, int height);
+	const std::array<int, 4> &getViewport();
+
+	void useProgram(uint32_t program);
+	uint32_t getProgram();
+	void bindVertexArray(uint32_t vertexArray);
+	uint32_t getVertexArray();
+
+	// GL_TEXTURE_2D on `unit`; also makes `unit` the active one
+	void bindTexture(uint32_t texture, int unit = 0);
+
+	void setBlendEnabled(bool enabled);
+	bool isBlendEnabled();
+	void setBlendFunc(uint32_t source, uint32_t destination);
+	void setBlendFunc(uint32_t sourceRgb, uint32_t destinationRgb,
+					  uint32_t sourceAlpha, uint32_t destinationAlpha);
+	void setBlendEquation(uint32_t equation);
+	void setBlendEquation(uint32_t equationRgb, uint32_t equationAlpha);
+	const Blend &getBlend();
+	void setBlend(const Blend &blend);
+	// Advanced (KHR) equations read the framebuffer. With the coherent
+	// extension that is ordered automatically; otherwise a sample may be
+	// blended only once between barriers, so overlapping draws need
+	// blendBarrier() in between.
+	void setBlendCoherent(bool enabled);
+	bool needsBlendBarrier();
+	// glBlendBarrierKHR() if needsBlendBarrier(), else nothing
+	void blendBarrier();
+
+	void setScissorEnabled(bool enabled);
+	void setScissor(int x, int y, int width, int height);
+
+	Snapshot save();
+	void restore(const Snapshot &snapshot);
+
+	// Delete objects and drop the bindings GL resets along with them
+	void deleteFramebuffers(int count, const uint32_t *framebuffers);
+	void deleteTextures(int count, const uint32_t *textures);
+	void deleteVertexArrays(int count, const uint32_t *vertexArrays);
+
+	// Forget everything; the next call for each piece of state is issued
+	void invalidate();
+
+	// Publish the finished frame's counts and start afresh
+	void beginFrame();
+	const Stats &getFrameStats() const { return m_lastFrame; }
+	const Stats &getCurrentStats() const { return m_frame; }
+
+  private:
+	GlState() { m_textures.fill(kUnknown); }
+
+	template <typename T> bool change(T &cached, const T &value);
+
+	uint32_t m_framebuffer = kUnknown;
+	std::array<int, 4> m_viewport{-1, -1, -1, -1};
+	uint32_t m_program = kUnknown;
+	uint32_t m_vertexArray = kUnknown;
+	uint32_t m_activeUnit = kUnknown;
+	std::array<uint32_t, kTextureUnits> m_textures;
+	Blend m_blend;
+	int m_scissorEnabled = -1;
+	std::array<int, 4> m_scissor{-1, -1, -1, -1};
+
+	Stats m_frame;
+	Stats m_lastFrame;
+};
+
+} // namespace blot
@@ -1,5 +1,11 @@
 #define _USE_MATH_DEFINES
 #include "rendering/Graphics.h"
+#include "core/util/MemoryTracker.h"
+#include "rendering/BlendKernels.h"
+#include "rendering/Blur.h"
+#include "rendering/GlState.h"
+#include "rendering/ShaderRegistry.h"
+#include "rendering/ShadowCache.h"
 
 #include "rendering/U_gladGlfw.h"
 
@@ -9,33 +15,87 @@
 #include <algorithm>
 #include <cmath>
 
+#include <spdlog/spdlog.h>
+
 namespace blot {
 
+namespace {
+
+// Textured quad from gl_VertexID, positioned in canvas pixels
+const char *kShadowVertexSource = R"(
+        #version 330 core
+        uniform vec4 uRect; // x, y, width, height in canvas pixels
+        uniform vec2 uViewSize;
+        out vec2 vUV;
+
+        void main() {
+            vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+            vec2 pixel = uRect.xy + corner * uRect.zw;
+            vUV = corner;
+            vec2 ndc = pixel / uViewSize * 2.0 - 1.0;
+            gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+        }
+    )";
+
+const char *kShadowFragmentSource = R"(
+        #version 330 core
+        #extension GL_KHR_blend_equation_advanced : enable
+        #ifdef GL_KHR_blend_equation_advanced
+        layout(blend_support_all_equations) out;
+        #endif
+        in vec2 vUV;
+        uniform sampler2D uMask;
+        uniform vec4 uColor;
+        out vec4 FragColor;
+
+        void main() {
+            FragColor = vec4(uColor.rgb, uColor.a * texture(uMask, vUV).r);
+        }
+    )";
+
+} // namespace
+
 struct Graphics::Impl {
 	GLuint shaderProgram = 0;
 	GLuint VAO = 0;
 	GLuint VBO = 0;
+	// Shadows
+	ShadowCache shadowCache;
+	std::vector<uint8_t> shadowRow;
+	GLuint shadowProgram = 0;
+	GLuint shadowVAO = 0;
 };
 
 Graphics::Graphics()
 	: m_impl(std::make_unique<Impl>()), m_fillColor(1.0f, 1.0f, 1.0f, 1.0f),
 	  m_strokeColor(0.0f, 0.0f, 0.0f, 1.0f), m_strokeWidth(1.0f),
 	  m_fillOpacity(1.0f), m_pathOpen(false), m_fontSize(12.0f), m_textAlign(0),
-	  m_blendMode(0), m_hasShadow(false), m_hasGradient(false) {
+	  m_blendMode(BlendMode::Normal), m_hasShadow(false), m_hasGradient(false) {
 	m_currentMatrix = glm::mat4(1.0f);
 	initShaders();
+	m_impl->shadowCache.setEvictCallback([](ShadowMask &mask) {
+		if (mask.texture) {
+			GlState::instance().deleteTextures(1, &mask.texture);
+			MemoryTracker::instance().remove(
+				MemoryTag::Cache, MemoryDomain::Gpu,
+				MemoryTracker::estimateTextureBytes(mask.width, mask.height,
+													1));
+		}
+	});
 }
 
 Graphics::~Graphics() {
-	if (m_impl->shaderProgram) {
-		glDeleteProgram(m_impl->shaderProgram);
-	}
+	// Programs belong to the ShaderRegistry
+	GlState &state = GlState::instance();
 	if (m_impl->VAO) {
-		glDeleteVertexArrays(1, &m_impl->VAO);
+		state.deleteVertexArrays(1, &m_impl->VAO);
 	}
 	if (m_impl->VBO) {
 		glDeleteBuffers(1, &m_impl->VBO);
 	}
+	if (m_impl->shadowVAO) {
+		state.deleteVertexArrays(1, &m_impl->shadowVAO);
+	}
 }
 
 void Graphics::setFillColor(float r, float g, float b, float a) {
@@ -59,18 +119,28 @@ void Graphics::setStrokeWidth(float width) {
 void Graphics::setFillOpacity(float opacity) { m_fillOpacity = opacity; }
 
 void Graphics::drawRect(float x, float y, float width, float height) {
+	if (m_hasShadow) {
+		drawShadow(false, x, y, width, height);
+	}
 	if (m_renderer) {
 		m_renderer->drawRect(x, y, width, height);
 	}
 }
 
 void Graphics::drawEllipse(float x, float y, float width, float height) {
+	if (m_hasShadow) {
+		drawShadow(true, x, y, width, height);
+	}
 	if (m_renderer) {
 		m_renderer->drawEllipse(x, y, width, height);
 	}
 }
 
 void Graphics::drawCircle(float x, float y, float radius) {
+	if (m_hasShadow) {
+		drawShadow(true, x - radius, y - radius, radius * 2.0f,
+				   radius * 2.0f);
+	}
 	if (m_renderer) {
 		m_renderer->drawCircle(x, y, radius);
 	}
@@ -114,12 +184,24 @@ void Graphics::lineTo(float x, float y) {
 
 void Graphics::curveTo(float x1, float y1, float x2, float y2, float x3,
 					   float y3) {
-	// Basic curve implementation
-	if (m_pathOpen) {
-		// Add control points and end point
-		m_currentPath.push_back(glm::vec2(x1, y1));
-		m_currentPath.push_back(glm::vec2(x2, y2));
-		m_currentPath.push_back(glm::vec2(x3, y3));
+	if (!m_pathOpen) {
+		return;
+	}
+
+	glm::vec2 p1(x1, y1), p2(x2, y2), p3(x3, y3);
+	if (m_currentPath.empty()) {
+		m_currentPath.push_back(p3);
+		return;
+	}
+
+	// Flatten the cubic with as many segments as the LOD tolerance needs
+	glm::vec2 p0 = m_currentPath.back();
+	int segments = m_lod.cubicSegments(p0, p1, p2, p3);
+	for (int i = 1; i <= segments; ++i) {
+		float t = static_cast<float>(i) / segments;
+		float u = 1.0f - t;
+		m_currentPath.push_back(u * u * u * p0 + 3.0f * u * u * t * p1 +
+								3.0f * u * t * t * p2 + t * t * t * p3);
 	}
 }
 
@@ -185,14 +267,184 @@ void Graphics::transform(float a, float b, float c, float d, float e, float f) {
 	m_currentMatrix = m_currentMatrix * transform;
 }
 
-void Graphics::setBlendMode(int mode) { m_blendMode = mode; }
+void Graphics::setBlendMode(int mode) {
+	if (mode < 0 || mode >= static_cast<int>(BlendMode::Count)) {
+		spdlog::warn("[Graphics] Unknown blend mode {}", mode);
+		mode = 0;
+	}
+	setBlendMode(static_cast<BlendMode>(mode));
+}
+
+void Graphics::setBlendMode(BlendMode mode) {
+	if (mode == m_blendMode) {
+		return;
+	}
+	m_blendMode = mode;
+	if (m_renderer) {
+		applyBlendMode();
+	}
+}
+
+void Graphics::applyBlendMode() {
+	if (m_renderer->getType() == RendererType::OpenGL) {
+		if (!applyGlBlendMode(m_blendMode) && !m_warnedBlendMode) {
+			spdlog::warn("[Graphics] Blend mode {} needs "
+						 "KHR_blend_equation_advanced, using Normal",
+						 getBlendModeName(m_blendMode));
+			m_warnedBlendMode = true;
+		}
+	} else if (!m_renderer->setBlendMode(m_blendMode) && !m_warnedBlendMode) {
+		spdlog::warn("[Graphics] {} cannot blend with {}, using Normal",
+					 m_renderer->getName(), getBlendModeName(m_blendMode));
+		m_warnedBlendMode = true;
+	}
+}
 
 void Graphics::setShadow(float x, float y, float blur, float r, float g,
 						 float b, float a) {
 	m_hasShadow = true;
 	m_shadowColor = glm::vec4(r, g, b, a);
 	m_shadowOffset = glm::vec2(x, y);
-	m_shadowBlur = blur;
+	m_shadowBlur = std::max(blur, 0.0f);
+}
+
+void Graphics::clearShadow() { m_hasShadow = false; }
+
+void Graphics::drawShadow(bool ellipse, float x, float y, float width,
+						  float height) {
+	if (!m_renderer || width <= 0.0f || height <= 0.0f ||
+		m_shadowColor.a <= 0.0f) {
+		return;
+	}
+	// The shape goes through the renderer's transform, so its shadow does
+	// too: the offset rect maps to its device bounds, and the blur scales
+	// with it. Under rotation that is the shadow of the bounds.
+	const glm::mat3 transform = m_renderer->getTransform();
+	glm::vec2 lo(INFINITY);
+	glm::vec2 hi(-INFINITY);
+	for (int corner = 0; corner < 4; ++corner) {
+		glm::vec3 p = transform *
+					  glm::vec3(x + m_shadowOffset.x + (corner & 1) * width,
+								y + m_shadowOffset.y + (corner >> 1) * height,
+								1.0f);
+		lo = glm::min(lo, glm::vec2(p.x, p.y));
+		hi = glm::max(hi, glm::vec2(p.x, p.y));
+	}
+	float scale = std::sqrt(std::fabs(transform[0][0] * transform[1][1] -
+									  transform[0][1] * transform[1][0]));
+	if (!(hi.x - lo.x > 0.0f) || !(hi.y - lo.y > 0.0f)) {
+		return;
+	}
+	ShadowMask &mask = m_impl->shadowCache.get(
+		ellipse ? ShadowCache::Shape::Ellipse : ShadowCache::Shape::Rectangle,
+		hi - lo, m_shadowBlur * scale);
+	// Masks are position independent, so snap to whole pixels
+	int left = static_cast<int>(std::floor(lo.x + 0.5f)) + mask.offset.x;
+	int top = static_cast<int>(std::floor(lo.y + 0.5f)) + mask.offset.y;
+
+	if (m_renderer->getType() != RendererType::OpenGL) {
+		uint8_t *pixels = m_renderer->getPixelBuffer();
+		int canvasWidth = m_renderer->getWidth();
+		int canvasHeight = m_renderer->getHeight();
+		int x0 = std::max(left, 0);
+		int x1 = std::min(left + mask.width, canvasWidth);
+		if (!pixels || x0 >= x1) {
+			return;
+		}
+		// Tint one mask row at a time and composite it like any other span
+		const float alpha = m_shadowColor.a;
+		const glm::vec4 color(m_shadowColor.r * alpha, m_shadowColor.g * alpha,
+							  m_shadowColor.b * alpha, alpha);
+		std::vector<uint8_t> &row = m_impl->shadowRow;
+		row.resize(static_cast<size_t>(x1 - x0) * 4);
+		for (int y = std::max(top, 0);
+			 y < std::min(top + mask.height, canvasHeight); ++y) {
+			const uint8_t *coverage =
+				mask.alpha.data() +
+				static_cast<size_t>(y - top) * mask.width + (x0 - left);
+			for (int i = 0; i < x1 - x0; ++i) {
+				float c = coverage[i];
+				for (int k = 0; k < 4; ++k) {
+					row[i * 4 + k] =
+						static_cast<uint8_t>(color[k] * c + 0.5f);
+				}
+			}
+			uint8_t *dst =
+				pixels + (static_cast<size_t>(y) * canvasWidth + x0) * 4;
+			blendSpan(BlendMode::Normal, row.data(), dst, dst, x1 - x0);
+		}
+		return;
+	}
+
+	ShaderRegistry &shaders = ShaderRegistry::instance();
+	if (!m_impl->shadowProgram) {
+		m_impl->shadowProgram =
+			shaders.getProgram(kShadowVertexSource, kShadowFragmentSource);
+		if (!m_impl->shadowProgram) {
+			return;
+		}
+		glGenVertexArrays(1, &m_impl->shadowVAO);
+	}
+	GlState &state = GlState::instance();
+	if (!mask.texture) {
+		GLint alignment = 4;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glGenTextures(1, &mask.texture);
+		state.bindTexture(mask.texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, mask.width, mask.height, 0,
+					 GL_RED, GL_UNSIGNED_BYTE, mask.alpha.data());
+		MemoryTracker::instance().add(
+			MemoryTag::Cache, MemoryDomain::Gpu,
+			MemoryTracker::estimateTextureBytes(mask.width, mask.height, 1));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	}
+
+	glm::vec2 viewSize(m_canvasWidth, m_canvasHeight);
+	if (m_canvasWidth <= 0 || m_canvasHeight <= 0) {
+		const std::array<int, 4> &viewport = state.getViewport();
+		viewSize = glm::vec2(viewport[2], viewport[3]);
+	}
+	GLuint program = m_impl->shadowProgram;
+	state.useProgram(program);
+	glUniform4f(shaders.getUniformLocation(program, "uRect"),
+				static_cast<float>(left), static_cast<float>(top),
+				static_cast<float>(mask.width),
+				static_cast<float>(mask.height));
+	glUniform2f(shaders.getUniformLocation(program, "uViewSize"), viewSize.x,
+				viewSize.y);
+	glUniform4fv(shaders.getUniformLocation(program, "uColor"), 1,
+				 glm::value_ptr(m_shadowColor));
+	glUniform1i(shaders.getUniformLocation(program, "uMask"), 0);
+	state.bindTexture(mask.texture);
+	state.bindVertexArray(m_impl->shadowVAO);
+	// Composited over like the CPU path, whatever blending shapes use; the
+	// shader writes straight alpha
+	const GlState::Blend previousBlend = state.getBlend();
+	applyGlBlendMode(BlendMode::Normal);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	state.setBlend(previousBlend);
+}
+
+void Graphics::blur(float radius) {
+	if (!m_renderer || radius <= 0.0f) {
+		return;
+	}
+	uint8_t *pixels = m_renderer->getPixelBuffer();
+	if (!pixels) {
+		if (!m_warnedBlur) {
+			spdlog::warn("[Graphics] blur() needs a renderer with a pixel "
+						 "buffer");
+			m_warnedBlur = true;
+		}
+		return;
+	}
+	blurImage(pixels, m_renderer->getWidth(), m_renderer->getHeight(), 4,
+			  radius, m_threadPool);
 }
 
 void Graphics::setGradient(float x1, float y1, float r1, float g1, float b1,
@@ -245,6 +497,11 @@ void Graphics::setImageMode(int mode) {
 }
 
 void Graphics::clear(float r, float g, float b, float a) {
+	// CPU renderers clear their own pixels, keeping render() free of GL calls
+	if (m_renderer && m_renderer->getType() != RendererType::OpenGL) {
+		m_renderer->clear(glm::vec4(r, g, b, a));
+		return;
+	}
 	glClearColor(r, g, b, a);
 	glClear(GL_COLOR_BUFFER_BIT);
 }
@@ -268,6 +525,10 @@ void Graphics::initShaders() {
 
 	const char *fragmentShaderSource = R"(
         #version 330 core
+        #extension GL_KHR_blend_equation_advanced : enable
+        #ifdef GL_KHR_blend_equation_advanced
+        layout(blend_support_all_equations) out;
+        #endif
         out vec4 FragColor;
         
         uniform vec4 fillColor;
@@ -279,26 +540,15 @@ void Graphics::initShaders() {
         }
     )";
 
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-
-	m_impl->shaderProgram = glCreateProgram();
-	glAttachShader(m_impl->shaderProgram, vertexShader);
-	glAttachShader(m_impl->shaderProgram, fragmentShader);
-	glLinkProgram(m_impl->shaderProgram);
-
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	// Every Graphics shares one program; the registry compiles it once
+	m_impl->shaderProgram = ShaderRegistry::instance().getProgram(
+		vertexShaderSource, fragmentShaderSource);
 
 	glGenVertexArrays(1, &m_impl->VAO);
 	glGenBuffers(1, &m_impl->VBO);
 
-	glBindVertexArray(m_impl->VAO);
+	GlState &state = GlState::instance();
+	state.bindVertexArray(m_impl->VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_impl->VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 1024, NULL, GL_DYNAMIC_DRAW);
 
@@ -306,14 +556,25 @@ void Graphics::initShaders() {
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
 						  (void *)0);
 
-	glBindVertexArray(0);
+	state.bindVertexArray(0);
 }
 
 void Graphics::updateTransform() {
 	// Update transformation matrix
 }
 
-void Graphics::setRenderer(IRenderer *renderer) { m_renderer = renderer; }
+void Graphics::setRenderer(IRenderer *renderer) {
+	m_renderer = renderer;
+	// GL state is set when the mode changes, on the thread that draws
+	if (m_renderer && m_renderer->getType() != RendererType::OpenGL) {
+		applyBlendMode();
+	}
+}
+
+void Graphics::setThreadPool(ThreadPool *pool) {
+	m_threadPool = pool;
+	m_impl->shadowCache.setThreadPool(pool);
+}
 
 void Graphics::setStrokeCap(int cap) {
 	if (m_renderer) {
@@ -344,6 +605,9 @@ void Graphics::setCanvasSize(int width, int height) {
 }
 
 void Graphics::rect(float x, float y, float width, float height) {
+	if (m_hasShadow) {
+		drawShadow(false, x, y, width, height);
+	}
 	if (m_renderer) {
 		m_renderer->drawRect(x, y, width, height);
 	}
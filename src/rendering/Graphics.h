@@ -4,16 +4,22 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "rendering/BlendMode.h"
 #include "rendering/IRenderer.h"
+#include "rendering/LodPolicy.h"
 
 namespace blot {
 
+class ThreadPool;
+
 class Graphics {
   public:
 	Graphics();
 	~Graphics();
 	void setRenderer(IRenderer *renderer);
 	IRenderer *getRenderer() const { return m_renderer; }
+	// Workers for blurs; optional
+	void setThreadPool(ThreadPool *pool);
 
 	// Color and style
 	void setFillColor(float r, float g, float b, float a = 1.0f);
@@ -55,8 +61,19 @@ class Graphics {
 
 	// Effects and filters
 	void setBlendMode(int mode);
+	void setBlendMode(BlendMode mode);
+	// Every draw blends with the pixels under it, on GL and on renderers
+	// that implement IRenderer::setBlendMode()
+	BlendMode getBlendMode() const { return m_blendMode; }
+	// Drop shadow under rectangles, ellipses and circles, composited with
+	// Normal blending whatever the blend mode. Offset and blur are in user
+	// units and follow the renderer's transform like the shape. Blurred
+	// masks are cached, so repeated shapes only pay for compositing.
 	void setShadow(float x, float y, float blur, float r, float g, float b,
 				   float a = 1.0f);
+	void clearShadow();
+	// Gaussian blur of everything drawn so far (CPU renderers)
+	void blur(float radius);
 	void setGradient(float x1, float y1, float r1, float g1, float b1, float x2,
 					 float y2, float r2, float g2, float b2);
 
@@ -84,6 +101,14 @@ class Graphics {
 	void restore();
 	void setCanvasSize(int width, int height);
 
+	// Level of detail used when flattening curves
+	void setLodTolerance(float tolerance) { m_lod.tolerance = tolerance; }
+	// Canvas units to screen pixels, so curves get detail for their shown
+	// size. Only set it when the paths are drawn through that scale; 1 by
+	// default.
+	void setZoom(float zoom) { m_lod.zoom = zoom > 0.0f ? zoom : 1.0f; }
+	const LodPolicy &getLodPolicy() const { return m_lod; }
+
 	// Getters
 	glm::vec4 getFillColor() const { return m_fillColor; }
 	glm::vec4 getStrokeColor() const { return m_strokeColor; }
@@ -92,6 +117,9 @@ class Graphics {
   private:
 	void initShaders();
 	void updateTransform();
+	void applyBlendMode();
+	void drawShadow(bool ellipse, float x, float y, float width,
+					float height);
 
 	// PIMPL for OpenGL resources
 	struct Impl;
@@ -110,6 +138,7 @@ class Graphics {
 	// Path state
 	std::vector<glm::vec2> m_currentPath;
 	bool m_pathOpen;
+	LodPolicy m_lod;
 
 	// Text state
 	std::string m_currentFont;
@@ -117,11 +146,14 @@ class Graphics {
 	int m_textAlign;
 
 	// Effects
-	int m_blendMode;
+	BlendMode m_blendMode;
+	bool m_warnedBlendMode = false;
 	bool m_hasShadow;
 	glm::vec4 m_shadowColor;
 	glm::vec2 m_shadowOffset;
 	float m_shadowBlur;
+	bool m_warnedBlur = false;
+	ThreadPool *m_threadPool = nullptr;
 
 	// Gradient
 	bool m_hasGradient;
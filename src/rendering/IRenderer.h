@@ -4,12 +4,13 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "rendering/BlendMode.h"
 
 // Forward declarations
 class Canvas;
 class Graphics;
 
-enum class RendererType { OpenGL, Blend2D };
+enum class RendererType { OpenGL, Blend2D, Software };
 
 // Gradient types
 enum class GradientType { Linear, Radial, Conic };
@@ -68,11 +69,18 @@ class IRenderer {
 	virtual void rotate(float angle) = 0;
 	virtual void scale(float sx, float sy) = 0;
 	virtual void resetMatrix() = 0;
+	// User space to device pixels, for effects drawn around the renderer
+	virtual glm::mat3 getTransform() const { return glm::mat3(1.0f); }
 
 	// State setters
 	virtual void setFillColor(const glm::vec4 &color) = 0;
 	virtual void setStrokeColor(const glm::vec4 &color) = 0;
 	virtual void setStrokeWidth(float width) = 0;
+	// How later draws combine with the pixels under them, per primitive.
+	// False, keeping Normal, if the renderer cannot blend the mode itself.
+	virtual bool setBlendMode(blot::BlendMode mode) {
+		return mode == blot::BlendMode::Normal;
+	}
 
 	// Advanced gradient support
 	virtual void setLinearGradient(float x1, float y1, float x2, float y2,
@@ -0,0 +1,43 @@
+#include "rendering/LodPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace blot {
+
+namespace {
+constexpr float kTwoPi = 6.28318530718f;
+} // namespace
+
+bool LodPolicy::isSubPixel(float width, float height) const {
+	float extent = std::max(std::fabs(width), std::fabs(height)) * zoom;
+	return extent < pointSize;
+}
+
+int LodPolicy::arcSegments(float radius, float sweep) const {
+	float r = std::fabs(radius) * zoom;
+	float tol = std::max(tolerance, 1e-3f);
+	float fraction = std::min(std::fabs(sweep), kTwoPi) / kTwoPi;
+	int lo = std::max(1, static_cast<int>(std::ceil(minSegments * fraction)));
+	if (r <= tol) {
+		return lo;
+	}
+	// Sagitta of a chord spanning angle a is r * (1 - cos(a / 2)); solve for
+	// the largest step that keeps it within tolerance.
+	float step = 2.0f * std::acos(1.0f - tol / r);
+	int n = static_cast<int>(std::ceil(std::fabs(sweep) / step));
+	return std::clamp(n, lo, maxSegments);
+}
+
+int LodPolicy::cubicSegments(const glm::vec2 &p0, const glm::vec2 &p1,
+							 const glm::vec2 &p2, const glm::vec2 &p3) const {
+	// Wang's formula: n = sqrt(3 * 2 / 8 * max|second difference| / tol)
+	glm::vec2 d1 = p0 - 2.0f * p1 + p2;
+	glm::vec2 d2 = p1 - 2.0f * p2 + p3;
+	float m = std::sqrt(std::max(glm::dot(d1, d1), glm::dot(d2, d2))) * zoom;
+	float tol = std::max(tolerance, 1e-3f);
+	int n = static_cast<int>(std::ceil(std::sqrt(0.75f * m / tol)));
+	return std::clamp(n, 1, maxSegments);
+}
+
+} // namespace blot
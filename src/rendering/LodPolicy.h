@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace blot {
+
+/**
+ * @brief Screen-space level of detail for curved and many-sided geometry.
+ *
+ * Segment counts are chosen so the flattened outline never deviates from the
+ * true curve by more than `tolerance` screen pixels at the current `zoom`.
+ * Shapes whose projected size is below `pointSize` collapse to a point.
+ */
+struct LodPolicy {
+	float tolerance = 0.25f; // Max deviation in screen pixels
+	float zoom = 1.0f;		 // Canvas units to screen pixels
+	float pointSize = 1.0f;	 // Projected size below which shapes are points
+	int minSegments = 6;
+	int maxSegments = 512;
+
+	// True if a canvas-space extent covers less than pointSize on screen
+	bool isSubPixel(float width, float height) const;
+
+	// Segments for a full circle (or an arc of `sweep` radians) of the given
+	// canvas-space radius
+	int arcSegments(float radius, float sweep = 6.28318530718f) const;
+
+	// Segments for a cubic Bezier, from Wang's formula
+	int cubicSegments(const glm::vec2 &p0, const glm::vec2 &p1,
+					  const glm::vec2 &p2, const glm::vec2 &p3) const;
+};
+
+} // namespace blot
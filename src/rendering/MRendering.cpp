@@ -171,12 +171,14 @@ RendererType getRendererTypeFromString(const std::string &name) {
         return RendererType::OpenGL;
     } else if (name == "blend2d" || name == "Blend2D") {
         return RendererType::Blend2D;
+    } else if (name == "software" || name == "Software") {
+        return RendererType::Software;
     }
     return RendererType::OpenGL; // Default
 }
 
 std::vector<std::string> getAvailableRendererNames() {
-    return {"OpenGL", "Blend2D"};
+    return {"OpenGL", "Blend2D", "Software"};
 }
 
 } // namespace blot
@@ -0,0 +1,93 @@
+#include "rendering/PamImage.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <spdlog/spdlog.h>
+
+namespace blot {
+
+bool writePam(const std::string &path, const uint8_t *rgba, int width,
+			  int height) {
+	if (!rgba || width <= 0 || height <= 0) {
+		return false;
+	}
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		spdlog::error("[PamImage] Cannot open {} for writing", path);
+		return false;
+	}
+	file << "P7\nWIDTH " << width << "\nHEIGHT " << height
+		 << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+	file.write(reinterpret_cast<const char *>(rgba),
+			   static_cast<std::streamsize>(width) * height * 4);
+	return static_cast<bool>(file);
+}
+
+bool readPam(const std::string &path, std::vector<uint8_t> &rgba, int &width,
+			 int &height) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	std::string line;
+	if (!std::getline(file, line) || line != "P7") {
+		spdlog::error("[PamImage] {} is not a PAM file", path);
+		return false;
+	}
+	width = 0;
+	height = 0;
+	int depth = 0;
+	int maxval = 0;
+	while (std::getline(file, line) && line != "ENDHDR") {
+		std::istringstream fields(line);
+		std::string key;
+		fields >> key;
+		if (key == "WIDTH") {
+			fields >> width;
+		} else if (key == "HEIGHT") {
+			fields >> height;
+		} else if (key == "DEPTH") {
+			fields >> depth;
+		} else if (key == "MAXVAL") {
+			fields >> maxval;
+		}
+	}
+	if (width <= 0 || height <= 0 || depth != 4 || maxval != 255) {
+		spdlog::error("[PamImage] {}: only 8-bit RGBA PAM is supported",
+					  path);
+		return false;
+	}
+	rgba.resize(static_cast<size_t>(width) * height * 4);
+	file.read(reinterpret_cast<char *>(rgba.data()),
+			  static_cast<std::streamsize>(rgba.size()));
+	if (file.gcount() != static_cast<std::streamsize>(rgba.size())) {
+		spdlog::error("[PamImage] {} is truncated", path);
+		return false;
+	}
+	return true;
+}
+
+void unpremultiplyRgba(const uint8_t *src, uint8_t *dst, size_t count) {
+	for (size_t i = 0; i < count * 4; i += 4) {
+		unsigned a = src[i + 3];
+		for (int c = 0; c < 3; ++c) {
+			unsigned value = a ? (src[i + c] * 255u + a / 2) / a : 0;
+			dst[i + c] = static_cast<uint8_t>(std::min(value, 255u));
+		}
+		dst[i + 3] = static_cast<uint8_t>(a);
+	}
+}
+
+void premultiplyRgba(const uint8_t *src, uint8_t *dst, size_t count) {
+	for (size_t i = 0; i < count * 4; i += 4) {
+		unsigned a = src[i + 3];
+		for (int c = 0; c < 3; ++c) {
+			dst[i + c] = static_cast<uint8_t>((src[i + c] * a + 127) / 255);
+		}
+		dst[i + 3] = static_cast<uint8_t>(a);
+	}
+}
+
+} // namespace blot
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace blot {
+
+// Netpbm PAM (P7, RGB_ALPHA, 8-bit) files: uncompressed, lossless and
+// readable by ImageMagick, GIMP and netpbm, with no codec dependency.
+// Pixels are straight (not premultiplied) RGBA rows, tightly packed.
+
+bool writePam(const std::string &path, const uint8_t *rgba, int width,
+			  int height);
+bool readPam(const std::string &path, std::vector<uint8_t> &rgba, int &width,
+			 int &height);
+
+// Convert premultiplied RGBA8 to straight alpha, or back, `count` pixels
+void unpremultiplyRgba(const uint8_t *src, uint8_t *dst, size_t count);
+void premultiplyRgba(const uint8_t *src, uint8_t *dst, size_t count);
+
+} // namespace blot
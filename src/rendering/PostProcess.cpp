@@ -0,0 +1,665 @@
+#include "rendering/PostProcess.h"
+
+#include "rendering/U_gladGlfw.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "core/util/ThreadPool.h"
+#include "rendering/Blur.h"
+#include "rendering/GlState.h"
+#include "rendering/ShaderRegistry.h"
+
+namespace blot {
+
+namespace {
+
+constexpr int kTileRows = 32;
+// GPU blur taps on each side, enough for three sigma up to ~20 pixels
+constexpr int kMaxBlurTaps = 64;
+
+// Full-screen triangle from gl_VertexID
+const char *kPostVertexSource = R"(
+        #version 330 core
+        out vec2 vUV;
+
+        void main() {
+            vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+            vUV = corner;
+            gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+const char *kBlurFragmentSource = R"(
+        #version 330 core
+        in vec2 vUV;
+        uniform sampler2D uSource;
+        uniform vec2 uTexelSize;
+        uniform vec2 uDirection;
+        uniform float uSigma;
+        uniform int uTaps;
+        out vec4 FragColor;
+
+        void main() {
+            vec4 sum = texture(uSource, vUV);
+            float total = 1.0;
+            vec2 step = uDirection * uTexelSize;
+            for (int i = 1; i <= uTaps; ++i) {
+                float weight = exp(-0.5 * float(i * i) / (uSigma * uSigma));
+                sum += (texture(uSource, vUV + step * float(i)) +
+                        texture(uSource, vUV - step * float(i))) * weight;
+                total += 2.0 * weight;
+            }
+            FragColor = sum / total;
+        }
+    )";
+
+const char *kColorMatrixFragmentSource = R"(
+        #version 330 core
+        in vec2 vUV;
+        uniform sampler2D uSource;
+        uniform mat4 uMatrix;
+        uniform vec4 uOffset;
+        out vec4 FragColor;
+
+        void main() {
+            vec4 color = texture(uSource, vUV);
+            if (color.a > 0.0) {
+                color.rgb /= color.a;
+            }
+            vec4 result = clamp(uMatrix * color + uOffset, 0.0, 1.0);
+            FragColor = vec4(result.rgb * result.a, result.a);
+        }
+    )";
+
+const char *kThresholdFragmentSource = R"(
+        #version 330 core
+        in vec2 vUV;
+        uniform sampler2D uSource;
+        uniform float uLevel;
+        uniform float uSoftness;
+        out vec4 FragColor;
+
+        void main() {
+            vec4 color = texture(uSource, vUV);
+            vec3 rgb = color.a > 0.0 ? color.rgb / color.a : vec3(0.0);
+            float luma = dot(rgb, vec3(0.2126, 0.7152, 0.0722));
+            float value = uSoftness > 0.0
+                ? smoothstep(uLevel - uSoftness, uLevel + uSoftness, luma)
+                : step(uLevel, luma);
+            FragColor = vec4(vec3(value * color.a), color.a);
+        }
+    )";
+
+const char *kDisplacementFragmentSource = R"(
+        #version 330 core
+        in vec2 vUV;
+        uniform sampler2D uSource;
+        uniform sampler2D uMap;
+        uniform vec2 uTexelSize;
+        uniform float uScale;
+        out vec4 FragColor;
+
+        void main() {
+            vec2 offset = (texture(uMap, vUV).rg - 0.5) * 2.0 * uScale;
+            FragColor = texture(uSource, vUV + offset * uTexelSize);
+        }
+    )";
+
+inline float luminance(float r, float g, float b) {
+	return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+inline uint8_t toByte(float value) {
+	return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f +
+								0.5f);
+}
+
+GLint uniform(GLuint program, const char *name) {
+	return ShaderRegistry::instance().getUniformLocation(program, name);
+}
+
+} // namespace
+
+// PostEffect
+
+void PostEffect::applyCpu(const uint8_t *src, uint8_t *dst, int width,
+						  int height, ThreadPool *pool) const {
+	if (pool && height > kTileRows) {
+		pool->parallelForRange(height, kTileRows,
+							   [&](size_t begin, size_t end) {
+								   applyRows(src, dst, width, height,
+											 static_cast<int>(begin),
+											 static_cast<int>(end));
+							   });
+	} else {
+		applyRows(src, dst, width, height, 0, height);
+	}
+}
+
+void PostEffect::applyRows(const uint8_t *src, uint8_t *dst, int width,
+						   int /*height*/, int rowBegin, int rowEnd) const {
+	size_t stride = static_cast<size_t>(width) * 4;
+	std::memcpy(dst + rowBegin * stride, src + rowBegin * stride,
+				(rowEnd - rowBegin) * stride);
+}
+
+void PostEffect::setEnabled(bool enabled) {
+	if (enabled != m_enabled) {
+		m_enabled = enabled;
+		touch();
+	}
+}
+
+// BlurEffect
+
+void BlurEffect::setRadius(float radius) {
+	m_radius = std::max(radius, 0.0f);
+	touch();
+}
+
+void BlurEffect::applyCpu(const uint8_t *src, uint8_t *dst, int width,
+						  int height, ThreadPool *pool) const {
+	std::memcpy(dst, src, static_cast<size_t>(width) * height * 4);
+	blurImage(dst, width, height, 4, m_radius, pool);
+}
+
+const char *BlurEffect::getFragmentSource() const {
+	return kBlurFragmentSource;
+}
+
+void BlurEffect::setUniforms(uint32_t program, int pass) const {
+	float sigma = std::max(m_radius * 0.5f, 1e-3f);
+	int taps = std::min(static_cast<int>(std::ceil(sigma * 3.0f)),
+						kMaxBlurTaps);
+	glUniform2f(uniform(program, "uDirection"),
+				pass == 0 ? 1.0f : 0.0f, pass == 0 ? 0.0f : 1.0f);
+	glUniform1f(uniform(program, "uSigma"), sigma);
+	glUniform1i(uniform(program, "uTaps"),
+				m_radius > 0.0f ? taps : 0);
+}
+
+// ColorMatrixEffect
+
+ColorMatrixEffect::ColorMatrixEffect(const glm::mat4 &matrix,
+									 const glm::vec4 &offset)
+	: m_matrix(matrix), m_offset(offset) {}
+
+void ColorMatrixEffect::setMatrix(const glm::mat4 &matrix,
+								  const glm::vec4 &offset) {
+	m_matrix = matrix;
+	m_offset = offset;
+	touch();
+}
+
+glm::mat4 ColorMatrixEffect::grayscale() { return saturation(0.0f); }
+
+glm::mat4 ColorMatrixEffect::sepia() {
+	// Column-major: each column is the contribution of one input channel
+	return glm::mat4(0.393f, 0.349f, 0.272f, 0.0f, // Red
+					 0.769f, 0.686f, 0.534f, 0.0f, // Green
+					 0.189f, 0.168f, 0.131f, 0.0f, // Blue
+					 0.0f, 0.0f, 0.0f, 1.0f);	   // Alpha
+}
+
+glm::mat4 ColorMatrixEffect::saturation(float amount) {
+	const float r = 0.2126f * (1.0f - amount);
+	const float g = 0.7152f * (1.0f - amount);
+	const float b = 0.0722f * (1.0f - amount);
+	return glm::mat4(r + amount, r, r, 0.0f, // Red
+					 g, g + amount, g, 0.0f, // Green
+					 b, b, b + amount, 0.0f, // Blue
+					 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+const char *ColorMatrixEffect::getFragmentSource() const {
+	return kColorMatrixFragmentSource;
+}
+
+void ColorMatrixEffect::setUniforms(uint32_t program, int /*pass*/) const {
+	glUniformMatrix4fv(uniform(program, "uMatrix"), 1, GL_FALSE,
+					   glm::value_ptr(m_matrix));
+	glUniform4fv(uniform(program, "uOffset"), 1,
+				 glm::value_ptr(m_offset));
+}
+
+void ColorMatrixEffect::applyRows(const uint8_t *src, uint8_t *dst,
+								  int width, int /*height*/, int rowBegin,
+								  int rowEnd) const {
+	const float inv255 = 1.0f / 255.0f;
+	size_t begin = static_cast<size_t>(rowBegin) * width * 4;
+	size_t end = static_cast<size_t>(rowEnd) * width * 4;
+	for (size_t i = begin; i < end; i += 4) {
+		float alpha = src[i + 3] * inv255;
+		float unpremultiply = alpha > 0.0f ? inv255 / alpha : 0.0f;
+		float color[4] = {src[i] * unpremultiply, src[i + 1] * unpremultiply,
+						  src[i + 2] * unpremultiply, alpha};
+		float result[4];
+		for (int row = 0; row < 4; ++row) {
+			result[row] = m_offset[row];
+			for (int column = 0; column < 4; ++column) {
+				result[row] += m_matrix[column][row] * color[column];
+			}
+		}
+		float outAlpha = std::clamp(result[3], 0.0f, 1.0f);
+		for (int k = 0; k < 3; ++k) {
+			dst[i + k] =
+				toByte(std::clamp(result[k], 0.0f, 1.0f) * outAlpha);
+		}
+		dst[i + 3] = toByte(outAlpha);
+	}
+}
+
+// ThresholdEffect
+
+void ThresholdEffect::setLevel(float level, float softness) {
+	m_level = level;
+	m_softness = std::max(softness, 0.0f);
+	touch();
+}
+
+const char *ThresholdEffect::getFragmentSource() const {
+	return kThresholdFragmentSource;
+}
+
+void ThresholdEffect::setUniforms(uint32_t program, int /*pass*/) const {
+	glUniform1f(uniform(program, "uLevel"), m_level);
+	glUniform1f(uniform(program, "uSoftness"), m_softness);
+}
+
+void ThresholdEffect::applyRows(const uint8_t *src, uint8_t *dst, int width,
+								int /*height*/, int rowBegin,
+								int rowEnd) const {
+	size_t begin = static_cast<size_t>(rowBegin) * width * 4;
+	size_t end = static_cast<size_t>(rowEnd) * width * 4;
+	const float low = m_level - m_softness;
+	const float high = m_level + m_softness;
+	for (size_t i = begin; i < end; i += 4) {
+		uint8_t alpha = src[i + 3];
+		float luma =
+			alpha ? luminance(src[i], src[i + 1], src[i + 2]) / alpha : 0.0f;
+		float value;
+		if (m_softness > 0.0f) {
+			float t = std::clamp((luma - low) / (high - low), 0.0f, 1.0f);
+			value = t * t * (3.0f - 2.0f * t);
+		} else {
+			value = luma >= m_level ? 1.0f : 0.0f;
+		}
+		uint8_t level = static_cast<uint8_t>(value * alpha + 0.5f);
+		dst[i] = dst[i + 1] = dst[i + 2] = level;
+		dst[i + 3] = alpha;
+	}
+}
+
+// DisplacementEffect
+
+DisplacementEffect::~DisplacementEffect() {
+	if (m_mapTexture) {
+		GlState::instance().deleteTextures(1, &m_mapTexture);
+	}
+}
+
+void DisplacementEffect::setMap(const uint8_t *pixels, int width,
+								int height) {
+	if (!pixels || width <= 0 || height <= 0) {
+		m_map.clear();
+		m_mapWidth = m_mapHeight = 0;
+	} else {
+		m_map.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		m_mapWidth = width;
+		m_mapHeight = height;
+	}
+	m_mapUploaded = false;
+	touch();
+}
+
+void DisplacementEffect::setScale(float scale) {
+	m_scale = scale;
+	touch();
+}
+
+const char *DisplacementEffect::getFragmentSource() const {
+	return kDisplacementFragmentSource;
+}
+
+void DisplacementEffect::setUniforms(uint32_t program, int /*pass*/) const {
+	GlState &state = GlState::instance();
+	if (!m_mapUploaded) {
+		if (!m_mapTexture) {
+			glGenTextures(1, &m_mapTexture);
+		}
+		// A flat map leaves the image in place when none is set
+		const uint8_t flat[4] = {128, 128, 0, 255};
+		state.bindTexture(m_mapTexture, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_map.empty() ? 1 : m_mapWidth,
+					 m_map.empty() ? 1 : m_mapHeight, 0, GL_RGBA,
+					 GL_UNSIGNED_BYTE, m_map.empty() ? flat : m_map.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		m_mapUploaded = true;
+	}
+	state.bindTexture(m_mapTexture, 1);
+	glUniform1i(uniform(program, "uMap"), 1);
+	glUniform1f(uniform(program, "uScale"), m_scale);
+}
+
+void DisplacementEffect::applyRows(const uint8_t *src, uint8_t *dst,
+								   int width, int height, int rowBegin,
+								   int rowEnd) const {
+	if (m_map.empty()) {
+		PostEffect::applyRows(src, dst, width, height, rowBegin, rowEnd);
+		return;
+	}
+	const float scale = m_scale * 2.0f / 255.0f;
+	for (int y = rowBegin; y < rowEnd; ++y) {
+		int mapY = static_cast<int>(static_cast<int64_t>(y) * m_mapHeight /
+									height);
+		const uint8_t *mapRow =
+			m_map.data() + static_cast<size_t>(mapY) * m_mapWidth * 4;
+		uint8_t *out = dst + static_cast<size_t>(y) * width * 4;
+		for (int x = 0; x < width; ++x) {
+			int mapX = static_cast<int>(static_cast<int64_t>(x) * m_mapWidth /
+										width);
+			const uint8_t *offset = mapRow + mapX * 4;
+			int sx = static_cast<int>(
+				std::lround(x + (offset[0] - 127.5f) * scale));
+			int sy = static_cast<int>(
+				std::lround(y + (offset[1] - 127.5f) * scale));
+			sx = std::clamp(sx, 0, width - 1);
+			sy = std::clamp(sy, 0, height - 1);
+			std::memcpy(out + x * 4,
+						src + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+		}
+	}
+}
+
+// ShaderEffect
+
+ShaderEffect::ShaderEffect(std::string fragmentSource, RowFunction cpu)
+	: m_source(std::move(fragmentSource)), m_cpu(std::move(cpu)) {}
+
+void ShaderEffect::setSource(std::string fragmentSource) {
+	m_source = std::move(fragmentSource);
+	touch();
+}
+
+void ShaderEffect::setCpuFunction(RowFunction cpu) {
+	m_cpu = std::move(cpu);
+	touch();
+}
+
+const char *ShaderEffect::getFragmentSource() const {
+	return m_source.empty() ? nullptr : m_source.c_str();
+}
+
+void ShaderEffect::setUniforms(uint32_t program, int /*pass*/) const {
+	if (m_uniforms) {
+		m_uniforms(program);
+	}
+}
+
+void ShaderEffect::applyRows(const uint8_t *src, uint8_t *dst, int width,
+							 int height, int rowBegin, int rowEnd) const {
+	if (m_cpu) {
+		m_cpu(src, dst, width, height, rowBegin, rowEnd);
+	} else {
+		PostEffect::applyRows(src, dst, width, height, rowBegin, rowEnd);
+	}
+}
+
+// PostProcessChain
+
+PostProcessChain::PostProcessChain() {}
+
+PostProcessChain::~PostProcessChain() {
+	clearEffects();
+	if (m_vao) {
+		GlState::instance().deleteVertexArrays(1, &m_vao);
+	}
+}
+
+void PostProcessChain::setTargetPool(RenderTargetPool *pool) {
+	if (pool == m_pool) {
+		return;
+	}
+	releaseResources();
+	m_pool = pool;
+}
+
+void PostProcessChain::addEffect(std::shared_ptr<PostEffect> effect) {
+	if (!effect) {
+		return;
+	}
+	Pass pass;
+	pass.effect = std::move(effect);
+	m_passes.push_back(std::move(pass));
+	m_effectsChanged = true;
+}
+
+void PostProcessChain::removeEffect(const std::shared_ptr<PostEffect> &effect) {
+	for (auto it = m_passes.begin(); it != m_passes.end(); ++it) {
+		if (it->effect == effect) {
+			releasePass(*it);
+			// Passes after it see a different input now
+			for (auto next = it + 1; next != m_passes.end(); ++next) {
+				next->valid = false;
+			}
+			m_passes.erase(it);
+			m_effectsChanged = true;
+			return;
+		}
+	}
+}
+
+void PostProcessChain::clearEffects() {
+	releaseResources();
+	m_passes.clear();
+	m_effectsChanged = true;
+}
+
+std::vector<std::shared_ptr<PostEffect>> PostProcessChain::getEffects() const {
+	std::vector<std::shared_ptr<PostEffect>> effects;
+	effects.reserve(m_passes.size());
+	for (const Pass &pass : m_passes) {
+		effects.push_back(pass.effect);
+	}
+	return effects;
+}
+
+bool PostProcessChain::hasEnabledEffects() const {
+	return std::any_of(m_passes.begin(), m_passes.end(),
+					   [](const Pass &pass) {
+						   return pass.effect->isEnabled();
+					   });
+}
+
+bool PostProcessChain::isStale() const {
+	if (m_effectsChanged) {
+		return true;
+	}
+	for (const Pass &pass : m_passes) {
+		if (pass.version != pass.effect->getVersion()) {
+			return true;
+		}
+		if (pass.effect->isEnabled() && (m_sourceChanged || !pass.valid)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+RenderTargetPool &PostProcessChain::getPool() {
+	if (m_pool) {
+		return *m_pool;
+	}
+	if (!m_ownPool) {
+		m_ownPool = std::make_unique<RenderTargetPool>();
+	}
+	return *m_ownPool;
+}
+
+void PostProcessChain::releasePass(Pass &pass) {
+	getPool().releaseTarget(pass.target);
+	getPool().releaseBuffer(std::move(pass.buffer));
+	pass.valid = false;
+}
+
+void PostProcessChain::releaseResources() {
+	for (Pass &pass : m_passes) {
+		releasePass(pass);
+	}
+}
+
+void PostProcessChain::prepare(int width, int height, bool gpu) {
+	if (width != m_width || height != m_height || gpu != m_gpu) {
+		releaseResources();
+		m_width = width;
+		m_height = height;
+		m_gpu = gpu;
+	}
+	m_passesRun = 0;
+}
+
+uint32_t PostProcessChain::getProgram(Pass &pass) {
+	const char *source = pass.effect->getFragmentSource();
+	if (!source) {
+		return 0;
+	}
+	if (!pass.program || pass.programSource != source) {
+		// The registry owns the program and shares it between chains
+		pass.program =
+			ShaderRegistry::instance().getProgram(kPostVertexSource, source);
+		pass.programSource = source;
+	}
+	return pass.program;
+}
+
+void PostProcessChain::drawPasses(const PostEffect &effect, uint32_t program,
+								  uint32_t source, RenderTarget &output) {
+	const int count = std::max(effect.getPassCount(), 1);
+	RenderTarget scratch[2];
+	GlState &state = GlState::instance();
+	state.useProgram(program);
+	glUniform1i(uniform(program, "uSource"), 0);
+	glUniform2f(uniform(program, "uTexelSize"), 1.0f / m_width,
+				1.0f / m_height);
+
+	for (int pass = 0; pass < count; ++pass) {
+		// Intermediate passes ping-pong between two pooled targets
+		RenderTarget *target = &output;
+		if (pass + 1 < count) {
+			target = &scratch[pass % 2];
+			if (!*target) {
+				*target = getPool().acquireTarget(m_width, m_height);
+			}
+		}
+		state.bindFramebuffer(target->framebuffer);
+		state.bindTexture(source);
+		effect.setUniforms(program, pass);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		source = target->texture;
+	}
+
+	getPool().releaseTarget(scratch[0]);
+	getPool().releaseTarget(scratch[1]);
+}
+
+uint32_t PostProcessChain::processGpu(uint32_t sourceTexture, int width,
+									  int height) {
+	prepare(width, height, true);
+	m_effectsChanged = false;
+	if (!hasEnabledEffects() || width <= 0 || height <= 0) {
+		for (Pass &pass : m_passes) {
+			pass.version = pass.effect->getVersion();
+		}
+		m_sourceChanged = false;
+		return sourceTexture;
+	}
+
+	GlState &state = GlState::instance();
+	const GlState::Snapshot previous = state.save();
+
+	if (!m_vao) {
+		glGenVertexArrays(1, &m_vao);
+	}
+	state.bindVertexArray(m_vao);
+	state.setBlendEnabled(false);
+	state.setViewport(0, 0, width, height);
+
+	uint32_t input = sourceTexture;
+	bool upstreamChanged = m_sourceChanged;
+	for (Pass &pass : m_passes) {
+		const PostEffect &effect = *pass.effect;
+		bool changed = pass.version != effect.getVersion();
+		pass.version = effect.getVersion();
+		if (!effect.isEnabled()) {
+			upstreamChanged = upstreamChanged || changed;
+			releasePass(pass);
+			continue;
+		}
+		uint32_t program = getProgram(pass);
+		if (!program) {
+			pass.valid = true; // CPU-only or broken shader: pass through
+			continue;
+		}
+		if (upstreamChanged || changed || !pass.valid) {
+			if (!pass.target) {
+				pass.target = getPool().acquireTarget(width, height);
+			}
+			drawPasses(effect, program, input, pass.target);
+			pass.valid = true;
+			upstreamChanged = true;
+			++m_passesRun;
+		}
+		input = pass.target.texture;
+	}
+
+	state.restore(previous);
+
+	m_sourceChanged = false;
+	return input;
+}
+
+const uint8_t *PostProcessChain::processCpu(const uint8_t *pixels, int width,
+											int height) {
+	prepare(width, height, false);
+	m_effectsChanged = false;
+	const size_t size = static_cast<size_t>(width) * height * 4;
+
+	const uint8_t *input = pixels;
+	bool upstreamChanged = m_sourceChanged;
+	for (Pass &pass : m_passes) {
+		const PostEffect &effect = *pass.effect;
+		bool changed = pass.version != effect.getVersion();
+		pass.version = effect.getVersion();
+		if (!effect.isEnabled()) {
+			upstreamChanged = upstreamChanged || changed;
+			releasePass(pass);
+			continue;
+		}
+		if (upstreamChanged || changed || !pass.valid) {
+			if (pass.buffer.size() != size) {
+				getPool().releaseBuffer(std::move(pass.buffer));
+				pass.buffer = getPool().acquireBuffer(size);
+			}
+			effect.applyCpu(input, pass.buffer.data(), width, height,
+							m_threadPool);
+			pass.valid = true;
+			upstreamChanged = true;
+			++m_passesRun;
+		}
+		input = pass.buffer.data();
+	}
+
+	m_sourceChanged = false;
+	return input;
+}
+
+} // namespace blot
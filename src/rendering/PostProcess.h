@@ -0,0 +1,270 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rendering/RenderTargetPool.h"
+
+namespace blot {
+
+class ThreadPool;
+
+/**
+ * @brief One step of a post-processing chain.
+ *
+ * Effects read and write premultiplied RGBA8 images. On the CPU, applyCpu()
+ * splits the image into row tiles on the thread pool and calls applyRows()
+ * for each. On the GPU, the chain draws a full-screen triangle with the
+ * getFragmentSource() shader, which receives `uniform sampler2D uSource`,
+ * `uniform vec2 uTexelSize` and `in vec2 vUV`, and writes
+ * `out vec4 FragColor`. Setters bump getVersion() so the chain knows which
+ * passes to rerun.
+ */
+class PostEffect {
+  public:
+	virtual ~PostEffect() = default;
+
+	virtual const char *getName() const = 0;
+
+	// Write `dst` (width * height * 4 bytes) from `src`
+	virtual void applyCpu(const uint8_t *src, uint8_t *dst, int width,
+						  int height, ThreadPool *pool) const;
+
+	// Null when the effect has no GPU version (it is then skipped there)
+	virtual const char *getFragmentSource() const = 0;
+	// Passes drawn in a row, each reading the previous one's output
+	virtual int getPassCount() const { return 1; }
+	virtual void setUniforms(uint32_t /*program*/, int /*pass*/) const {}
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const { return m_enabled; }
+	uint64_t getVersion() const { return m_version; }
+
+  protected:
+	// Output rows [rowBegin, rowEnd); `src` is the whole image. The default
+	// copies the rows unchanged.
+	virtual void applyRows(const uint8_t *src, uint8_t *dst, int width,
+						   int height, int rowBegin, int rowEnd) const;
+	void touch() { ++m_version; }
+
+  private:
+	uint64_t m_version = 1;
+	bool m_enabled = true;
+};
+
+// Gaussian blur; the radius follows blurImage()
+class BlurEffect : public PostEffect {
+  public:
+	explicit BlurEffect(float radius = 4.0f) : m_radius(radius) {}
+
+	void setRadius(float radius);
+	float getRadius() const { return m_radius; }
+
+	const char *getName() const override { return "Blur"; }
+	void applyCpu(const uint8_t *src, uint8_t *dst, int width, int height,
+				  ThreadPool *pool) const override;
+	const char *getFragmentSource() const override;
+	int getPassCount() const override { return 2; }
+	void setUniforms(uint32_t program, int pass) const override;
+
+  private:
+	float m_radius;
+};
+
+// color' = matrix * color + offset, on unpremultiplied RGBA in [0, 1]
+class ColorMatrixEffect : public PostEffect {
+  public:
+	explicit ColorMatrixEffect(const glm::mat4 &matrix = glm::mat4(1.0f),
+							   const glm::vec4 &offset = glm::vec4(0.0f));
+
+	void setMatrix(const glm::mat4 &matrix,
+				   const glm::vec4 &offset = glm::vec4(0.0f));
+	const glm::mat4 &getMatrix() const { return m_matrix; }
+	const glm::vec4 &getOffset() const { return m_offset; }
+
+	// Common matrices
+	static glm::mat4 grayscale();
+	static glm::mat4 sepia();
+	static glm::mat4 saturation(float amount);
+
+	const char *getName() const override { return "ColorMatrix"; }
+	const char *getFragmentSource() const override;
+	void setUniforms(uint32_t program, int pass) const override;
+
+  protected:
+	void applyRows(const uint8_t *src, uint8_t *dst, int width, int height,
+				   int rowBegin, int rowEnd) const override;
+
+  private:
+	glm::mat4 m_matrix;
+	glm::vec4 m_offset;
+};
+
+// Black or white by luminance, with an optional soft edge; keeps alpha
+class ThresholdEffect : public PostEffect {
+  public:
+	explicit ThresholdEffect(float level = 0.5f, float softness = 0.0f)
+		: m_level(level), m_softness(softness) {}
+
+	void setLevel(float level, float softness = 0.0f);
+	float getLevel() const { return m_level; }
+	float getSoftness() const { return m_softness; }
+
+	const char *getName() const override { return "Threshold"; }
+	const char *getFragmentSource() const override;
+	void setUniforms(uint32_t program, int pass) const override;
+
+  protected:
+	void applyRows(const uint8_t *src, uint8_t *dst, int width, int height,
+				   int rowBegin, int rowEnd) const override;
+
+  private:
+	float m_level;
+	float m_softness;
+};
+
+// Offsets each pixel by a map: red and green at 128 leave it in place and
+// 0 or 255 move it by -scale or +scale pixels along x and y. The map is
+// stretched over the canvas.
+class DisplacementEffect : public PostEffect {
+  public:
+	explicit DisplacementEffect(float scale = 10.0f) : m_scale(scale) {}
+	~DisplacementEffect() override;
+
+	// Tightly packed RGBA8
+	void setMap(const uint8_t *pixels, int width, int height);
+	void setScale(float scale);
+	float getScale() const { return m_scale; }
+
+	const char *getName() const override { return "Displacement"; }
+	const char *getFragmentSource() const override;
+	void setUniforms(uint32_t program, int pass) const override;
+
+  protected:
+	void applyRows(const uint8_t *src, uint8_t *dst, int width, int height,
+				   int rowBegin, int rowEnd) const override;
+
+  private:
+	std::vector<uint8_t> m_map;
+	int m_mapWidth = 0;
+	int m_mapHeight = 0;
+	float m_scale;
+	// Uploaded on first GPU use after setMap()
+	mutable uint32_t m_mapTexture = 0;
+	mutable bool m_mapUploaded = false;
+};
+
+// User fragment shader, with an optional CPU version (pass-through without)
+class ShaderEffect : public PostEffect {
+  public:
+	using RowFunction = std::function<void(const uint8_t *src, uint8_t *dst,
+										   int width, int height,
+										   int rowBegin, int rowEnd)>;
+	using UniformFunction = std::function<void(uint32_t program)>;
+
+	explicit ShaderEffect(std::string fragmentSource,
+						  RowFunction cpu = nullptr);
+
+	void setSource(std::string fragmentSource);
+	void setCpuFunction(RowFunction cpu);
+	// Called with the program bound, before each draw
+	void setUniformFunction(UniformFunction uniforms) {
+		m_uniforms = std::move(uniforms);
+	}
+	// Call when values read by the uniform or row functions change
+	void markChanged() { touch(); }
+
+	const char *getName() const override { return "Shader"; }
+	const char *getFragmentSource() const override;
+	void setUniforms(uint32_t program, int pass) const override;
+
+  protected:
+	void applyRows(const uint8_t *src, uint8_t *dst, int width, int height,
+				   int rowBegin, int rowEnd) const override;
+
+  private:
+	std::string m_source;
+	RowFunction m_cpu;
+	UniformFunction m_uniforms;
+};
+
+/**
+ * @brief Ordered list of effects applied to a canvas after it renders.
+ *
+ * Each enabled pass keeps its output (a render target or a pixel buffer
+ * borrowed from the RenderTargetPool), so a process call starts at the
+ * first pass whose input or parameters changed and reuses everything
+ * before it. Multi-pass effects ping-pong through temporary targets from
+ * the same pool.
+ */
+class PostProcessChain {
+  public:
+	PostProcessChain();
+	~PostProcessChain();
+	PostProcessChain(const PostProcessChain &) = delete;
+	PostProcessChain &operator=(const PostProcessChain &) = delete;
+
+	// Pool for targets and buffers, normally shared between canvases. A
+	// private one is used when none is set.
+	void setTargetPool(RenderTargetPool *pool);
+	void setThreadPool(ThreadPool *pool) { m_threadPool = pool; }
+
+	void addEffect(std::shared_ptr<PostEffect> effect);
+	void removeEffect(const std::shared_ptr<PostEffect> &effect);
+	void clearEffects();
+	std::vector<std::shared_ptr<PostEffect>> getEffects() const;
+	bool hasEnabledEffects() const;
+
+	// The source image changed; all passes rerun on the next process call
+	void invalidate() { m_sourceChanged = true; }
+	// Whether a process call would do any work
+	bool isStale() const;
+
+	// GL thread. Returns the texture holding the result, which is
+	// `sourceTexture` itself when no effect is enabled.
+	uint32_t processGpu(uint32_t sourceTexture, int width, int height);
+	// Any thread. Returns the resulting pixels, `pixels` when no effect is
+	// enabled. The result stays valid until the next call.
+	const uint8_t *processCpu(const uint8_t *pixels, int width, int height);
+
+	// Passes actually run by the last process call
+	size_t getPassesRun() const { return m_passesRun; }
+	// Hand every target and buffer back to the pool
+	void releaseResources();
+
+  private:
+	struct Pass {
+		std::shared_ptr<PostEffect> effect;
+		uint64_t version = 0; // Effect version of the stored output
+		bool valid = false;
+		RenderTarget target;
+		std::vector<uint8_t> buffer;
+		uint32_t program = 0;
+		std::string programSource;
+	};
+
+	RenderTargetPool &getPool();
+	void releasePass(Pass &pass);
+	void prepare(int width, int height, bool gpu);
+	uint32_t getProgram(Pass &pass);
+	void drawPasses(const PostEffect &effect, uint32_t program,
+					uint32_t source, RenderTarget &output);
+
+	std::vector<Pass> m_passes;
+	std::unique_ptr<RenderTargetPool> m_ownPool;
+	RenderTargetPool *m_pool = nullptr;
+	ThreadPool *m_threadPool = nullptr;
+	uint32_t m_vao = 0;
+	int m_width = 0;
+	int m_height = 0;
+	bool m_gpu = false;
+	bool m_sourceChanged = true;
+	bool m_effectsChanged = false;
+	size_t m_passesRun = 0;
+};
+
+} // namespace blot
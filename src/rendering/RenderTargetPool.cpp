@@ -0,0 +1,132 @@
+#include "rendering/RenderTargetPool.h"
+
+#include "rendering/U_gladGlfw.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "rendering/GlState.h"
+
+namespace blot {
+
+namespace {
+
+size_t targetBytes(const RenderTarget &target) {
+	return MemoryTracker::estimateTextureBytes(target.width, target.height, 4);
+}
+
+void destroyTarget(RenderTarget &target) {
+	GlState &state = GlState::instance();
+	if (target.framebuffer) {
+		state.deleteFramebuffers(1, &target.framebuffer);
+	}
+	if (target.texture) {
+		state.deleteTextures(1, &target.texture);
+	}
+	target = RenderTarget();
+}
+
+} // namespace
+
+RenderTargetPool::~RenderTargetPool() { trim(); }
+
+RenderTarget RenderTargetPool::acquireTarget(int width, int height) {
+	auto found = std::find_if(m_idleTargets.begin(), m_idleTargets.end(),
+							  [&](const RenderTarget &target) {
+								  return target.width == width &&
+										 target.height == height;
+							  });
+	if (found != m_idleTargets.end()) {
+		RenderTarget target = *found;
+		*found = m_idleTargets.back();
+		m_idleTargets.pop_back();
+		return target;
+	}
+
+	RenderTarget target;
+	target.width = width;
+	target.height = height;
+
+	GlState &state = GlState::instance();
+	const uint32_t previousFramebuffer = state.getFramebuffer();
+
+	glGenTextures(1, &target.texture);
+	state.bindTexture(target.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+				 GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &target.framebuffer);
+	state.bindFramebuffer(target.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+						   target.texture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		spdlog::error("[RenderTargetPool] Incomplete {}x{} target", width,
+					  height);
+	}
+
+	state.bindFramebuffer(previousFramebuffer);
+	m_targetMemory.set(m_targetMemory.get() + targetBytes(target));
+	return target;
+}
+
+void RenderTargetPool::releaseTarget(RenderTarget &target) {
+	if (target) {
+		m_idleTargets.push_back(target);
+	}
+	target = RenderTarget();
+}
+
+std::vector<uint8_t> RenderTargetPool::acquireBuffer(size_t size) {
+	std::vector<uint8_t> buffer;
+	{
+		std::lock_guard<std::mutex> lock(m_bufferMutex);
+		// Smallest idle buffer that fits, to keep big ones for big canvases
+		auto best = m_idleBuffers.end();
+		for (auto it = m_idleBuffers.begin(); it != m_idleBuffers.end(); ++it) {
+			if (it->capacity() >= size &&
+				(best == m_idleBuffers.end() ||
+				 it->capacity() < best->capacity())) {
+				best = it;
+			}
+		}
+		if (best != m_idleBuffers.end()) {
+			std::swap(*best, m_idleBuffers.back());
+			buffer = std::move(m_idleBuffers.back());
+			m_idleBuffers.pop_back();
+			m_idleBufferMemory.set(m_idleBufferMemory.get() -
+								   buffer.capacity());
+		}
+	}
+	buffer.resize(size);
+	return buffer;
+}
+
+void RenderTargetPool::releaseBuffer(std::vector<uint8_t> &&buffer) {
+	if (buffer.capacity() == 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	if (m_idleBuffers.size() < kMaxIdleBuffers) {
+		m_idleBufferMemory.set(m_idleBufferMemory.get() + buffer.capacity());
+		m_idleBuffers.push_back(std::move(buffer));
+	}
+	buffer = std::vector<uint8_t>();
+}
+
+void RenderTargetPool::trim() {
+	for (RenderTarget &target : m_idleTargets) {
+		m_targetMemory.set(m_targetMemory.get() - targetBytes(target));
+		destroyTarget(target);
+	}
+	m_idleTargets.clear();
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	m_idleBuffers.clear();
+	m_idleBufferMemory.set(0);
+}
+
+} // namespace blot
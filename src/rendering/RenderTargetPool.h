@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "core/util/MemoryTracker.h"
+
+namespace blot {
+
+// Color texture with a framebuffer to draw into it
+struct RenderTarget {
+	uint32_t framebuffer = 0;
+	uint32_t texture = 0;
+	int width = 0;
+	int height = 0;
+	explicit operator bool() const { return framebuffer != 0; }
+};
+
+/**
+ * @brief Recycles offscreen targets and pixel buffers between users.
+ *
+ * Post-processing passes borrow RGBA8 render targets (GL thread only) or
+ * CPU pixel buffers (any thread) and hand them back when done, so
+ * canvases of the same size share a handful of allocations instead of
+ * each keeping its own. Release everything before the pool is destroyed,
+ * which must happen on the GL thread.
+ */
+class RenderTargetPool {
+  public:
+	RenderTargetPool() = default;
+	~RenderTargetPool();
+	RenderTargetPool(const RenderTargetPool &) = delete;
+	RenderTargetPool &operator=(const RenderTargetPool &) = delete;
+
+	RenderTarget acquireTarget(int width, int height);
+	// Return a target to the pool and reset the handle
+	void releaseTarget(RenderTarget &target);
+
+	// A buffer of exactly `size` bytes; contents are unspecified
+	std::vector<uint8_t> acquireBuffer(size_t size);
+	void releaseBuffer(std::vector<uint8_t> &&buffer);
+
+	// Free everything not currently borrowed
+	void trim();
+	size_t getIdleTargetCount() const { return m_idleTargets.size(); }
+	// Estimated bytes of every target made, borrowed or idle
+	size_t getTargetMemory() const { return m_targetMemory.get(); }
+
+  private:
+	static constexpr size_t kMaxIdleBuffers = 8;
+
+	std::vector<RenderTarget> m_idleTargets;
+	std::vector<std::vector<uint8_t>> m_idleBuffers;
+	std::mutex m_bufferMutex;
+	TrackedMemory m_targetMemory{MemoryTag::Rendering, MemoryDomain::Gpu};
+	// Idle buffers only; borrowed ones belong to whoever holds them
+	TrackedMemory m_idleBufferMemory{MemoryTag::Cache, MemoryDomain::Cpu};
+};
+
+} // namespace blot
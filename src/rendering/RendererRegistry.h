@@ -1,7 +1,10 @@
 #pragma once
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
+#include "rendering/SoftwareRenderer.h"
 #include "rendering/U_rendering.h"
 
 class RendererRegistry {
@@ -25,6 +28,23 @@ class RendererRegistry {
 		return nullptr;
 	}
 
+	std::vector<RendererType> getRegisteredTypes() const {
+		std::vector<RendererType> types;
+		for (const auto &entry : factories) {
+			types.push_back(entry.first);
+		}
+		std::sort(types.begin(), types.end());
+		return types;
+	}
+
   private:
+	// The software renderer needs nothing from the platform, so it is
+	// always available; GPU and library backends register from addons
+	RendererRegistry() {
+		registerFactory(RendererType::Software, [] {
+			return std::make_shared<blot::SoftwareRenderer>();
+		});
+	}
+
 	std::unordered_map<RendererType, Factory> factories;
 };
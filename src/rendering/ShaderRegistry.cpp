@@ -0,0 +1,252 @@
+#include "rendering/ShaderRegistry.h"
+
+#include "rendering/U_gladGlfw.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "rendering/GlState.h"
+
+namespace blot {
+
+namespace {
+
+// Binary file layout: header followed by the driver's program blob
+struct BinaryHeader {
+	char magic[4] = {'B', 'L', 'S', 'P'};
+	uint32_t version = 1;
+	uint32_t format = 0;
+	uint32_t length = 0;
+};
+
+uint64_t hashString(const std::string &text) {
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : text) {
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+const char *glString(GLenum name) {
+	const GLubyte *value = glGetString(name);
+	return value ? reinterpret_cast<const char *>(value) : "";
+}
+
+GLuint compileStage(GLenum stage, const char *source) {
+	GLuint shader = glCreateShader(stage);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	GLint ok = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		spdlog::error("[ShaderRegistry] Shader compile failed: {}", log);
+	}
+	return shader;
+}
+
+} // namespace
+
+ShaderRegistry &ShaderRegistry::instance() {
+	static ShaderRegistry registry;
+	return registry;
+}
+
+void ShaderRegistry::setCacheDirectory(const std::string &directory) {
+	m_cacheDirectory = directory;
+	if (directory.empty()) {
+		return;
+	}
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		spdlog::warn("[ShaderRegistry] Cannot create cache directory {}: {}",
+					 directory, error.message());
+		m_cacheDirectory.clear();
+	}
+}
+
+uint32_t ShaderRegistry::getProgram(const char *vertexSource,
+									const char *fragmentSource) {
+	if (!vertexSource || !fragmentSource) {
+		return 0;
+	}
+	std::string sources = vertexSource;
+	sources.push_back('\0');
+	sources += fragmentSource;
+
+	auto found = m_programs.find(sources);
+	if (found != m_programs.end()) {
+		++m_stats.reused;
+		return found->second.id;
+	}
+
+	// Failed builds are remembered as 0 so the error is logged once
+	Program &entry = m_programs[sources];
+	std::string binaryPath = binariesSupported() ? getBinaryPath(sources) : "";
+	if (!binaryPath.empty()) {
+		entry.id = loadBinary(binaryPath);
+		if (entry.id) {
+			++m_stats.loadedBinaries;
+			m_byId[entry.id] = &entry;
+			return entry.id;
+		}
+	}
+
+	GLuint vertexShader = compileStage(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentShader = compileStage(GL_FRAGMENT_SHADER, fragmentSource);
+	GLuint program = glCreateProgram();
+	if (!binaryPath.empty()) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+							GL_TRUE);
+	}
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint ok = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		char log[1024];
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		spdlog::error("[ShaderRegistry] Program link failed: {}", log);
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	++m_stats.compiled;
+	entry.id = program;
+	m_byId[program] = &entry;
+	if (!binaryPath.empty()) {
+		saveBinary(binaryPath, program);
+	}
+	return program;
+}
+
+int ShaderRegistry::getUniformLocation(uint32_t program, const char *name) {
+	auto found = m_byId.find(program);
+	if (found == m_byId.end()) {
+		return glGetUniformLocation(program, name);
+	}
+	auto &uniforms = found->second->uniforms;
+	auto location = uniforms.find(name);
+	if (location == uniforms.end()) {
+		location =
+			uniforms.emplace(name, glGetUniformLocation(program, name)).first;
+	}
+	return location->second;
+}
+
+void ShaderRegistry::clear() {
+	for (auto &entry : m_programs) {
+		if (entry.second.id) {
+			glDeleteProgram(entry.second.id);
+		}
+	}
+	m_programs.clear();
+	m_byId.clear();
+	// The cached binding may name a deleted program
+	GlState::instance().invalidate();
+}
+
+bool ShaderRegistry::binariesSupported() {
+	if (m_cacheDirectory.empty()) {
+		return false;
+	}
+	if (m_binarySupport < 0) {
+		GLint formats = 0;
+		if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) {
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		}
+		m_binarySupport = formats > 0 ? 1 : 0;
+		// Binaries are only valid for the driver that produced them
+		m_driver = std::string(glString(GL_VENDOR)) + '\n' +
+				   glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+	}
+	return m_binarySupport == 1;
+}
+
+std::string ShaderRegistry::getBinaryPath(const std::string &sources) {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin",
+				  static_cast<unsigned long long>(
+					  hashString(m_driver + '\n' + sources)));
+	return (std::filesystem::path(m_cacheDirectory) / name).string();
+}
+
+uint32_t ShaderRegistry::loadBinary(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+	BinaryHeader header;
+	BinaryHeader expected;
+	file.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if (!file || std::char_traits<char>::compare(header.magic, expected.magic,
+												 4) != 0 ||
+		header.version != expected.version) {
+		return 0;
+	}
+	std::vector<char> blob(header.length);
+	file.read(blob.data(), blob.size());
+	if (!file) {
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, blob.data(),
+					static_cast<GLsizei>(blob.size()));
+	GLint ok = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		// Driver update or corrupt file; rebuild from source
+		glDeleteProgram(program);
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		return 0;
+	}
+	return program;
+}
+
+void ShaderRegistry::saveBinary(const std::string &path, uint32_t program) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	BinaryHeader header;
+	std::vector<char> blob(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, NULL, &format, blob.data());
+	header.format = format;
+	header.length = static_cast<uint32_t>(length);
+
+	// Write then rename so a crash never leaves a truncated binary
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.write(blob.data(), blob.size());
+		if (!file) {
+			spdlog::warn("[ShaderRegistry] Could not write {}", temporary);
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+} // namespace blot
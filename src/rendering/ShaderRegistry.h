@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace blot {
+
+/**
+ * @brief Compiles each GLSL program once per process and shares it.
+ *
+ * Programs are keyed by their sources, so every Graphics, Canvas or effect
+ * asking for the same pair gets the same program id. When a cache
+ * directory is set and the driver supports program binaries, linked
+ * programs are also saved to disk, keyed by a hash of the sources and the
+ * GL vendor/renderer/version, and loaded from there on later runs.
+ *
+ * GL thread only. The registry owns the programs: callers never delete
+ * them, and clear() must run while the context is still current.
+ */
+class ShaderRegistry {
+  public:
+	struct Stats {
+		size_t compiled = 0;	   // Built from source
+		size_t loadedBinaries = 0; // Restored from the disk cache
+		size_t reused = 0;		   // Served from memory
+	};
+
+	static ShaderRegistry &instance();
+
+	// Directory for program binaries; empty disables the disk cache
+	void setCacheDirectory(const std::string &directory);
+	const std::string &getCacheDirectory() const { return m_cacheDirectory; }
+
+	// Linked program for the sources, or 0 if they fail to build (the log
+	// is printed once)
+	uint32_t getProgram(const char *vertexSource, const char *fragmentSource);
+
+	// Uniform location, looked up once per program and name
+	int getUniformLocation(uint32_t program, const char *name);
+
+	// Delete every program; ids handed out before become invalid
+	void clear();
+
+	const Stats &getStats() const { return m_stats; }
+
+  private:
+	ShaderRegistry() = default;
+
+	struct Program {
+		uint32_t id = 0;
+		std::unordered_map<std::string, int> uniforms;
+	};
+
+	bool binariesSupported();
+	std::string getBinaryPath(const std::string &sources);
+	uint32_t loadBinary(const std::string &path);
+	void saveBinary(const std::string &path, uint32_t program);
+
+	std::unordered_map<std::string, Program> m_programs; // Keyed by sources
+	std::unordered_map<uint32_t, Program *> m_byId;
+	std::string m_cacheDirectory;
+	std::string m_driver;
+	int m_binarySupport = -1; // Unknown until a context is current
+	Stats m_stats;
+};
+
+} // namespace blot
@@ -0,0 +1,122 @@
+#include "rendering/ShadowCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rendering/Blur.h"
+
+namespace blot {
+
+namespace {
+
+constexpr float kQuantum = 4.0f; // Steps per pixel in cache keys
+
+uint32_t quantize(float value) {
+	return static_cast<uint32_t>(std::max(0.0f, std::round(value * kQuantum)));
+}
+
+float dequantize(uint32_t value) { return value / kQuantum; }
+
+// Length of [a0, a1] covered by [b0, b1]
+float overlap(float a0, float a1, float b0, float b1) {
+	return std::max(0.0f, std::min(a1, b1) - std::max(a0, b0));
+}
+
+} // namespace
+
+size_t ShadowCache::KeyHash::operator()(const Key &key) const {
+	size_t hash = static_cast<size_t>(key.shape);
+	for (uint32_t part : {key.width, key.height, key.blur}) {
+		hash = hash * 1000003u ^ part;
+	}
+	return hash;
+}
+
+ShadowCache::ShadowCache(size_t capacityBytes) : m_capacity(capacityBytes) {}
+
+ShadowCache::~ShadowCache() { clear(); }
+
+ShadowMask &ShadowCache::get(Shape shape, const glm::vec2 &size,
+							 float blur) {
+	Key key{shape, quantize(size.x), quantize(size.y), quantize(blur)};
+	auto found = m_lookup.find(key);
+	if (found != m_lookup.end()) {
+		++m_hits;
+		m_entries.splice(m_entries.begin(), m_entries, found->second);
+		return found->second->second;
+	}
+
+	++m_misses;
+	m_entries.emplace_front(key, buildMask(key));
+	m_lookup[key] = m_entries.begin();
+	m_bytes += m_entries.front().second.alpha.size();
+	evictToBudget();
+	m_memory.set(m_bytes);
+	return m_entries.front().second;
+}
+
+void ShadowCache::clear() {
+	if (m_onEvict) {
+		for (Entry &entry : m_entries) {
+			m_onEvict(entry.second);
+		}
+	}
+	m_entries.clear();
+	m_lookup.clear();
+	m_bytes = 0;
+	m_memory.set(0);
+}
+
+ShadowMask ShadowCache::buildMask(const Key &key) const {
+	float width = dequantize(key.width);
+	float height = dequantize(key.height);
+	float blur = dequantize(key.blur);
+	int pad = getBlurExtent(blur) + 1;
+
+	ShadowMask mask;
+	mask.width = static_cast<int>(std::ceil(width)) + 2 * pad;
+	mask.height = static_cast<int>(std::ceil(height)) + 2 * pad;
+	mask.offset = glm::ivec2(-pad, -pad);
+	mask.alpha.assign(static_cast<size_t>(mask.width) * mask.height, 0);
+
+	// Analytic coverage of the shape placed at (pad, pad)
+	const float left = static_cast<float>(pad);
+	const float top = static_cast<float>(pad);
+	const glm::vec2 radius(width * 0.5f, height * 0.5f);
+	const glm::vec2 center(left + radius.x, top + radius.y);
+	const float minRadius = std::max(std::min(radius.x, radius.y), 1e-3f);
+	for (int y = 0; y < mask.height; ++y) {
+		uint8_t *row = mask.alpha.data() + static_cast<size_t>(y) * mask.width;
+		for (int x = 0; x < mask.width; ++x) {
+			float coverage;
+			if (key.shape == Shape::Rectangle) {
+				coverage = overlap(x, x + 1.0f, left, left + width) *
+						   overlap(y, y + 1.0f, top, top + height);
+			} else {
+				glm::vec2 p = (glm::vec2(x + 0.5f, y + 0.5f) - center) /
+							  glm::max(radius, glm::vec2(1e-3f));
+				float distance = (glm::length(p) - 1.0f) * minRadius;
+				coverage = std::clamp(0.5f - distance, 0.0f, 1.0f);
+			}
+			row[x] = static_cast<uint8_t>(coverage * 255.0f + 0.5f);
+		}
+	}
+
+	blurImage(mask.alpha.data(), mask.width, mask.height, 1, blur, m_pool);
+	return mask;
+}
+
+void ShadowCache::evictToBudget() {
+	// Never evict the entry just returned by get()
+	while (m_bytes > m_capacity && m_entries.size() > 1) {
+		Entry &oldest = m_entries.back();
+		if (m_onEvict) {
+			m_onEvict(oldest.second);
+		}
+		m_bytes -= oldest.second.alpha.size();
+		m_lookup.erase(oldest.first);
+		m_entries.pop_back();
+	}
+}
+
+} // namespace blot
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "core/util/MemoryTracker.h"
+
+namespace blot {
+
+class ThreadPool;
+
+// Blurred coverage of one shape, ready to tint and composite
+struct ShadowMask {
+	int width = 0;
+	int height = 0;
+	glm::ivec2 offset{0, 0}; // Mask top-left relative to the shape
+	std::vector<uint8_t> alpha;
+	uint32_t texture = 0; // GPU copy, managed through the evict callback
+};
+
+/**
+ * @brief Keeps blurred shadow masks keyed by shape, size and blur radius.
+ *
+ * Masks do not depend on position, so a static (or moving) shadowed shape
+ * is blurred once and then only composited. Sizes and radii are quantized
+ * to a quarter pixel. Least recently used masks are evicted once the
+ * cache grows past its byte budget.
+ */
+class ShadowCache {
+  public:
+	enum class Shape : uint8_t { Rectangle, Ellipse };
+
+	explicit ShadowCache(size_t capacityBytes = 32 * 1024 * 1024);
+	~ShadowCache();
+	ShadowCache(const ShadowCache &) = delete;
+	ShadowCache &operator=(const ShadowCache &) = delete;
+
+	void setThreadPool(ThreadPool *pool) { m_pool = pool; }
+	// Called for every mask that leaves the cache, to free its texture
+	void setEvictCallback(std::function<void(ShadowMask &)> callback) {
+		m_onEvict = std::move(callback);
+	}
+
+	// Mask for `shape` of `size` blurred by `blur` (see blurImage). The
+	// reference stays valid until the next call that may evict. Callers
+	// may attach a texture, which the evict callback then frees.
+	ShadowMask &get(Shape shape, const glm::vec2 &size, float blur);
+
+	void clear();
+	size_t getEntryCount() const { return m_entries.size(); }
+	size_t getMemoryUsage() const { return m_bytes; }
+	size_t getHits() const { return m_hits; }
+	size_t getMisses() const { return m_misses; }
+
+  private:
+	struct Key {
+		Shape shape;
+		uint32_t width; // Quarter pixels
+		uint32_t height;
+		uint32_t blur;
+		bool operator==(const Key &other) const {
+			return shape == other.shape && width == other.width &&
+				   height == other.height && blur == other.blur;
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key &key) const;
+	};
+	using Entry = std::pair<Key, ShadowMask>;
+
+	ShadowMask buildMask(const Key &key) const;
+	void evictToBudget();
+
+	std::list<Entry> m_entries; // Most recently used first
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_lookup;
+	std::function<void(ShadowMask &)> m_onEvict;
+	ThreadPool *m_pool = nullptr;
+	size_t m_capacity;
+	size_t m_bytes = 0;
+	TrackedMemory m_memory{MemoryTag::Cache, MemoryDomain::Cpu};
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+};
+
+} // namespace blot
@@ -0,0 +1,381 @@
+#include "rendering/ShapeInstancer.h"
+#include "rendering/GlState.h"
+#include "rendering/ShaderRegistry.h"
+#include "resources/VertexBuffer.h"
+
+#include "rendering/U_gladGlfw.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace blot {
+
+namespace {
+
+constexpr size_t kKindCount = static_cast<size_t>(ShapeInstancer::Kind::Count);
+
+// Unit quad corners come from gl_VertexID; no vertex buffer is bound
+const char *kBoxVertexSource = R"(
+        #version 330 core
+        layout (location = 0) in vec4 aRect;
+        layout (location = 1) in vec4 aFill;
+        layout (location = 2) in vec4 aStroke;
+        layout (location = 3) in vec2 aParams;
+
+        uniform vec2 uViewOffset;
+        uniform vec2 uViewSize;
+        uniform float uViewZoom;
+
+        out vec2 vLocal;
+        flat out vec2 vHalfSize;
+        flat out vec4 vFill;
+        flat out vec4 vStroke;
+        flat out float vStrokeWidth;
+
+        void main() {
+            vec2 p0 = min(aRect.xy, aRect.xy + aRect.zw);
+            vec2 p1 = max(aRect.xy, aRect.xy + aRect.zw);
+            vHalfSize = 0.5 * (p1 - p0);
+
+            // Pad by half the stroke plus one pixel for the AA ramp
+            float pad = 0.5 * aParams.x + 1.0 / uViewZoom;
+            vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+            vLocal = (corner * 2.0 - 1.0) * (vHalfSize + pad);
+
+            vec2 screen = (0.5 * (p0 + p1) + vLocal) * uViewZoom + uViewOffset;
+            vec2 ndc = screen / uViewSize * 2.0 - 1.0;
+            gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+
+            vFill = aFill;
+            vStroke = aStroke;
+            vStrokeWidth = aParams.x;
+        }
+    )";
+
+const char *kBoxFragmentSource = R"(
+        #version 330 core
+        #extension GL_KHR_blend_equation_advanced : enable
+        #ifdef GL_KHR_blend_equation_advanced
+        layout(blend_support_all_equations) out;
+        #endif
+        in vec2 vLocal;
+        flat in vec2 vHalfSize;
+        flat in vec4 vFill;
+        flat in vec4 vStroke;
+        flat in float vStrokeWidth;
+
+        uniform int uShape; // 0 rectangle, 1 ellipse
+        uniform float uViewZoom;
+        uniform float uBackdrop;
+
+        out vec4 FragColor;
+
+        float sdBox(vec2 p, vec2 b) {
+            vec2 q = abs(p) - b;
+            return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+        }
+
+        // First order approximation, exact on the outline
+        float sdEllipse(vec2 p, vec2 r) {
+            r = max(r, vec2(1e-4));
+            float k0 = length(p / r);
+            float k1 = length(p / (r * r));
+            return k1 > 0.0 ? k0 * (k0 - 1.0) / k1 : -min(r.x, r.y);
+        }
+
+        void main() {
+            float d = uShape == 1 ? sdEllipse(vLocal, vHalfSize)
+                                  : sdBox(vLocal, vHalfSize);
+            float px = 1.0 / uViewZoom;
+
+            float fillCov = clamp(0.5 - d / px, 0.0, 1.0);
+            float strokeCov = 0.0;
+            if (vStrokeWidth > 0.0) {
+                float edge = abs(d) - 0.5 * vStrokeWidth;
+                strokeCov = clamp(0.5 - edge / px, 0.0, 1.0);
+            }
+
+            // Premultiplied stroke over fill
+            vec4 fill = vec4(vFill.rgb * vFill.a, vFill.a) * fillCov;
+            vec4 stroke = vec4(vStroke.rgb * vStroke.a, vStroke.a) * strokeCov;
+            FragColor = stroke + fill * (1.0 - stroke.a);
+            if (FragColor.a <= 0.0)
+                discard;
+            FragColor.rgb += (1.0 - FragColor.a) * uBackdrop;
+        }
+    )";
+
+const char *kLineVertexSource = R"(
+        #version 330 core
+        layout (location = 0) in vec4 aSegment;
+        layout (location = 1) in vec4 aColor;
+        layout (location = 3) in vec2 aParams;
+
+        uniform vec2 uViewOffset;
+        uniform vec2 uViewSize;
+        uniform float uViewZoom;
+
+        out vec2 vLocal;
+        flat out vec4 vColor;
+        flat out float vLength;
+        flat out float vWidth;
+        flat out float vCap;
+
+        void main() {
+            vec2 dir = aSegment.zw - aSegment.xy;
+            vLength = length(dir);
+            vec2 t = vLength > 0.0 ? dir / vLength : vec2(1.0, 0.0);
+            vec2 n = vec2(-t.y, t.x);
+
+            // Hairlines keep one pixel of width and fade out instead
+            float px = 1.0 / uViewZoom;
+            vWidth = max(aParams.x, px);
+            vColor = aColor;
+            vColor.a *= min(aParams.x / px, 1.0);
+            vCap = aParams.y;
+
+            float pad = 0.5 * vWidth + px;
+            vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+            vLocal = vec2(mix(-pad, vLength + pad, corner.x),
+                          mix(-pad, pad, corner.y));
+
+            vec2 canvas = aSegment.xy + t * vLocal.x + n * vLocal.y;
+            vec2 screen = canvas * uViewZoom + uViewOffset;
+            vec2 ndc = screen / uViewSize * 2.0 - 1.0;
+            gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+        }
+    )";
+
+const char *kLineFragmentSource = R"(
+        #version 330 core
+        #extension GL_KHR_blend_equation_advanced : enable
+        #ifdef GL_KHR_blend_equation_advanced
+        layout(blend_support_all_equations) out;
+        #endif
+        in vec2 vLocal;
+        flat in vec4 vColor;
+        flat in float vLength;
+        flat in float vWidth;
+        flat in float vCap; // 0 butt, 1 square, 2 round
+
+        uniform float uViewZoom;
+        uniform float uBackdrop;
+
+        out vec4 FragColor;
+
+        void main() {
+            float d;
+            if (vCap > 1.5) {
+                float u = clamp(vLocal.x, 0.0, vLength);
+                d = length(vec2(vLocal.x - u, vLocal.y)) - 0.5 * vWidth;
+            } else {
+                float ext = vCap > 0.5 ? 0.5 * vWidth : 0.0;
+                vec2 q = abs(vec2(vLocal.x - 0.5 * vLength, vLocal.y)) -
+                         vec2(0.5 * vLength + ext, 0.5 * vWidth);
+                d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+            }
+
+            float cov = clamp(0.5 - d * uViewZoom, 0.0, 1.0);
+            FragColor = vec4(vColor.rgb * vColor.a, vColor.a) * cov;
+            if (FragColor.a <= 0.0)
+                discard;
+            FragColor.rgb += (1.0 - FragColor.a) * uBackdrop;
+        }
+    )";
+
+} // namespace
+
+struct ShapeInstancer::Impl {
+	struct Program {
+		GLuint id = 0;
+		GLint viewOffset = -1;
+		GLint viewSize = -1;
+		GLint viewZoom = -1;
+		GLint shape = -1;
+		GLint backdrop = -1;
+	};
+
+	Program box;
+	Program line;
+	std::unique_ptr<VertexBuffer> buffers[kKindCount];
+	const Program *bound = nullptr;
+	// Gray level the output is composited over, see flush()
+	float backdrop = 0.0f;
+};
+
+ShapeInstancer::ShapeInstancer() : m_impl(std::make_unique<Impl>()) {
+	initGL();
+}
+
+ShapeInstancer::~ShapeInstancer() = default;
+
+void ShapeInstancer::initGL() {
+	auto loadProgram = [](Impl::Program &program, const char *vs,
+						  const char *fs) {
+		ShaderRegistry &shaders = ShaderRegistry::instance();
+		program.id = shaders.getProgram(vs, fs);
+		auto uniform = [&](const char *name) {
+			return shaders.getUniformLocation(program.id, name);
+		};
+		program.viewOffset = uniform("uViewOffset");
+		program.viewSize = uniform("uViewSize");
+		program.viewZoom = uniform("uViewZoom");
+		program.shape = uniform("uShape");
+		program.backdrop = uniform("uBackdrop");
+	};
+	loadProgram(m_impl->box, kBoxVertexSource, kBoxFragmentSource);
+	loadProgram(m_impl->line, kLineVertexSource, kLineFragmentSource);
+
+	static_assert(sizeof(Instance) == 32, "Instance must be tightly packed");
+	using Type = VertexBuffer::ComponentType;
+	VertexBuffer::Layout layout;
+	layout.add(0, 4, Type::Float, false, 1)
+		.add(1, 4, Type::UnsignedByte, true, 1)
+		.add(2, 4, Type::UnsignedByte, true, 1)
+		.add(3, 2, Type::Float, false, 1);
+	for (auto &buffer : m_impl->buffers) {
+		// A persistently mapped ring where supported, orphaning elsewhere
+		buffer = std::make_unique<VertexBuffer>(VertexBuffer::Usage::Stream);
+		buffer->setLayout(layout);
+	}
+}
+
+uint32_t ShapeInstancer::packColor(const glm::vec4 &color) {
+	return glm::packUnorm4x8(color);
+}
+
+void ShapeInstancer::setView(const glm::vec2 &offset, float zoom,
+							 const glm::vec2 &size) {
+	m_viewOffset = offset;
+	m_viewZoom = zoom > 0.0f ? zoom : 1.0f;
+	m_viewSize = size;
+}
+
+void ShapeInstancer::push(Kind kind, const Instance &instance) {
+	std::vector<Instance> &batch = m_batches[static_cast<size_t>(kind)];
+	uint32_t index = static_cast<uint32_t>(batch.size());
+	batch.push_back(instance);
+	if (!m_runs.empty() && m_runs.back().kind == kind) {
+		++m_runs.back().count;
+	} else {
+		m_runs.push_back({kind, index, 1});
+	}
+}
+
+void ShapeInstancer::addRect(const glm::vec4 &rect, uint32_t fill,
+							 uint32_t stroke, float strokeWidth) {
+	push(Kind::Rectangle,
+		 {rect, fill, stroke, glm::vec2(strokeWidth, 0.0f)});
+}
+
+void ShapeInstancer::addEllipse(const glm::vec4 &rect, uint32_t fill,
+								uint32_t stroke, float strokeWidth) {
+	push(Kind::Ellipse, {rect, fill, stroke, glm::vec2(strokeWidth, 0.0f)});
+}
+
+void ShapeInstancer::addLine(const glm::vec4 &segment, uint32_t color,
+							 float width, LineCap cap) {
+	push(Kind::Line,
+		 {segment, color, 0u, glm::vec2(width, static_cast<float>(cap))});
+}
+
+size_t ShapeInstancer::getPendingCount() const {
+	size_t count = 0;
+	for (const std::vector<Instance> &batch : m_batches) {
+		count += batch.size();
+	}
+	return count;
+}
+
+void ShapeInstancer::drawRun(const Run &run) {
+	const size_t k = static_cast<size_t>(run.kind);
+	const Impl::Program &program =
+		run.kind == Kind::Line ? m_impl->line : m_impl->box;
+
+	GlState &state = GlState::instance();
+	if (m_impl->bound != &program) {
+		state.useProgram(program.id);
+		glUniform2f(program.viewOffset, m_viewOffset.x, m_viewOffset.y);
+		glUniform2f(program.viewSize, m_viewSize.x, m_viewSize.y);
+		glUniform1f(program.viewZoom, m_viewZoom);
+		glUniform1f(program.backdrop, m_impl->backdrop);
+		m_impl->bound = &program;
+	}
+	if (program.shape >= 0) {
+		glUniform1i(program.shape, run.kind == Kind::Ellipse ? 1 : 0);
+	}
+
+	// Binds the type's vertex array, attributes at the run's first instance
+	m_impl->buffers[k]->setFirstVertex(run.first);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+						  static_cast<GLsizei>(run.count));
+}
+
+size_t ShapeInstancer::flush() {
+	if (m_runs.empty()) {
+		return 0;
+	}
+	GlState &state = GlState::instance();
+	if (m_viewSize.x <= 0.0f || m_viewSize.y <= 0.0f) {
+		const std::array<int, 4> &viewport = state.getViewport();
+		m_viewSize = glm::vec2(viewport[2], viewport[3]);
+	}
+
+	for (size_t k = 0; k < kKindCount; ++k) {
+		const std::vector<Instance> &batch = m_batches[k];
+		if (!batch.empty()) {
+			m_impl->buffers[k]->setData(batch.data(),
+										batch.size() * sizeof(Instance));
+		}
+	}
+
+	const GlState::Blend previousBlend = state.getBlend();
+	// Shaders output premultiplied color
+	applyGlBlendMode(m_blendMode, true);
+	// The GL_MIN fallback for Darken ignores coverage; over white, partly
+	// covered pixels fade towards leaving the backdrop as it is
+	m_impl->backdrop = state.getBlend().equation[0] == GL_MIN ? 1.0f : 0.0f;
+	// Non-coherent advanced blending blends each sample once per barrier,
+	// and instances of one draw may overlap
+	const bool barriers = state.needsBlendBarrier();
+
+	size_t drawCalls = 0;
+	m_impl->bound = nullptr;
+	auto draw = [&](const Run &run) {
+		if (!barriers) {
+			drawRun(run);
+			++drawCalls;
+			return;
+		}
+		for (uint32_t i = 0; i < run.count; ++i) {
+			state.blendBarrier();
+			drawRun({run.kind, run.first + i, 1});
+			++drawCalls;
+		}
+	};
+	if (getPreserveOrder()) {
+		for (const Run &run : m_runs) {
+			draw(run);
+		}
+	} else {
+		for (size_t k = 0; k < kKindCount; ++k) {
+			size_t count = m_batches[k].size();
+			if (count == 0) {
+				continue;
+			}
+			draw({static_cast<Kind>(k), 0, static_cast<uint32_t>(count)});
+		}
+	}
+
+	// Program and vertex array stay bound; the next user binds its own
+	state.setBlend(previousBlend);
+
+	for (std::vector<Instance> &batch : m_batches) {
+		batch.clear();
+	}
+	m_runs.clear();
+	return drawCalls;
+}
+
+} // namespace blot
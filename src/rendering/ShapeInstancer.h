@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "rendering/BlendMode.h"
+
+namespace blot {
+
+/**
+ * @brief Draws rectangles, ellipses and lines as GPU instances.
+ *
+ * Shapes are packed into one interleaved instance stream per type
+ * (geometry, fill, stroke, parameters), uploaded through a streaming
+ * VertexBuffer, and each type is drawn with one instanced call
+ * whose fragment shader evaluates a signed distance field for antialiased
+ * fill and stroke. Requires a current OpenGL 3.3 context and draws into the
+ * bound framebuffer, mapping canvas to screen as canvas * zoom + offset.
+ */
+class ShapeInstancer {
+  public:
+	enum class Kind : uint8_t { Rectangle, Ellipse, Line, Count };
+	enum class LineCap : uint8_t { Butt, Square, Round };
+
+	ShapeInstancer();
+	~ShapeInstancer();
+	ShapeInstancer(const ShapeInstancer &) = delete;
+	ShapeInstancer &operator=(const ShapeInstancer &) = delete;
+
+	// Keep submission order across types (one draw per run of equal type).
+	// When off, each type is drawn with a single call, rectangles first.
+	// Order is only kept where it shows: blend modes for which it does not
+	// matter always batch by type.
+	void setPreserveOrder(bool preserve) { m_preserveOrder = preserve; }
+	bool getPreserveOrder() const {
+		return m_preserveOrder && !isOrderIndependent(m_blendMode);
+	}
+
+	// Blend mode used by flush(); the previous GL blend state is restored
+	void setBlendMode(BlendMode mode) { m_blendMode = mode; }
+	BlendMode getBlendMode() const { return m_blendMode; }
+
+	void setView(const glm::vec2 &offset, float zoom, const glm::vec2 &size);
+
+	// Rectangles use the IRenderer convention (x, y, width, height). Colors
+	// are packed with packColor(); a zero alpha or width disables that part.
+	void addRect(const glm::vec4 &rect, uint32_t fill, uint32_t stroke,
+				 float strokeWidth);
+	void addEllipse(const glm::vec4 &rect, uint32_t fill, uint32_t stroke,
+					float strokeWidth);
+	void addLine(const glm::vec4 &segment, uint32_t color, float width,
+				 LineCap cap = LineCap::Butt);
+
+	// Upload pending instances and draw them. Returns the draw call count.
+	size_t flush();
+	size_t getPendingCount() const;
+
+	static uint32_t packColor(const glm::vec4 &color);
+
+  private:
+	struct Run {
+		Kind kind;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	// Per-instance vertex data, matching the shaders' attribute locations
+	struct Instance {
+		glm::vec4 geometry; // rect or segment, canvas space
+		uint32_t fill;		// RGBA8, line color for lines
+		uint32_t stroke;	// RGBA8, unused for lines
+		glm::vec2 params;	// stroke width, line cap
+	};
+
+	void push(Kind kind, const Instance &instance);
+	void initGL();
+	void drawRun(const Run &run);
+
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+
+	std::vector<Instance> m_batches[static_cast<size_t>(Kind::Count)];
+	std::vector<Run> m_runs;
+	bool m_preserveOrder = true;
+	BlendMode m_blendMode = BlendMode::Normal;
+
+	glm::vec2 m_viewOffset{0.0f, 0.0f};
+	glm::vec2 m_viewSize{0.0f, 0.0f};
+	float m_viewZoom = 1.0f;
+};
+
+} // namespace blot
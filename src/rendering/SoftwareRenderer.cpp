@@ -0,0 +1,679 @@
+#include "rendering/SoftwareRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "rendering/BlendKernels.h"
+#include "rendering/PamImage.h"
+
+namespace blot {
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+// Largest distance, in pixels, between a curve and its flattened outline
+constexpr float kFlatness = 0.25f;
+constexpr float kMiterLimit = 10.0f;
+
+// Pixels are handled as one 32-bit word in memory order (R, G, B, A bytes),
+// so loads and stores are plain copies on any endianness
+uint32_t packPremultiplied(const glm::vec4 &color) {
+	glm::vec4 c = glm::clamp(color, glm::vec4(0.0f), glm::vec4(1.0f));
+	uint8_t bytes[4] = {static_cast<uint8_t>(c.r * c.a * 255.0f + 0.5f),
+						static_cast<uint8_t>(c.g * c.a * 255.0f + 0.5f),
+						static_cast<uint8_t>(c.b * c.a * 255.0f + 0.5f),
+						static_cast<uint8_t>(c.a * 255.0f + 0.5f)};
+	uint32_t pixel;
+	std::memcpy(&pixel, bytes, 4);
+	return pixel;
+}
+
+inline uint32_t alphaOf(uint32_t pixel) {
+	uint8_t bytes[4];
+	std::memcpy(bytes, &pixel, 4);
+	return bytes[3];
+}
+
+// All four channels times `scale` / 255, rounded, two channels per multiply
+inline uint32_t scalePixel(uint32_t pixel, uint32_t scale) {
+	uint32_t rb = (pixel & 0x00ff00ff) * scale + 0x00800080;
+	uint32_t ga = ((pixel >> 8) & 0x00ff00ff) * scale + 0x00800080;
+	rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+	ga = (ga + ((ga >> 8) & 0x00ff00ff)) & 0xff00ff00;
+	return rb | ga;
+}
+
+// Source-over of one premultiplied pixel scaled by `coverage` (0-255)
+inline void blendPixel(uint8_t *dst, uint32_t src, uint32_t coverage) {
+	if (coverage < 255) {
+		src = scalePixel(src, coverage);
+	}
+	uint32_t alpha = alphaOf(src);
+	if (alpha < 255) {
+		uint32_t backdrop;
+		std::memcpy(&backdrop, dst, 4);
+		src += scalePixel(backdrop, 255 - alpha);
+	}
+	std::memcpy(dst, &src, 4);
+}
+
+float signedArea(const std::vector<glm::vec2> &points) {
+	float area = 0.0f;
+	for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+		area += points[j].x * points[i].y - points[i].x * points[j].y;
+	}
+	return area;
+}
+
+// Stroke pieces overlap; giving them one winding keeps the overlaps from
+// cancelling out
+void orient(std::vector<glm::vec2> &points) {
+	if (signedArea(points) < 0.0f) {
+		std::reverse(points.begin(), points.end());
+	}
+}
+
+glm::vec2 perpendicular(glm::vec2 v) { return glm::vec2(-v.y, v.x); }
+
+} // namespace
+
+bool SoftwareRenderer::initialize(int width, int height) {
+	if (width <= 0 || height <= 0) {
+		spdlog::error("[SoftwareRenderer] Invalid size {}x{}", width, height);
+		return false;
+	}
+	resize(width, height);
+	m_initialized = true;
+	return true;
+}
+
+void SoftwareRenderer::shutdown() {
+	m_pixels.clear();
+	m_pixels.shrink_to_fit();
+	m_memory.set(0);
+	m_width = 0;
+	m_height = 0;
+	m_initialized = false;
+}
+
+void SoftwareRenderer::resize(int width, int height) {
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	m_pixels.assign(static_cast<size_t>(m_width) * m_height * 4, 0);
+	m_memory.set(m_pixels.capacity());
+}
+
+void SoftwareRenderer::beginFrame() {
+	m_matrixStack.clear();
+	m_matrix = glm::mat3(1.0f);
+}
+
+void SoftwareRenderer::clear(const glm::vec4 &color) {
+	uint32_t pixel = packPremultiplied(color);
+	for (size_t i = 0; i < m_pixels.size(); i += 4) {
+		std::memcpy(&m_pixels[i], &pixel, 4);
+	}
+}
+
+void SoftwareRenderer::drawLine(float x1, float y1, float x2, float y2) {
+	glm::vec2 points[2] = {toDevice(x1, y1), toDevice(x2, y2)};
+	addStroke(points, 2, false, m_strokeWidth * getDeviceScale());
+	rasterize(m_strokeColor, false);
+}
+
+void SoftwareRenderer::drawRect(float x, float y, float width, float height) {
+	glm::vec2 points[4] = {toDevice(x, y), toDevice(x + width, y),
+						   toDevice(x + width, y + height),
+						   toDevice(x, y + height)};
+	drawShape(points, 4);
+}
+
+void SoftwareRenderer::drawCircle(float x, float y, float radius) {
+	drawEllipse(x, y, radius, radius);
+}
+
+void SoftwareRenderer::drawEllipse(float x, float y, float width,
+								   float height) {
+	flattenEllipse(glm::vec2(x, y), glm::vec2(width, height), m_points);
+	drawShape(m_points.data(), m_points.size());
+}
+
+void SoftwareRenderer::drawTriangle(float x1, float y1, float x2, float y2,
+									float x3, float y3) {
+	glm::vec2 points[3] = {toDevice(x1, y1), toDevice(x2, y2),
+						   toDevice(x3, y3)};
+	drawShape(points, 3);
+}
+
+void SoftwareRenderer::drawPolygon(const std::vector<glm::vec2> &points) {
+	m_points.clear();
+	for (const glm::vec2 &point : points) {
+		m_points.push_back(toDevice(point.x, point.y));
+	}
+	drawShape(m_points.data(), m_points.size());
+}
+
+void SoftwareRenderer::beginPath() {
+	m_path.clear();
+	m_pathClosed.clear();
+}
+
+void SoftwareRenderer::moveTo(float x, float y) {
+	m_path.emplace_back();
+	m_path.back().push_back(toDevice(x, y));
+	m_pathClosed.push_back(false);
+}
+
+void SoftwareRenderer::lineTo(float x, float y) {
+	if (m_path.empty()) {
+		moveTo(x, y);
+		return;
+	}
+	if (m_pathClosed.back()) {
+		// After closePath() the next segment starts a new subpath at the
+		// start of the closed one
+		glm::vec2 start = m_path.back().front();
+		m_path.emplace_back(1, start);
+		m_pathClosed.push_back(false);
+	}
+	m_path.back().push_back(toDevice(x, y));
+}
+
+void SoftwareRenderer::curveTo(float cx1, float cy1, float cx2, float cy2,
+							   float x, float y) {
+	if (m_path.empty()) {
+		moveTo(cx1, cy1);
+	}
+	lineTo(cx1, cy1); // Opens a new subpath after closePath() if needed
+	Outline &points = m_path.back();
+	points.pop_back();
+
+	glm::vec2 p0 = points.back();
+	glm::vec2 p1 = toDevice(cx1, cy1);
+	glm::vec2 p2 = toDevice(cx2, cy2);
+	glm::vec2 p3 = toDevice(x, y);
+	// Wang's formula: segments needed to stay within kFlatness
+	float bend = std::max(glm::length(p0 - 2.0f * p1 + p2),
+						  glm::length(p1 - 2.0f * p2 + p3));
+	int segments = static_cast<int>(std::ceil(std::sqrt(0.75f * bend /
+														 kFlatness)));
+	segments = std::min(std::max(segments, 1), 256);
+	for (int i = 1; i <= segments; ++i) {
+		float t = static_cast<float>(i) / segments;
+		float u = 1.0f - t;
+		points.push_back(u * u * u * p0 + 3.0f * u * u * t * p1 +
+						 3.0f * u * t * t * p2 + t * t * t * p3);
+	}
+}
+
+void SoftwareRenderer::closePath() {
+	if (!m_pathClosed.empty()) {
+		m_pathClosed.back() = true;
+	}
+}
+
+void SoftwareRenderer::fill(const glm::vec4 &color) {
+	for (const Outline &points : m_path) {
+		if (points.size() >= 3) {
+			nextOutline().assign(points.begin(), points.end());
+		}
+	}
+	rasterize(color, false);
+}
+
+void SoftwareRenderer::stroke(const glm::vec4 &color, float width) {
+	float deviceWidth = width * getDeviceScale();
+	for (size_t i = 0; i < m_path.size(); ++i) {
+		addStroke(m_path[i].data(), m_path[i].size(), m_pathClosed[i],
+				  deviceWidth);
+	}
+	rasterize(color, false);
+}
+
+void SoftwareRenderer::setFont(const std::string &fontPath, float size) {
+	m_fontSize = size;
+}
+
+void SoftwareRenderer::drawText(const std::string &text, float x, float y,
+								const glm::vec4 &color) {
+	if (!m_warnedText) {
+		spdlog::warn("[SoftwareRenderer] Text is not supported; drawText() "
+					 "draws nothing");
+		m_warnedText = true;
+	}
+}
+
+glm::vec2 SoftwareRenderer::getTextBounds(const std::string &text) {
+	// Rough advance of a proportional font, enough for layout
+	return glm::vec2(text.size() * m_fontSize * 0.5f, m_fontSize);
+}
+
+void SoftwareRenderer::pushMatrix() { m_matrixStack.push_back(m_matrix); }
+
+void SoftwareRenderer::popMatrix() {
+	if (m_matrixStack.empty()) {
+		return;
+	}
+	m_matrix = m_matrixStack.back();
+	m_matrixStack.pop_back();
+}
+
+void SoftwareRenderer::translate(float x, float y) {
+	m_matrix = m_matrix * glm::mat3(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y,
+									1.0f);
+}
+
+void SoftwareRenderer::rotate(float angle) {
+	float c = std::cos(angle);
+	float s = std::sin(angle);
+	m_matrix =
+		m_matrix * glm::mat3(c, s, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void SoftwareRenderer::scale(float sx, float sy) {
+	m_matrix = m_matrix * glm::mat3(sx, 0.0f, 0.0f, 0.0f, sy, 0.0f, 0.0f,
+									0.0f, 1.0f);
+}
+
+void SoftwareRenderer::resetMatrix() { m_matrix = glm::mat3(1.0f); }
+
+void SoftwareRenderer::setFillColor(const glm::vec4 &color) {
+	m_fillColor = color;
+	m_strokeShapes = false;
+}
+
+void SoftwareRenderer::setStrokeColor(const glm::vec4 &color) {
+	m_strokeColor = color;
+	m_strokeShapes = true;
+}
+
+void SoftwareRenderer::setStrokeWidth(float width) {
+	m_strokeWidth = width;
+	m_strokeShapes = true;
+}
+
+bool SoftwareRenderer::setBlendMode(BlendMode mode) {
+	m_blendMode = mode;
+	return true;
+}
+
+void SoftwareRenderer::setLinearGradient(
+	float x1, float y1, float x2, float y2,
+	const std::vector<GradientStop> &stops) {
+	Gradient gradient;
+	gradient.type = GradientType::Linear;
+	gradient.start = glm::vec2(x1, y1);
+	gradient.end = glm::vec2(x2, y2);
+	setGradient(gradient, stops);
+}
+
+void SoftwareRenderer::setRadialGradient(
+	float cx, float cy, float radius, const std::vector<GradientStop> &stops) {
+	Gradient gradient;
+	gradient.type = GradientType::Radial;
+	gradient.start = glm::vec2(cx, cy);
+	gradient.radius = radius;
+	setGradient(gradient, stops);
+}
+
+void SoftwareRenderer::setConicGradient(
+	float cx, float cy, float angle, const std::vector<GradientStop> &stops) {
+	Gradient gradient;
+	gradient.type = GradientType::Conic;
+	gradient.start = glm::vec2(cx, cy);
+	gradient.angle = angle;
+	setGradient(gradient, stops);
+}
+
+void SoftwareRenderer::clearGradient() { m_hasGradient = false; }
+
+bool SoftwareRenderer::saveToFile(const std::string &filename) {
+	if (m_pixels.empty()) {
+		return false;
+	}
+	std::vector<uint8_t> straight(m_pixels.size());
+	unpremultiplyRgba(m_pixels.data(), straight.data(), m_pixels.size() / 4);
+	return writePam(filename, straight.data(), m_width, m_height);
+}
+
+bool SoftwareRenderer::saveToMemory(std::vector<uint8_t> &data) {
+	if (m_pixels.empty()) {
+		return false;
+	}
+	data = m_pixels;
+	return true;
+}
+
+glm::vec2 SoftwareRenderer::toDevice(float x, float y) const {
+	glm::vec3 p = m_matrix * glm::vec3(x, y, 1.0f);
+	return glm::vec2(p.x, p.y);
+}
+
+float SoftwareRenderer::getDeviceScale() const {
+	return std::sqrt(std::fabs(m_matrix[0][0] * m_matrix[1][1] -
+							   m_matrix[0][1] * m_matrix[1][0]));
+}
+
+void SoftwareRenderer::setGradient(Gradient gradient,
+								   const std::vector<GradientStop> &stops) {
+	// Stops are looked up in gradient space, so transforms applied after
+	// this call do not move the gradient
+	gradient.toUser = glm::inverse(m_matrix);
+
+	std::vector<GradientStop> sorted = stops;
+	std::stable_sort(sorted.begin(), sorted.end(),
+					 [](const GradientStop &a, const GradientStop &b) {
+						 return a.offset < b.offset;
+					 });
+	for (size_t i = 0; i < gradient.ramp.size(); ++i) {
+		float t = static_cast<float>(i) / (gradient.ramp.size() - 1);
+		glm::vec4 color(0.0f);
+		if (!sorted.empty()) {
+			auto next = std::find_if(
+				sorted.begin(), sorted.end(),
+				[t](const GradientStop &stop) { return stop.offset >= t; });
+			if (next == sorted.begin()) {
+				color = next->color;
+			} else if (next == sorted.end()) {
+				color = sorted.back().color;
+			} else {
+				auto previous = next - 1;
+				float span = next->offset - previous->offset;
+				float f = span > 0.0f ? (t - previous->offset) / span : 1.0f;
+				color = glm::mix(previous->color, next->color, f);
+			}
+		}
+		gradient.ramp[i] = packPremultiplied(color);
+	}
+	m_gradient = gradient;
+	m_hasGradient = true;
+	m_strokeShapes = false;
+}
+
+SoftwareRenderer::Outline &SoftwareRenderer::nextOutline() {
+	if (m_outlineCount == m_outlines.size()) {
+		m_outlines.emplace_back();
+	}
+	Outline &outline = m_outlines[m_outlineCount++];
+	outline.clear();
+	return outline;
+}
+
+void SoftwareRenderer::flattenEllipse(glm::vec2 center, glm::vec2 radius,
+									  Outline &out) const {
+	// Enough segments that the chord sag stays within kFlatness
+	float deviceRadius =
+		std::max(std::fabs(radius.x), std::fabs(radius.y)) * getDeviceScale();
+	int segments = 8;
+	if (deviceRadius > kFlatness) {
+		float step = std::acos(1.0f - kFlatness / deviceRadius);
+		segments = static_cast<int>(std::ceil(kPi / step));
+	}
+	segments = std::min(std::max(segments, 8), 1024);
+
+	out.clear();
+	for (int i = 0; i < segments; ++i) {
+		float angle = 2.0f * kPi * i / segments;
+		out.push_back(toDevice(center.x + radius.x * std::cos(angle),
+							   center.y + radius.y * std::sin(angle)));
+	}
+}
+
+void SoftwareRenderer::addStroke(const glm::vec2 *points, size_t count,
+								 bool closed, float width) {
+	if (count < 2 || !(width > 0.0f)) {
+		return;
+	}
+	float half = 0.5f * width;
+
+	size_t segments = closed ? count : count - 1;
+	for (size_t i = 0; i < segments; ++i) {
+		glm::vec2 a = points[i];
+		glm::vec2 b = points[(i + 1) % count];
+		float length = glm::length(b - a);
+		if (length < 1e-6f) {
+			continue;
+		}
+		glm::vec2 n = perpendicular(b - a) * (half / length);
+		Outline &quad = nextOutline();
+		quad = {a + n, b + n, b - n, a - n};
+		orient(quad);
+	}
+
+	// Joins fill the wedge on the outer side of each corner
+	size_t first = closed ? 0 : 1;
+	size_t last = closed ? count : count - 1;
+	for (size_t i = first; i < last; ++i) {
+		glm::vec2 v = points[i];
+		glm::vec2 in = v - points[(i + count - 1) % count];
+		glm::vec2 out = points[(i + 1) % count] - v;
+		float inLength = glm::length(in);
+		float outLength = glm::length(out);
+		if (inLength < 1e-6f || outLength < 1e-6f) {
+			continue;
+		}
+		in /= inLength;
+		out /= outLength;
+		float cross = in.x * out.y - in.y * out.x;
+		if (std::fabs(cross) < 1e-4f && glm::dot(in, out) > 0.0f) {
+			continue; // Straight through
+		}
+		float side = cross > 0.0f ? -1.0f : 1.0f;
+		glm::vec2 n0 = perpendicular(in) * (half * side);
+		glm::vec2 n1 = perpendicular(out) * (half * side);
+
+		Outline &join = nextOutline();
+		join.push_back(v);
+		join.push_back(v + n0);
+		glm::vec2 bisector = n0 + n1;
+		float bisectorLength = glm::length(bisector);
+		if (bisectorLength > 1e-6f) {
+			// Miter length over stroke width is 1 / cos(turn / 2)
+			float cosHalf = bisectorLength / (2.0f * half);
+			if (1.0f / cosHalf <= kMiterLimit) {
+				join.push_back(v + bisector * (half / (cosHalf *
+														bisectorLength)));
+			}
+		}
+		join.push_back(v + n1);
+		orient(join);
+	}
+}
+
+void SoftwareRenderer::drawShape(const glm::vec2 *points, size_t count) {
+	if (m_strokeShapes) {
+		addStroke(points, count, true, m_strokeWidth * getDeviceScale());
+		rasterize(m_strokeColor, false);
+		return;
+	}
+	if (count >= 3) {
+		nextOutline().assign(points, points + count);
+	}
+	rasterize(m_fillColor, m_hasGradient);
+}
+
+void SoftwareRenderer::rasterize(const glm::vec4 &color, bool useGradient) {
+	size_t outlineCount = m_outlineCount;
+	m_outlineCount = 0;
+	if (m_pixels.empty() || outlineCount == 0) {
+		return;
+	}
+
+	glm::vec2 lo(INFINITY);
+	glm::vec2 hi(-INFINITY);
+	for (size_t i = 0; i < outlineCount; ++i) {
+		for (const glm::vec2 &p : m_outlines[i]) {
+			lo = glm::min(lo, p);
+			hi = glm::max(hi, p);
+		}
+	}
+	if (!std::isfinite(lo.x) || !std::isfinite(lo.y) ||
+		!std::isfinite(hi.x) || !std::isfinite(hi.y)) {
+		return;
+	}
+	auto clampTo = [](float v, int limit) {
+		return static_cast<int>(
+			std::min(std::max(v, 0.0f), static_cast<float>(limit)));
+	};
+	int x0 = clampTo(std::floor(lo.x), m_width);
+	int y0 = clampTo(std::floor(lo.y), m_height);
+	int x1 = clampTo(std::ceil(hi.x), m_width);
+	int y1 = clampTo(std::ceil(hi.y), m_height);
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	// Two spare cells per row take area that lands right of the last pixel
+	int columns = x1 - x0;
+	int rows = y1 - y0;
+	int stride = columns + 2;
+	m_coverage.assign(static_cast<size_t>(stride) * rows, 0.0f);
+	glm::vec2 origin(static_cast<float>(x0), static_cast<float>(y0));
+	for (size_t i = 0; i < outlineCount; ++i) {
+		const Outline &points = m_outlines[i];
+		for (size_t j = 0, k = points.size() - 1; j < points.size(); k = j++) {
+			accumulateEdge(points[k] - origin, points[j] - origin, stride,
+						   rows);
+		}
+	}
+
+	// Other modes gather the row's coverage-scaled source, then blend the
+	// covered run in one blendSpan() call
+	bool blended = m_blendMode != BlendMode::Normal;
+	if (blended) {
+		m_blendRow.resize(static_cast<size_t>(columns) * 4);
+	}
+	uint32_t solid = packPremultiplied(color);
+	for (int y = 0; y < rows; ++y) {
+		const float *cells = &m_coverage[static_cast<size_t>(y) * stride];
+		uint8_t *row =
+			&m_pixels[(static_cast<size_t>(y0 + y) * m_width + x0) * 4];
+		uint8_t *dst = row;
+		int first = columns;
+		int last = 0;
+		float area = 0.0f;
+		for (int x = 0; x < columns; ++x, dst += 4) {
+			area += cells[x];
+			float coverage = std::min(std::fabs(area), 1.0f);
+			uint32_t alpha = static_cast<uint32_t>(coverage * 255.0f + 0.5f);
+			if (blended) {
+				// Uncovered pixels inside the run blend as transparent
+				std::memset(&m_blendRow[x * 4], 0, 4);
+			}
+			if (alpha == 0) {
+				continue;
+			}
+			uint32_t src = solid;
+			if (useGradient) {
+				glm::vec3 p = m_gradient.toUser *
+							  glm::vec3(x0 + x + 0.5f, y0 + y + 0.5f, 1.0f);
+				glm::vec2 d = glm::vec2(p.x, p.y) - m_gradient.start;
+				float t = 0.0f;
+				if (m_gradient.type == GradientType::Linear) {
+					glm::vec2 axis = m_gradient.end - m_gradient.start;
+					float length2 = glm::dot(axis, axis);
+					t = length2 > 0.0f ? glm::dot(d, axis) / length2 : 0.0f;
+				} else if (m_gradient.type == GradientType::Radial) {
+					t = m_gradient.radius > 0.0f
+							? glm::length(d) / m_gradient.radius
+							: 0.0f;
+				} else {
+					t = (std::atan2(d.y, d.x) - m_gradient.angle) /
+						(2.0f * kPi);
+					t -= std::floor(t);
+				}
+				t = std::min(std::max(t, 0.0f), 1.0f);
+				src = m_gradient.ramp[static_cast<size_t>(t * 255.0f + 0.5f)];
+			}
+			if (!blended) {
+				blendPixel(dst, src, alpha);
+				continue;
+			}
+			if (alpha < 255) {
+				src = scalePixel(src, alpha);
+			}
+			std::memcpy(&m_blendRow[x * 4], &src, 4);
+			first = std::min(first, x);
+			last = x + 1;
+		}
+		if (first < last) {
+			uint8_t *span = row + first * 4;
+			blendSpan(m_blendMode, &m_blendRow[first * 4], span, span,
+					  last - first);
+		}
+	}
+}
+
+// Adds the signed area an edge covers to each cell it crosses; a running sum
+// along the row then gives the coverage of every pixel. Coordinates are
+// relative to the raster origin. After font-rs by Raph Levien.
+void SoftwareRenderer::accumulateEdge(glm::vec2 p0, glm::vec2 p1, int stride,
+									  int rows) {
+	if (p0.y == p1.y) {
+		return;
+	}
+	float direction = 1.0f;
+	if (p0.y > p1.y) {
+		std::swap(p0, p1);
+		direction = -1.0f;
+	}
+	float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+	float x = p0.x;
+	float top = p0.y;
+	if (top < 0.0f) {
+		x -= top * dxdy;
+		top = 0.0f;
+	}
+	float bottom = std::min(p1.y, static_cast<float>(rows));
+	if (top >= bottom) {
+		return;
+	}
+	// Area left of the raster collapses into its first column
+	float maxX = static_cast<float>(stride - 2);
+
+	for (int y = static_cast<int>(top); y < bottom; ++y) {
+		float *row = &m_coverage[static_cast<size_t>(y) * stride];
+		float rowTop = std::max(static_cast<float>(y), top);
+		float dy = std::min(y + 1.0f, bottom) - rowTop;
+		float xNext = x + dxdy * dy;
+		float d = dy * direction;
+		float xa = std::min(std::max(std::min(x, xNext), 0.0f), maxX);
+		float xb = std::min(std::max(std::max(x, xNext), 0.0f), maxX);
+		float xaFloor = std::floor(xa);
+		int xai = static_cast<int>(xaFloor);
+		float xbCeil = std::ceil(xb);
+		int xbi = static_cast<int>(xbCeil);
+
+		if (xbi <= xai + 1) {
+			// Edge stays within one pixel on this row
+			float mid = 0.5f * (xa + xb) - xaFloor;
+			row[xai] += d - d * mid;
+			row[xai + 1] += d * mid;
+		} else {
+			float s = 1.0f / (xb - xa);
+			float xaFrac = xa - xaFloor;
+			float a0 = 0.5f * s * (1.0f - xaFrac) * (1.0f - xaFrac);
+			float xbFrac = xb - xbCeil + 1.0f;
+			float am = 0.5f * s * xbFrac * xbFrac;
+			row[xai] += d * a0;
+			if (xbi == xai + 2) {
+				row[xai + 1] += d * (1.0f - a0 - am);
+			} else {
+				float a1 = s * (1.5f - xaFrac);
+				row[xai + 1] += d * (a1 - a0);
+				for (int xi = xai + 2; xi < xbi - 1; ++xi) {
+					row[xi] += d * s;
+				}
+				float a2 = a1 + (xbi - xai - 3) * s;
+				row[xbi - 1] += d * (1.0f - a2 - am);
+			}
+			row[xbi] += d * am;
+		}
+		x = xNext;
+	}
+}
+
+} // namespace blot
@@ -2,23 +2,56 @@
 
 #include "rendering/U_gladGlfw.h"
 
+#include <glm/gtc/type_ptr.hpp>
+
+#include "rendering/GlState.h"
+#include "rendering/ShaderRegistry.h"
+
 Shader::Shader() {}
+
+// The program belongs to the ShaderRegistry and may be shared
 Shader::~Shader() {}
 
 bool Shader::load(const std::string &vertSrc, const std::string &fragSrc) {
-	// Stub: always return true
-	return true;
+	m_program = blot::ShaderRegistry::instance().getProgram(vertSrc.c_str(),
+														   fragSrc.c_str());
+	return m_program != 0;
 }
 
-void Shader::use() {
-	// Stub: do nothing
+void Shader::use() { blot::GlState::instance().useProgram(m_program); }
+
+namespace {
+
+GLint location(unsigned int program, const std::string &name) {
+	return blot::ShaderRegistry::instance().getUniformLocation(program,
+															   name.c_str());
 }
 
-void Shader::setUniform(const std::string &name, float value) {}
-void Shader::setUniform(const std::string &name, int value) {}
-void Shader::setUniform(const std::string &name, const glm::vec2 &value) {}
-void Shader::setUniform(const std::string &name, const glm::vec3 &value) {}
-void Shader::setUniform(const std::string &name, const glm::vec4 &value) {}
-void Shader::setUniform(const std::string &name, const glm::mat4 &value) {}
+} // namespace
+
+void Shader::setUniform(const std::string &name, float value) {
+	glUniform1f(location(m_program, name), value);
+}
+
+void Shader::setUniform(const std::string &name, int value) {
+	glUniform1i(location(m_program, name), value);
+}
+
+void Shader::setUniform(const std::string &name, const glm::vec2 &value) {
+	glUniform2fv(location(m_program, name), 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform(const std::string &name, const glm::vec3 &value) {
+	glUniform3fv(location(m_program, name), 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform(const std::string &name, const glm::vec4 &value) {
+	glUniform4fv(location(m_program, name), 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform(const std::string &name, const glm::mat4 &value) {
+	glUniformMatrix4fv(location(m_program, name), 1, GL_FALSE,
+					   glm::value_ptr(value));
+}
 
 unsigned int Shader::getProgram() const { return m_program; }
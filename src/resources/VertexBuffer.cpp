@@ -2,34 +2,364 @@
 
 #include "rendering/U_gladGlfw.h"
 
-VertexBuffer::VertexBuffer() {
+#include <algorithm>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "rendering/GlState.h"
+
+namespace {
+
+// Smallest ring region, so small writes share one instead of cycling
+// through all three within a frame
+constexpr size_t kMinRegionBytes = 64 * 1024;
+
+GLenum toGlType(VertexBuffer::ComponentType type) {
+	switch (type) {
+	case VertexBuffer::ComponentType::HalfFloat:
+		return GL_HALF_FLOAT;
+	case VertexBuffer::ComponentType::UnsignedByte:
+		return GL_UNSIGNED_BYTE;
+	case VertexBuffer::ComponentType::Float:
+	default:
+		return GL_FLOAT;
+	}
+}
+
+size_t componentSize(VertexBuffer::ComponentType type) {
+	switch (type) {
+	case VertexBuffer::ComponentType::HalfFloat:
+		return 2;
+	case VertexBuffer::ComponentType::UnsignedByte:
+		return 1;
+	case VertexBuffer::ComponentType::Float:
+	default:
+		return 4;
+	}
+}
+
+bool bufferStorageSupported() {
+	return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+}
+
+// Wait until the GPU has finished reading whatever the fence guards
+void waitAndDelete(void *&fence) {
+	if (!fence) {
+		return;
+	}
+	GLsync sync = static_cast<GLsync>(fence);
+	GLbitfield flags = 0;
+	for (;;) {
+		GLenum result = glClientWaitSync(sync, flags, 1000000000);
+		if (result == GL_ALREADY_SIGNALED ||
+			result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+		// Make sure the fence itself has been submitted before waiting again
+		flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	}
+	glDeleteSync(sync);
+	fence = nullptr;
+}
+
+} // namespace
+
+VertexBuffer::Layout &VertexBuffer::Layout::add(unsigned int location,
+												int components,
+												ComponentType type,
+												bool normalized,
+												unsigned int divisor) {
+	Attribute attribute;
+	attribute.location = location;
+	attribute.components = components;
+	attribute.type = type;
+	attribute.normalized = normalized;
+	attribute.offset = stride;
+	attribute.divisor = divisor;
+	attributes.push_back(attribute);
+	stride += components * componentSize(type);
+	return *this;
+}
+
+VertexBuffer::VertexBuffer(Usage usage) : m_usage(usage) {
 	glGenVertexArrays(1, &m_vao);
 	glGenBuffers(1, &m_vbo);
 }
 
 VertexBuffer::~VertexBuffer() {
+	releaseStorage();
 	glDeleteBuffers(1, &m_vbo);
-	glDeleteVertexArrays(1, &m_vao);
+	blot::GlState::instance().deleteVertexArrays(1, &m_vao);
+}
+
+void VertexBuffer::setLayout(const Layout &layout) {
+	disableLayout();
+	m_layout = layout;
+	if (m_mapped) {
+		// Regions are sized in whole vertices, so the ring has to be rebuilt
+		allocateRing(m_capacity);
+	}
+	applyLayout(m_mapped ? static_cast<size_t>(m_region) * m_capacity : 0);
 }
 
 void VertexBuffer::setData(const std::vector<float> &data,
 						   int componentsPerVertex) {
-	m_components = componentsPerVertex;
-	glBindVertexArray(m_vao);
+	const Layout &current = m_layout;
+	if (current.attributes.size() != 1 ||
+		current.attributes[0].components != componentsPerVertex ||
+		current.attributes[0].type != ComponentType::Float) {
+		setLayout(Layout().add(0, componentsPerVertex));
+	}
+	setData(data.data(), data.size() * sizeof(float));
+}
+
+void VertexBuffer::setData(const void *data, size_t bytes) {
+	if (usesRing()) {
+		void *dst = beginWrite(bytes);
+		if (dst && bytes) {
+			std::memcpy(dst, data, bytes);
+		}
+		endWrite();
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	if (m_usage == Usage::Static || bytes > m_capacity) {
+		glBufferData(GL_ARRAY_BUFFER, bytes, data, getGlUsage());
+		m_capacity = bytes;
+		trackMemory();
+	} else {
+		// Same size store, fresh memory: draws still reading the old
+		// contents keep it, and this upload does not wait for them
+		glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, getGlUsage());
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+	}
+	m_size = bytes;
+	m_writeOffset = 0;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	applyLayout();
+}
+
+void VertexBuffer::updateData(size_t offset, const void *data, size_t bytes) {
+	// The ring only holds the latest write; elsewhere the whole store counts
+	size_t limit = m_mapped ? m_size : m_capacity;
+	if (offset + bytes > limit) {
+		spdlog::error("[VertexBuffer] Update of {} bytes at {} exceeds the "
+					  "{} bytes of data",
+					  bytes, offset, limit);
+		return;
+	}
+	if (m_mapped) {
+		if (!m_writing) {
+			// Draws already issued may be reading this data. They are not
+			// tracked, so wait for everything submitted so far.
+			void *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			waitAndDelete(fence);
+		}
+		// Coherent mapping: writing the region is the update
+		std::memcpy(m_mapped + m_writeOffset + offset, data, bytes);
+		return;
+	}
 	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-	glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(),
-				 GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, m_components, GL_FLOAT, GL_FALSE, 0, (void *)0);
-	glBindVertexArray(0);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_size = std::max(m_size, offset + bytes);
 }
 
-void VertexBuffer::bind() const { glBindVertexArray(m_vao); }
+void VertexBuffer::orphan() {
+	if (m_mapped || m_capacity == 0) {
+		// The ring never waits on a region the GPU is still reading
+		return;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, getGlUsage());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_size = 0;
+}
 
-void VertexBuffer::unbind() const { glBindVertexArray(0); }
+void *VertexBuffer::beginWrite(size_t bytes) {
+	if (m_writing) {
+		endWrite();
+	}
+
+	if (usesRing()) {
+		if (!m_mapped || bytes > m_capacity) {
+			allocateRing(std::max(
+				{bytes, m_capacity + m_capacity / 2, kMinRegionBytes}));
+		} else if (m_regionHead + bytes > m_capacity) {
+			// Fence the region just filled and move to the oldest one
+			void *&fence = m_fences[m_region];
+			if (!fence) {
+				fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+			m_region = (m_region + 1) % kRegions;
+			m_regionHead = 0;
+			waitAndDelete(m_fences[m_region]);
+		}
+		if (m_mapped) {
+			// Writes go back to back, each starting on a whole vertex
+			const size_t stride = std::max<size_t>(m_layout.stride, 1);
+			m_writing = true;
+			m_writeOffset =
+				static_cast<size_t>(m_region) * m_capacity + m_regionHead;
+			m_regionHead += (bytes + stride - 1) / stride * stride;
+			m_size = bytes;
+			return m_mapped + m_writeOffset;
+		}
+		// Mapping failed; fall through to the orphaning path
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	if (bytes > m_capacity) {
+		m_capacity = bytes;
+		glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, getGlUsage());
+		trackMemory();
+	}
+	void *dst = nullptr;
+	if (bytes > 0) {
+		// Invalidating the whole buffer orphans it like glBufferData(null)
+		dst = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+							   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_writing = dst != nullptr;
+	m_writeOffset = 0;
+	m_size = bytes;
+	return dst;
+}
+
+void VertexBuffer::endWrite() {
+	if (!m_writing) {
+		return;
+	}
+	m_writing = false;
+	if (!m_mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+			// The store was lost (e.g. a mode switch); contents undefined
+			spdlog::warn("[VertexBuffer] Buffer contents lost while mapped");
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	applyLayout(m_writeOffset);
+}
+
+void VertexBuffer::setFirstVertex(size_t first) {
+	applyLayout(m_writeOffset + first * m_layout.stride);
+}
+
+void VertexBuffer::bind() const {
+	blot::GlState::instance().bindVertexArray(m_vao);
+}
+
+void VertexBuffer::unbind() const {
+	blot::GlState::instance().bindVertexArray(0);
+}
+
+void VertexBuffer::draw(int mode, int count, int first) const {
+	// Left bound: back-to-back draws of one buffer skip the rebind
+	bind();
+	glDrawArrays(mode, first, count);
+}
+
+bool VertexBuffer::usesRing() const {
+	return m_usage == Usage::Stream && !m_ringFailed &&
+		   bufferStorageSupported();
+}
+
+void VertexBuffer::allocateRing(size_t bytes) {
+	releaseStorage();
+	// Whole vertices per region keep every region's base aligned to a vertex
+	const size_t stride = std::max<size_t>(m_layout.stride, 1);
+	m_capacity = std::max<size_t>((bytes + stride - 1) / stride * stride,
+								  stride);
+	const GLsizeiptr total = static_cast<GLsizeiptr>(m_capacity * kRegions);
+	const GLbitfield flags =
+		GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags);
+	m_mapped = static_cast<uint8_t *>(
+		glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!m_mapped) {
+		spdlog::warn("[VertexBuffer] Persistent mapping failed, falling back "
+					 "to orphaning");
+		// Immutable storage cannot be respecified; start over on a new name
+		releaseStorage();
+		m_ringFailed = true;
+	}
+	trackMemory();
+	m_region = 0;
+	m_regionHead = 0;
+	m_writeOffset = 0;
+	m_size = 0;
+}
+
+void VertexBuffer::applyLayout(size_t base) {
+	if (m_layout.attributes.empty()) {
+		return;
+	}
+	bind();
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	for (const Attribute &attribute : m_layout.attributes) {
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(
+			attribute.location, attribute.components,
+			toGlType(attribute.type),
+			attribute.normalized ? GL_TRUE : GL_FALSE,
+			static_cast<GLsizei>(m_layout.stride),
+			reinterpret_cast<void *>(base + attribute.offset));
+		glVertexAttribDivisor(attribute.location, attribute.divisor);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::disableLayout() {
+	if (m_layout.attributes.empty()) {
+		return;
+	}
+	bind();
+	for (const Attribute &attribute : m_layout.attributes) {
+		glDisableVertexAttribArray(attribute.location);
+	}
+}
+
+void VertexBuffer::releaseStorage() {
+	for (void *&fence : m_fences) {
+		waitAndDelete(fence);
+	}
+	if (!m_mapped && m_capacity == 0) {
+		return;
+	}
+	if (m_mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_mapped = nullptr;
+	}
+	// Storage made with glBufferStorage is immutable, so swap in a new name
+	glDeleteBuffers(1, &m_vbo);
+	glGenBuffers(1, &m_vbo);
+	m_capacity = 0;
+	m_size = 0;
+	m_writing = false;
+	trackMemory();
+}
+
+void VertexBuffer::trackMemory() {
+	m_memory.set(m_mapped ? m_capacity * kRegions : m_capacity);
+}
 
-void VertexBuffer::draw(int mode, int count) const {
-	glBindVertexArray(m_vao);
-	glDrawArrays(mode, 0, count);
-	glBindVertexArray(0);
+unsigned int VertexBuffer::getGlUsage() const {
+	switch (m_usage) {
+	case Usage::Dynamic:
+		return GL_DYNAMIC_DRAW;
+	case Usage::Stream:
+		return GL_STREAM_DRAW;
+	case Usage::Static:
+	default:
+		return GL_STATIC_DRAW;
+	}
 }
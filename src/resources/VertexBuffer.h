@@ -1,19 +1,117 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
+#include "core/util/MemoryTracker.h"
+
 class VertexBuffer {
   public:
-	VertexBuffer();
+	// How often the contents are rewritten; maps to the GL usage hint
+	enum class Usage {
+		Static,	 // Written once, drawn many times
+		Dynamic, // Rewritten now and then, drawn several times
+		Stream	 // Rewritten every frame, drawn once or twice
+	};
+
+	enum class ComponentType { Float, HalfFloat, UnsignedByte };
+
+	struct Attribute {
+		unsigned int location = 0;
+		int components = 0;
+		ComponentType type = ComponentType::Float;
+		bool normalized = false;
+		size_t offset = 0;		  // Bytes from the start of a vertex
+		unsigned int divisor = 0; // 1 to advance once per instance
+	};
+
+	// Interleaved vertex description; offsets are packed in add() order
+	struct Layout {
+		std::vector<Attribute> attributes;
+		size_t stride = 0;
+
+		Layout &add(unsigned int location, int components,
+					ComponentType type = ComponentType::Float,
+					bool normalized = false, unsigned int divisor = 0);
+	};
+
+	explicit VertexBuffer(Usage usage = Usage::Static);
 	~VertexBuffer();
 
+	VertexBuffer(const VertexBuffer &) = delete;
+	VertexBuffer &operator=(const VertexBuffer &) = delete;
+
+	void setLayout(const Layout &layout);
+	const Layout &getLayout() const { return m_layout; }
+	Usage getUsage() const { return m_usage; }
+
+	// Single float attribute at location 0, the original convenience path
 	void setData(const std::vector<float> &data, int componentsPerVertex);
+
+	// Replace the contents. Dynamic and stream buffers that already have
+	// the room orphan the old store instead of waiting on draws using it.
+	void setData(const void *data, size_t bytes);
+
+	// Overwrite part of the current data in place. A persistent ring first
+	// waits for the GPU to finish every draw issued so far, as they may
+	// read the region being patched; stream fresh data with beginWrite()
+	// instead.
+	void updateData(size_t offset, const void *data, size_t bytes);
+
+	// Detach the current store so the next write does not wait on the GPU
+	void orphan();
+
+	/**
+	 * @brief Write pointer for up to `bytes` of fresh vertex data.
+	 *
+	 * Stream buffers on GL 4.4 / ARB_buffer_storage write straight into a
+	 * persistently mapped ring of three regions. Writes are placed back to
+	 * back, so several per frame share a region; a full region is fenced
+	 * and only reused once the GPU is done with it. Elsewhere the store is
+	 * orphaned and mapped for the write. Call endWrite() before drawing.
+	 */
+	void *beginWrite(size_t bytes);
+
+	// Finish a beginWrite() and point the attributes at the written data
+	void endWrite();
+
+	// Point the attributes at vertex `first` of the current data, to draw
+	// a range of instances without GL 4.2 base instances
+	void setFirstVertex(size_t first);
+
 	void bind() const;
 	void unbind() const;
-	void draw(int mode, int count) const;
+	void draw(int mode, int count, int first = 0) const;
+
+	bool isPersistent() const { return m_mapped != nullptr; }
+	size_t getCapacity() const { return m_capacity; }
+	size_t getSize() const { return m_size; }
 
   private:
+	bool usesRing() const;
+	void allocateRing(size_t bytes);
+	void applyLayout(size_t base = 0);
+	void disableLayout();
+	void releaseStorage();
+	void trackMemory();
+	unsigned int getGlUsage() const;
+
+	static constexpr int kRegions = 3;
+
 	unsigned int m_vao = 0;
 	unsigned int m_vbo = 0;
-	int m_components = 0;
+	Usage m_usage;
+	Layout m_layout;
+	size_t m_capacity = 0; // Bytes in the store, or in one ring region
+	size_t m_size = 0;	   // Bytes of valid data
+	// Persistent ring
+	uint8_t *m_mapped = nullptr;
+	int m_region = 0;
+	size_t m_regionHead = 0; // Bytes written to the region so far
+	bool m_ringFailed = false;
+	void *m_fences[kRegions] = {}; // GLsync per region
+	bool m_writing = false;
+	size_t m_writeOffset = 0;
+	blot::TrackedMemory m_memory{blot::MemoryTag::Rendering,
+								 blot::MemoryDomain::Gpu};
 };